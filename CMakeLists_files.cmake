@@ -21,7 +21,26 @@
 #	                      the library needs it.
 
 list (APPEND MAIN_SOURCE_FILES
+      opm/common/data/AlignedBuffer.cpp
+      opm/common/data/CellPartition.cpp
+      opm/common/data/DeltaCheckpoint.cpp
+      opm/common/data/FieldBits.cpp
+      opm/common/data/FieldComparison.cpp
+      opm/common/data/FieldCompressor.cpp
+      opm/common/data/FieldKey.cpp
+      opm/common/data/FieldLayout.cpp
+      opm/common/data/FieldRegistry.cpp
+      opm/common/data/FieldStatistics.cpp
+      opm/common/data/FieldTable.cpp
+      opm/common/data/FieldType.cpp
+      opm/common/data/FirstTouch.cpp
+      opm/common/data/HaloExchanger.cpp
+      opm/common/data/MappedStorage.cpp
+      opm/common/data/MemoryResource.cpp
+      opm/common/data/RegionAggregation.cpp
       opm/common/data/SimulationDataContainer.cpp
+      opm/common/data/SnapshotSlot.cpp
+      opm/common/data/SparseField.cpp
       opm/common/OpmLog/CounterLog.cpp
       opm/common/OpmLog/EclipsePRTLog.cpp
       opm/common/OpmLog/LogBackend.cpp
@@ -35,6 +54,7 @@ list (APPEND MAIN_SOURCE_FILES
 list (APPEND TEST_SOURCE_FILES
       tests/test_SimulationDataContainer.cpp
       tests/test_cmp.cpp
+      tests/test_FieldCompressor.cpp
       tests/test_OpmLog.cpp
       tests/test_messagelimiter.cpp
       )
@@ -43,6 +63,14 @@ list (APPEND TEST_DATA_FILES
 	)
 
 list (APPEND EXAMPLE_SOURCE_FILES
+      examples/benchmark_checkpoint.cpp
+      examples/benchmark_compression.cpp
+      examples/benchmark_expression.cpp
+      examples/benchmark_first_touch.cpp
+      examples/benchmark_layout.cpp
+      examples/benchmark_memory_resource.cpp
+      examples/benchmark_rebalance.cpp
+      examples/benchmark_registry.cpp
 	)
 
 # programs listed here will not only be compiled, but also marked for
@@ -54,7 +82,31 @@ list (APPEND PROGRAM_SOURCE_FILES
 list( APPEND PUBLIC_HEADER_FILES
       opm/common/ErrorMacros.hpp
       opm/common/Exceptions.hpp
+      opm/common/data/AlignedBuffer.hpp
+      opm/common/data/CellPartition.hpp
+      opm/common/data/DeltaCheckpoint.hpp
+      opm/common/data/FieldBits.hpp
+      opm/common/data/FieldComparison.hpp
+      opm/common/data/FieldCompressor.hpp
+      opm/common/data/FieldExpression.hpp
+      opm/common/data/FieldId.hpp
+      opm/common/data/FieldKey.hpp
+      opm/common/data/FieldLayout.hpp
+      opm/common/data/FieldRegistry.hpp
+      opm/common/data/FieldStatistics.hpp
+      opm/common/data/FieldTable.hpp
+      opm/common/data/FieldType.hpp
+      opm/common/data/FieldView.hpp
+      opm/common/data/FirstTouch.hpp
+      opm/common/data/HaloExchanger.hpp
+      opm/common/data/MappedStorage.hpp
+      opm/common/data/MemoryResource.hpp
+      opm/common/data/RegionAggregation.hpp
+      opm/common/data/SegmentedArray.hpp
       opm/common/data/SimulationDataContainer.hpp
+      opm/common/data/SnapshotSlot.hpp
+      opm/common/data/SparseField.hpp
+      opm/common/data/StridedView.hpp
       opm/common/OpmLog/CounterLog.hpp
       opm/common/OpmLog/EclipsePRTLog.hpp
       opm/common/OpmLog/LogBackend.hpp
@@ -0,0 +1,71 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Measures the throughput of SimulationDataContainer::save() and
+// load(). Usage: benchmark_checkpoint [num_cells] [path]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+namespace {
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_cells = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 10000000;
+  const std::string path = argc > 2 ? argv[2] : "benchmark_checkpoint.bin";
+
+  Opm::SimulationDataContainer container(num_cells, num_cells * 3,
+                                         Opm::FieldStorage::Vector);
+  container.registerCellData("PRESSURE", 1, 200.0);
+  container.registerCellData("SATURATION", 3, 0.25);
+  container.registerCellData("TEMPERATURE", 1, 293.15);
+  container.registerFaceData("FACEFLUX", 1, 1.0);
+  const double bytes = 8.0 * sizeof(double) * num_cells;
+
+  auto start = std::chrono::steady_clock::now();
+  container.save(path);
+  const double save_time = seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  Opm::SimulationDataContainer loaded(0, 0, Opm::FieldStorage::Vector);
+  loaded.load(path);
+  const double load_time = seconds(start);
+
+  // Touch every page so the load is measured including the reads.
+  start = std::chrono::steady_clock::now();
+  const bool equal = loaded.equal(container);
+  const double compare_time = seconds(start);
+
+  std::cout << "payload:       " << bytes / 1e9 << " GB\n"
+            << "save:          " << bytes / 1e9 / save_time << " GB/s\n"
+            << "load (map):    " << load_time * 1e3 << " ms\n"
+            << "load + read:   " << bytes / 1e9 / (load_time + compare_time)
+            << " GB/s\n";
+  std::remove(path.c_str());
+  return equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
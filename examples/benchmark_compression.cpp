@@ -0,0 +1,79 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Measures the compression ratio and throughput of FieldCompressor on
+// synthetic fields. Usage: benchmark_compression [num_cells]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opm/common/data/FieldCompressor.hpp>
+
+namespace {
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+bool run(const std::string& name, const std::vector<double>& values,
+         size_t stride) {
+  const double bytes = values.size() * sizeof(double);
+  auto start = std::chrono::steady_clock::now();
+  const std::vector<char> compressed =
+    Opm::FieldCompressor::compress(values, stride);
+  const double compress_time = seconds(start);
+
+  std::vector<double> restored(values.size());
+  start = std::chrono::steady_clock::now();
+  Opm::FieldCompressor::decompress(compressed.data(), compressed.size(),
+                                   restored.data(), restored.size());
+  const double decompress_time = seconds(start);
+
+  std::cout << name << ": ratio " << bytes / compressed.size()
+            << ", compress " << bytes / 1e9 / compress_time << " GB/s"
+            << ", decompress " << bytes / 1e9 / decompress_time << " GB/s\n";
+  return std::memcmp(values.data(), restored.data(), bytes) == 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_cells = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 10000000;
+
+  std::vector<double> pressure(num_cells);
+  std::vector<double> saturation(3 * num_cells);
+  std::vector<double> temperature(num_cells, 293.15);
+  for (size_t cell = 0; cell < num_cells; ++cell) {
+    pressure[cell] = 2e7 + 1e5 * std::sin(cell * 1e-5);
+    const double water = (cell / 5000) % 3 == 0 ? 0.2 : 0.2 + 1e-6 * cell;
+    saturation[3 * cell] = std::min(water, 0.8);
+    saturation[3 * cell + 1] = 0.1;
+    saturation[3 * cell + 2] = 0.9 - saturation[3 * cell];
+  }
+
+  bool ok = run("PRESSURE   ", pressure, 1);
+  ok = run("SATURATION ", saturation, 3) && ok;
+  ok = run("TEMPERATURE", temperature, 1) && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
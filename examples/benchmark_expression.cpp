@@ -0,0 +1,116 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+// Measures a = p * s0 + t / c over cell vectors, once step by step with
+// a temporary vector per operation and once as a fused expression
+// (FieldExpression.hpp), and the sum of the same expression.
+// Usage: benchmark_expression [num_cells]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+namespace {
+const int repetitions = 10;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<double> multiply(const std::vector<double>& a,
+                             const std::vector<double>& b) {
+  std::vector<double> result(a.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    result[i] = a[i] * b[i];
+  }
+  return result;
+}
+
+std::vector<double> divide(const std::vector<double>& a,
+                           const std::vector<double>& b) {
+  std::vector<double> result(a.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    result[i] = a[i] / b[i];
+  }
+  return result;
+}
+
+std::vector<double> add(const std::vector<double>& a,
+                        const std::vector<double>& b) {
+  std::vector<double> result(a.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    result[i] = a[i] + b[i];
+  }
+  return result;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_cells = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 10000000;
+  Opm::SimulationDataContainer container(num_cells, 0,
+                                         Opm::FieldStorage::Vector);
+  container.registerCellData("P", 1, 2.0e7);
+  container.registerCellData("S", 2, 0.5);
+  container.registerCellData("T", 1, 300.0);
+  container.registerCellData("C", 1, 4.0);
+  const Opm::CellFieldId a = container.registerCellData("A", 1);
+  const Opm::SimulationDataContainer& data = container;
+  const auto p = data.cellComponentView("P", 0);
+  const auto s0 = data.cellComponentView("S", 0);
+  const auto t = data.cellComponentView("T", 0);
+  const auto c = data.cellComponentView("C", 0);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+    std::vector<double> pv(num_cells), s0v(num_cells), tv(num_cells),
+        cv(num_cells);
+    p.copyTo(pv.data());
+    s0.copyTo(s0v.data());
+    t.copyTo(tv.data());
+    c.copyTo(cv.data());
+    const std::vector<double> result = add(multiply(pv, s0v),
+                                           divide(tv, cv));
+    container.cellComponentView(a, 0).assign(result.data());
+  }
+  const double step_time = seconds(start) / repetitions;
+
+  start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+    container.evaluateCellData(a, 0, p * s0 + t / c);
+  }
+  const double fused_time = seconds(start) / repetitions;
+
+  double sum = 0.0;
+  start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+    sum += Opm::evaluateStatistics(p * s0 + t / c).sum;
+  }
+  const double reduce_time = seconds(start) / repetitions;
+
+  const double bytes = 5.0 * num_cells * sizeof(double);
+  std::cout << "step by step " << bytes / 1e9 / step_time << " GB/s, fused "
+            << bytes / 1e9 / fused_time << " GB/s ("
+            << step_time / fused_time << "x), fused sum "
+            << 4 * bytes / 5 / 1e9 / reduce_time << " GB/s (" << sum
+            << ")\n";
+  return EXIT_SUCCESS;
+}
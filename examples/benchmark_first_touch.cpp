@@ -0,0 +1,101 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+// Measures a bandwidth bound triad over fields initialized serially and
+// by the OpenMP threads (FirstTouch::Parallel), for fresh fields and for
+// the duplicates made when a copy of the container is written; vector
+// storage, whose fields are std::vector<double>, is the baseline. On a
+// multi-socket machine run it with OMP_PROC_BIND=close and OMP_PLACES=cores.
+// Usage: benchmark_first_touch [num_cells]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+namespace {
+const size_t components = 3;
+const int repetitions = 10;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+// a = b + s * c with the same static schedule as the initialization.
+double triad(Opm::SimulationDataContainer& container, Opm::CellFieldId a,
+             Opm::CellFieldId b, Opm::CellFieldId c) {
+  double* av = container.cellView(a).data();
+  const double* bv = container.cellView(b).data();
+  const double* cv = container.cellView(c).data();
+  const long size = static_cast<long>(container.numCells() * components);
+  auto start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (long i = 0; i < size; ++i) {
+      av[i] = bv[i] + 0.5 * cv[i];
+    }
+  }
+  return seconds(start) / repetitions;
+}
+
+void run(const std::string& name, Opm::FieldStorage storage,
+         Opm::FirstTouch touch, size_t num_cells) {
+  const double field_bytes = num_cells * components * sizeof(double);
+  Opm::SimulationDataContainer container(num_cells, 0, storage);
+  container.setFirstTouch(touch);
+
+  auto start = std::chrono::steady_clock::now();
+  Opm::CellFieldId a = container.registerCellData("A", components, 0.0);
+  Opm::CellFieldId b = container.registerCellData("B", components, 1.0);
+  Opm::CellFieldId c = container.registerCellData("C", components, 2.0);
+  const double register_time = seconds(start);
+  const double fresh_time = triad(container, a, b, c);
+
+  // The copy shares the buffers until the triad writes them.
+  Opm::SimulationDataContainer copy(container);
+  start = std::chrono::steady_clock::now();
+  copy.cellView(a);
+  copy.cellView(b);
+  copy.cellView(c);
+  const double duplicate_time = seconds(start);
+  const double copy_time = triad(copy, a, b, c);
+
+  std::cout << name << ": register " << 3 * field_bytes / 1e9 / register_time
+            << " GB/s, triad " << 3 * field_bytes / 1e9 / fresh_time
+            << " GB/s, duplicate "
+            << 6 * field_bytes / 1e9 / duplicate_time
+            << " GB/s, triad on copy " << 3 * field_bytes / 1e9 / copy_time
+            << " GB/s\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_cells = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 10000000;
+  run("vector serial  ", Opm::FieldStorage::Vector, Opm::FirstTouch::Serial,
+      num_cells);
+  run("arena serial   ", Opm::FieldStorage::Arena, Opm::FirstTouch::Serial,
+      num_cells);
+  run("arena parallel ", Opm::FieldStorage::Arena, Opm::FirstTouch::Parallel,
+      num_cells);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+// Measures bandwidth bound kernels on component views for every field
+// layout, and the throughput of changing layouts.
+// Usage: benchmark_layout [num_cells]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+namespace {
+const size_t components = 3;
+const int repetitions = 5;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+void run(const std::string& name, const Opm::FieldLayout& layout,
+         size_t num_cells) {
+  Opm::SimulationDataContainer container(num_cells, 0,
+                                         Opm::FieldStorage::Vector);
+  Opm::CellFieldId x = container.registerCellData("X", components, 1.0);
+  Opm::CellFieldId y = container.registerCellData("Y", components, 2.0);
+  const double field_bytes = num_cells * components * sizeof(double);
+
+  auto start = std::chrono::steady_clock::now();
+  container.relayoutCellData(x, layout);
+  container.relayoutCellData(y, layout);
+  const double relayout_time = seconds(start);
+
+  // All components: y += a * x reads two fields and writes one.
+  start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+    for (size_t component = 0; component < components; ++component) {
+      container.cellComponentView(y, component)
+        .axpy(0.5, container.cellComponentView(x, component));
+    }
+  }
+  const double all_time = seconds(start) / repetitions;
+
+  // One component only, where the layout decides how much of the
+  // fetched cache lines is used.
+  start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+    container.cellComponentView(y, 0)
+      .axpy(0.5, container.cellComponentView(x, 0));
+  }
+  const double one_time = seconds(start) / repetitions;
+
+  std::cout << name << ": relayout ";
+  if (layout == Opm::FieldLayout::interleaved()) {
+    std::cout << "-";
+  } else {
+    std::cout << 2 * field_bytes / 1e9 / relayout_time << " GB/s";
+  }
+  std::cout << ", axpy all components "
+            << 3 * field_bytes / 1e9 / all_time
+            << " GB/s, axpy one component "
+            << 3 * field_bytes / components / 1e9 / one_time << " GB/s\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_cells = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 10000000;
+  run("interleaved", Opm::FieldLayout::interleaved(), num_cells);
+  run("planar     ", Opm::FieldLayout::planar(), num_cells);
+  run("aosoa 8    ", Opm::FieldLayout::aosoa(8), num_cells);
+  run("aosoa 16   ", Opm::FieldLayout::aosoa(16), num_cells);
+  return EXIT_SUCCESS;
+}
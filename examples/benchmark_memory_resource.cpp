@@ -0,0 +1,106 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+// Measures field registration, a streaming axpy and a random gather,
+// which is bound by TLB misses on large fields, with the field buffers
+// allocated by posix_memalign(), on transparent huge pages and from a
+// monotonic pool on huge pages.
+// Usage: benchmark_memory_resource [num_cells]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+namespace {
+const int repetitions = 5;
+const size_t num_fields = 4;
+
+double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+void run(const std::string& name,
+         const std::shared_ptr<Opm::MemoryResource>& resource,
+         const std::vector<int32_t>& cells, size_t num_cells) {
+  const double field_bytes = num_cells * sizeof(double);
+  Opm::SimulationDataContainer container(num_cells, 0,
+                                         Opm::FieldStorage::Arena, resource);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<Opm::CellFieldId> ids;
+  for (size_t field = 0; field < num_fields; ++field) {
+    ids.push_back(container.registerCellData("F" + std::to_string(field),
+                                             1, 1.0));
+  }
+  const double register_time = seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+    for (size_t field = 1; field < num_fields; ++field) {
+      container.cellComponentView(ids[field], 0)
+        .axpy(0.5, container.cellComponentView(ids[0], 0));
+    }
+  }
+  const double axpy_time = seconds(start) / repetitions;
+
+  std::vector<double> values(cells.size());
+  start = std::chrono::steady_clock::now();
+  for (int rep = 0; rep < repetitions; ++rep) {
+    for (size_t field = 0; field < num_fields; ++field) {
+      container.gatherCellData(ids[field], 0, cells.data(), values.data(),
+                               cells.size(), Opm::IndexCheck::Unchecked);
+    }
+  }
+  const double gather_time = seconds(start) / repetitions;
+
+  std::cout << name << ": register "
+            << num_fields * field_bytes / 1e9 / register_time
+            << " GB/s, axpy "
+            << 3 * (num_fields - 1) * field_bytes / 1e9 / axpy_time
+            << " GB/s, random gather "
+            << num_fields * cells.size() / 1e6 / gather_time
+            << " M values/s\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_cells = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 20000000;
+  std::vector<int32_t> cells(num_cells / 4);
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int32_t> cell(
+    0, static_cast<int32_t>(num_cells) - 1);
+  for (auto& index : cells) {
+    index = cell(generator);
+  }
+
+  auto huge_pages = std::make_shared<Opm::HugePageResource>();
+  run("posix_memalign ", nullptr, cells, num_cells);
+  run("huge pages     ", huge_pages, cells, num_cells);
+  run("huge page pool ",
+      std::make_shared<Opm::MonotonicResource>(
+        num_fields * num_cells * sizeof(double) + 4096, huge_pages),
+      cells, num_cells);
+  return EXIT_SUCCESS;
+}
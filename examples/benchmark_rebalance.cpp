@@ -0,0 +1,136 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+// Measures moving half of the cells, in a shuffled order, out of a
+// container with seven cell fields of several types, layouts and
+// numbers of components: field by field with a scalar loop per
+// component, with extractCells(), and packed into one contiguous
+// message with packCells().
+// Usage: benchmark_rebalance [num_cells]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+namespace {
+const size_t repetitions = 10;
+
+template <typename F>
+double time(F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repetitions; ++i) {
+    f();
+  }
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+// The cells copied one value at a time through the component views.
+Opm::SimulationDataContainer extractScalar(
+    const Opm::SimulationDataContainer& container,
+    const std::vector<int32_t>& cells) {
+  Opm::SimulationDataContainer part(cells.size(), 0,
+                                    Opm::FieldStorage::Vector);
+  const size_t count = cells.size();
+  const struct {
+    const char* name;
+    size_t components;
+  } fields[] = { { "PRESSURE", 1 }, { "TEMPERATURE", 1 }, { "RS", 1 },
+                 { "SATURATION", 3 }, { "MOBILITY", 3 } };
+  for (const auto& field : fields) {
+    const char* name = field.name;
+    const size_t components = field.components;
+    const Opm::CellFieldId id = container.cellFieldId(name);
+    const Opm::CellFieldId target = part.registerCellData(
+      name, components, 0.0, container.cellLayout(id));
+    for (size_t component = 0; component < components; ++component) {
+      auto from = container.cellComponentView(id, component);
+      auto to = part.cellComponentView(target, component);
+      for (size_t i = 0; i < count; ++i) {
+        to[i] = from[cells[i]];
+      }
+    }
+  }
+  const Opm::CellFieldId velocity = container.cellFieldId("VELOCITY");
+  const Opm::CellFieldId velocity_target = part.registerCellData(
+    "VELOCITY", 3, 0.0, container.cellLayout(velocity),
+    Opm::FieldType::Float32);
+  for (size_t component = 0; component < 3; ++component) {
+    auto from = container.cellComponentView<float>(velocity, component);
+    auto to = part.cellComponentView<float>(velocity_target, component);
+    for (size_t i = 0; i < count; ++i) {
+      to[i] = from[cells[i]];
+    }
+  }
+  const Opm::CellFieldId region = container.cellFieldId("REGION");
+  const Opm::CellFieldId region_target = part.registerCellData(
+    "REGION", 1, 0.0, Opm::FieldLayout(), Opm::FieldType::Int32);
+  auto from = container.cellView<int32_t>(region);
+  auto to = part.cellView<int32_t>(region_target);
+  for (size_t i = 0; i < count; ++i) {
+    to[i] = from[cells[i]];
+  }
+  return part;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_cells = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                    : 1 << 22;
+  Opm::SimulationDataContainer container(num_cells, 0,
+                                         Opm::FieldStorage::Vector);
+  container.registerCellData("PRESSURE", 1, 2.0e7);
+  container.registerCellData("TEMPERATURE", 1, 350.0);
+  container.registerCellData("RS", 1, 100.0);
+  container.registerCellData("SATURATION", 3, 0.3);
+  container.registerCellData("MOBILITY", 3, 1.0,
+                             Opm::FieldLayout::planar());
+  container.registerCellData("VELOCITY", 3, 0.0,
+                             Opm::FieldLayout::aosoa(8),
+                             Opm::FieldType::Float32);
+  container.registerCellData("REGION", 1, 1.0, Opm::FieldLayout(),
+                             Opm::FieldType::Int32);
+
+  std::vector<int32_t> cells;
+  for (size_t cell = 0; cell < num_cells; cell += 2) {
+    cells.push_back(static_cast<int32_t>(cell));
+  }
+  std::shuffle(cells.begin(), cells.end(), std::mt19937(42));
+  std::vector<double> buffer(container.cellMessageBytes(cells.size())
+                             / sizeof(double));
+
+  const double scalar = time([&]() { extractScalar(container, cells); });
+  const double extract = time([&]() { container.extractCells(cells); });
+  const double pack = time([&]() {
+    container.packCells(cells, buffer.data());
+  });
+  const double bytes = static_cast<double>(buffer.size() * sizeof(double));
+  std::cout << cells.size() << " of " << num_cells << " cells, "
+            << bytes / 1e6 << " MB\n"
+            << "  field by field:  " << scalar * 1e3 << " ms\n"
+            << "  extractCells():  " << extract * 1e3 << " ms ("
+            << scalar / extract << "x)\n"
+            << "  packCells():     " << pack * 1e3 << " ms, "
+            << bytes / pack / 1e9 << " GB/s\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+// Measures lookups of existing cell fields by name while some threads
+// register scratch fields, at 1 to 64 threads: one in eight threads
+// registers, the others look up and read fields. The same is run with
+// a global mutex around every container call for comparison.
+// Usage: benchmark_registry [num_fields]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+namespace {
+const size_t lookups_per_thread = 1000000;
+
+double run(size_t num_threads, size_t num_fields, bool global_mutex) {
+  Opm::SimulationDataContainer container(16, 0, Opm::FieldStorage::Vector);
+  std::vector<std::string> names;
+  for (size_t field = 0; field < num_fields; ++field) {
+    names.push_back("FIELD_" + std::to_string(field));
+    container.registerCellData(names.back(), 1, field);
+  }
+
+  const Opm::SimulationDataContainer& data = container;
+  std::mutex mutex;
+  std::atomic<size_t> checksum(0);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t thread = 0; thread < num_threads; ++thread) {
+    threads.emplace_back([&, thread]() {
+      size_t sum = 0;
+      if (thread % 8 == 1) {
+        for (size_t field = 0; field < 1000; ++field) {
+          const std::string name = "SCRATCH_" + std::to_string(thread)
+                                   + "_" + std::to_string(field);
+          if (global_mutex) {
+            std::lock_guard<std::mutex> lock(mutex);
+            container.registerCellData(name, 1, 0.0);
+          } else {
+            container.registerCellData(name, 1, 0.0);
+          }
+        }
+      } else {
+        for (size_t i = 0; i < lookups_per_thread; ++i) {
+          const std::string& name = names[(i * 7 + thread) % num_fields];
+          if (global_mutex) {
+            std::lock_guard<std::mutex> lock(mutex);
+            sum += static_cast<size_t>(data.getCellData(name)[0]);
+          } else {
+            sum += static_cast<size_t>(data.getCellData(name)[0]);
+          }
+        }
+      }
+      checksum += sum;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  const size_t readers = num_threads - (num_threads + 6) / 8;
+  std::cout << num_threads << " threads"
+            << (global_mutex ? ", global mutex: " : ", lock-free: ")
+            << readers * lookups_per_thread / seconds / 1e6
+            << " million lookups/s (checksum " << checksum << ")\n";
+  return seconds;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_fields = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                     : 200;
+  for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    run(num_threads, num_fields, false);
+    run(num_threads, num_fields, true);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <cstring>
+#include <new>
+#include <utility>
+#include "opm/common/data/AlignedBuffer.hpp"
+
+namespace Opm {
+const size_t AlignedBuffer::alignment;
+
+AlignedBuffer::AlignedBuffer()
+    : m_data(nullptr),
+      m_size(0),
+      m_resource() {
+}
+
+AlignedBuffer::AlignedBuffer(size_t bytes)
+    : AlignedBuffer(bytes, std::shared_ptr<MemoryResource>()) {
+}
+
+AlignedBuffer::AlignedBuffer(size_t bytes,
+                             std::shared_ptr<MemoryResource> resource)
+    : m_data(nullptr),
+      m_size(bytes),
+      m_resource(resource) {
+  if (bytes == 0) {
+    return;
+  }
+  if (m_resource) {
+    m_data = m_resource->allocate(padded(bytes), alignment);
+  } else if (posix_memalign(&m_data, alignment, padded(bytes)) != 0) {
+    throw std::bad_alloc();
+  }
+}
+
+AlignedBuffer::AlignedBuffer(const AlignedBuffer& other)
+    : AlignedBuffer(other.m_size, other.m_resource) {
+  if (m_size > 0) {
+    std::memcpy(m_data, other.m_data, m_size);
+  }
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& other)
+    : m_data(other.m_data),
+      m_size(other.m_size),
+      m_resource(std::move(other.m_resource)) {
+  other.m_data = nullptr;
+  other.m_size = 0;
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer other) {
+  swap(other);
+  return *this;
+}
+
+AlignedBuffer::~AlignedBuffer() {
+  if (m_resource) {
+    if (m_data) {
+      m_resource->deallocate(m_data, padded(m_size), alignment);
+    }
+  } else {
+    free(m_data);
+  }
+}
+
+void AlignedBuffer::swap(AlignedBuffer& other) {
+  std::swap(m_data, other.m_data);
+  std::swap(m_size, other.m_size);
+  m_resource.swap(other.m_resource);
+}
+}  // namespace Opm
@@ -0,0 +1,92 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_ALIGNEDBUFFER_H_
+#define OPM_COMMON_DATA_ALIGNEDBUFFER_H_
+
+#include <cstddef>
+#include <memory>
+
+#include <opm/common/data/MemoryResource.hpp>
+
+namespace Opm {
+/**
+ * @class AlignedBuffer
+ * @brief An owning, uninitialized block of cache line aligned memory.
+ *
+ * The buffer does not initialize its content; callers are expected to
+ * write every byte they read. Without a MemoryResource the block comes
+ * from posix_memalign(); copies allocate from the resource of the
+ * buffer they copy.
+ */
+class AlignedBuffer {
+ public:
+  /**
+   * @brief Alignment in bytes of the start of every buffer.
+   */
+  static const size_t alignment = 64;
+
+  /**
+   * @brief Round @p bytes up to a multiple of the alignment.
+   */
+  static size_t padded(size_t bytes) {
+    return (bytes + alignment - 1) / alignment * alignment;
+  }
+
+  /**
+   * @brief Construct an empty buffer.
+   */
+  AlignedBuffer();
+
+  /**
+   * @brief Allocate an uninitialized buffer of @p bytes bytes.
+   */
+  explicit AlignedBuffer(size_t bytes);
+
+  /**
+   * @brief Allocate an uninitialized buffer of @p bytes bytes from
+   *        @p resource, or with posix_memalign() if it is null.
+   */
+  AlignedBuffer(size_t bytes, std::shared_ptr<MemoryResource> resource);
+
+  /**
+   * @brief Deep copy of the whole buffer.
+   */
+  AlignedBuffer(const AlignedBuffer& other);
+
+  AlignedBuffer(AlignedBuffer&& other);
+  AlignedBuffer& operator=(AlignedBuffer other);
+  ~AlignedBuffer();
+
+  void swap(AlignedBuffer& other);
+
+  void* data() { return m_data; }
+  const void* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  const std::shared_ptr<MemoryResource>& resource() const {
+    return m_resource;
+  }
+
+ private:
+  void* m_data;  //!< start of the block, aligned to alignment bytes
+  size_t m_size;  //!< size of the block in bytes
+  std::shared_ptr<MemoryResource> m_resource;  //!< null: posix_memalign()
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_ALIGNEDBUFFER_H_
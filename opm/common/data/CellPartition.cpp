@@ -0,0 +1,499 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/CellPartition.hpp"
+#include "opm/common/data/FieldBits.hpp"
+
+namespace Opm {
+namespace {
+// Lists of fewer cells are packed and copied by one thread.
+const size_t parallel_cells = 1 << 14;
+
+// Bytes of one field in a message; fields start on 8 byte boundaries.
+size_t fieldBytes(const FieldTable& table, size_t index, size_t num_cells) {
+  const size_t bytes = storageBytes(table.type(index),
+                                    num_cells * table.components(index));
+  return (bytes + 7) / 8 * 8;
+}
+
+// Call f(base, stride, block, component) with the position of every
+// component of a field, as in a StridedView.
+template <typename F>
+void forEachComponent(const FieldTable& table, size_t index, F f) {
+  const FieldLayout& layout = table.layout(index);
+  const size_t num_entities = table.numEntities();
+  const size_t components = table.components(index);
+  for (size_t component = 0; component < components; ++component) {
+    f(layout.componentOffset(component, num_entities),
+      layout.componentStride(num_entities, components),
+      layout.componentBlock(num_entities), component);
+  }
+}
+
+// The three loops are the plain stride of the interleaved layout, the
+// contiguous planar layout and the blocks of AoSoA.
+template <typename T>
+void packValues(const FieldTable& table, size_t index,
+                const std::vector<int32_t>& cells, T* message) {
+  const T* values = table.typedData<T>(index);
+  const size_t count = cells.size();
+  const size_t num_entities = table.numEntities();
+  forEachComponent(table, index, [&](size_t offset, size_t stride,
+                                     size_t block, size_t component) {
+    const T* base = values + offset;
+    T* target = message + component * count;
+    if (block == 1) {
+#pragma omp parallel for schedule(static) if (count >= parallel_cells)
+      for (size_t i = 0; i < count; ++i) {
+        target[i] = base[static_cast<size_t>(cells[i]) * stride];
+      }
+    } else if (block >= num_entities) {
+#pragma omp parallel for schedule(static) if (count >= parallel_cells)
+      for (size_t i = 0; i < count; ++i) {
+        target[i] = base[cells[i]];
+      }
+    } else {
+#pragma omp parallel for schedule(static) if (count >= parallel_cells)
+      for (size_t i = 0; i < count; ++i) {
+        const size_t cell = static_cast<size_t>(cells[i]);
+        target[i] = base[cell / block * stride + cell % block];
+      }
+    }
+  });
+}
+
+template <typename T>
+void unpackValues(FieldTable& table, size_t index,
+                  const std::vector<int32_t>& cells, const T* message) {
+  T* values = table.typedData<T>(index);
+  const size_t count = cells.size();
+  const size_t num_entities = table.numEntities();
+  forEachComponent(table, index, [&](size_t offset, size_t stride,
+                                     size_t block, size_t component) {
+    T* base = values + offset;
+    const T* source = message + component * count;
+    if (block == 1) {
+#pragma omp parallel for schedule(static) if (count >= parallel_cells)
+      for (size_t i = 0; i < count; ++i) {
+        base[static_cast<size_t>(cells[i]) * stride] = source[i];
+      }
+    } else if (block >= num_entities) {
+#pragma omp parallel for schedule(static) if (count >= parallel_cells)
+      for (size_t i = 0; i < count; ++i) {
+        base[cells[i]] = source[i];
+      }
+    } else {
+#pragma omp parallel for schedule(static) if (count >= parallel_cells)
+      for (size_t i = 0; i < count; ++i) {
+        const size_t cell = static_cast<size_t>(cells[i]);
+        base[cell / block * stride + cell % block] = source[i];
+      }
+    }
+  });
+}
+
+// Bit fields are interleaved, so value k of a cell is bit
+// cell * components + k.
+void packBits(const FieldTable& table, size_t index,
+              const std::vector<int32_t>& cells, FieldBits::Word* message) {
+  const size_t count = cells.size();
+  const size_t components = table.components(index);
+  const BitView<const FieldBits::Word> bits(table.words(index),
+                                            table.count(index));
+  const BitView<FieldBits::Word> target(message, count * components);
+  target.fill(false);
+  for (size_t component = 0; component < components; ++component) {
+    for (size_t i = 0; i < count; ++i) {
+      if (bits[static_cast<size_t>(cells[i]) * components + component]) {
+        target.set(component * count + i);
+      }
+    }
+  }
+}
+
+void unpackBits(FieldTable& table, size_t index,
+                const std::vector<int32_t>& cells,
+                const FieldBits::Word* message) {
+  const size_t count = cells.size();
+  const size_t components = table.components(index);
+  const BitView<FieldBits::Word> bits(table.words(index), table.count(index));
+  const BitView<const FieldBits::Word> source(message, count * components);
+  for (size_t component = 0; component < components; ++component) {
+    for (size_t i = 0; i < count; ++i) {
+      bits.set(static_cast<size_t>(cells[i]) * components + component,
+               source[component * count + i]);
+    }
+  }
+}
+
+// Position of value (cell, component) of a field, through its layout.
+class CellIndex {
+ public:
+  CellIndex(const FieldTable& table, size_t index)
+      : m_num_entities(table.numEntities()),
+        m_stride(table.layout(index).componentStride(
+                   m_num_entities, table.components(index))),
+        m_block(table.layout(index).componentBlock(m_num_entities)),
+        m_offsets() {
+    for (size_t component = 0; component < table.components(index);
+         ++component) {
+      m_offsets.push_back(
+        table.layout(index).componentOffset(component, m_num_entities));
+    }
+  }
+
+  size_t operator()(size_t cell, size_t component) const {
+    if (m_block == 1) {
+      return m_offsets[component] + cell * m_stride;
+    } else if (m_block >= m_num_entities) {
+      return m_offsets[component] + cell;
+    }
+    return m_offsets[component] + cell / m_block * m_stride
+           + cell % m_block;
+  }
+
+ private:
+  size_t m_num_entities;
+  size_t m_stride;
+  size_t m_block;
+  std::vector<size_t> m_offsets;
+};
+
+// Cell i of a copy: cells[i], or i for an empty list.
+inline size_t cellOf(const std::vector<int32_t>& cells, size_t i) {
+  return cells.empty() ? i : static_cast<size_t>(cells[i]);
+}
+
+// All components of a cell are copied together, which for the
+// interleaved layout moves whole cells.
+template <typename T>
+void copyValues(const FieldTable& from, size_t from_index,
+                const std::vector<int32_t>& from_cells, FieldTable& to,
+                size_t to_index, const std::vector<int32_t>& to_cells,
+                size_t count) {
+  const T* source = from.typedData<T>(from_index);
+  T* target = to.typedData<T>(to_index);
+  const CellIndex from_position(from, from_index);
+  const CellIndex to_position(to, to_index);
+  const size_t components = from.components(from_index);
+#pragma omp parallel for schedule(static) if (count >= parallel_cells)
+  for (size_t i = 0; i < count; ++i) {
+    const size_t from_cell = cellOf(from_cells, i);
+    const size_t to_cell = cellOf(to_cells, i);
+    for (size_t component = 0; component < components; ++component) {
+      target[to_position(to_cell, component)] =
+        source[from_position(from_cell, component)];
+    }
+  }
+}
+
+// Neighbouring cells share words, so bits are copied by one thread.
+void copyBits(const FieldTable& from, size_t from_index,
+              const std::vector<int32_t>& from_cells, FieldTable& to,
+              size_t to_index, const std::vector<int32_t>& to_cells,
+              size_t count) {
+  const size_t components = from.components(from_index);
+  const BitView<const FieldBits::Word> source(from.words(from_index),
+                                              from.count(from_index));
+  const BitView<FieldBits::Word> target(to.words(to_index),
+                                        to.count(to_index));
+  for (size_t i = 0; i < count; ++i) {
+    const size_t from_cell = cellOf(from_cells, i);
+    const size_t to_cell = cellOf(to_cells, i);
+    for (size_t component = 0; component < components; ++component) {
+      target.set(to_cell * components + component,
+                 source[from_cell * components + component]);
+    }
+  }
+}
+}  // namespace
+
+CellPartition::CellPartition(size_t num_cells)
+    : m_num_cells(num_cells), m_num_owned(num_cells), m_neighbors() {
+}
+
+CellPartition::CellPartition(size_t num_cells, size_t num_owned,
+                             std::vector<Neighbor> neighbors)
+    : m_num_cells(num_cells),
+      m_num_owned(num_owned),
+      m_neighbors(std::move(neighbors)) {
+  if (num_owned > num_cells ||
+      num_cells > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    OPM_THROW(std::invalid_argument, "Invalid partition of " << num_cells
+              << " cells with " << num_owned << " owned cells");
+  }
+  for (size_t i = 0; i < m_neighbors.size(); ++i) {
+    const Neighbor& neighbor = m_neighbors[i];
+    if (i > 0 && neighbor.rank <= m_neighbors[i - 1].rank) {
+      OPM_THROW(std::invalid_argument,
+                "The neighbours are not sorted by rank");
+    }
+    for (int32_t cell : neighbor.send) {
+      if (cell < 0 || static_cast<size_t>(cell) >= num_owned) {
+        OPM_THROW(std::invalid_argument, "Cell " << cell << " sent to rank "
+                  << neighbor.rank << " is not owned");
+      }
+    }
+    for (int32_t cell : neighbor.receive) {
+      if (cell < 0 || static_cast<size_t>(cell) < num_owned ||
+          static_cast<size_t>(cell) >= num_cells) {
+        OPM_THROW(std::invalid_argument, "Cell " << cell
+                  << " received from rank " << neighbor.rank
+                  << " is not a ghost cell");
+      }
+    }
+  }
+}
+
+CellPartition CellPartition::build(const std::vector<int>& owners,
+                                   const std::vector<int64_t>& global_ids,
+                                   HaloExchanger& exchanger) {
+  const int rank = exchanger.rank();
+  const size_t size = static_cast<size_t>(exchanger.size());
+  const size_t num_cells = owners.size();
+  if (global_ids.size() != num_cells) {
+    OPM_THROW(std::invalid_argument,
+              "size mismatch between owners and global ids");
+  }
+  size_t num_owned = 0;
+  while (num_owned < num_cells && owners[num_owned] == rank) {
+    ++num_owned;
+  }
+
+  // Ghosts by owner, in global id order so that both ranks agree.
+  std::vector<std::vector<int32_t>> receive(size);
+  for (size_t cell = num_owned; cell < num_cells; ++cell) {
+    const int owner = owners[cell];
+    if (owner == rank || owner < 0 || static_cast<size_t>(owner) >= size) {
+      OPM_THROW(std::invalid_argument, "Cell " << cell << " has owner "
+                << owner << "; owned cells must come before the ghosts");
+    }
+    receive[owner].push_back(static_cast<int32_t>(cell));
+  }
+  std::vector<std::vector<int64_t>> wanted_ids(size);
+  for (size_t other = 0; other < size; ++other) {
+    std::sort(receive[other].begin(), receive[other].end(),
+              [&](int32_t lhs, int32_t rhs) {
+                return global_ids[lhs] < global_ids[rhs];
+              });
+    for (int32_t cell : receive[other]) {
+      wanted_ids[other].push_back(global_ids[cell]);
+    }
+  }
+
+  // Every rank learns how many of its cells the others need, and then
+  // which ones.
+  std::vector<uint64_t> wanted(size), requested(size);
+  std::vector<HaloSend> sends;
+  std::vector<HaloReceive> receives;
+  for (size_t other = 0; other < size; ++other) {
+    if (static_cast<int>(other) != rank) {
+      wanted[other] = wanted_ids[other].size();
+      sends.push_back(HaloSend { static_cast<int>(other), &wanted[other],
+                                 sizeof(uint64_t) });
+      receives.push_back(HaloReceive { static_cast<int>(other),
+                                       &requested[other],
+                                       sizeof(uint64_t) });
+    }
+  }
+  exchanger.exchange(sends, receives);
+  std::vector<std::vector<int64_t>> requested_ids(size);
+  sends.clear();
+  receives.clear();
+  for (size_t other = 0; other < size; ++other) {
+    if (wanted[other] > 0) {
+      sends.push_back(HaloSend { static_cast<int>(other),
+                                 wanted_ids[other].data(),
+                                 wanted[other] * sizeof(int64_t) });
+    }
+    if (requested[other] > 0) {
+      requested_ids[other].resize(requested[other]);
+      receives.push_back(HaloReceive { static_cast<int>(other),
+                                       requested_ids[other].data(),
+                                       requested[other] * sizeof(int64_t) });
+    }
+  }
+  exchanger.exchange(sends, receives);
+
+  std::vector<std::pair<int64_t, int32_t>> owned_ids(num_owned);
+  for (size_t cell = 0; cell < num_owned; ++cell) {
+    owned_ids[cell] = std::make_pair(global_ids[cell],
+                                     static_cast<int32_t>(cell));
+  }
+  std::sort(owned_ids.begin(), owned_ids.end());
+  std::vector<Neighbor> neighbors;
+  for (size_t other = 0; other < size; ++other) {
+    if (receive[other].empty() && requested_ids[other].empty()) {
+      continue;
+    }
+    Neighbor neighbor = { static_cast<int>(other), std::vector<int32_t>(),
+                          std::move(receive[other]) };
+    for (int64_t id : requested_ids[other]) {
+      auto pos = std::lower_bound(owned_ids.begin(), owned_ids.end(),
+                                  std::make_pair(id, int32_t(0)));
+      if (pos == owned_ids.end() || pos->first != id) {
+        OPM_THROW(std::runtime_error, "Rank " << other << " requested cell "
+                  << id << " which rank " << rank << " does not own");
+      }
+      neighbor.send.push_back(pos->second);
+    }
+    neighbors.push_back(std::move(neighbor));
+  }
+  return CellPartition(num_cells, num_owned, std::move(neighbors));
+}
+
+namespace HaloPacking {
+size_t messageBytes(const FieldTable& table,
+                    const std::vector<size_t>& fields, size_t num_cells) {
+  size_t bytes = 0;
+  for (size_t index : fields) {
+    bytes += fieldBytes(table, index, num_cells);
+  }
+  return bytes;
+}
+
+void pack(const FieldTable& table, const std::vector<size_t>& fields,
+          const std::vector<int32_t>& cells, void* buffer) {
+  char* message = static_cast<char*>(buffer);
+  for (size_t index : fields) {
+    switch (table.type(index)) {
+      case FieldType::Float64:
+        packValues(table, index, cells, reinterpret_cast<double*>(message));
+        break;
+      case FieldType::Float32:
+        packValues(table, index, cells, reinterpret_cast<float*>(message));
+        break;
+      case FieldType::Int32:
+        packValues(table, index, cells, reinterpret_cast<int32_t*>(message));
+        break;
+      case FieldType::Int16:
+        packValues(table, index, cells, reinterpret_cast<int16_t*>(message));
+        break;
+      case FieldType::UInt8:
+        packValues(table, index, cells, reinterpret_cast<uint8_t*>(message));
+        break;
+      case FieldType::Bit:
+        packBits(table, index, cells,
+                 reinterpret_cast<FieldBits::Word*>(message));
+        break;
+    }
+    message += fieldBytes(table, index, cells.size());
+  }
+}
+
+void unpack(FieldTable& table, const std::vector<size_t>& fields,
+            const std::vector<int32_t>& cells, const void* buffer) {
+  if (cells.empty()) {
+    return;
+  }
+  const auto range = std::minmax_element(cells.begin(), cells.end());
+  const size_t first = static_cast<size_t>(*range.first);
+  const size_t last = static_cast<size_t>(*range.second);
+  const char* message = static_cast<const char*>(buffer);
+  for (size_t index : fields) {
+    switch (table.type(index)) {
+      case FieldType::Float64:
+        unpackValues(table, index, cells,
+                     reinterpret_cast<const double*>(message));
+        break;
+      case FieldType::Float32:
+        unpackValues(table, index, cells,
+                     reinterpret_cast<const float*>(message));
+        break;
+      case FieldType::Int32:
+        unpackValues(table, index, cells,
+                     reinterpret_cast<const int32_t*>(message));
+        break;
+      case FieldType::Int16:
+        unpackValues(table, index, cells,
+                     reinterpret_cast<const int16_t*>(message));
+        break;
+      case FieldType::UInt8:
+        unpackValues(table, index, cells,
+                     reinterpret_cast<const uint8_t*>(message));
+        break;
+      case FieldType::Bit:
+        unpackBits(table, index, cells,
+                   reinterpret_cast<const FieldBits::Word*>(message));
+        break;
+    }
+    // Only the values between the first and the last cell changed.
+    const FieldLayout& layout = table.layout(index);
+    const size_t components = table.components(index);
+    for (size_t component = 0; component < components; ++component) {
+      table.markDirty(index,
+                      layout.index(first, component, table.numEntities(),
+                                   components),
+                      layout.index(last, component, table.numEntities(),
+                                   components) + 1);
+    }
+    message += fieldBytes(table, index, cells.size());
+  }
+}
+
+void copy(const FieldTable& from, size_t from_index,
+          const std::vector<int32_t>& from_cells, FieldTable& to,
+          size_t to_index, const std::vector<int32_t>& to_cells,
+          size_t count) {
+  if (from.type(from_index) != to.type(to_index) ||
+      from.components(from_index) != to.components(to_index)) {
+    OPM_THROW(std::invalid_argument, "Cells are copied between fields "
+              "of different types or numbers of components");
+  }
+  if ((!from_cells.empty() && from_cells.size() != count) ||
+      (!to_cells.empty() && to_cells.size() != count)) {
+    OPM_THROW(std::invalid_argument, "The cell lists of a copy differ "
+              "in size");
+  }
+  switch (from.type(from_index)) {
+    case FieldType::Float64:
+      copyValues<double>(from, from_index, from_cells, to, to_index,
+                         to_cells, count);
+      break;
+    case FieldType::Float32:
+      copyValues<float>(from, from_index, from_cells, to, to_index,
+                        to_cells, count);
+      break;
+    case FieldType::Int32:
+      copyValues<int32_t>(from, from_index, from_cells, to, to_index,
+                          to_cells, count);
+      break;
+    case FieldType::Int16:
+      copyValues<int16_t>(from, from_index, from_cells, to, to_index,
+                          to_cells, count);
+      break;
+    case FieldType::UInt8:
+      copyValues<uint8_t>(from, from_index, from_cells, to, to_index,
+                          to_cells, count);
+      break;
+    case FieldType::Bit:
+      copyBits(from, from_index, from_cells, to, to_index, to_cells, count);
+      break;
+  }
+  to.touch(to_index);
+}
+}  // namespace HaloPacking
+}  // namespace Opm
@@ -0,0 +1,141 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_CELLPARTITION_H_
+#define OPM_COMMON_DATA_CELLPARTITION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <opm/common/data/FieldTable.hpp>
+#include <opm/common/data/HaloExchanger.hpp>
+
+namespace Opm {
+/**
+ * @class CellPartition
+ * @brief The cells of one rank of a distributed run: the cells it
+ *        owns, followed by the ghost cells owned by other ranks.
+ *
+ * Cells [0, numOwned()) are owned and cells [numOwned(), numCells())
+ * are ghosts. For every neighbouring rank the partition holds the
+ * owned cells whose values the neighbour needs (send) and the ghost
+ * cells whose values come from it (receive); the send list of one rank
+ * and the receive list of the other hold the same cells in the same
+ * order. A default partition owns all cells and has no neighbours.
+ */
+class CellPartition {
+ public:
+  struct Neighbor {
+    int rank;  //!< the neighbouring rank
+    std::vector<int32_t> send;  //!< owned cells it holds as ghosts
+    std::vector<int32_t> receive;  //!< ghost cells it owns
+  };
+
+  /**
+   * @brief A partition owning all @p num_cells cells.
+   */
+  explicit CellPartition(size_t num_cells = 0);
+
+  /**
+   * @brief A partition from precomputed lists.
+   *
+   * Send lists may only hold owned cells and receive lists only ghost
+   * cells, and the neighbours must be sorted by rank; otherwise
+   * std::invalid_argument is thrown.
+   */
+  CellPartition(size_t num_cells, size_t num_owned,
+                std::vector<Neighbor> neighbors);
+
+  /**
+   * @brief Compute the lists of this rank from the owners of its cells.
+   *
+   * Every rank calls build() with the same exchanger group: the ghost
+   * cells of a rank are requested from their owners by global id, in
+   * increasing global id order.
+   * @param owners the rank owning each local cell; the cells of this
+   *        rank must come first
+   * @param global_ids the global number of each local cell
+   * @param exchanger the transport, which gives the rank of the caller
+   */
+  static CellPartition build(const std::vector<int>& owners,
+                             const std::vector<int64_t>& global_ids,
+                             HaloExchanger& exchanger);
+
+  size_t numCells() const { return m_num_cells; }
+  size_t numOwned() const { return m_num_owned; }
+  size_t numGhosts() const { return m_num_cells - m_num_owned; }
+  bool owned(size_t cell) const { return cell < m_num_owned; }
+
+  const std::vector<Neighbor>& neighbors() const { return m_neighbors; }
+
+ private:
+  size_t m_num_cells;  //!< owned and ghost cells
+  size_t m_num_owned;  //!< owned cells, which come first
+  std::vector<Neighbor> m_neighbors;  //!< sorted by rank
+};
+
+/**
+ * @brief Kernels packing cell fields into halo messages, and copying
+ *        cells between tables when cells move between ranks.
+ *
+ * A message holds, field by field and component by component, the
+ * values of a list of cells in the scalar type of the field (Bit
+ * fields as packed words); every field starts on an 8 byte boundary.
+ * The cells are gathered through the layout of the field in loops the
+ * compiler vectorizes, and long lists are split over the OpenMP
+ * threads.
+ */
+namespace HaloPacking {
+/**
+ * @brief Size of the message holding @p fields of @p num_cells cells.
+ */
+size_t messageBytes(const FieldTable& table,
+                    const std::vector<size_t>& fields, size_t num_cells);
+
+/**
+ * @brief Copy the values of @p cells into @p buffer.
+ */
+void pack(const FieldTable& table, const std::vector<size_t>& fields,
+          const std::vector<int32_t>& cells, void* buffer);
+
+/**
+ * @brief Copy the values in @p buffer to @p cells and mark them dirty.
+ */
+void unpack(FieldTable& table, const std::vector<size_t>& fields,
+            const std::vector<int32_t>& cells, const void* buffer);
+
+/**
+ * @brief Copy cells of a field to a field of another table with the
+ *        same type and number of components, in one parallel pass over
+ *        the cells, and mark the target as dirty.
+ *
+ * Cell from_cells[i] of the source goes to cell to_cells[i] of the
+ * target; an empty list stands for the cells 0 to count - 1. The
+ * layouts of the fields may differ. The target cells must be
+ * distinct and, like the source cells, in range.
+ */
+void copy(const FieldTable& from, size_t from_index,
+          const std::vector<int32_t>& from_cells, FieldTable& to,
+          size_t to_index, const std::vector<int32_t>& to_cells,
+          size_t count);
+}  // namespace HaloPacking
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_CELLPARTITION_H_
@@ -0,0 +1,291 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/DeltaCheckpoint.hpp"
+
+namespace Opm {
+namespace {
+const char magic[8] = { 'O', 'P', 'M', 'S', 'D', 'C', 'D', '\0' };
+const uint32_t endian_mark = 0x01020304;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian;
+  uint64_t num_cells;
+  uint64_t num_faces;
+  uint64_t num_fields;
+};
+
+struct FieldHeader {
+  uint32_t entity;
+  uint32_t name_length;
+  uint64_t components;
+  uint64_t count;
+  uint64_t chunk_size;
+  uint64_t num_chunks;
+  // Added in version 2.
+  uint32_t layout;
+  uint32_t width;
+  // Added in version 3.
+  uint32_t type;
+  uint32_t reserved;
+};
+
+// Size of a field header in files of a given version.
+size_t fieldHeaderBytes(uint32_t version) {
+  switch (version) {
+    case 1:
+      return offsetof(FieldHeader, layout);
+    case 2:
+      return offsetof(FieldHeader, type);
+    default:
+      return sizeof(FieldHeader);
+  }
+}
+
+size_t paddedName(size_t length) {
+  return (length + 7) / 8 * 8;
+}
+
+// Calls f(begin, end) for the values of every run of adjacent chunks.
+// Bit fields are stored in whole words, and a word shared by two
+// adjacent chunks must be in the stream once, so the writer and the
+// reader both handle a run as one range.
+template <typename F>
+void forEachRun(const std::vector<uint64_t>& chunks, size_t chunk_size,
+                size_t count, F f) {
+  size_t first = 0;
+  while (first < chunks.size()) {
+    size_t last = first + 1;
+    while (last < chunks.size() && chunks[last] == chunks[last - 1] + 1) {
+      ++last;
+    }
+    const size_t begin = chunks[first] * chunk_size;
+    const size_t end = std::min<size_t>(chunks[last - 1] * chunk_size
+                                        + chunk_size, count);
+    f(begin, end);
+    first = last;
+  }
+}
+}  // namespace
+
+const uint32_t DeltaCheckpoint::format_version;
+
+void DeltaCheckpoint::write(const std::string& path, const FieldTable& cells,
+                            const FieldTable& faces) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    OPM_THROW(std::runtime_error, "Could not create " << path);
+  }
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = format_version;
+  header.endian = endian_mark;
+  header.num_cells = cells.numEntities();
+  header.num_faces = faces.numEntities();
+  header.num_fields = 0;
+  for (const FieldTable* fields : { &cells, &faces }) {
+    for (size_t index = 0; index < fields->size(); ++index) {
+      header.num_fields += fields->dirty(index) ? 1 : 0;
+    }
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  auto add = [&](const FieldTable& fields, MappedStorage::Entity entity) {
+    const size_t chunk_size = fields.chunkSize();
+    for (size_t index = 0; index < fields.size(); ++index) {
+      if (!fields.dirty(index)) {
+        continue;
+      }
+      const std::vector<size_t> chunks = fields.dirtyChunks(index);
+      const std::string& name = fields.name(index);
+      const size_t count = fields.count(index);
+      const FieldLayout& layout = fields.layout(index);
+      FieldHeader field = { static_cast<uint32_t>(entity),
+                            static_cast<uint32_t>(name.size()),
+                            fields.components(index), count, chunk_size,
+                            chunks.size(),
+                            static_cast<uint32_t>(layout.kind()),
+                            static_cast<uint32_t>(layout.width()),
+                            static_cast<uint32_t>(fields.type(index)), 0 };
+      out.write(reinterpret_cast<const char*>(&field), sizeof(field));
+      std::vector<char> padded_name(paddedName(name.size()), '\0');
+      std::copy(name.begin(), name.end(), padded_name.begin());
+      out.write(padded_name.data(), padded_name.size());
+      const std::vector<uint64_t> chunk_indices(chunks.begin(), chunks.end());
+      out.write(reinterpret_cast<const char*>(chunk_indices.data()),
+                chunk_indices.size() * sizeof(uint64_t));
+
+      // Adjacent dirty chunks are written with one call.
+      const char* data = static_cast<const char*>(fields.rawData(index));
+      const FieldType type = fields.type(index);
+      forEachRun(chunk_indices, chunk_size, count,
+                 [&](size_t begin, size_t end) {
+        const size_t offset = storageOffset(type, begin);
+        out.write(data + offset, storageBytes(type, end) - offset);
+      });
+    }
+  };
+  add(cells, MappedStorage::Entity::Cell);
+  add(faces, MappedStorage::Entity::Face);
+  out.close();
+  if (!out) {
+    OPM_THROW(std::runtime_error, "Could not write " << path);
+  }
+}
+
+void DeltaCheckpoint::apply(const std::string& path, FieldTable& cells,
+                            FieldTable& faces) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    OPM_THROW(std::runtime_error, "Could not open " << path);
+  }
+  auto read = [&](void* data, size_t bytes) {
+    if (!in.read(static_cast<char*>(data), bytes)) {
+      OPM_THROW(std::runtime_error, "Truncated delta checkpoint " << path);
+    }
+  };
+  Header header;
+  read(&header, sizeof(header));
+  if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+    OPM_THROW(std::runtime_error, path << " is not a delta checkpoint");
+  }
+  if (header.endian != endian_mark || header.version == 0 ||
+      header.version > format_version) {
+    OPM_THROW(std::runtime_error, "Unsupported delta checkpoint version "
+              << header.version);
+  }
+  if (header.num_cells != cells.numEntities() ||
+      header.num_faces != faces.numEntities()) {
+    OPM_THROW(std::invalid_argument, "The delta checkpoint " << path
+              << " does not match the number of cells and faces");
+  }
+
+  // The whole delta is read and checked before the tables change, so
+  // a delta which does not apply leaves them untouched.
+  struct Record {
+    FieldHeader field;
+    std::string name;
+    std::vector<uint64_t> chunks;
+    std::vector<char> values;
+  };
+  std::vector<Record> records;
+  for (uint64_t field_number = 0; field_number < header.num_fields;
+       ++field_number) {
+    records.push_back(Record());
+    Record& record = records.back();
+    FieldHeader& field = record.field;
+    field.layout = static_cast<uint32_t>(FieldLayout::Kind::Interleaved);
+    field.width = 1;
+    field.type = static_cast<uint32_t>(FieldType::Float64);
+    read(&field, fieldHeaderBytes(header.version));
+    if (field.entity > static_cast<uint32_t>(MappedStorage::Entity::Face) ||
+        field.chunk_size == 0) {
+      OPM_THROW(std::runtime_error, "Corrupt delta checkpoint " << path);
+    }
+    std::vector<char> padded_name(paddedName(field.name_length));
+    read(padded_name.data(), padded_name.size());
+    record.name.assign(padded_name.data(), field.name_length);
+    record.chunks.resize(field.num_chunks);
+    read(record.chunks.data(), record.chunks.size() * sizeof(uint64_t));
+    const std::vector<uint64_t>& chunks = record.chunks;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      if (chunks[i] >= (field.count + field.chunk_size - 1) / field.chunk_size
+          || (i > 0 && chunks[i] <= chunks[i - 1])) {
+        OPM_THROW(std::runtime_error, "Corrupt delta checkpoint " << path);
+      }
+    }
+    const FieldType type = fieldTypeFromValue(field.type);
+    size_t bytes = 0;
+    forEachRun(chunks, field.chunk_size, field.count,
+               [&](size_t begin, size_t end) {
+      bytes += storageBytes(type, end) - storageOffset(type, begin);
+    });
+    record.values.resize(bytes);
+    read(record.values.data(), bytes);
+
+    const FieldTable& fields =
+      field.entity == static_cast<uint32_t>(MappedStorage::Entity::Cell)
+      ? cells : faces;
+    const FieldLayout layout = FieldLayout::fromKind(field.layout,
+                                                     field.width);
+    const size_t index = fields.find(record.name.data(),
+                                     record.name.size());
+    const char* error = nullptr;
+    if (field.count != layout.count(fields.numEntities(),
+                                    field.components)) {
+      error = "The number of values does not match the container";
+    } else if (index == FieldTable::npos) {
+      if (type == FieldType::Bit && layout != FieldLayout()) {
+        OPM_THROW(std::runtime_error, "Corrupt delta checkpoint " << path);
+      }
+    } else if (fields.components(index) != field.components) {
+      error = "The number of components does not match the container";
+    } else {
+      // Changing the layout or the type keeps the values, so the
+      // chunks of the delta apply on top of the converted field.
+      error = fields.conversionError(index, layout, type);
+    }
+    if (error) {
+      OPM_THROW(std::invalid_argument, "Cannot apply the field "
+                << record.name << " of the delta checkpoint " << path
+                << ": " << error);
+    }
+  }
+
+  for (const Record& record : records) {
+    const FieldHeader& field = record.field;
+    FieldTable& fields =
+      field.entity == static_cast<uint32_t>(MappedStorage::Entity::Cell)
+      ? cells : faces;
+    const FieldLayout layout = FieldLayout::fromKind(field.layout,
+                                                     field.width);
+    const FieldType type = fieldTypeFromValue(field.type);
+    size_t index = fields.find(record.name.data(), record.name.size());
+    if (index == FieldTable::npos) {
+      index = fields.insert(record.name, field.components, 0.0, layout,
+                            type);
+      fields.clearDirty(index);
+    } else if (fields.layout(index) != layout ||
+               fields.type(index) != type) {
+      fields.relayout(index, layout);
+      fields.retype(index, type);
+      fields.clearDirty(index);
+    }
+    char* data = static_cast<char*>(fields.rawData(index));
+    const char* values = record.values.data();
+    forEachRun(record.chunks, field.chunk_size, field.count,
+               [&](size_t begin, size_t end) {
+      const size_t offset = storageOffset(type, begin);
+      const size_t bytes = storageBytes(type, end) - offset;
+      std::memcpy(data + offset, values, bytes);
+      values += bytes;
+    });
+  }
+}
+}  // namespace Opm
@@ -0,0 +1,87 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_DELTACHECKPOINT_H_
+#define OPM_COMMON_DATA_DELTACHECKPOINT_H_
+
+#include <cstdint>
+#include <string>
+
+#include <opm/common/data/FieldTable.hpp>
+
+namespace Opm {
+/**
+ * @class DeltaCheckpoint
+ * @brief Incremental checkpoints holding only the dirty chunks of the
+ *        fields of a SimulationDataContainer.
+ *
+ * A delta file is written sequentially and consists of
+ *
+ * - a header with magic, format version, number of cells and faces
+ *   and the number of fields in the file;
+ * - for every field with dirty chunks: entity kind, name, components,
+ *   layout, scalar type, number of values, chunk size and the indices
+ *   of the dirty chunks, followed by the values of those chunks, one
+ *   range per run of adjacent chunks (so the word of a Bit field
+ *   shared by two adjacent chunks is stored once).
+ *
+ * Applying the deltas of a run in order to the full checkpoint they
+ * started from reproduces the state at any step. Fields registered
+ * after the base checkpoint are dirty as a whole, and are registered
+ * when the delta is applied; fields whose layout or type changed are
+ * converted before the chunks are written.
+ */
+class DeltaCheckpoint {
+ public:
+  /**
+   * @brief Version of the layout written by this class.
+   *
+   * Version 2 added the field layout and version 3 the scalar type;
+   * older files are still read.
+   */
+  static const uint32_t format_version = 3;
+
+  /**
+   * @brief Write the dirty chunks of all fields; the tables are unchanged.
+   * @param path the file to write, truncated if it exists
+   * @param cells the cell fields
+   * @param faces the face fields
+   */
+  static void write(const std::string& path, const FieldTable& cells,
+                    const FieldTable& faces);
+
+  /**
+   * @brief Copy the chunks of a delta file into the tables.
+   *
+   * Missing fields are registered; the applied values are not marked
+   * as dirty. The whole file is read and checked first, so a delta
+   * which does not apply leaves the tables unchanged: std::runtime_error
+   * is thrown for a corrupt or truncated file, and std::invalid_argument
+   * for fields which do not match the tables, or whose layout or type
+   * cannot be changed to that of the delta (see
+   * FieldTable::conversionError()).
+   * @param path a file written by write()
+   * @param cells the cell fields
+   * @param faces the face fields
+   */
+  static void apply(const std::string& path, FieldTable& cells,
+                    FieldTable& faces);
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_DELTACHECKPOINT_H_
@@ -0,0 +1,180 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <vector>
+#include "opm/common/data/FieldBits.hpp"
+
+namespace Opm {
+namespace FieldBits {
+namespace {
+// Words handled by one thread at a time: 1 Mi bits.
+const size_t block_words = 1 << 14;
+
+size_t numBlocks(size_t words) {
+  return (words + block_words - 1) / block_words;
+}
+
+inline size_t popcount(Word word) {
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_popcountll(word));
+#else
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<size_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline size_t lowestBit(Word word) {
+#if defined(__GNUC__)
+  return static_cast<size_t>(__builtin_ctzll(word));
+#else
+  return popcount((word & (~word + 1)) - 1);
+#endif
+}
+
+// The bits of the last word which hold values.
+Word tailMask(size_t bits) {
+  const size_t used = bits % word_bits;
+  return used == 0 ? ~Word(0) : (Word(1) << used) - 1;
+}
+
+template <typename Op>
+size_t countWords(const Word* words, const Word* mask, size_t bits, Op op) {
+  const size_t num_words = numWords(bits);
+  size_t total = 0;
+#pragma omp parallel for reduction(+:total) schedule(static)
+  for (size_t word = 0; word < num_words; ++word) {
+    total += popcount(op(words[word], mask ? mask[word] : 0));
+  }
+  return total;
+}
+
+template <typename Op>
+void applyWords(Word* target, const Word* mask, size_t bits, Op op) {
+  const size_t num_words = numWords(bits);
+#pragma omp parallel for schedule(static)
+  for (size_t word = 0; word < num_words; ++word) {
+    target[word] = op(target[word], mask ? mask[word] : 0);
+  }
+  if (num_words > 0) {
+    target[num_words - 1] &= tailMask(bits);
+  }
+}
+
+// Every block first counts its set bits; the prefix sums of the counts
+// are where the blocks write, so the output is in order for any number
+// of threads.
+template <typename Emit>
+size_t forEachSet(const Word* words, size_t bits, Emit emit) {
+  const size_t num_words = numWords(bits);
+  const size_t num_blocks = numBlocks(num_words);
+  std::vector<size_t> starts(num_blocks + 1, 0);
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t end = std::min((block + 1) * block_words, num_words);
+    size_t total = 0;
+    for (size_t word = block * block_words; word < end; ++word) {
+      total += popcount(words[word]);
+    }
+    starts[block + 1] = total;
+  }
+  for (size_t block = 0; block < num_blocks; ++block) {
+    starts[block + 1] += starts[block];
+  }
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t end = std::min((block + 1) * block_words, num_words);
+    size_t next = starts[block];
+    for (size_t word = block * block_words; word < end; ++word) {
+      for (Word bits_left = words[word]; bits_left != 0;
+           bits_left &= bits_left - 1) {
+        emit(next++, word * word_bits + lowestBit(bits_left));
+      }
+    }
+  }
+  return starts[num_blocks];
+}
+
+template <typename Index>
+size_t writeIndices(const Word* words, size_t bits, Index* indices) {
+  return forEachSet(words, bits, [=](size_t position, size_t bit) {
+    indices[position] = static_cast<Index>(bit);
+  });
+}
+}  // namespace
+
+size_t count(const Word* words, size_t bits) {
+  return countWords(words, nullptr, bits,
+                    [](Word word, Word) { return word; });
+}
+
+size_t countAnd(const Word* words, const Word* mask, size_t bits) {
+  return countWords(words, mask, bits,
+                    [](Word word, Word other) { return word & other; });
+}
+
+size_t countDifferent(const Word* words, const Word* other, size_t bits) {
+  return countWords(words, other, bits,
+                    [](Word word, Word other) { return word ^ other; });
+}
+
+void fill(Word* words, size_t bits, bool value) {
+  const Word pattern = value ? ~Word(0) : Word(0);
+  applyWords(words, nullptr, bits,
+             [=](Word, Word) { return pattern; });
+}
+
+void flip(Word* words, size_t bits) {
+  applyWords(words, nullptr, bits, [](Word word, Word) { return ~word; });
+}
+
+void assignAnd(Word* target, const Word* mask, size_t bits) {
+  applyWords(target, mask, bits,
+             [](Word word, Word other) { return word & other; });
+}
+
+void assignOr(Word* target, const Word* mask, size_t bits) {
+  applyWords(target, mask, bits,
+             [](Word word, Word other) { return word | other; });
+}
+
+void assignAndNot(Word* target, const Word* mask, size_t bits) {
+  applyWords(target, mask, bits,
+             [](Word word, Word other) { return word & ~other; });
+}
+
+size_t indices(const Word* words, size_t bits, int32_t* indices) {
+  return writeIndices(words, bits, indices);
+}
+
+size_t indices(const Word* words, size_t bits, int64_t* indices) {
+  return writeIndices(words, bits, indices);
+}
+
+size_t select(const Word* words, size_t bits, const double* values,
+              double* selected) {
+  return forEachSet(words, bits, [=](size_t position, size_t bit) {
+    selected[position] = values[bit];
+  });
+}
+}  // namespace FieldBits
+}  // namespace Opm
@@ -0,0 +1,208 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_FIELDBITS_H_
+#define OPM_COMMON_DATA_FIELDBITS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Opm {
+/**
+ * @brief Kernels on packed bits, the storage of FieldType::Bit fields.
+ *
+ * Bit i of a field is bit i % 64 of word i / 64, and the bits past the
+ * last value of the last word are always zero, so whole words can be
+ * counted and compared. The kernels loop over whole words, which the
+ * compiler turns into popcount and vector instructions where the
+ * target has them, and run in parallel blocks when OpenMP is enabled.
+ */
+namespace FieldBits {
+typedef uint64_t Word;
+
+const size_t word_bits = 64;
+
+/**
+ * @brief Number of words holding @p bits bits.
+ */
+inline size_t numWords(size_t bits) {
+  return (bits + word_bits - 1) / word_bits;
+}
+
+/**
+ * @brief Number of set bits.
+ */
+size_t count(const Word* words, size_t bits);
+
+/**
+ * @brief Number of bits set in both @p words and @p mask.
+ */
+size_t countAnd(const Word* words, const Word* mask, size_t bits);
+
+/**
+ * @brief Number of bits which differ between @p words and @p other.
+ */
+size_t countDifferent(const Word* words, const Word* other, size_t bits);
+
+/**
+ * @brief Set all bits to @p value.
+ */
+void fill(Word* words, size_t bits, bool value);
+
+/**
+ * @brief Invert all bits.
+ */
+void flip(Word* words, size_t bits);
+
+/**
+ * @brief target &= mask, target |= mask and target &= ~mask.
+ */
+void assignAnd(Word* target, const Word* mask, size_t bits);
+void assignOr(Word* target, const Word* mask, size_t bits);
+void assignAndNot(Word* target, const Word* mask, size_t bits);
+
+/**
+ * @brief Write the positions of the set bits in increasing order.
+ * @param indices room for count() positions
+ * @return the number of positions written
+ */
+size_t indices(const Word* words, size_t bits, int32_t* indices);
+size_t indices(const Word* words, size_t bits, int64_t* indices);
+
+/**
+ * @brief Copy the values whose bit is set, in order.
+ * @param values one value per bit
+ * @param selected room for count() values
+ * @return the number of values copied
+ */
+size_t select(const Word* words, size_t bits, const double* values,
+              double* selected);
+}  // namespace FieldBits
+
+/**
+ * @class BitView
+ * @brief Non-owning view of the packed bits of a FieldType::Bit field.
+ *
+ * W is FieldBits::Word, or const FieldBits::Word for a read-only view.
+ * Besides single bit access the view offers the bulk kernels of
+ * FieldBits; e.g. the active cells of a region are
+ * region.assignAnd(active), and region.indices() lists them for
+ * SimulationDataContainer::gatherCellData(). Like FieldView, a view
+ * is invalidated by any operation which reallocates the field storage.
+ */
+template <typename W>
+class BitView {
+ public:
+  typedef FieldBits::Word Word;
+
+  BitView() : m_words(nullptr), m_size(0) {}
+
+  BitView(W* words, size_t size) : m_words(words), m_size(size) {}
+
+  /**
+   * @brief Conversion from a mutable to a const view.
+   */
+  template <typename U,
+            typename = typename std::enable_if<
+              std::is_convertible<U*, W*>::value>::type>
+  BitView(const BitView<U>& other)
+      : m_words(other.data()), m_size(other.size()) {}
+
+  W* data() const { return m_words; }
+  size_t size() const { return m_size; }
+  size_t numWords() const { return FieldBits::numWords(m_size); }
+  bool empty() const { return m_size == 0; }
+
+  bool operator[](size_t index) const {
+    return ((m_words[index / FieldBits::word_bits]
+             >> (index % FieldBits::word_bits)) & 1) != 0;
+  }
+
+  void set(size_t index, bool value = true) const {
+    const Word bit = Word(1) << (index % FieldBits::word_bits);
+    if (value) {
+      m_words[index / FieldBits::word_bits] |= bit;
+    } else {
+      m_words[index / FieldBits::word_bits] &= ~bit;
+    }
+  }
+
+  void reset(size_t index) const { set(index, false); }
+
+  /**
+   * @brief Number of set bits.
+   */
+  size_t count() const { return FieldBits::count(m_words, m_size); }
+
+  /**
+   * @brief Number of bits set both here and in @p mask.
+   */
+  size_t countAnd(const BitView<const Word>& mask) const {
+    checkSize(mask.size());
+    return FieldBits::countAnd(m_words, mask.data(), m_size);
+  }
+
+  void fill(bool value) const { FieldBits::fill(m_words, m_size, value); }
+  void flip() const { FieldBits::flip(m_words, m_size); }
+
+  void assignAnd(const BitView<const Word>& mask) const {
+    checkSize(mask.size());
+    FieldBits::assignAnd(m_words, mask.data(), m_size);
+  }
+
+  void assignOr(const BitView<const Word>& mask) const {
+    checkSize(mask.size());
+    FieldBits::assignOr(m_words, mask.data(), m_size);
+  }
+
+  void assignAndNot(const BitView<const Word>& mask) const {
+    checkSize(mask.size());
+    FieldBits::assignAndNot(m_words, mask.data(), m_size);
+  }
+
+  /**
+   * @brief Write the positions of the set bits, see FieldBits::indices().
+   */
+  template <typename Index>
+  size_t indices(Index* indices) const {
+    return FieldBits::indices(m_words, m_size, indices);
+  }
+
+  /**
+   * @brief Copy the values whose bit is set, see FieldBits::select().
+   */
+  size_t select(const double* values, double* selected) const {
+    return FieldBits::select(m_words, m_size, values, selected);
+  }
+
+ private:
+  void checkSize(size_t size) const {
+    if (size != m_size) {
+      throw std::invalid_argument("The views have different sizes");
+    }
+  }
+
+  W* m_words;  //!< first word
+  size_t m_size;  //!< number of bits
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDBITS_H_
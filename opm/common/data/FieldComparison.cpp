@@ -0,0 +1,259 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "opm/common/data/FieldBits.hpp"
+#include "opm/common/data/FieldComparison.hpp"
+
+namespace Opm {
+namespace {
+const size_t block_values = 1 << 14;
+
+size_t numBlocks(size_t count) {
+  return (count + block_values - 1) / block_values;
+}
+
+// Same test as cmp::scalar_equal(), without branches so that the loops
+// over a block vectorize.
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+mismatch(T value, T other, T abs_eps, T rel_eps) {
+  const T diff = std::fabs(value - other);
+  const T scale = std::max(std::fabs(value), std::fabs(other));
+  return (diff > abs_eps) & (diff > scale * rel_eps);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value, bool>::type
+mismatch(T value, T other, T, T) {
+  return value != other;
+}
+
+template <typename T>
+bool equalValues(const T* values, const T* other, size_t count,
+                 T abs_eps, T rel_eps) {
+  if (values == other) {
+    return true;
+  }
+  const size_t num_blocks = numBlocks(count);
+  bool different = false;
+#pragma omp parallel for schedule(dynamic)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    bool done;
+#pragma omp atomic read
+    done = different;
+    if (done) {
+      continue;
+    }
+    const size_t begin = block * block_values;
+    const size_t end = std::min(begin + block_values, count);
+    if (std::memcmp(values + begin, other + begin,
+                    (end - begin) * sizeof(T)) == 0) {
+      continue;
+    }
+    size_t mismatches = 0;
+    for (size_t i = begin; i < end; ++i) {
+      mismatches += mismatch(values[i], other[i], abs_eps, rel_eps);
+    }
+    if (mismatches > 0) {
+#pragma omp atomic write
+      different = true;
+    }
+  }
+  return !different;
+}
+
+template <typename T>
+void compareValues(const T* values, const T* other, size_t count,
+                   T abs_eps, T rel_eps, FieldDifference& difference) {
+  // Statistics are gathered per block and combined in block order, so
+  // the result does not depend on the number of threads.
+  struct Block {
+    size_t mismatches;
+    size_t first;
+    size_t worst;
+    double worst_error;
+    double max_abs;
+    double max_rel;
+  };
+  const size_t num_blocks = numBlocks(count);
+  std::vector<Block> blocks(num_blocks);
+#pragma omp parallel for schedule(dynamic)
+  for (size_t block_index = 0; block_index < num_blocks; ++block_index) {
+    Block& block = blocks[block_index];
+    block = Block { 0, FieldDifference::npos, FieldDifference::npos,
+                    0.0, 0.0, 0.0 };
+    const size_t begin = block_index * block_values;
+    const size_t end = std::min(begin + block_values, count);
+    if (std::memcmp(values + begin, other + begin,
+                    (end - begin) * sizeof(T)) == 0) {
+      continue;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      // The statistics are kept in double precision for all types.
+      const double value = values[i];
+      const double other_value = other[i];
+      const double diff = std::fabs(value - other_value);
+      const double scale = std::max(std::fabs(value),
+                                    std::fabs(other_value));
+      block.max_abs = std::max(block.max_abs, diff);
+      if (scale > 0) {
+        block.max_rel = std::max(block.max_rel, diff / scale);
+      }
+      if (mismatch(values[i], other[i], abs_eps, rel_eps)) {
+        if (block.mismatches++ == 0) {
+          block.first = i;
+        }
+        if (block.worst == FieldDifference::npos ||
+            diff > block.worst_error) {
+          block.worst = i;
+          block.worst_error = diff;
+        }
+      }
+    }
+  }
+
+  difference.count = count;
+  difference.mismatches = 0;
+  difference.first_mismatch = FieldDifference::npos;
+  difference.worst_mismatch = FieldDifference::npos;
+  difference.max_abs_error = 0.0;
+  difference.max_rel_error = 0.0;
+  double worst_error = 0.0;
+  for (const Block& block : blocks) {
+    difference.max_abs_error = std::max(difference.max_abs_error,
+                                        block.max_abs);
+    difference.max_rel_error = std::max(difference.max_rel_error,
+                                        block.max_rel);
+    if (block.mismatches == 0) {
+      continue;
+    }
+    if (difference.mismatches == 0) {
+      difference.first_mismatch = block.first;
+    }
+    if (difference.worst_mismatch == FieldDifference::npos ||
+        block.worst_error > worst_error) {
+      difference.worst_mismatch = block.worst;
+      worst_error = block.worst_error;
+    }
+    difference.mismatches += block.mismatches;
+  }
+}
+}  // namespace
+
+const size_t FieldDifference::npos;
+
+bool ComparisonReport::equal() const {
+  if (!sizes_equal) {
+    return false;
+  }
+  for (const auto* fields : { &cell_fields, &face_fields,
+                              &sparse_cell_fields, &sparse_face_fields }) {
+    for (const auto& field : *fields) {
+      if (!field.equal()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+namespace FieldComparison {
+bool equal(const double* values, const double* other, size_t count,
+           double abs_eps, double rel_eps) {
+  return equalValues(values, other, count, abs_eps, rel_eps);
+}
+
+bool equal(const float* values, const float* other, size_t count,
+           double abs_eps, double rel_eps) {
+  return equalValues<float>(values, other, count, abs_eps, rel_eps);
+}
+
+void compare(const double* values, const double* other, size_t count,
+             double abs_eps, double rel_eps, FieldDifference& difference) {
+  compareValues(values, other, count, abs_eps, rel_eps, difference);
+}
+
+void compare(const float* values, const float* other, size_t count,
+             double abs_eps, double rel_eps, FieldDifference& difference) {
+  compareValues<float>(values, other, count, abs_eps, rel_eps, difference);
+}
+
+bool equal(const int32_t* values, const int32_t* other, size_t count) {
+  return equalValues<int32_t>(values, other, count, 0, 0);
+}
+
+bool equal(const int16_t* values, const int16_t* other, size_t count) {
+  return equalValues<int16_t>(values, other, count, 0, 0);
+}
+
+bool equal(const uint8_t* values, const uint8_t* other, size_t count) {
+  return equalValues<uint8_t>(values, other, count, 0, 0);
+}
+
+bool equalBits(const uint64_t* words, const uint64_t* other, size_t bits) {
+  // The bits past the last value are zero, so whole words compare.
+  return equalValues<uint64_t>(words, other, FieldBits::numWords(bits), 0, 0);
+}
+
+void compare(const int32_t* values, const int32_t* other, size_t count,
+             FieldDifference& difference) {
+  compareValues<int32_t>(values, other, count, 0, 0, difference);
+}
+
+void compare(const int16_t* values, const int16_t* other, size_t count,
+             FieldDifference& difference) {
+  compareValues<int16_t>(values, other, count, 0, 0, difference);
+}
+
+void compare(const uint8_t* values, const uint8_t* other, size_t count,
+             FieldDifference& difference) {
+  compareValues<uint8_t>(values, other, count, 0, 0, difference);
+}
+
+void compareBits(const uint64_t* words, const uint64_t* other, size_t bits,
+                 FieldDifference& difference) {
+  // Every mismatch is off by one, so the first is also the worst.
+  difference.count = bits;
+  difference.mismatches = FieldBits::countDifferent(words, other, bits);
+  difference.first_mismatch = FieldDifference::npos;
+  difference.worst_mismatch = FieldDifference::npos;
+  difference.max_abs_error = difference.mismatches > 0 ? 1.0 : 0.0;
+  difference.max_rel_error = difference.max_abs_error;
+  if (difference.mismatches == 0) {
+    return;
+  }
+  size_t word = 0;
+  while (words[word] == other[word]) {
+    ++word;
+  }
+  const uint64_t different = words[word] ^ other[word];
+  size_t bit = 0;
+  while (((different >> bit) & 1) == 0) {
+    ++bit;
+  }
+  difference.first_mismatch = word * FieldBits::word_bits + bit;
+  difference.worst_mismatch = difference.first_mismatch;
+}
+}  // namespace FieldComparison
+}  // namespace Opm
@@ -0,0 +1,117 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDCOMPARISON_H_
+#define OPM_COMMON_DATA_FIELDCOMPARISON_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Opm {
+/**
+ * @brief Differences between one field of two containers.
+ *
+ * Two values mismatch if they differ by more than both the absolute
+ * and the relative tolerance, as in cmp::scalar_equal(). The errors
+ * are the largest over all values; the relative error of a pair is
+ * the difference divided by the larger magnitude.
+ */
+struct FieldDifference {
+  enum class Status {
+    Compared,  //!< both fields exist with the same size
+    Missing,  //!< the field only exists in one of the containers
+    SizeMismatch  //!< the fields have a different number of values,
+                  //!< or are sparse fields on different entities
+  };
+
+  static const size_t npos = static_cast<size_t>(-1);
+
+  std::string name;  //!< the name of the field
+  Status status;  //!< whether the values were compared
+  size_t count;  //!< number of values compared
+  size_t mismatches;  //!< number of mismatching values
+  size_t first_mismatch;  //!< index of the first mismatch, or npos
+  size_t worst_mismatch;  //!< index of the largest mismatch, or npos
+  double max_abs_error;  //!< largest absolute difference
+  double max_rel_error;  //!< largest relative difference
+
+  bool equal() const {
+    return status == Status::Compared && mismatches == 0;
+  }
+};
+
+/**
+ * @brief Result of SimulationDataContainer::compare().
+ */
+struct ComparisonReport {
+  bool sizes_equal;  //!< same numbers of cells, faces and phases
+  std::vector<FieldDifference> cell_fields;  //!< cell fields of both
+  std::vector<FieldDifference> face_fields;  //!< face fields of both
+  std::vector<FieldDifference> sparse_cell_fields;  //!< sparse cell fields
+  std::vector<FieldDifference> sparse_face_fields;  //!< sparse face fields
+
+  bool equal() const;
+};
+
+/**
+ * @brief Kernels comparing two arrays of values.
+ *
+ * The arrays are compared in blocks, in parallel when OpenMP is
+ * enabled; identical blocks are recognized with memcmp(). Float32
+ * values are compared in single precision, like cmp::scalar_equal()
+ * for float. Integer and Bit values mismatch whenever they differ,
+ * whatever the tolerances.
+ */
+namespace FieldComparison {
+/**
+ * @brief Whether no values mismatch; stops at the first mismatch.
+ */
+bool equal(const double* values, const double* other, size_t count,
+           double abs_eps, double rel_eps);
+bool equal(const float* values, const float* other, size_t count,
+           double abs_eps, double rel_eps);
+bool equal(const int32_t* values, const int32_t* other, size_t count);
+bool equal(const int16_t* values, const int16_t* other, size_t count);
+bool equal(const uint8_t* values, const uint8_t* other, size_t count);
+
+/**
+ * @brief Whether two Bit fields of @p bits values are equal.
+ */
+bool equalBits(const uint64_t* words, const uint64_t* other, size_t bits);
+
+/**
+ * @brief Fill in the statistics of @p difference.
+ */
+void compare(const double* values, const double* other, size_t count,
+             double abs_eps, double rel_eps, FieldDifference& difference);
+void compare(const float* values, const float* other, size_t count,
+             double abs_eps, double rel_eps, FieldDifference& difference);
+void compare(const int32_t* values, const int32_t* other, size_t count,
+             FieldDifference& difference);
+void compare(const int16_t* values, const int16_t* other, size_t count,
+             FieldDifference& difference);
+void compare(const uint8_t* values, const uint8_t* other, size_t count,
+             FieldDifference& difference);
+void compareBits(const uint64_t* words, const uint64_t* other, size_t bits,
+                 FieldDifference& difference);
+}  // namespace FieldComparison
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDCOMPARISON_H_
@@ -0,0 +1,342 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/FieldCompressor.hpp"
+
+namespace Opm {
+namespace {
+const char magic[4] = { 'O', 'F', 'C', '1' };
+
+struct Header {
+  char magic[4];
+  uint32_t stride;
+  uint64_t count;
+  uint64_t chunk_values;
+  uint64_t num_chunks;
+};
+
+// How a byte plane of a chunk is stored:
+// - ZeroPlane:   not at all;
+// - SparsePlane: bitmap of the nonzero bytes, followed by those bytes;
+// - RawPlane:    every byte;
+// - RunPlane:    the number of nonzero bytes, and for each of them
+//                the number of zero bytes before it, followed by the
+//                byte; the numbers are stored as varints.
+enum PlaneMode : uint8_t {
+  ZeroPlane = 0, SparsePlane = 1, RawPlane = 2, RunPlane = 3
+};
+
+const size_t num_planes = sizeof(uint64_t);
+
+void appendVarint(std::vector<char>& out, size_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const char* data, size_t bytes, size_t& pos, size_t& value) {
+  value = 0;
+  for (unsigned bits = 0; pos < bytes && bits < 64; bits += 7) {
+    const uint8_t byte = static_cast<uint8_t>(data[pos++]);
+    value |= size_t(byte & 0x7f) << bits;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t varintBytes(size_t value) {
+  size_t bytes = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++bytes;
+  }
+  return bytes;
+}
+
+// Buffers of one thread, reused for all the chunks it codes.
+struct Scratch {
+  std::vector<uint64_t> residuals;
+  std::vector<uint8_t> plane;
+};
+
+void encodeChunk(const double* values, size_t n, size_t stride,
+                 Scratch& scratch, std::vector<char>& out) {
+  // The bits of the values are XORed straight from the input.
+  std::vector<uint64_t>& residuals = scratch.residuals;
+  residuals.resize(n);
+  const size_t head = std::min(stride, n);
+  std::memcpy(residuals.data(), values, head * sizeof(double));
+  for (size_t i = head; i < n; ++i) {
+    uint64_t value;
+    uint64_t previous;
+    std::memcpy(&value, values + i, sizeof(value));
+    std::memcpy(&previous, values + i - stride, sizeof(previous));
+    residuals[i] = value ^ previous;
+  }
+
+  const size_t bitmap_bytes = (n + 7) / 8;
+  std::vector<uint8_t>& plane = scratch.plane;
+  plane.resize(n);
+  out.assign(num_planes, 0);
+  for (size_t p = 0; p < num_planes; ++p) {
+    const unsigned shift = 8 * p;
+    size_t nonzero = 0;
+    for (size_t i = 0; i < n; ++i) {
+      plane[i] = static_cast<uint8_t>(residuals[i] >> shift);
+      nonzero += plane[i] != 0;
+    }
+    // Runs are only considered for planes which are mostly zero.
+    size_t run_bytes = n;
+    if (nonzero > 0 && 8 * nonzero < n) {
+      run_bytes = varintBytes(nonzero);
+      size_t gap = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (plane[i] != 0) {
+          run_bytes += varintBytes(gap) + 1;
+          gap = 0;
+        } else {
+          ++gap;
+        }
+      }
+    }
+    if (nonzero == 0) {
+      out[p] = ZeroPlane;
+    } else if (run_bytes < std::min(bitmap_bytes + nonzero, n)) {
+      out[p] = RunPlane;
+      appendVarint(out, nonzero);
+      size_t gap = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (plane[i] != 0) {
+          appendVarint(out, gap);
+          out.push_back(static_cast<char>(plane[i]));
+          gap = 0;
+        } else {
+          ++gap;
+        }
+      }
+    } else if (bitmap_bytes + nonzero < n) {
+      out[p] = SparsePlane;
+      const size_t start = out.size();
+      out.resize(start + bitmap_bytes + nonzero, 0);
+      char* bitmap = out.data() + start;
+      char* bytes = bitmap + bitmap_bytes;
+      for (size_t i = 0; i < n; ++i) {
+        if (plane[i] != 0) {
+          bitmap[i / 8] |= static_cast<char>(1 << (i % 8));
+          *bytes++ = static_cast<char>(plane[i]);
+        }
+      }
+    } else {
+      out[p] = RawPlane;
+      out.insert(out.end(), plane.begin(), plane.begin() + n);
+    }
+  }
+}
+
+// Returns false if the chunk is corrupt; this runs in a parallel
+// region, which exceptions must not leave.
+bool decodeChunk(const char* data, size_t bytes, size_t n, size_t stride,
+                 Scratch& scratch, double* values) {
+  if (bytes < num_planes) {
+    return false;
+  }
+  const size_t bitmap_bytes = (n + 7) / 8;
+  std::vector<uint64_t>& residuals = scratch.residuals;
+  residuals.assign(n, 0);
+  size_t pos = num_planes;
+  for (size_t p = 0; p < num_planes; ++p) {
+    const unsigned shift = 8 * p;
+    switch (static_cast<uint8_t>(data[p])) {
+      case ZeroPlane:
+        break;
+      case RawPlane: {
+        if (bytes - pos < n) {
+          return false;
+        }
+        const uint8_t* plane = reinterpret_cast<const uint8_t*>(data + pos);
+        for (size_t i = 0; i < n; ++i) {
+          residuals[i] |= uint64_t(plane[i]) << shift;
+        }
+        pos += n;
+        break;
+      }
+      case SparsePlane: {
+        if (bytes - pos < bitmap_bytes) {
+          return false;
+        }
+        const uint8_t* bitmap = reinterpret_cast<const uint8_t*>(data + pos);
+        pos += bitmap_bytes;
+        for (size_t i = 0; i < n; ++i) {
+          if (bitmap[i / 8] & (1 << (i % 8))) {
+            if (pos == bytes) {
+              return false;
+            }
+            residuals[i] |= uint64_t(static_cast<uint8_t>(data[pos++]))
+                            << shift;
+          }
+        }
+        break;
+      }
+      case RunPlane: {
+        size_t nonzero;
+        if (!readVarint(data, bytes, pos, nonzero) || nonzero > n) {
+          return false;
+        }
+        size_t i = 0;
+        for (size_t k = 0; k < nonzero; ++k) {
+          size_t gap;
+          if (!readVarint(data, bytes, pos, gap) || gap >= n - i ||
+              pos == bytes) {
+            return false;
+          }
+          i += gap;
+          residuals[i++] |= uint64_t(static_cast<uint8_t>(data[pos++]))
+                            << shift;
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  if (pos != bytes) {
+    return false;
+  }
+  for (size_t i = stride; i < n; ++i) {
+    residuals[i] ^= residuals[i - stride];
+  }
+  std::memcpy(values, residuals.data(), n * sizeof(double));
+  return true;
+}
+
+Header readHeader(const char* data, size_t bytes) {
+  Header header;
+  if (bytes < sizeof(header)) {
+    OPM_THROW(std::runtime_error, "Truncated compressed field");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+      header.stride == 0 || header.chunk_values == 0 ||
+      header.num_chunks != (header.count + header.chunk_values - 1)
+                           / header.chunk_values) {
+    OPM_THROW(std::runtime_error, "Not a compressed field");
+  }
+  if ((bytes - sizeof(header)) / sizeof(uint64_t) <= header.num_chunks) {
+    OPM_THROW(std::runtime_error, "Truncated compressed field");
+  }
+  return header;
+}
+}  // namespace
+
+const size_t FieldCompressor::chunk_values;
+
+std::vector<char> FieldCompressor::compress(const double* values,
+                                            size_t count, size_t stride) {
+  if (stride == 0 || stride > UINT32_MAX) {
+    OPM_THROW(std::invalid_argument, "Invalid stride " << stride);
+  }
+  const size_t num_chunks = (count + chunk_values - 1) / chunk_values;
+  std::vector<std::vector<char>> chunks(num_chunks);
+#pragma omp parallel
+  {
+    Scratch scratch;
+#pragma omp for schedule(dynamic)
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      const size_t begin = chunk * chunk_values;
+      encodeChunk(values + begin, std::min(chunk_values, count - begin),
+                  stride, scratch, chunks[chunk]);
+    }
+  }
+
+  // Header, the offsets of the chunks relative to the end of the
+  // offset table, and the chunks.
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.stride = static_cast<uint32_t>(stride);
+  header.count = count;
+  header.chunk_values = chunk_values;
+  header.num_chunks = num_chunks;
+  std::vector<uint64_t> offsets(num_chunks + 1, 0);
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    offsets[chunk + 1] = offsets[chunk] + chunks[chunk].size();
+  }
+  const size_t table_end = sizeof(header) + offsets.size() * sizeof(uint64_t);
+  std::vector<char> out(table_end + offsets.back());
+  std::memcpy(out.data(), &header, sizeof(header));
+  std::memcpy(out.data() + sizeof(header), offsets.data(),
+              offsets.size() * sizeof(uint64_t));
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    std::copy(chunks[chunk].begin(), chunks[chunk].end(),
+              out.begin() + table_end + offsets[chunk]);
+  }
+  return out;
+}
+
+size_t FieldCompressor::count(const char* data, size_t bytes) {
+  return readHeader(data, bytes).count;
+}
+
+void FieldCompressor::decompress(const char* data, size_t bytes,
+                                 double* values, size_t count) {
+  const Header header = readHeader(data, bytes);
+  if (header.count != count) {
+    OPM_THROW(std::invalid_argument, "The compressed field holds "
+              << header.count << " values, not " << count);
+  }
+  const size_t num_chunks = header.num_chunks;
+  std::vector<uint64_t> offsets(num_chunks + 1);
+  std::memcpy(offsets.data(), data + sizeof(header),
+              offsets.size() * sizeof(uint64_t));
+  const size_t table_end = sizeof(header) + offsets.size() * sizeof(uint64_t);
+  if (offsets[0] != 0 || offsets.back() != bytes - table_end ||
+      !std::is_sorted(offsets.begin(), offsets.end())) {
+    OPM_THROW(std::runtime_error, "Corrupt compressed field");
+  }
+
+  bool corrupt = false;
+#pragma omp parallel
+  {
+    Scratch scratch;
+#pragma omp for schedule(dynamic)
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+      const size_t begin = chunk * header.chunk_values;
+      if (!decodeChunk(data + table_end + offsets[chunk],
+                       offsets[chunk + 1] - offsets[chunk],
+                       std::min<size_t>(header.chunk_values, count - begin),
+                       header.stride, scratch, values + begin)) {
+#pragma omp atomic write
+        corrupt = true;
+      }
+    }
+  }
+  if (corrupt) {
+    OPM_THROW(std::runtime_error, "Corrupt compressed field");
+  }
+}
+}  // namespace Opm
@@ -0,0 +1,97 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDCOMPRESSOR_H_
+#define OPM_COMMON_DATA_FIELDCOMPRESSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Opm {
+/**
+ * @class FieldCompressor
+ * @brief Lossless compression of field values.
+ *
+ * The values are split in chunks of chunk_values values, which are
+ * compressed independently, and in parallel when OpenMP is enabled.
+ * In a chunk every value is XORed with the value @p stride positions
+ * before it, i.e. the same component of the previous cell. For smooth
+ * fields this clears the sign, the exponent and the leading mantissa
+ * bits. The residuals are then shuffled into eight byte planes, and
+ * every plane is stored in the smallest of four ways: not at all when
+ * it is all zero; as a bitmap of its nonzero bytes followed by those
+ * bytes; as runs, i.e. for every nonzero byte the number of zero bytes
+ * before it and the byte, which suits planes with few nonzero bytes;
+ * or raw.
+ *
+ * There is no entropy coding stage: the raw planes of the low
+ * mantissa bytes, which are close to random for computed fields, are
+ * not worth its cost. Constant and piecewise constant fields compress
+ * very well; other fields typically by about a factor of two, since
+ * how well they compress depends on how many mantissa bits change
+ * from one cell to the next. The stream starts with a small header and a
+ * table of chunk offsets; it is not meant as a file format and uses
+ * the byte order of the machine.
+ */
+class FieldCompressor {
+ public:
+  /**
+   * @brief Number of values per independently compressed chunk.
+   */
+  static const size_t chunk_values = 65536;
+
+  /**
+   * @brief Compress values.
+   * @param values the values to compress
+   * @param count number of values
+   * @param stride distance to the value used for prediction; the
+   *               number of components of the field
+   */
+  static std::vector<char> compress(const double* values, size_t count,
+                                    size_t stride = 1);
+
+  static std::vector<char> compress(const std::vector<double>& values,
+                                    size_t stride = 1) {
+    return compress(values.data(), values.size(), stride);
+  }
+
+  /**
+   * @brief Number of values in a compressed stream.
+   */
+  static size_t count(const char* data, size_t bytes);
+
+  /**
+   * @brief Decompress a stream into @p count values.
+   * @param data the stream returned by compress()
+   * @param bytes size of the stream
+   * @param values where the values are written
+   * @param count number of values; must match the stream
+   */
+  static void decompress(const char* data, size_t bytes, double* values,
+                         size_t count);
+
+  static std::vector<double> decompress(const std::vector<char>& data) {
+    std::vector<double> values(count(data.data(), data.size()));
+    decompress(data.data(), data.size(), values.data(), values.size());
+    return values;
+  }
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDCOMPRESSOR_H_
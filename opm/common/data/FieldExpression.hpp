@@ -0,0 +1,561 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_FIELDEXPRESSION_H_
+#define OPM_COMMON_DATA_FIELDEXPRESSION_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <opm/common/data/FieldStatistics.hpp>
+#include <opm/common/data/FieldView.hpp>
+#include <opm/common/data/StridedView.hpp>
+
+/**
+ * @file FieldExpression.hpp
+ * @brief Lazy arithmetic over field views.
+ *
+ * The operators +, -, * and / and the functions minimum(), maximum(),
+ * absolute() and squareRoot() applied to views (FieldView,
+ * StridedView) and numbers do not compute anything; they build a
+ * small expression object holding the views by value:
+ *
+ *     auto a = p * s0 + t / c;
+ *     evaluate(target, a);               // one pass, no temporaries
+ *     double total = evaluateStatistics(a).sum;
+ *
+ * evaluate() and evaluateStatistics() compute the whole expression
+ * value by value in a single pass over the operands, in blocks and in
+ * parallel when OpenMP is enabled. The innermost loops run over the
+ * contiguous runs the operand layouts have in common, so the compiler
+ * vectorizes them. All arithmetic is in double precision, whatever the
+ * scalar types of the views. An expression is invalidated together
+ * with the views it holds.
+ */
+namespace Opm {
+namespace ExpressionOps {
+struct Add {
+  static double apply(double a, double b) { return a + b; }
+};
+struct Subtract {
+  static double apply(double a, double b) { return a - b; }
+};
+struct Multiply {
+  static double apply(double a, double b) { return a * b; }
+};
+struct Divide {
+  static double apply(double a, double b) { return a / b; }
+};
+struct Minimum {
+  static double apply(double a, double b) { return b < a ? b : a; }
+};
+struct Maximum {
+  static double apply(double a, double b) { return a < b ? b : a; }
+};
+struct Negate {
+  static double apply(double a) { return -a; }
+};
+struct Absolute {
+  static double apply(double a) { return std::fabs(a); }
+};
+struct SquareRoot {
+  static double apply(double a) { return std::sqrt(a); }
+};
+}  // namespace ExpressionOps
+
+/**
+ * @brief Size of an expression made of numbers only, which fits any
+ *        size.
+ */
+const size_t expression_any_size = static_cast<size_t>(-1);
+
+/**
+ * @brief Expression of the values of a view.
+ *
+ * A run from value i is the values i to i + runLength(i) - 1, which
+ * are unitStride() apart; value k of the run is run(i)[k].
+ */
+template <typename T>
+class ExpressionLeaf {
+ public:
+  struct Run {
+    const T* data;
+    size_t step;
+    double operator[](size_t k) const { return data[k * step]; }
+    double unit(size_t k) const { return data[k]; }
+  };
+
+  ExpressionLeaf(const T* data, size_t size, size_t stride, size_t block)
+      : m_data(data), m_size(size), m_stride(stride), m_block(block) {}
+
+  size_t size() const { return m_size; }
+
+  bool unitStride() const {
+    return m_block > 1 || m_stride == 1 || m_size <= 1;
+  }
+
+  size_t runLength(size_t i) const {
+    if (m_block == 1 || m_block >= m_size) {
+      return m_size - i;
+    }
+    return m_block - i % m_block;
+  }
+
+  Run run(size_t i) const {
+    Run run = { m_data, 1 };
+    if (m_block >= m_size) {
+      run.data += i;
+    } else if (m_block == 1) {
+      run.data += i * m_stride;
+      run.step = m_stride;
+    } else {
+      run.data += i / m_block * m_stride + i % m_block;
+    }
+    return run;
+  }
+
+ private:
+  const T* m_data;
+  size_t m_size;
+  size_t m_stride;
+  size_t m_block;
+};
+
+/**
+ * @brief Expression of a number, the same for every value.
+ */
+class ExpressionScalar {
+ public:
+  struct Run {
+    double value;
+    double operator[](size_t) const { return value; }
+    double unit(size_t) const { return value; }
+  };
+
+  explicit ExpressionScalar(double value) : m_value(value) {}
+
+  size_t size() const { return expression_any_size; }
+  bool unitStride() const { return true; }
+  size_t runLength(size_t) const { return expression_any_size; }
+
+  Run run(size_t) const {
+    Run run = { m_value };
+    return run;
+  }
+
+ private:
+  double m_value;
+};
+
+/**
+ * @brief Expression applying Op to the values of two expressions of
+ *        the same size.
+ */
+template <typename Op, typename L, typename R>
+class BinaryExpression {
+ public:
+  struct Run {
+    typename L::Run left;
+    typename R::Run right;
+    double operator[](size_t k) const {
+      return Op::apply(left[k], right[k]);
+    }
+    double unit(size_t k) const {
+      return Op::apply(left.unit(k), right.unit(k));
+    }
+  };
+
+  BinaryExpression(const L& left, const R& right)
+      : m_left(left), m_right(right) {
+    if (left.size() != expression_any_size
+        && right.size() != expression_any_size
+        && left.size() != right.size()) {
+      throw std::invalid_argument("The operands of a field expression "
+                                  "differ in size");
+    }
+  }
+
+  size_t size() const {
+    return m_left.size() == expression_any_size ? m_right.size()
+                                                : m_left.size();
+  }
+
+  bool unitStride() const {
+    return m_left.unitStride() && m_right.unitStride();
+  }
+
+  size_t runLength(size_t i) const {
+    return std::min(m_left.runLength(i), m_right.runLength(i));
+  }
+
+  Run run(size_t i) const {
+    Run run = { m_left.run(i), m_right.run(i) };
+    return run;
+  }
+
+ private:
+  L m_left;
+  R m_right;
+};
+
+/**
+ * @brief Expression applying Op to the values of an expression.
+ */
+template <typename Op, typename E>
+class UnaryExpression {
+ public:
+  struct Run {
+    typename E::Run operand;
+    double operator[](size_t k) const { return Op::apply(operand[k]); }
+    double unit(size_t k) const { return Op::apply(operand.unit(k)); }
+  };
+
+  explicit UnaryExpression(const E& operand) : m_operand(operand) {}
+
+  size_t size() const { return m_operand.size(); }
+  bool unitStride() const { return m_operand.unitStride(); }
+  size_t runLength(size_t i) const { return m_operand.runLength(i); }
+
+  Run run(size_t i) const {
+    Run run = { m_operand.run(i) };
+    return run;
+  }
+
+ private:
+  E m_operand;
+};
+
+/**
+ * @brief The expression for an operand: views become leaves, numbers
+ *        scalars, and expressions stay as they are. field tells
+ *        whether the operand has values of its own, i.e. is not a
+ *        number.
+ */
+template <typename X, typename Enable = void>
+struct ExpressionOperand {
+  static const bool valid = false;
+  static const bool field = false;
+};
+
+template <typename T>
+struct ExpressionOperand<FieldView<T>, void> {
+  static const bool valid = true;
+  static const bool field = true;
+  typedef ExpressionLeaf<typename std::remove_const<T>::type> type;
+  static type make(const FieldView<T>& view) {
+    return type(view.data(), view.size(), 1, view.size());
+  }
+};
+
+template <typename T>
+struct ExpressionOperand<StridedView<T>, void> {
+  static const bool valid = true;
+  static const bool field = true;
+  typedef ExpressionLeaf<typename std::remove_const<T>::type> type;
+  static type make(const StridedView<T>& view) {
+    return type(view.data(), view.size(), view.stride(), view.block());
+  }
+};
+
+template <typename X>
+struct ExpressionOperand<X, typename std::enable_if<
+                              std::is_arithmetic<X>::value>::type> {
+  static const bool valid = true;
+  static const bool field = false;
+  typedef ExpressionScalar type;
+  static type make(X value) { return type(static_cast<double>(value)); }
+};
+
+template <typename T>
+struct ExpressionOperand<ExpressionLeaf<T>, void> {
+  static const bool valid = true;
+  static const bool field = true;
+  typedef ExpressionLeaf<T> type;
+  static const type& make(const type& expression) { return expression; }
+};
+
+template <typename Op, typename L, typename R>
+struct ExpressionOperand<BinaryExpression<Op, L, R>, void> {
+  static const bool valid = true;
+  static const bool field = true;
+  typedef BinaryExpression<Op, L, R> type;
+  static const type& make(const type& expression) { return expression; }
+};
+
+template <typename Op, typename E>
+struct ExpressionOperand<UnaryExpression<Op, E>, void> {
+  static const bool valid = true;
+  static const bool field = true;
+  typedef UnaryExpression<Op, E> type;
+  static const type& make(const type& expression) { return expression; }
+};
+
+/**
+ * @brief The expression type of Op applied to two operands, if at
+ *        least one of them has values of its own.
+ */
+template <typename Op, typename L, typename R, typename Enable = void>
+struct BinaryExpressionOf {};
+
+template <typename Op, typename L, typename R>
+struct BinaryExpressionOf<Op, L, R, typename std::enable_if<
+                                      ExpressionOperand<L>::valid
+                                      && ExpressionOperand<R>::valid
+                                      && (ExpressionOperand<L>::field
+                                          || ExpressionOperand<R>::field)
+                                      >::type> {
+  typedef BinaryExpression<Op, typename ExpressionOperand<L>::type,
+                           typename ExpressionOperand<R>::type> type;
+  static type make(const L& left, const R& right) {
+    return type(ExpressionOperand<L>::make(left),
+                ExpressionOperand<R>::make(right));
+  }
+};
+
+/**
+ * @brief The expression type of Op applied to an operand with values
+ *        of its own.
+ */
+template <typename Op, typename E, typename Enable = void>
+struct UnaryExpressionOf {};
+
+template <typename Op, typename E>
+struct UnaryExpressionOf<Op, E, typename std::enable_if<
+                                  ExpressionOperand<E>::field>::type> {
+  typedef UnaryExpression<Op, typename ExpressionOperand<E>::type> type;
+  static type make(const E& operand) {
+    return type(ExpressionOperand<E>::make(operand));
+  }
+};
+
+template <typename L, typename R>
+typename BinaryExpressionOf<ExpressionOps::Add, L, R>::type
+operator+(const L& left, const R& right) {
+  return BinaryExpressionOf<ExpressionOps::Add, L, R>::make(left, right);
+}
+
+template <typename L, typename R>
+typename BinaryExpressionOf<ExpressionOps::Subtract, L, R>::type
+operator-(const L& left, const R& right) {
+  return BinaryExpressionOf<ExpressionOps::Subtract, L, R>::make(left,
+                                                                 right);
+}
+
+template <typename L, typename R>
+typename BinaryExpressionOf<ExpressionOps::Multiply, L, R>::type
+operator*(const L& left, const R& right) {
+  return BinaryExpressionOf<ExpressionOps::Multiply, L, R>::make(left,
+                                                                 right);
+}
+
+template <typename L, typename R>
+typename BinaryExpressionOf<ExpressionOps::Divide, L, R>::type
+operator/(const L& left, const R& right) {
+  return BinaryExpressionOf<ExpressionOps::Divide, L, R>::make(left, right);
+}
+
+template <typename E>
+typename UnaryExpressionOf<ExpressionOps::Negate, E>::type
+operator-(const E& operand) {
+  return UnaryExpressionOf<ExpressionOps::Negate, E>::make(operand);
+}
+
+/**
+ * @brief The smaller of the two values, value by value.
+ */
+template <typename L, typename R>
+typename BinaryExpressionOf<ExpressionOps::Minimum, L, R>::type
+minimum(const L& left, const R& right) {
+  return BinaryExpressionOf<ExpressionOps::Minimum, L, R>::make(left, right);
+}
+
+/**
+ * @brief The larger of the two values, value by value.
+ */
+template <typename L, typename R>
+typename BinaryExpressionOf<ExpressionOps::Maximum, L, R>::type
+maximum(const L& left, const R& right) {
+  return BinaryExpressionOf<ExpressionOps::Maximum, L, R>::make(left, right);
+}
+
+template <typename E>
+typename UnaryExpressionOf<ExpressionOps::Absolute, E>::type
+absolute(const E& operand) {
+  return UnaryExpressionOf<ExpressionOps::Absolute, E>::make(operand);
+}
+
+template <typename E>
+typename UnaryExpressionOf<ExpressionOps::SquareRoot, E>::type
+squareRoot(const E& operand) {
+  return UnaryExpressionOf<ExpressionOps::SquareRoot, E>::make(operand);
+}
+
+/**
+ * @brief Number of values per block of the parallel loops of
+ *        evaluate() and evaluateStatistics().
+ */
+const size_t expression_block_values = 1 << 12;
+
+/**
+ * @brief Write the values of an expression to a view of the same size,
+ *        converted to T.
+ *
+ * The view may be one of the operands: every value is read before it
+ * is written.
+ */
+template <typename T, typename E>
+void evaluate(const StridedView<T>& target, const E& operand) {
+  typedef ExpressionOperand<E> Operand;
+  static_assert(Operand::field, "evaluate() needs a view or expression");
+  const typename Operand::type& expression = Operand::make(operand);
+  const size_t size = target.size();
+  if (expression.size() != size) {
+    throw std::invalid_argument("The target of a field expression "
+                                "differs in size");
+  }
+  const ExpressionLeaf<T> output(target.data(), size, target.stride(),
+                                 target.block());
+  const bool unit_stride = output.unitStride() && expression.unitStride();
+  const size_t num_blocks = (size + expression_block_values - 1)
+                            / expression_block_values;
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t end = std::min((block + 1) * expression_block_values,
+                                size);
+    size_t i = block * expression_block_values;
+    while (i < end) {
+      const size_t length = std::min(std::min(end - i,
+                                              output.runLength(i)),
+                                     expression.runLength(i));
+      const typename ExpressionLeaf<T>::Run out = output.run(i);
+      T* values = const_cast<T*>(out.data);
+      const typename Operand::type::Run run = expression.run(i);
+      if (unit_stride) {
+        for (size_t k = 0; k < length; ++k) {
+          values[k] = static_cast<T>(run.unit(k));
+        }
+      } else {
+        for (size_t k = 0; k < length; ++k) {
+          values[k * out.step] = static_cast<T>(run[k]);
+        }
+      }
+      i += length;
+    }
+  }
+}
+
+template <typename T, typename E>
+void evaluate(const FieldView<T>& target, const E& operand) {
+  evaluate(StridedView<T>(target.data(), target.size(), 1, target.size()),
+           operand);
+}
+
+/**
+ * @brief Minimum, maximum and sum of the values of an expression, with
+ *        the positions of the first extremes.
+ *
+ * The expression is reduced as fieldStatistics() reduces a field: the
+ * block results are combined in block order, so the result does not
+ * depend on the number of threads, and the loops over the values are
+ * free of branches. Only the block holding an extreme is evaluated a
+ * second time to locate it.
+ */
+template <typename E>
+FieldStatistics evaluateStatistics(const E& operand) {
+  typedef ExpressionOperand<E> Operand;
+  static_assert(Operand::field,
+                "evaluateStatistics() needs a view or expression");
+  typedef typename Operand::type Expression;
+  const Expression& expression = Operand::make(operand);
+  const size_t size = expression.size();
+  const size_t num_blocks = (size + expression_block_values - 1)
+                            / expression_block_values;
+  std::vector<FieldStatistics> blocks(num_blocks, FieldStatistics::empty());
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t begin = block * expression_block_values;
+    const size_t end = std::min(begin + expression_block_values, size);
+    double min = blocks[block].min;
+    double max = blocks[block].max;
+    double sum = 0.0;
+    size_t i = begin;
+    while (i < end) {
+      const size_t length = std::min(end - i, expression.runLength(i));
+      const typename Expression::Run run = expression.run(i);
+      for (size_t k = 0; k < length; ++k) {
+        const double value = run[k];
+        min = std::min(min, value);
+        max = std::max(max, value);
+        sum += value;
+      }
+      i += length;
+    }
+    blocks[block].count = end - begin;
+    blocks[block].min = min;
+    blocks[block].max = max;
+    blocks[block].sum = sum;
+  }
+
+  FieldStatistics statistics = FieldStatistics::empty();
+  size_t min_block = FieldStatistics::npos;
+  size_t max_block = FieldStatistics::npos;
+  for (size_t block = 0; block < num_blocks; ++block) {
+    statistics.count += blocks[block].count;
+    statistics.sum += blocks[block].sum;
+    if (blocks[block].min < statistics.min) {
+      statistics.min = blocks[block].min;
+      min_block = block;
+    }
+    if (blocks[block].max > statistics.max) {
+      statistics.max = blocks[block].max;
+      max_block = block;
+    }
+  }
+
+  auto locate = [&](size_t block, double target) -> size_t {
+    const size_t begin = block * expression_block_values;
+    const size_t end = std::min(begin + expression_block_values, size);
+    size_t i = begin;
+    while (i < end) {
+      const size_t length = std::min(end - i, expression.runLength(i));
+      const typename Expression::Run run = expression.run(i);
+      for (size_t k = 0; k < length; ++k) {
+        if (run[k] == target) {
+          return i + k;
+        }
+      }
+      i += length;
+    }
+    return FieldStatistics::npos;
+  };
+  if (min_block != FieldStatistics::npos) {
+    statistics.argmin = locate(min_block, statistics.min);
+  }
+  if (max_block != FieldStatistics::npos) {
+    statistics.argmax = locate(max_block, statistics.max);
+  }
+  return statistics;
+}
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDEXPRESSION_H_
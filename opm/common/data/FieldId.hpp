@@ -0,0 +1,85 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDID_H_
+#define OPM_COMMON_DATA_FIELDID_H_
+
+#include <cstddef>
+
+namespace Opm {
+/**
+ * @class FieldId
+ * @brief Typed handle to a field registered in a SimulationDataContainer.
+ *
+ * A handle is the position of the field in the field table of the
+ * container, so looking a field up by handle is a plain array index.
+ * Since copies of a container keep the registration order, a handle
+ * obtained from one container is valid for all its copies. The @p Tag
+ * parameter keeps cell and face handles apart at compile time.
+ */
+template <typename Tag>
+class FieldId {
+ public:
+  /**
+   * @brief Construct an invalid handle.
+   */
+  FieldId() : m_index(invalidIndex()) {}
+
+  /**
+   * @brief Construct a handle referring to table position @p index.
+   */
+  explicit FieldId(size_t index) : m_index(index) {}
+
+  /**
+   * @brief Position of the field in the field table.
+   */
+  size_t index() const { return m_index; }
+
+  /**
+   * @brief Check whether the handle refers to a field.
+   */
+  bool valid() const { return m_index != invalidIndex(); }
+
+  bool operator==(const FieldId& other) const {
+    return m_index == other.m_index;
+  }
+
+  bool operator!=(const FieldId& other) const {
+    return m_index != other.m_index;
+  }
+
+ private:
+  static size_t invalidIndex() { return static_cast<size_t>(-1); }
+
+  size_t m_index;  //!< position in the field table
+};
+
+struct CellFieldTag {};
+struct FaceFieldTag {};
+struct SparseCellFieldTag {};
+struct SparseFaceFieldTag {};
+
+typedef FieldId<CellFieldTag> CellFieldId;  //!< handle to a cell field
+typedef FieldId<FaceFieldTag> FaceFieldId;  //!< handle to a face field
+//! handle to a sparse cell field
+typedef FieldId<SparseCellFieldTag> SparseCellFieldId;
+//! handle to a sparse face field
+typedef FieldId<SparseFaceFieldTag> SparseFaceFieldId;
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDID_H_
@@ -0,0 +1,99 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_FIELDKEY_H_
+#define OPM_COMMON_DATA_FIELDKEY_H_
+
+#include <cstddef>
+
+#include <opm/common/data/FieldId.hpp>
+
+namespace Opm {
+/**
+ * @brief Number of key slots whose handles a FieldTable remembers;
+ *        fields of further keys are looked up by name every time.
+ */
+const size_t max_field_keys = 64;
+
+/**
+ * @brief A new key slot, unique in the process.
+ */
+size_t nextFieldKeySlot();
+
+/**
+ * @brief The slot of the key type @p Key, assigned on first use.
+ */
+template <typename Key>
+size_t fieldKeySlot() {
+  static const size_t slot = nextFieldKeySlot();
+  return slot;
+}
+
+/**
+ * @brief Base of the compile-time keys of cell fields.
+ *
+ * A key is a tag type naming a field. Accessing a field through its
+ * key (SimulationDataContainer::get<Key>()) looks the name up once
+ * per container; afterwards the handle is read from the slot of the
+ * key, without a lookup:
+ *
+ *     struct Porosity : CellFieldKey {
+ *       static constexpr const char* name() { return "PORO"; }
+ *     };
+ *     container.registerData<Porosity>(1);
+ *     FieldView<double> poro = container.get<Porosity>();
+ */
+struct CellFieldKey {
+  typedef CellFieldId Id;
+};
+
+/**
+ * @brief Base of the compile-time keys of face fields.
+ */
+struct FaceFieldKey {
+  typedef FaceFieldId Id;
+};
+
+/**
+ * @brief Keys of the standard fields.
+ */
+namespace FieldKeys {
+struct Pressure : CellFieldKey {
+  static constexpr const char* name() { return "PRESSURE"; }
+};
+
+struct Saturation : CellFieldKey {
+  static constexpr const char* name() { return "SATURATION"; }
+};
+
+struct Temperature : CellFieldKey {
+  static constexpr const char* name() { return "TEMPERATURE"; }
+};
+
+struct FacePressure : FaceFieldKey {
+  static constexpr const char* name() { return "FACEPRESSURE"; }
+};
+
+struct FaceFlux : FaceFieldKey {
+  static constexpr const char* name() { return "FACEFLUX"; }
+};
+}  // namespace FieldKeys
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDKEY_H_
@@ -0,0 +1,148 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/FieldLayout.hpp"
+
+namespace Opm {
+namespace {
+// Entities per tile of convert(); a multiple of any usual AoSoA width.
+const size_t tile_entities = 1024;
+
+// Call f(position, entity, length) for the runs of contiguous values of
+// one component of the entities [begin, end).
+template <typename F>
+void forEachRun(const FieldLayout& layout, size_t component,
+                size_t num_entities, size_t components, size_t begin,
+                size_t end, F f) {
+  const size_t offset = layout.componentOffset(component, num_entities);
+  const size_t block = layout.componentBlock(num_entities);
+  const size_t stride = layout.componentStride(num_entities, components);
+  if (block == 1) {
+    for (size_t entity = begin; entity < end; ++entity) {
+      f(offset + entity * stride, entity, 1);
+    }
+    return;
+  }
+  size_t entity = begin;
+  while (entity < end) {
+    const size_t length = std::min(block - entity % block, end - entity);
+    f(offset + entity / block * stride + entity % block, entity, length);
+    entity += length;
+  }
+}
+
+template <typename T>
+void convertTiles(const T* source, const FieldLayout& from, T* target,
+                  const FieldLayout& to, size_t num_entities,
+                  size_t components) {
+  const size_t num_tiles = (num_entities + tile_entities - 1)
+                           / tile_entities;
+#pragma omp parallel for schedule(static)
+  for (size_t tile = 0; tile < num_tiles; ++tile) {
+    // Every component of the tile goes through a contiguous buffer,
+    // so that both sides are copied in runs of contiguous values.
+    T buffer[tile_entities];
+    const size_t begin = tile * tile_entities;
+    const size_t end = std::min(begin + tile_entities, num_entities);
+    for (size_t component = 0; component < components; ++component) {
+      forEachRun(from, component, num_entities, components, begin, end,
+                 [&](size_t position, size_t entity, size_t length) {
+                   std::copy(source + position, source + position + length,
+                             buffer + (entity - begin));
+                 });
+      forEachRun(to, component, num_entities, components, begin, end,
+                 [&](size_t position, size_t entity, size_t length) {
+                   std::copy(buffer + (entity - begin),
+                             buffer + (entity - begin) + length,
+                             target + position);
+                 });
+    }
+  }
+}
+}  // namespace
+
+FieldLayout FieldLayout::aosoa(size_t width) {
+  if (width == 0 || width > UINT32_MAX) {
+    OPM_THROW(std::invalid_argument, "Invalid AoSoA block width " << width);
+  }
+  return FieldLayout(Kind::AoSoA, width);
+}
+
+FieldLayout FieldLayout::fromKind(uint32_t kind, uint32_t width) {
+  switch (kind) {
+    case static_cast<uint32_t>(Kind::Interleaved):
+      return interleaved();
+    case static_cast<uint32_t>(Kind::Planar):
+      return planar();
+    case static_cast<uint32_t>(Kind::AoSoA):
+      return aosoa(width);
+    default:
+      OPM_THROW(std::runtime_error, "Unknown field layout " << kind);
+  }
+}
+
+void FieldLayout::convert(const double* source, const FieldLayout& from,
+                          double* target, const FieldLayout& to,
+                          size_t num_entities, size_t components) {
+  convertTiles(source, from, target, to, num_entities, components);
+}
+
+void FieldLayout::convert(const float* source, const FieldLayout& from,
+                          float* target, const FieldLayout& to,
+                          size_t num_entities, size_t components) {
+  convertTiles(source, from, target, to, num_entities, components);
+}
+
+void FieldLayout::convert(const void* source, const FieldLayout& from,
+                          void* target, const FieldLayout& to,
+                          FieldType type, size_t num_entities,
+                          size_t components) {
+  // Converting moves values without looking at them, so the types are
+  // handled by their size.
+  switch (valueSize(type)) {
+    case 1:
+      convertTiles(static_cast<const uint8_t*>(source), from,
+                   static_cast<uint8_t*>(target), to, num_entities,
+                   components);
+      break;
+    case 2:
+      convertTiles(static_cast<const uint16_t*>(source), from,
+                   static_cast<uint16_t*>(target), to, num_entities,
+                   components);
+      break;
+    case 4:
+      convertTiles(static_cast<const uint32_t*>(source), from,
+                   static_cast<uint32_t*>(target), to, num_entities,
+                   components);
+      break;
+    default:
+      if (type == FieldType::Bit) {
+        OPM_THROW(std::logic_error, "Bit fields cannot change the layout");
+      }
+      convertTiles(static_cast<const uint64_t*>(source), from,
+                   static_cast<uint64_t*>(target), to, num_entities,
+                   components);
+      break;
+  }
+}
+}  // namespace Opm
@@ -0,0 +1,180 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDLAYOUT_H_
+#define OPM_COMMON_DATA_FIELDLAYOUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "opm/common/data/FieldType.hpp"
+
+namespace Opm {
+/**
+ * @class FieldLayout
+ * @brief Order of the values of a field with several components.
+ *
+ * For entity e and component k of a field with K components on n
+ * entities, the value is stored at
+ *
+ * - Interleaved: e * K + k (cell by cell, the default);
+ * - Planar:      k * n + e (component by component);
+ * - AoSoA:       (e / W) * W * K + k * W + e % W, for blocks of W
+ *                entities; the last block is padded with zeros, so the
+ *                field holds ceil(n / W) * W * K values.
+ *
+ * Every component is a sequence of blocks of contiguous values with
+ * equal distance between the blocks, which is what the component
+ * views of SimulationDataContainer use.
+ */
+class FieldLayout {
+ public:
+  enum class Kind : uint32_t { Interleaved = 0, Planar = 1, AoSoA = 2 };
+
+  /**
+   * @brief The interleaved layout.
+   */
+  FieldLayout() : m_kind(Kind::Interleaved), m_width(1) {}
+
+  static FieldLayout interleaved() { return FieldLayout(); }
+  static FieldLayout planar() { return FieldLayout(Kind::Planar, 1); }
+
+  /**
+   * @brief The AoSoA layout with blocks of @p width entities.
+   */
+  static FieldLayout aosoa(size_t width);
+
+  /**
+   * @brief Layout from its stored representation.
+   */
+  static FieldLayout fromKind(uint32_t kind, uint32_t width);
+
+  Kind kind() const { return m_kind; }
+
+  /**
+   * @brief Entities per block of the AoSoA layout; 1 otherwise.
+   */
+  size_t width() const { return m_width; }
+
+  bool operator==(const FieldLayout& other) const {
+    return m_kind == other.m_kind && m_width == other.m_width;
+  }
+  bool operator!=(const FieldLayout& other) const {
+    return !(*this == other);
+  }
+
+  /**
+   * @brief Number of values of a field of @p components components
+   *        on @p num_entities entities, including padding.
+   */
+  size_t count(size_t num_entities, size_t components) const {
+    if (m_kind == Kind::AoSoA) {
+      return (num_entities + m_width - 1) / m_width * m_width * components;
+    }
+    return num_entities * components;
+  }
+
+  /**
+   * @brief Position of component @p component of entity @p entity.
+   */
+  size_t index(size_t entity, size_t component, size_t num_entities,
+               size_t components) const {
+    switch (m_kind) {
+      case Kind::Planar:
+        return component * num_entities + entity;
+      case Kind::AoSoA:
+        return (entity / m_width) * m_width * components
+               + component * m_width + entity % m_width;
+      default:
+        return entity * components + component;
+    }
+  }
+
+  /**
+   * @brief Position of the first value of a component.
+   */
+  size_t componentOffset(size_t component, size_t num_entities) const {
+    switch (m_kind) {
+      case Kind::Planar:
+        return component * num_entities;
+      case Kind::AoSoA:
+        return component * m_width;
+      default:
+        return component;
+    }
+  }
+
+  /**
+   * @brief Number of contiguous values of a component in each block.
+   */
+  size_t componentBlock(size_t num_entities) const {
+    switch (m_kind) {
+      case Kind::Planar:
+        return num_entities > 0 ? num_entities : 1;
+      case Kind::AoSoA:
+        return m_width;
+      default:
+        return 1;
+    }
+  }
+
+  /**
+   * @brief Distance between the blocks of a component.
+   */
+  size_t componentStride(size_t num_entities, size_t components) const {
+    switch (m_kind) {
+      case Kind::Planar:
+        return num_entities * components;
+      case Kind::AoSoA:
+        return m_width * components;
+      default:
+        return components;
+    }
+  }
+
+  /**
+   * @brief Copy a field from one layout to another.
+   *
+   * The work is split in tiles of entities, which run in parallel when
+   * OpenMP is enabled. Padding in @p target is not written.
+   */
+  static void convert(const double* source, const FieldLayout& from,
+                      double* target, const FieldLayout& to,
+                      size_t num_entities, size_t components);
+  static void convert(const float* source, const FieldLayout& from,
+                      float* target, const FieldLayout& to,
+                      size_t num_entities, size_t components);
+
+  /**
+   * @brief Copy a field of scalar type @p type to another layout.
+   *
+   * Bit fields are always interleaved; converting them throws
+   * std::logic_error.
+   */
+  static void convert(const void* source, const FieldLayout& from,
+                      void* target, const FieldLayout& to, FieldType type,
+                      size_t num_entities, size_t components);
+
+ private:
+  FieldLayout(Kind kind, size_t width) : m_kind(kind), m_width(width) {}
+
+  Kind m_kind;  //!< the layout
+  size_t m_width;  //!< entities per AoSoA block
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDLAYOUT_H_
@@ -0,0 +1,114 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include <utility>
+#include "opm/common/data/FieldRegistry.hpp"
+
+namespace Opm {
+namespace {
+const size_t initial_capacity = 16;
+}  // namespace
+
+const size_t FieldRegistry::npos;
+
+FieldRegistry::Table::Table(size_t capacity)
+    : mask(capacity - 1),
+      slots(new std::atomic<const Entry*>[capacity]) {
+  for (size_t slot = 0; slot < capacity; ++slot) {
+    slots[slot].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+FieldRegistry::FieldRegistry() : m_entries(), m_tables(), m_current() {
+  m_tables.emplace_back(new Table(initial_capacity));
+  m_current.store(m_tables.back().get(), std::memory_order_release);
+}
+
+FieldRegistry::FieldRegistry(const FieldRegistry& other) : FieldRegistry() {
+  for (const Entry& entry : other.m_entries) {
+    insert(entry.name, entry.index);
+  }
+}
+
+FieldRegistry::FieldRegistry(FieldRegistry&& other) : FieldRegistry() {
+  swap(other);
+}
+
+void FieldRegistry::swap(FieldRegistry& other) {
+  // Not concurrent with lookups: both registries are quiescent.
+  using std::swap;
+  swap(m_entries, other.m_entries);
+  swap(m_tables, other.m_tables);
+  Table* current = m_current.load(std::memory_order_relaxed);
+  m_current.store(other.m_current.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+  other.m_current.store(current, std::memory_order_relaxed);
+}
+
+size_t FieldRegistry::find(const char* name, size_t length) const {
+  const Table* table = m_current.load(std::memory_order_acquire);
+  const size_t key = hash(name, length);
+  for (size_t slot = key & table->mask;; slot = (slot + 1) & table->mask) {
+    const Entry* entry = table->slots[slot].load(std::memory_order_acquire);
+    if (!entry) {
+      return npos;
+    }
+    if (entry->hash == key &&
+        entry->name.compare(0, std::string::npos, name, length) == 0) {
+      return entry->index;
+    }
+  }
+}
+
+void FieldRegistry::insert(const std::string& name, size_t index) {
+  Table* table = m_current.load(std::memory_order_relaxed);
+  if (2 * (m_entries.size() + 1) > table->mask + 1) {
+    // Readers still probing the old table find every entry it has.
+    m_tables.emplace_back(new Table(2 * (table->mask + 1)));
+    table = m_tables.back().get();
+    for (const Entry& entry : m_entries) {
+      place(*table, &entry);
+    }
+    m_current.store(table, std::memory_order_release);
+  }
+  Entry entry = { name, index, hash(name.data(), name.size()) };
+  m_entries.push_back(entry);
+  place(*table, &m_entries.back());
+}
+
+size_t FieldRegistry::hash(const char* name, size_t length) {
+  // FNV-1a.
+  uint64_t value = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; ++i) {
+    value ^= static_cast<unsigned char>(name[i]);
+    value *= 1099511628211ULL;
+  }
+  return static_cast<size_t>(value);
+}
+
+void FieldRegistry::place(Table& table, const Entry* entry) {
+  size_t slot = entry->hash & table.mask;
+  while (table.slots[slot].load(std::memory_order_relaxed)) {
+    slot = (slot + 1) & table.mask;
+  }
+  table.slots[slot].store(entry, std::memory_order_release);
+}
+}  // namespace Opm
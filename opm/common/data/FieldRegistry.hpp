@@ -0,0 +1,94 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_FIELDREGISTRY_H_
+#define OPM_COMMON_DATA_FIELDREGISTRY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Opm {
+/**
+ * @class FieldRegistry
+ * @brief Index from field names to table positions, with lock-free
+ *        lookups.
+ *
+ * The registry is a hash table with open addressing over pointers to
+ * its entries, kept at most half full. Entries are never changed or
+ * removed once inserted. Growing builds a new table and publishes it
+ * with one atomic store; the old tables are kept until the registry is
+ * destroyed, so a find() running concurrently with insert() always
+ * probes a complete table. find() takes no lock and does not allocate;
+ * insert() calls must be serialized by the caller.
+ */
+class FieldRegistry {
+ public:
+  /**
+   * @brief Returned by find() for a name which is not registered.
+   */
+  static const size_t npos = static_cast<size_t>(-1);
+
+  FieldRegistry();
+  FieldRegistry(const FieldRegistry& other);
+  FieldRegistry(FieldRegistry&& other);
+  FieldRegistry& operator=(const FieldRegistry& other) = delete;
+  void swap(FieldRegistry& other);
+
+  /**
+   * @brief The position registered for @p name, or npos.
+   */
+  size_t find(const char* name, size_t length) const;
+
+  /**
+   * @brief Register a new name; it must not be registered already.
+   */
+  void insert(const std::string& name, size_t index);
+
+  /**
+   * @brief Number of registered names.
+   */
+  size_t size() const { return m_entries.size(); }
+
+ private:
+  struct Entry {
+    std::string name;
+    size_t index;
+    size_t hash;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity);
+    size_t mask;  //!< capacity - 1, for a power of two capacity
+    std::unique_ptr<std::atomic<const Entry*>[]> slots;
+  };
+
+  static size_t hash(const char* name, size_t length);
+  static void place(Table& table, const Entry* entry);
+
+  std::deque<Entry> m_entries;  //!< in insertion order, at fixed addresses
+  std::vector<std::unique_ptr<Table>> m_tables;  //!< the last is current
+  std::atomic<Table*> m_current;  //!< the table find() probes
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDREGISTRY_H_
@@ -0,0 +1,216 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "opm/common/data/FieldBits.hpp"
+#include "opm/common/data/FieldStatistics.hpp"
+
+namespace Opm {
+namespace {
+const size_t block_values = 1 << 14;
+
+// One component: entity e is values[(e / block) * stride + e % block].
+struct Component {
+  size_t size;
+  size_t stride;
+  size_t block;
+};
+
+// Calls @p run(first_entity, pointer, length) for the contiguous runs
+// of entities [begin, end).
+template <typename T, typename Run>
+void forEachRun(const T* values, const Component& component, size_t begin,
+                size_t end, Run run) {
+  if (component.block == 1) {
+    for (size_t entity = begin; entity < end; ++entity) {
+      run(entity, values + entity * component.stride, size_t(1));
+    }
+    return;
+  }
+  size_t entity = begin;
+  while (entity < end) {
+    const size_t offset = entity % component.block;
+    const size_t length = std::min(component.block - offset, end - entity);
+    run(entity, values + (entity / component.block) * component.stride
+                + offset, length);
+    entity += length;
+  }
+}
+
+template <typename T>
+FieldStatistics reduce(const T* values, const Component& component) {
+  // Branch free minimum, maximum and sum per block first.
+  const size_t num_blocks = (component.size + block_values - 1)
+                            / block_values;
+  std::vector<FieldStatistics> blocks(num_blocks, FieldStatistics::empty());
+#pragma omp parallel for schedule(static)
+  for (size_t block_index = 0; block_index < num_blocks; ++block_index) {
+    FieldStatistics& block = blocks[block_index];
+    const size_t begin = block_index * block_values;
+    const size_t end = std::min(begin + block_values, component.size);
+    double min = block.min;
+    double max = block.max;
+    double sum = 0.0;
+    forEachRun(values, component, begin, end,
+               [&](size_t, const T* run, size_t length) {
+                 for (size_t i = 0; i < length; ++i) {
+                   const double value = run[i];
+                   min = std::min(min, value);
+                   max = std::max(max, value);
+                   sum += value;
+                 }
+               });
+    block.count = end - begin;
+    block.min = min;
+    block.max = max;
+    block.sum = sum;
+  }
+
+  FieldStatistics statistics = FieldStatistics::empty();
+  size_t min_block = FieldStatistics::npos;
+  size_t max_block = FieldStatistics::npos;
+  for (size_t block_index = 0; block_index < num_blocks; ++block_index) {
+    const FieldStatistics& block = blocks[block_index];
+    statistics.count += block.count;
+    statistics.sum += block.sum;
+    if (block.min < statistics.min) {
+      statistics.min = block.min;
+      min_block = block_index;
+    }
+    if (block.max > statistics.max) {
+      statistics.max = block.max;
+      max_block = block_index;
+    }
+  }
+
+  // The first entity with the extreme value, within its block.
+  auto locate = [&](size_t block_index, double target) {
+    size_t found = FieldStatistics::npos;
+    const size_t begin = block_index * block_values;
+    const size_t end = std::min(begin + block_values, component.size);
+    forEachRun(values, component, begin, end,
+               [&](size_t entity, const T* run, size_t length) {
+                 for (size_t i = 0;
+                      i < length && found == FieldStatistics::npos; ++i) {
+                   if (static_cast<double>(run[i]) == target) {
+                     found = entity + i;
+                   }
+                 }
+               });
+    return found;
+  };
+  if (min_block != FieldStatistics::npos) {
+    statistics.argmin = locate(min_block, statistics.min);
+  }
+  if (max_block != FieldStatistics::npos) {
+    statistics.argmax = locate(max_block, statistics.max);
+  }
+  return statistics;
+}
+
+FieldStatistics reduceBits(const FieldBits::Word* words, size_t num_entities,
+                           size_t components, size_t component) {
+  const BitView<const FieldBits::Word> bits(words,
+                                            num_entities * components);
+  FieldStatistics statistics = FieldStatistics::empty();
+  statistics.count = num_entities;
+  size_t first_clear = FieldStatistics::npos;
+  size_t first_set = FieldStatistics::npos;
+  size_t set = 0;
+  for (size_t entity = 0; entity < num_entities; ++entity) {
+    if (bits[entity * components + component]) {
+      ++set;
+      if (first_set == FieldStatistics::npos) {
+        first_set = entity;
+      }
+    } else if (first_clear == FieldStatistics::npos) {
+      first_clear = entity;
+    }
+  }
+  statistics.sum = set;
+  if (num_entities > 0) {
+    statistics.min = first_clear == FieldStatistics::npos ? 1.0 : 0.0;
+    statistics.max = first_set == FieldStatistics::npos ? 0.0 : 1.0;
+    statistics.argmin = first_clear == FieldStatistics::npos ? 0
+                                                             : first_clear;
+    statistics.argmax = first_set == FieldStatistics::npos ? 0 : first_set;
+  }
+  return statistics;
+}
+}  // namespace
+
+const size_t FieldStatistics::npos;
+
+FieldStatistics FieldStatistics::empty() {
+  FieldStatistics statistics = {
+    0, std::numeric_limits<double>::infinity(),
+    -std::numeric_limits<double>::infinity(), 0.0, npos, npos };
+  return statistics;
+}
+
+FieldStatistics fieldStatistics(const void* values, FieldType type,
+                                const FieldLayout& layout,
+                                size_t num_entities, size_t components,
+                                size_t component) {
+  if (type == FieldType::Bit) {
+    return reduceBits(static_cast<const FieldBits::Word*>(values),
+                      num_entities, components, component);
+  }
+  const Component view = {
+    num_entities, layout.componentStride(num_entities, components),
+    layout.componentBlock(num_entities) };
+  const size_t offset = layout.componentOffset(component, num_entities);
+  switch (type) {
+    case FieldType::Float64:
+      return reduce(static_cast<const double*>(values) + offset, view);
+    case FieldType::Float32:
+      return reduce(static_cast<const float*>(values) + offset, view);
+    case FieldType::Int32:
+      return reduce(static_cast<const int32_t*>(values) + offset, view);
+    case FieldType::Int16:
+      return reduce(static_cast<const int16_t*>(values) + offset, view);
+    case FieldType::UInt8:
+      return reduce(static_cast<const uint8_t*>(values) + offset, view);
+    case FieldType::Bit:
+      break;
+  }
+  return FieldStatistics::empty();
+}
+
+FieldStatistics mergeStatistics(const FieldStatistics& first,
+                                const FieldStatistics& second) {
+  FieldStatistics merged = first;
+  merged.count += second.count;
+  merged.sum += second.sum;
+  if (second.min < first.min ||
+      (second.min == first.min && second.argmin < first.argmin)) {
+    merged.min = second.min;
+    merged.argmin = second.argmin;
+  }
+  if (second.max > first.max ||
+      (second.max == first.max && second.argmax < first.argmax)) {
+    merged.max = second.max;
+    merged.argmax = second.argmax;
+  }
+  return merged;
+}
+}  // namespace Opm
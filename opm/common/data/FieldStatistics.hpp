@@ -0,0 +1,89 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDSTATISTICS_H_
+#define OPM_COMMON_DATA_FIELDSTATISTICS_H_
+
+#include <cstddef>
+#include <limits>
+
+#include <opm/common/data/FieldLayout.hpp>
+#include <opm/common/data/FieldType.hpp>
+
+namespace Opm {
+/**
+ * @brief Minimum, maximum and sum of one component of a field, or of
+ *        all its components.
+ *
+ * The statistics are kept in double precision for all types. NaN
+ * values are skipped by the minimum and maximum but make the sum NaN.
+ * argmin and argmax are the first entity (cell or face) holding the
+ * minimum and the maximum; for statistics over all components the
+ * component is not recorded.
+ */
+struct FieldStatistics {
+  static const size_t npos = static_cast<size_t>(-1);
+
+  size_t count;  //!< number of values
+  double min;  //!< smallest value, +infinity without values
+  double max;  //!< largest value, -infinity without values
+  double sum;  //!< sum of the values
+  size_t argmin;  //!< entity of the first minimum, or npos
+  size_t argmax;  //!< entity of the first maximum, or npos
+
+  /**
+   * @brief The statistics of no values.
+   */
+  static FieldStatistics empty();
+
+  double mean() const {
+    return count > 0 ? sum / count
+                     : std::numeric_limits<double>::quiet_NaN();
+  }
+};
+
+/**
+ * @brief Statistics of one component of a field.
+ *
+ * The component is reduced in blocks, in parallel when OpenMP is
+ * enabled; the block results are combined in block order, so the
+ * result, the sum included, does not depend on the number of threads.
+ * The loops over contiguous runs of values are free of branches, so
+ * the compiler can vectorize them; the extremes are located within
+ * the block holding them afterwards.
+ * @param values the values of the field, laid out as @p layout says
+ * @param type the scalar type of the values
+ * @param layout the layout of the field
+ * @param num_entities number of cells or faces
+ * @param components components of the field
+ * @param component the component to reduce
+ */
+FieldStatistics fieldStatistics(const void* values, FieldType type,
+                                const FieldLayout& layout,
+                                size_t num_entities, size_t components,
+                                size_t component);
+
+/**
+ * @brief Statistics over the values of both @p first and @p second;
+ *        ties go to the smaller entity.
+ */
+FieldStatistics mergeStatistics(const FieldStatistics& first,
+                                const FieldStatistics& second);
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDSTATISTICS_H_
@@ -0,0 +1,762 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "opm/common/data/FieldBits.hpp"
+#include "opm/common/data/FieldTable.hpp"
+#include "opm/common/data/FirstTouch.hpp"
+
+namespace Opm {
+namespace {
+// Number of doubles in one cache line; every arena field is padded to
+// a multiple of this.
+const size_t line_doubles = AlignedBuffer::alignment / sizeof(double);
+
+// Default dirty tracking chunk: 64 KiB of values.
+const size_t default_chunk_size = 65536 / sizeof(double);
+
+size_t paddedCount(size_t count) {
+  return (count + line_doubles - 1) / line_doubles * line_doubles;
+}
+
+template <typename T>
+void fillTyped(void* values, size_t count, double value) {
+  T* first = static_cast<T*>(values);
+  std::fill(first, first + count, static_cast<T>(value));
+}
+
+void fillValues(void* values, FieldType type, size_t count, double value) {
+  switch (type) {
+    case FieldType::Float64:
+      fillTyped<double>(values, count, value);
+      break;
+    case FieldType::Float32:
+      fillTyped<float>(values, count, value);
+      break;
+    case FieldType::Int32:
+      fillTyped<int32_t>(values, count, value);
+      break;
+    case FieldType::Int16:
+      fillTyped<int16_t>(values, count, value);
+      break;
+    case FieldType::UInt8:
+      fillTyped<uint8_t>(values, count, value);
+      break;
+    case FieldType::Bit:
+      FieldBits::fill(static_cast<FieldBits::Word*>(values), count,
+                      value != 0.0);
+      break;
+  }
+}
+
+// A buffer outside the slab for @p count values of type @p type,
+// with the cache line padding cleared.
+std::shared_ptr<AlignedBuffer> makeBuffer(
+    size_t count, FieldType type,
+    const std::shared_ptr<MemoryResource>& resource) {
+  const size_t bytes = storageBytes(type, count);
+  auto buffer = std::make_shared<AlignedBuffer>(AlignedBuffer::padded(bytes),
+                                                resource);
+  std::memset(static_cast<char*>(buffer->data()) + bytes, 0,
+              buffer->size() - bytes);
+  return buffer;
+}
+
+// Key slots with the positions of @p from, or empty ones.
+std::unique_ptr<std::atomic<size_t>[]> keySlots(
+    const std::atomic<size_t>* from) {
+  std::unique_ptr<std::atomic<size_t>[]> slots(
+    new std::atomic<size_t>[max_field_keys]);
+  for (size_t slot = 0; slot < max_field_keys; ++slot) {
+    slots[slot].store(from ? from[slot].load(std::memory_order_relaxed)
+                           : FieldTable::npos,
+                      std::memory_order_relaxed);
+  }
+  return slots;
+}
+}  // namespace
+
+const size_t FieldTable::npos;
+
+FieldTable::FieldTable(size_t num_entities, FieldStorage storage,
+                       std::shared_ptr<MemoryResource> resource)
+    : m_num_entities(num_entities),
+      m_storage(storage),
+      m_fields(),
+      m_registry(),
+      m_insert_mutex(new std::mutex),
+      m_keys(keySlots(nullptr)),
+      m_slab(),
+      m_slab_used(0),
+      m_mapped(),
+      m_entity(MappedStorage::Entity::Cell),
+      m_chunk_size(default_chunk_size),
+      m_first_touch(FirstTouch::Serial),
+      m_resource(resource),
+      m_map(),
+      m_map_copy() {
+  if (storage == FieldStorage::Mapped) {
+    throw std::invalid_argument(
+      "Mapped field storage needs a MappedStorage instance");
+  }
+}
+
+FieldTable::FieldTable(const std::shared_ptr<MappedStorage>& mapping,
+                       MappedStorage::Entity entity)
+    : m_num_entities(entity == MappedStorage::Entity::Cell
+                     ? mapping->numCells() : mapping->numFaces()),
+      m_storage(FieldStorage::Mapped),
+      m_fields(),
+      m_registry(),
+      m_insert_mutex(new std::mutex),
+      m_keys(keySlots(nullptr)),
+      m_slab(),
+      m_slab_used(0),
+      m_mapped(mapping),
+      m_entity(entity),
+      m_chunk_size(default_chunk_size),
+      m_first_touch(FirstTouch::Serial),
+      m_resource(),
+      m_map(),
+      m_map_copy() {
+  // Fields found in the mapping start out clean.
+  for (const auto& entry : mapping->entries()) {
+    if (entry.entity == entity) {
+      Field field = { entry.name, entry.components, entry.layout,
+                      entry.type, nullptr, nullptr,
+                      entry.offset / sizeof(double), entry.count,
+                      false, false, std::vector<bool>(),
+                      std::vector<Buffer>(),
+                      std::vector<CachedStatistics>() };
+      addField(field);
+    }
+  }
+}
+
+FieldTable::FieldTable(const FieldTable& other)
+    : FieldTable(other, other.m_mapped
+                        ? other.m_mapped->clone(other.m_first_touch)
+                        : std::shared_ptr<MappedStorage>()) {
+}
+
+FieldTable::FieldTable(const FieldTable& other,
+                       const std::shared_ptr<MappedStorage>& mapping)
+    : m_num_entities(other.m_num_entities),
+      m_storage(other.m_storage),
+      m_fields(other.m_fields),
+      m_registry(other.m_registry),
+      m_insert_mutex(new std::mutex),
+      m_keys(keySlots(other.m_keys.get())),
+      m_slab(other.m_slab),
+      m_slab_used(other.m_slab_used),
+      m_mapped(mapping),
+      m_entity(other.m_entity),
+      m_chunk_size(other.m_chunk_size),
+      m_first_touch(other.m_first_touch),
+      m_resource(other.m_resource),
+      m_map(),
+      m_map_copy() {
+  // The copied fields share the vectors and the slab with the other
+  // table; Mapped payloads were copied along with the mapping. Exposed
+  // fields are duplicated here, so that the pointers handed out by the
+  // other table keep writing to it alone.
+  if (m_mapped) {
+    return;
+  }
+  bool copy_slab = false;
+  for (size_t index = 0; index < m_fields.size(); ++index) {
+    Field& field = m_fields[index];
+    if (!field.exposed) {
+      continue;
+    }
+    if (field.vector || field.own) {
+      copyShared(index);
+    } else {
+      copy_slab = true;
+    }
+    for (Buffer& lag : field.history) {
+      lag = duplicate(field, lag.vector
+                             ? static_cast<const void*>(lag.vector->data())
+                             : lag.own->data());
+    }
+    field.exposed = false;
+  }
+  if (copy_slab) {
+    auto slab = std::make_shared<AlignedBuffer>(m_slab->size(), m_resource);
+    copySlab(*slab);
+    m_slab = slab;
+  }
+}
+
+FieldTable::FieldTable(FieldTable&& other)
+    : m_num_entities(other.m_num_entities),
+      m_storage(other.m_storage == FieldStorage::Mapped
+                ? FieldStorage::Vector : other.m_storage),
+      m_fields(),
+      m_registry(),
+      m_insert_mutex(new std::mutex),
+      m_keys(keySlots(nullptr)),
+      m_slab(),
+      m_slab_used(0),
+      m_mapped(),
+      m_entity(other.m_entity),
+      m_chunk_size(other.m_chunk_size),
+      m_first_touch(other.m_first_touch),
+      m_resource(other.m_resource),
+      m_map(),
+      m_map_copy() {
+  // An empty table is built first and exchanged with the other one, so
+  // the other table keeps a mutex and key slots of its own. The
+  // mapping moves, and an empty Mapped table would have none to grow.
+  swap(other);
+}
+
+void FieldTable::swap(FieldTable& other) {
+  // All members are exchanged and nothing is copied: the field
+  // records move with their registry, key slots and insert mutex, so a
+  // field keeps its index in the table it moves to, and pointers to
+  // field records follow their fields since the segments of m_fields
+  // are exchanged. Pointers to the values depend on the storage. Vector
+  // buffers belong to their fields and stay where they are. The Arena
+  // slab and the Mapped mapping move to the other table and stay in
+  // place until its next registration regrows them.
+  using std::swap;
+  swap(m_num_entities, other.m_num_entities);
+  swap(m_storage, other.m_storage);
+  m_fields.swap(other.m_fields);
+  m_registry.swap(other.m_registry);
+  swap(m_insert_mutex, other.m_insert_mutex);
+  swap(m_keys, other.m_keys);
+  swap(m_slab, other.m_slab);
+  swap(m_slab_used, other.m_slab_used);
+  swap(m_mapped, other.m_mapped);
+  swap(m_entity, other.m_entity);
+  swap(m_chunk_size, other.m_chunk_size);
+  swap(m_first_touch, other.m_first_touch);
+  swap(m_resource, other.m_resource);
+  swap(m_map, other.m_map);
+  swap(m_map_copy, other.m_map_copy);
+}
+
+size_t FieldTable::find(const char* name, size_t length) const {
+  return m_registry.find(name, length);
+}
+
+size_t FieldTable::findKey(size_t slot, const char* name) const {
+  if (slot >= max_field_keys) {
+    return find(name, std::strlen(name));
+  }
+  size_t index = m_keys[slot].load(std::memory_order_acquire);
+  if (index == npos) {
+    index = find(name, std::strlen(name));
+    if (index != npos) {
+      m_keys[slot].store(index, std::memory_order_release);
+    }
+  }
+  return index;
+}
+
+size_t FieldTable::findOrInsert(const std::string& name, size_t components,
+                                double initialValue,
+                                const FieldLayout& layout, FieldType type) {
+  size_t index = find(name.data(), name.size());
+  if (index != npos) {
+    return index;
+  }
+  // Another thread may have inserted the field in the meantime.
+  std::lock_guard<std::mutex> lock(*m_insert_mutex);
+  index = find(name.data(), name.size());
+  if (index == npos) {
+    index = insert(name, components, initialValue, layout, type);
+  }
+  return index;
+}
+
+size_t FieldTable::insert(const std::string& name, size_t components,
+                          double initialValue, const FieldLayout& layout,
+                          FieldType type) {
+  if (type == FieldType::Bit && layout != FieldLayout()) {
+    throw std::invalid_argument("Bit fields must have the interleaved layout");
+  }
+  // A new field is dirty until the next checkpoint.
+  Field field = { name, components, layout, type, nullptr, nullptr, 0,
+                  layout.count(m_num_entities, components), false, true,
+                  std::vector<bool>(), std::vector<Buffer>(),
+                  std::vector<CachedStatistics>() };
+  const size_t bytes = storageBytes(type, field.count);
+  if (m_storage == FieldStorage::Arena) {
+    // A slab shared with a copy is copied before appending to it.
+    const size_t padded = slabCount(field);
+    const size_t capacity = m_slab ? m_slab->size() / sizeof(double) : 0;
+    if (m_slab_used + padded > capacity || m_slab.use_count() > 1) {
+      auto grown = std::make_shared<AlignedBuffer>(
+        std::max(m_slab_used + padded, 2 * capacity) * sizeof(double),
+        m_resource);
+      copySlab(*grown);
+      m_slab = grown;
+    }
+    field.offset = m_slab_used;
+    char* values = reinterpret_cast<char*>(slab() + field.offset);
+    initialize(field, values, initialValue);
+    std::memset(values + bytes, 0, padded * sizeof(double) - bytes);
+    m_slab_used += padded;
+  } else if (m_storage == FieldStorage::Mapped) {
+    // New payloads in the mapping are zero filled already, and stay
+    // untouched until the first thread writes to them.
+    field.offset = m_mapped->allocate(m_entity, name, components,
+                                      field.count, layout, type)
+                   / sizeof(double);
+    if (initialValue != 0.0) {
+      initialize(field, slab() + field.offset, initialValue);
+    }
+  } else if (type == FieldType::Float64 && usesVectors()) {
+    field.vector = std::make_shared<std::vector<double>>(field.count,
+                                                        initialValue);
+    zeroPadding(field, field.vector->data());
+  } else {
+    field.own = std::make_shared<AlignedBuffer>(AlignedBuffer::padded(bytes),
+                                                m_resource);
+    initialize(field, field.own->data(), initialValue);
+  }
+  return addField(field);
+}
+
+void FieldTable::initialize(const Field& field, void* values,
+                            double initialValue) const {
+  if (m_first_touch == FirstTouch::Parallel) {
+    parallelFill(values, field.type, field.layout, m_num_entities,
+                 field.components, initialValue);
+  } else {
+    fillValues(values, field.type, field.count, initialValue);
+    zeroPadding(field, values);
+  }
+}
+
+size_t FieldTable::slabCount(const Field& field) {
+  const size_t bytes = storageBytes(field.type, field.count);
+  return paddedCount((bytes + sizeof(double) - 1) / sizeof(double));
+}
+
+void FieldTable::copySlab(AlignedBuffer& target) const {
+  if (m_slab_used == 0) {
+    return;
+  }
+  if (m_first_touch == FirstTouch::Serial) {
+    std::memcpy(target.data(), m_slab->data(), m_slab_used * sizeof(double));
+    return;
+  }
+  // Field by field, so that every field is copied by the threads
+  // owning its entities; slab space of fields which moved to buffers
+  // of their own is not copied.
+  const double* from = static_cast<const double*>(m_slab->data());
+  double* to = static_cast<double*>(target.data());
+  for (const Field& field : m_fields) {
+    if (!field.vector && !field.own) {
+      parallelCopy(to + field.offset, from + field.offset, field.type,
+                   field.layout, m_num_entities, field.components);
+      const size_t bytes = storageBytes(field.type, field.count);
+      std::memset(reinterpret_cast<char*>(to + field.offset) + bytes, 0,
+                  slabCount(field) * sizeof(double) - bytes);
+    }
+  }
+}
+
+size_t FieldTable::addField(const Field& field) {
+  // The field is complete before its name is published.
+  const size_t index = m_fields.size();
+  m_fields.push_back(field);
+  m_registry.insert(field.name, index);
+  return index;
+}
+
+void FieldTable::zeroPadding(const Field& field, void* values) const {
+  const size_t size = valueSize(field.type);
+  const size_t padded = field.layout.count(m_num_entities, 1);
+  for (size_t entity = m_num_entities; entity < padded; ++entity) {
+    for (size_t component = 0; component < field.components; ++component) {
+      const size_t index = field.layout.index(entity, component,
+                                              m_num_entities,
+                                              field.components);
+      std::memset(static_cast<char*>(values) + index * size, 0, size);
+    }
+  }
+}
+
+void FieldTable::relayout(size_t index, const FieldLayout& layout) {
+  Field& field = m_fields[index];
+  if (field.layout == layout) {
+    return;
+  }
+  if (const char* error = conversionError(index, layout, field.type)) {
+    throw std::logic_error(error);
+  }
+  const size_t new_count = layout.count(m_num_entities, field.components);
+  if (field.vector) {
+    auto converted = std::make_shared<std::vector<double>>(new_count, 0.0);
+    FieldLayout::convert(field.vector->data(), field.layout,
+                         converted->data(), layout, m_num_entities,
+                         field.components);
+    field.vector = converted;
+  } else if (m_mapped) {
+    // Mapped fields are never shared, so the payload is converted in
+    // place through one temporary copy.
+    void* values = address(field);
+    const size_t bytes = storageBytes(field.type, field.count);
+    std::vector<double> old((bytes + sizeof(double) - 1) / sizeof(double));
+    std::memcpy(old.data(), values, bytes);
+    FieldLayout::convert(old.data(), field.layout, values, layout,
+                         field.type, m_num_entities, field.components);
+    m_mapped->setLayout(field.offset * sizeof(double), layout);
+  } else {
+    auto own = makeBuffer(new_count, field.type, m_resource);
+    std::memset(own->data(), 0, own->size());
+    FieldLayout::convert(address(field), field.layout, own->data(), layout,
+                         field.type, m_num_entities, field.components);
+    field.own = own;
+  }
+  field.layout = layout;
+  field.count = new_count;
+  field.all_dirty = true;
+  field.dirty.clear();
+  field.statistics.clear();
+}
+
+const char* FieldTable::conversionError(size_t index,
+                                        const FieldLayout& layout,
+                                        FieldType type) const {
+  const Field& field = m_fields[index];
+  if (field.layout != layout) {
+    if (field.type == FieldType::Bit) {
+      return "Bit fields cannot change the layout";
+    }
+    if (!field.history.empty()) {
+      return "A field with a history cannot change the layout";
+    }
+    if (m_mapped &&
+        layout.count(m_num_entities, field.components) != field.count) {
+      return "A mapped field can only change to a layout of the same size";
+    }
+  }
+  if (field.type != type) {
+    if (m_mapped) {
+      return "The type of a mapped field cannot change";
+    }
+    if (!field.history.empty()) {
+      return "A field with a history cannot change the type";
+    }
+    if (type == FieldType::Bit && layout != FieldLayout()) {
+      return "Bit fields must have the interleaved layout";
+    }
+  }
+  return nullptr;
+}
+
+void FieldTable::retype(size_t index, FieldType type) {
+  Field& field = m_fields[index];
+  if (field.type == type) {
+    return;
+  }
+  if (const char* error = conversionError(index, field.layout, type)) {
+    throw std::logic_error(error);
+  }
+  const size_t count = this->count(index);
+  if (type == FieldType::Float64 && usesVectors()) {
+    auto converted = std::make_shared<std::vector<double>>(count);
+    convertValues(address(field), field.type, converted->data(), type,
+                  count);
+    field.vector = converted;
+    field.own.reset();
+  } else {
+    auto own = makeBuffer(count, type, m_resource);
+    convertValues(address(field), field.type, own->data(), type, count);
+    field.own = own;
+    field.vector.reset();
+  }
+  field.type = type;
+  field.count = count;
+  field.all_dirty = true;
+  field.dirty.clear();
+  field.statistics.clear();
+}
+
+FieldTable::VectorMap& FieldTable::vectorMap() {
+  for (size_t index = 0; index < m_fields.size(); ++index) {
+    if (!m_fields[index].vector) {
+      throwNotVector();
+    }
+  }
+  if (!m_map) {
+    m_map.reset(new VectorMap);
+  }
+  for (size_t index = 0; index < m_fields.size(); ++index) {
+    Field& field = m_fields[index];
+    std::vector<double>& entry = (*m_map)[field.name];
+    if (field.vector.get() != &entry) {
+      // The map owns the vector; the field refers to it without owning.
+      entry = *field.vector;
+      field.vector = VectorPtr(&entry, [](std::vector<double>*) {});
+    }
+    expose(index);
+    touch(index);
+  }
+  return *m_map;
+}
+
+const FieldTable::VectorMap& FieldTable::vectorMap() const {
+  bool held = m_map != nullptr;
+  for (size_t index = 0; index < m_fields.size(); ++index) {
+    const Field& field = m_fields[index];
+    if (!field.vector) {
+      throwNotVector();
+    }
+    if (held) {
+      const auto entry = m_map->find(field.name);
+      held = entry != m_map->end() && &entry->second == field.vector.get();
+    }
+  }
+  if (held) {
+    return *m_map;
+  }
+  if (!m_map_copy) {
+    m_map_copy.reset(new VectorMap);
+  }
+  m_map_copy->clear();
+  for (const Field& field : m_fields) {
+    (*m_map_copy)[field.name] = *field.vector;
+  }
+  return *m_map_copy;
+}
+
+void FieldTable::copyShared(size_t index) {
+  Field& field = m_fields[index];
+  const Buffer copy = duplicate(field, address(field));
+  field.vector = copy.vector;
+  field.own = copy.own;
+}
+
+FieldTable::Buffer FieldTable::duplicate(const Field& field,
+                                         const void* values) const {
+  Buffer copy;
+  if (field.vector) {
+    const double* first = static_cast<const double*>(values);
+    copy.vector = std::make_shared<std::vector<double>>(
+      first, first + field.vector->size());
+  } else {
+    copy.own = makeBuffer(field.count, field.type, m_resource);
+    if (m_first_touch == FirstTouch::Parallel) {
+      parallelCopy(copy.own->data(), values, field.type, field.layout,
+                   m_num_entities, field.components);
+    } else if (field.count > 0) {
+      std::memcpy(copy.own->data(), values,
+                  storageBytes(field.type, field.count));
+    }
+  }
+  return copy;
+}
+
+void FieldTable::setHistory(size_t index, size_t depth) {
+  Field& field = m_fields[index];
+  if (m_mapped) {
+    throw std::logic_error("A mapped field cannot keep a history");
+  }
+  if (depth > 0 && !field.vector && !field.own) {
+    // Only buffers of their own can rotate.
+    copyShared(index);
+  }
+  while (field.history.size() < depth) {
+    const Buffer& oldest = field.history.empty()
+                           ? Buffer{ field.vector, field.own }
+                           : field.history.back();
+    const void* values = oldest.vector
+                         ? static_cast<const void*>(oldest.vector->data())
+                         : oldest.own->data();
+    field.history.push_back(duplicate(field, values));
+  }
+  field.history.resize(depth);
+}
+
+void* FieldTable::historyAddress(size_t index, size_t lag) {
+  if (lag == 0) {
+    unshare(index);
+    return address(m_fields[index]);
+  }
+  Field& field = m_fields[index];
+  if (lag > field.history.size()) {
+    throw std::out_of_range("The lag is larger than the history depth");
+  }
+  Buffer& buffer = field.history[lag - 1];
+  if (buffer.vector) {
+    if (buffer.vector.use_count() > 1) {
+      buffer = duplicate(field, buffer.vector->data());
+    }
+    return buffer.vector->data();
+  }
+  if (buffer.own.use_count() > 1) {
+    buffer = duplicate(field, buffer.own->data());
+  }
+  return buffer.own->data();
+}
+
+const void* FieldTable::historyAddress(size_t index, size_t lag) const {
+  const Field& field = m_fields[index];
+  if (lag == 0) {
+    return address(field);
+  }
+  if (lag > field.history.size()) {
+    throw std::out_of_range("The lag is larger than the history depth");
+  }
+  const Buffer& buffer = field.history[lag - 1];
+  return buffer.vector ? static_cast<const void*>(buffer.vector->data())
+                       : buffer.own->data();
+}
+
+void FieldTable::rotateHistory() {
+  for (Field& field : m_fields) {
+    if (field.history.empty()) {
+      continue;
+    }
+    // The oldest lag moves to the front and trades places with the
+    // field.
+    std::rotate(field.history.rbegin(), field.history.rbegin() + 1,
+                field.history.rend());
+    field.vector.swap(field.history[0].vector);
+    field.own.swap(field.history[0].own);
+    field.all_dirty = true;
+    field.dirty.clear();
+    field.statistics.clear();
+  }
+}
+
+FieldStatistics FieldTable::statistics(size_t index, size_t component) const {
+  const Field& field = m_fields[index];
+  if (component > field.components) {
+    throw std::invalid_argument("The component number is invalid");
+  }
+  if (field.statistics.empty()) {
+    field.statistics.resize(field.components + 1,
+                            CachedStatistics{ false,
+                                              FieldStatistics::empty() });
+  }
+  CachedStatistics& cached = field.statistics[component];
+  if (!cached.valid) {
+    if (component < field.components) {
+      cached.value = fieldStatistics(address(field), field.type,
+                                     field.layout, m_num_entities,
+                                     field.components, component);
+    } else {
+      // All components, from the (cached) statistics of each.
+      cached.value = FieldStatistics::empty();
+      for (size_t other = 0; other < field.components; ++other) {
+        cached.value = mergeStatistics(cached.value,
+                                       statistics(index, other));
+      }
+    }
+    cached.valid = true;
+  }
+  return cached.value;
+}
+
+void FieldTable::setChunkSize(size_t values) {
+  if (values == 0) {
+    throw std::invalid_argument("The dirty tracking chunk must not be empty");
+  }
+  if (values == m_chunk_size) {
+    return;
+  }
+  m_chunk_size = values;
+  for (auto& field : m_fields) {
+    field.all_dirty = true;
+    field.dirty.clear();
+  }
+}
+
+void FieldTable::markDirty(size_t index, size_t begin, size_t end) {
+  Field& field = m_fields[index];
+  if (begin < end) {
+    field.statistics.clear();
+  }
+  if (field.all_dirty || begin >= end) {
+    return;
+  }
+  const size_t num_chunks = (count(index) + m_chunk_size - 1) / m_chunk_size;
+  field.dirty.resize(num_chunks, false);
+  const size_t last = std::min((end - 1) / m_chunk_size, num_chunks - 1);
+  for (size_t chunk = begin / m_chunk_size; chunk <= last; ++chunk) {
+    field.dirty[chunk] = true;
+  }
+}
+
+bool FieldTable::dirty(size_t index) const {
+  const Field& field = m_fields[index];
+  return field.all_dirty ||
+         std::find(field.dirty.begin(), field.dirty.end(), true)
+           != field.dirty.end();
+}
+
+std::vector<size_t> FieldTable::dirtyChunks(size_t index) const {
+  const Field& field = m_fields[index];
+  const size_t num_chunks = (count(index) + m_chunk_size - 1) / m_chunk_size;
+  std::vector<size_t> chunks;
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    if (field.all_dirty ||
+        (chunk < field.dirty.size() && field.dirty[chunk])) {
+      chunks.push_back(chunk);
+    }
+  }
+  return chunks;
+}
+
+void FieldTable::clearDirty(size_t index) const {
+  m_fields[index].all_dirty = false;
+  m_fields[index].dirty.clear();
+}
+
+void FieldTable::clearDirty() const {
+  for (size_t index = 0; index < m_fields.size(); ++index) {
+    clearDirty(index);
+  }
+}
+
+void FieldTable::advise(size_t index, FieldAdvice advice) const {
+  if (m_mapped) {
+    const Field& field = m_fields[index];
+    m_mapped->advise(field.offset * sizeof(double),
+                     storageBytes(field.type, field.count), advice);
+  }
+}
+
+void FieldTable::throwNotVector() {
+  throw std::logic_error("Field data is only available as std::vector for "
+                         "Float64 fields with vector storage");
+}
+
+void FieldTable::throwWrongType() {
+  throw std::logic_error("The field does not hold values of this type");
+}
+}  // namespace Opm
@@ -0,0 +1,626 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDTABLE_H_
+#define OPM_COMMON_DATA_FIELDTABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opm/common/data/AlignedBuffer.hpp>
+#include <opm/common/data/FieldBits.hpp>
+#include <opm/common/data/FieldKey.hpp>
+#include <opm/common/data/FieldLayout.hpp>
+#include <opm/common/data/FieldRegistry.hpp>
+#include <opm/common/data/FieldStatistics.hpp>
+#include <opm/common/data/FieldType.hpp>
+#include <opm/common/data/FirstTouch.hpp>
+#include <opm/common/data/MappedStorage.hpp>
+#include <opm/common/data/MemoryResource.hpp>
+#include <opm/common/data/SegmentedArray.hpp>
+
+namespace Opm {
+/**
+ * @brief How a FieldTable stores the values of its fields.
+ *
+ * - Vector: every field is a separate std::vector<double>.
+ * - Arena:  all fields share one cache line aligned slab, and every
+ *           field starts on a cache line boundary.
+ * - Mapped: all fields live in a memory mapping (see MappedStorage),
+ *           and every field starts on a page boundary.
+ */
+enum class FieldStorage { Vector, Arena, Mapped };
+
+/**
+ * @class FieldTable
+ * @brief The fields of one entity kind (cells or faces) of a
+ *        SimulationDataContainer.
+ *
+ * Fields are kept in a flat table in registration order; a field
+ * handle is the position in this table. A FieldRegistry maps names to
+ * table positions and serves lookups by name without a temporary
+ * std::string.
+ *
+ * Fields can be registered with findOrInsert() from several threads,
+ * while other threads look fields up and access the existing ones:
+ * lookups and the table never move or lock, and registrations are
+ * serialized by a mutex of the table. Only with Vector storage do the
+ * values of existing fields stay in place meanwhile.
+ *
+ * With Arena storage the slab grows geometrically when a field is
+ * registered, so registration invalidates pointers to the existing
+ * fields. With Mapped storage the cell and face tables of a container
+ * share one MappedStorage; registration may move the mapping as well.
+ *
+ * Copies of a table with Vector or Arena storage share the field
+ * buffers, so copying costs O(number of fields). A shared field is
+ * duplicated by the first mutable access to it (data(), vector() or
+ * unshare()); with Arena storage the duplicate is a separate aligned
+ * buffer outside the slab. Fields marked with expose() may be written
+ * through pointers at any time, so a copy duplicates them at once (an
+ * exposed field in the slab makes it duplicate the slab), and the
+ * pointers keep writing to the table they came from. Mapped storage
+ * is copied eagerly.
+ *
+ * Fields hold values of any FieldType. With Vector storage only
+ * Float64 fields are std::vector<double>; fields of the other types
+ * get an aligned buffer of their own. Bit fields are packed words
+ * (see FieldBits) and always have the interleaved layout.
+ *
+ * A table with Vector or Arena storage may allocate its buffers from
+ * a MemoryResource, e.g. on huge pages. All buffers of the table then
+ * come from the resource, except for the Float64 fields with Vector
+ * storage, which stay std::vector<double>.
+ *
+ * The table also tracks which parts of every field changed since the
+ * last clearDirty(), in chunks of chunkSize() values. touch() marks a
+ * whole field, which is what mutable access through the container
+ * does, and markDirty() marks the chunks of a range of values.
+ */
+class FieldTable {
+ public:
+  typedef std::shared_ptr<std::vector<double>> VectorPtr;
+  typedef std::map<std::string, std::vector<double>> VectorMap;
+
+  /**
+   * @brief Returned by find() when there is no such field.
+   */
+  static const size_t npos = static_cast<size_t>(-1);
+
+  /**
+   * @brief Create an empty table.
+   * @param num_entities number of cells or faces
+   * @param storage how the field values are stored
+   * @param resource where the buffers are allocated; null for
+   *                 std::vector and posix_memalign()
+   */
+  FieldTable(size_t num_entities, FieldStorage storage,
+             std::shared_ptr<MemoryResource> resource =
+               std::shared_ptr<MemoryResource>());
+
+  /**
+   * @brief Create a table with Mapped storage.
+   * 
+   * The fields of kind @p entity already in the directory of the
+   * mapping are added to the table in directory order.
+   * @param mapping the mapping, shared with the other entity kind
+   * @param entity which fields of the mapping this table holds
+   */
+  FieldTable(const std::shared_ptr<MappedStorage>& mapping,
+             MappedStorage::Entity entity);
+
+  /**
+   * @brief Copy a table; fields are shared until they are written to,
+   *        and Mapped storage is copied to an anonymous mapping.
+   */
+  FieldTable(const FieldTable& other);
+
+  /**
+   * @brief Copy a table with Mapped storage into @p mapping.
+   * 
+   * The mapping must be a clone of the mapping of @p other; this lets
+   * the cell and face tables of a container share the copy.
+   */
+  FieldTable(const FieldTable& other,
+             const std::shared_ptr<MappedStorage>& mapping);
+
+  /**
+   * @brief Move a table; @p other is left empty and usable, with the
+   *        same number of entities and Vector storage if it was
+   *        Mapped.
+   */
+  FieldTable(FieldTable&& other);
+
+  FieldTable& operator=(const FieldTable& other) = delete;
+  void swap(FieldTable& other);
+
+  /**
+   * @brief Table position of the field @p name, or npos.
+   */
+  size_t find(const char* name, size_t length) const;
+
+  /**
+   * @brief Insert a new field and return its table position.
+   * @param name the name of the field, which must not exist
+   * @param components the number of components per entity
+   * @param initialValue initialization value for all components
+   * @param layout order of the values; AoSoA padding is set to zero,
+   *        and Bit fields must be interleaved (std::invalid_argument)
+   * @param type scalar type of the values
+   */
+  size_t insert(const std::string& name, size_t components,
+                double initialValue,
+                const FieldLayout& layout = FieldLayout(),
+                FieldType type = FieldType::Float64);
+
+  /**
+   * @brief Table position of the field of a key (see FieldKey), or
+   *        npos.
+   *
+   * The first lookup of a field by the key of @p slot goes by
+   * @p name; the position found is kept in the slot, as positions stay
+   * valid for the lifetime of the table. Safe to call concurrently
+   * with findOrInsert().
+   */
+  size_t findKey(size_t slot, const char* name) const;
+
+  /**
+   * @brief Table position of the field @p name, inserted as insert()
+   *        does if it does not exist.
+   *
+   * Safe to call from several threads at once, and concurrently with
+   * find() and the accessors of other fields (see the class
+   * documentation). An existing field is found without locking.
+   */
+  size_t findOrInsert(const std::string& name, size_t components,
+                      double initialValue,
+                      const FieldLayout& layout = FieldLayout(),
+                      FieldType type = FieldType::Float64);
+
+  /**
+   * @brief Number of fields.
+   */
+  size_t size() const { return m_fields.size(); }
+
+  size_t numEntities() const { return m_num_entities; }
+  FieldStorage storage() const { return m_storage; }
+
+  const std::string& name(size_t index) const {
+    return m_fields[index].name;
+  }
+
+  size_t components(size_t index) const {
+    return m_fields[index].components;
+  }
+
+  const FieldLayout& layout(size_t index) const {
+    return m_fields[index].layout;
+  }
+
+  /**
+   * @brief Change the layout of a field and mark it as dirty.
+   *
+   * With Vector and Arena storage the field gets a new buffer, so a
+   * copy of the table sharing the field keeps the old layout. Mapped
+   * fields are converted in place, which needs the number of values to
+   * stay the same; otherwise std::logic_error is thrown, as for Bit
+   * fields.
+   */
+  void relayout(size_t index, const FieldLayout& layout);
+
+  FieldType type(size_t index) const { return m_fields[index].type; }
+
+  /**
+   * @brief Convert the values of a field to another scalar type and
+   *        mark it as dirty.
+   *
+   * The field gets a new buffer, as with relayout(). Mapped fields
+   * cannot change their type, and only interleaved fields can become
+   * Bit fields; otherwise std::logic_error is thrown.
+   */
+  void retype(size_t index, FieldType type);
+
+  /**
+   * @brief Why relayout() to @p layout followed by retype() to @p type
+   *        would throw, or null if both succeed.
+   */
+  const char* conversionError(size_t index, const FieldLayout& layout,
+                              FieldType type) const;
+
+  /**
+   * @brief Keep the values of a field at the last @p depth rotations.
+   *
+   * Lag k is the value of the field k calls of rotateHistory() ago;
+   * lag 0 is the field itself. New lags start as copies of the oldest
+   * lag there is, and depth zero drops the history. Every lag is a
+   * buffer like the field, shared with copies of the table until it
+   * is written. An Arena field moves to a buffer of its own; Mapped
+   * fields cannot keep a history, and fields with a history cannot
+   * change their layout or type (std::logic_error).
+   */
+  void setHistory(size_t index, size_t depth);
+
+  size_t historyDepth(size_t index) const {
+    return m_fields[index].history.size();
+  }
+
+  /**
+   * @brief The values of a field of type T at lag @p lag, unshared
+   *        first; std::out_of_range is thrown if the lag is larger
+   *        than the depth.
+   */
+  template <typename T>
+  T* historyData(size_t index, size_t lag) {
+    checkType(index, FieldTypeOf<T>::value);
+    return static_cast<T*>(historyAddress(index, lag));
+  }
+
+  template <typename T>
+  const T* historyData(size_t index, size_t lag) const {
+    checkType(index, FieldTypeOf<T>::value);
+    return static_cast<const T*>(historyAddress(index, lag));
+  }
+
+  FieldBits::Word* historyWords(size_t index, size_t lag) {
+    checkType(index, FieldType::Bit);
+    return static_cast<FieldBits::Word*>(historyAddress(index, lag));
+  }
+
+  const FieldBits::Word* historyWords(size_t index, size_t lag) const {
+    checkType(index, FieldType::Bit);
+    return static_cast<const FieldBits::Word*>(historyAddress(index, lag));
+  }
+
+  /**
+   * @brief Shift the history of every field with one by one lag.
+   *
+   * The field becomes lag 1 and the buffer of the oldest lag becomes
+   * the field, without copying any values: the field then holds the
+   * values it had depth + 1 rotations ago until it is written, and is
+   * marked as dirty. Pointers, views and vector references obtained
+   * before the rotation refer to lag 1 afterwards.
+   */
+  void rotateHistory();
+
+  /**
+   * @brief Number of values of a field.
+   */
+  size_t count(size_t index) const {
+    const Field& field = m_fields[index];
+    return field.vector ? field.vector->size() : field.count;
+  }
+
+  /**
+   * @brief The values of a Float64 field, unshared first.
+   */
+  double* data(size_t index) { return typedData<double>(index); }
+
+  const double* data(size_t index) const {
+    return typedData<double>(index);
+  }
+
+  /**
+   * @brief The values of a field of type T, unshared first;
+   *        std::logic_error is thrown for a field of another type.
+   */
+  template <typename T>
+  T* typedData(size_t index) {
+    checkType(index, FieldTypeOf<T>::value);
+    writeAccess(index);
+    return static_cast<T*>(address(m_fields[index]));
+  }
+
+  template <typename T>
+  const T* typedData(size_t index) const {
+    checkType(index, FieldTypeOf<T>::value);
+    return static_cast<const T*>(address(m_fields[index]));
+  }
+
+  /**
+   * @brief The words of a Bit field, unshared first; std::logic_error
+   *        is thrown for a field of another type.
+   */
+  FieldBits::Word* words(size_t index) {
+    checkType(index, FieldType::Bit);
+    writeAccess(index);
+    return static_cast<FieldBits::Word*>(address(m_fields[index]));
+  }
+
+  const FieldBits::Word* words(size_t index) const {
+    checkType(index, FieldType::Bit);
+    return static_cast<const FieldBits::Word*>(address(m_fields[index]));
+  }
+
+  /**
+   * @brief The values of a field of any type, unshared first.
+   */
+  void* rawData(size_t index) {
+    writeAccess(index);
+    return address(m_fields[index]);
+  }
+
+  const void* rawData(size_t index) const {
+    return address(m_fields[index]);
+  }
+
+  /**
+   * @brief The vector of a field, unshared first; only available with
+   *        Vector storage.
+   */
+  std::vector<double>& vector(size_t index) {
+    if (!m_fields[index].vector) {
+      throwNotVector();
+    }
+    writeAccess(index);
+    return *m_fields[index].vector;
+  }
+
+  const std::vector<double>& vector(size_t index) const {
+    const Field& field = m_fields[index];
+    if (!field.vector) {
+      throwNotVector();
+    }
+    return *field.vector;
+  }
+
+  /**
+   * @brief The vectors of all fields by name, for the deprecated
+   *        SimulationDataContainer::cellData().
+   *
+   * The first call moves the values of every field into the map, which
+   * then holds them, so references and views obtained before refer to
+   * the old buffers, as after relayout(). A field which gets a new
+   * buffer later is moved again by the next call. The fields are
+   * exposed and marked as dirty; entries added to the map are not
+   * fields. Fields which are not vectors throw std::logic_error.
+   */
+  VectorMap& vectorMap();
+
+  /**
+   * @brief The vectors of all fields by name; the map of the mutable
+   *        vectorMap() if it holds every field, otherwise a copy made
+   *        by the call and kept until the next one.
+   */
+  const VectorMap& vectorMap() const;
+
+  /**
+   * @brief Whether a field shares its buffer with a copy of the table.
+   */
+  bool shared(size_t index) const {
+    const Field& field = m_fields[index];
+    if (field.vector) {
+      return field.vector.use_count() > 1;
+    }
+    return field.own ? field.own.use_count() > 1 : m_slab.use_count() > 1;
+  }
+
+  /**
+   * @brief Give a shared field a buffer of its own.
+   */
+  void unshare(size_t index) {
+    if (shared(index)) {
+      copyShared(index);
+    }
+  }
+
+  /**
+   * @brief Which threads initialize new field buffers.
+   *
+   * With Parallel, new fields, the duplicates of shared fields, a
+   * grown Arena slab and the mapping of a copy are written first by
+   * the OpenMP threads owning their entities (see FirstTouch). Since
+   * a std::vector writes its values on construction, Float64 fields
+   * with Vector storage are still created and duplicated by the
+   * calling thread.
+   */
+  FirstTouch firstTouch() const { return m_first_touch; }
+  void setFirstTouch(FirstTouch touch) { m_first_touch = touch; }
+
+  /**
+   * @brief The resource the buffers are allocated from, or null.
+   */
+  const std::shared_ptr<MemoryResource>& memoryResource() const {
+    return m_resource;
+  }
+
+  /**
+   * @brief Number of values per dirty tracking chunk.
+   */
+  size_t chunkSize() const { return m_chunk_size; }
+
+  /**
+   * @brief Change the chunk size; if it changes, all fields are marked
+   *        as dirty.
+   */
+  void setChunkSize(size_t values);
+
+  /**
+   * @brief Record that a mutable pointer to the values of a field was
+   *        handed out, so that copies of the table do not share it.
+   *
+   * A field stays exposed for the lifetime of the table; copies start
+   * out with no exposed fields.
+   */
+  void expose(size_t index) {
+    if (!m_fields[index].exposed) {
+      m_fields[index].exposed = true;
+    }
+  }
+
+  /**
+   * @brief Mark the whole field as dirty.
+   *
+   * Only writes to the field record if the field was clean or had
+   * cached statistics, so touching a field again is a pair of loads.
+   */
+  void touch(size_t index) {
+    Field& field = m_fields[index];
+    if (!field.all_dirty) {
+      field.all_dirty = true;
+    }
+    if (!field.statistics.empty()) {
+      field.statistics.clear();
+    }
+  }
+
+  /**
+   * @brief Mark the chunks holding values [begin, end) as dirty.
+   */
+  void markDirty(size_t index, size_t begin, size_t end);
+
+  /**
+   * @brief Whether any chunk of the field is dirty.
+   */
+  bool dirty(size_t index) const;
+
+  /**
+   * @brief The dirty chunks of a field, in increasing order.
+   */
+  std::vector<size_t> dirtyChunks(size_t index) const;
+
+  /**
+   * @brief Mark a field, or all fields, as clean.
+   *
+   * The dirty state records what was written since the last
+   * checkpoint rather than the values, so it can be cleared through a
+   * const table.
+   */
+  void clearDirty(size_t index) const;
+  void clearDirty() const;
+
+  /**
+   * @brief Pass an access pattern hint for a field to the kernel.
+   * 
+   * Only Mapped storage acts on the hint.
+   */
+  void advise(size_t index, FieldAdvice advice) const;
+
+  /**
+   * @brief Statistics of one component of a field, or of all its
+   *        components if @p component is components(index).
+   *
+   * The result is cached until the field is next written through the
+   * table: mutable access to its values, touch(), markDirty(), a new
+   * layout or type, or a rotation of its history. Writes through
+   * pointers obtained earlier must be marked with touch() or
+   * markDirty(), as for dirty tracking. The cache is not guarded, so
+   * one field must not be reduced from several threads at once.
+   */
+  FieldStatistics statistics(size_t index, size_t component) const;
+
+ private:
+  struct Buffer {
+    VectorPtr vector;  //!< the values, if the field is a vector
+    std::shared_ptr<AlignedBuffer> own;  //!< the values otherwise
+  };
+
+  struct CachedStatistics {
+    bool valid;  //!< computed since the field was last written
+    FieldStatistics value;  //!< the statistics, if valid
+  };
+
+  struct Field {
+    std::string name;  //!< name of the field
+    size_t components;  //!< components per entity
+    FieldLayout layout;  //!< order of the values
+    FieldType type;  //!< scalar type of the values
+    VectorPtr vector;  //!< the values, Float64 with Vector storage
+    std::shared_ptr<AlignedBuffer> own;  //!< buffer outside the slab
+    size_t offset;  //!< first value in the slab or mapping
+    size_t count;  //!< number of values, Arena and Mapped storage
+    bool exposed;  //!< mutable pointers to the values were handed out
+    mutable bool all_dirty;  //!< every chunk is dirty
+    mutable std::vector<bool> dirty;  //!< dirty chunks, unless all_dirty
+    std::vector<Buffer> history;  //!< lag k at position k - 1
+    //! cached statistics() per component, then of all components
+    mutable std::vector<CachedStatistics> statistics;
+  };
+
+  double* slab() const {
+    if (m_mapped) {
+      return reinterpret_cast<double*>(m_mapped->base());
+    }
+    return m_slab ? static_cast<double*>(m_slab->data()) : nullptr;
+  }
+
+  // Mutable access to the values of a field; once the field is
+  // unshared and has no cached statistics this only reads.
+  void writeAccess(size_t index) {
+    unshare(index);
+    if (!m_fields[index].statistics.empty()) {
+      m_fields[index].statistics.clear();
+    }
+  }
+
+  void* address(const Field& field) const {
+    if (field.vector) {
+      return field.vector->data();
+    }
+    return field.own ? field.own->data()
+                     : static_cast<void*>(slab() + field.offset);
+  }
+
+  // Whether new Float64 fields are std::vector<double>.
+  bool usesVectors() const { return m_storage == FieldStorage::Vector; }
+
+  void checkType(size_t index, FieldType type) const {
+    if (m_fields[index].type != type) {
+      throwWrongType();
+    }
+  }
+
+  size_t addField(const Field& field);
+  void initialize(const Field& field, void* values,
+                  double initialValue) const;
+  static size_t slabCount(const Field& field);
+  void copySlab(AlignedBuffer& target) const;
+  void zeroPadding(const Field& field, void* values) const;
+  void copyShared(size_t index);
+  Buffer duplicate(const Field& field, const void* values) const;
+  void* historyAddress(size_t index, size_t lag);
+  const void* historyAddress(size_t index, size_t lag) const;
+  [[noreturn]] static void throwNotVector();
+  [[noreturn]] static void throwWrongType();
+
+  size_t m_num_entities;  //!< number of cells or faces
+  FieldStorage m_storage;  //!< storage kind
+  SegmentedArray<Field> m_fields;  //!< fields by handle, at fixed addresses
+  FieldRegistry m_registry;  //!< handles by name
+  std::unique_ptr<std::mutex> m_insert_mutex;  //!< serializes insertions
+  //! positions by key slot, npos until looked up
+  std::unique_ptr<std::atomic<size_t>[]> m_keys;
+  std::shared_ptr<AlignedBuffer> m_slab;  //!< Arena storage only
+  size_t m_slab_used;  //!< number of doubles in use in the slab
+  std::shared_ptr<MappedStorage> m_mapped;  //!< Mapped storage only
+  MappedStorage::Entity m_entity;  //!< entity kind in the mapping
+  size_t m_chunk_size;  //!< values per dirty tracking chunk
+  FirstTouch m_first_touch;  //!< who initializes new buffers
+  std::shared_ptr<MemoryResource> m_resource;  //!< null: default allocation
+  //! holds the vectors of the fields after vectorMap(), otherwise null
+  std::unique_ptr<VectorMap> m_map;
+  //! copy of the vectors returned by the const vectorMap()
+  mutable std::unique_ptr<VectorMap> m_map_copy;
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDTABLE_H_
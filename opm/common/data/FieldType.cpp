@@ -0,0 +1,164 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/FieldType.hpp"
+
+namespace Opm {
+namespace {
+// Values converted by one thread at a time.
+const size_t block_values = 1 << 16;
+
+template <typename From, typename To>
+void convertBlocks(const From* source, To* target, size_t count) {
+  const size_t num_blocks = (count + block_values - 1) / block_values;
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t begin = block * block_values;
+    const size_t end = std::min(begin + block_values, count);
+    for (size_t i = begin; i < end; ++i) {
+      target[i] = static_cast<To>(source[i]);
+    }
+  }
+}
+
+// Every thread packs whole words, so no word is written twice.
+template <typename From>
+void packBits(const From* source, uint64_t* target, size_t count) {
+  const size_t num_words = (count + 63) / 64;
+#pragma omp parallel for schedule(static)
+  for (size_t word = 0; word < num_words; ++word) {
+    const size_t begin = word * 64;
+    const size_t end = std::min(begin + 64, count);
+    uint64_t bits = 0;
+    for (size_t i = begin; i < end; ++i) {
+      bits |= static_cast<uint64_t>(source[i] != From(0)) << (i - begin);
+    }
+    target[word] = bits;
+  }
+}
+
+template <typename To>
+void unpackBits(const uint64_t* source, To* target, size_t count) {
+  const size_t num_blocks = (count + block_values - 1) / block_values;
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t begin = block * block_values;
+    const size_t end = std::min(begin + block_values, count);
+    for (size_t i = begin; i < end; ++i) {
+      target[i] = static_cast<To>((source[i / 64] >> (i % 64)) & 1);
+    }
+  }
+}
+
+template <typename From>
+void convertFrom(const From* source, void* target, FieldType to,
+                 size_t count) {
+  switch (to) {
+    case FieldType::Float64:
+      convertBlocks(source, static_cast<double*>(target), count);
+      break;
+    case FieldType::Float32:
+      convertBlocks(source, static_cast<float*>(target), count);
+      break;
+    case FieldType::Int32:
+      convertBlocks(source, static_cast<int32_t*>(target), count);
+      break;
+    case FieldType::Int16:
+      convertBlocks(source, static_cast<int16_t*>(target), count);
+      break;
+    case FieldType::UInt8:
+      convertBlocks(source, static_cast<uint8_t*>(target), count);
+      break;
+    case FieldType::Bit:
+      packBits(source, static_cast<uint64_t*>(target), count);
+      break;
+  }
+}
+
+void convertBits(const uint64_t* source, void* target, FieldType to,
+                 size_t count) {
+  switch (to) {
+    case FieldType::Float64:
+      unpackBits(source, static_cast<double*>(target), count);
+      break;
+    case FieldType::Float32:
+      unpackBits(source, static_cast<float*>(target), count);
+      break;
+    case FieldType::Int32:
+      unpackBits(source, static_cast<int32_t*>(target), count);
+      break;
+    case FieldType::Int16:
+      unpackBits(source, static_cast<int16_t*>(target), count);
+      break;
+    case FieldType::UInt8:
+      unpackBits(source, static_cast<uint8_t*>(target), count);
+      break;
+    case FieldType::Bit:
+      break;
+  }
+}
+}  // namespace
+
+const FieldType FieldTypeOf<double>::value;
+const FieldType FieldTypeOf<float>::value;
+const FieldType FieldTypeOf<int32_t>::value;
+const FieldType FieldTypeOf<int16_t>::value;
+const FieldType FieldTypeOf<uint8_t>::value;
+
+FieldType fieldTypeFromValue(uint32_t value) {
+  if (value > static_cast<uint32_t>(FieldType::Bit)) {
+    OPM_THROW(std::runtime_error, "Unknown field type " << value);
+  }
+  return static_cast<FieldType>(value);
+}
+
+void convertValues(const void* source, FieldType from, void* target,
+                   FieldType to, size_t count) {
+  if (from == to) {
+    if (count > 0 && source != target) {
+      std::memcpy(target, source, storageBytes(from, count));
+    }
+    return;
+  }
+  switch (from) {
+    case FieldType::Float64:
+      convertFrom(static_cast<const double*>(source), target, to, count);
+      break;
+    case FieldType::Float32:
+      convertFrom(static_cast<const float*>(source), target, to, count);
+      break;
+    case FieldType::Int32:
+      convertFrom(static_cast<const int32_t*>(source), target, to, count);
+      break;
+    case FieldType::Int16:
+      convertFrom(static_cast<const int16_t*>(source), target, to, count);
+      break;
+    case FieldType::UInt8:
+      convertFrom(static_cast<const uint8_t*>(source), target, to, count);
+      break;
+    case FieldType::Bit:
+      convertBits(static_cast<const uint64_t*>(source), target, to, count);
+      break;
+  }
+}
+}  // namespace Opm
@@ -0,0 +1,135 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDTYPE_H_
+#define OPM_COMMON_DATA_FIELDTYPE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Opm {
+/**
+ * @brief Scalar type of the values of a field.
+ *
+ * Float64 is the default; Float32 halves the memory and bandwidth of
+ * fields which do not need the precision, e.g. diagnostics and output
+ * only fields. Int32, Int16 and UInt8 hold region numbers, table
+ * indices and the like, and Bit holds flags such as the active cells,
+ * packed 64 to a word (see FieldBits).
+ */
+enum class FieldType : uint32_t {
+  Float64 = 0,
+  Float32 = 1,
+  Int32 = 2,
+  Int16 = 3,
+  UInt8 = 4,
+  Bit = 5
+};
+
+/**
+ * @brief Size of one value of type @p type, in bytes; for Bit the size
+ *        of the word holding 64 values.
+ */
+inline size_t valueSize(FieldType type) {
+  switch (type) {
+    case FieldType::Float32:
+    case FieldType::Int32:
+      return 4;
+    case FieldType::Int16:
+      return 2;
+    case FieldType::UInt8:
+      return 1;
+    default:
+      return 8;
+  }
+}
+
+/**
+ * @brief Number of bytes holding the first @p count values of type
+ *        @p type; Bit values are stored in whole words.
+ */
+inline size_t storageBytes(FieldType type, size_t count) {
+  if (type == FieldType::Bit) {
+    return (count + 63) / 64 * sizeof(uint64_t);
+  }
+  return count * valueSize(type);
+}
+
+/**
+ * @brief Offset of the first byte holding value @p index of type
+ *        @p type; for Bit the offset of the word holding it.
+ */
+inline size_t storageOffset(FieldType type, size_t index) {
+  if (type == FieldType::Bit) {
+    return index / 64 * sizeof(uint64_t);
+  }
+  return index * valueSize(type);
+}
+
+/**
+ * @brief The FieldType of the C++ type T; Bit fields have none and are
+ *        accessed as words through BitView.
+ */
+template <typename T>
+struct FieldTypeOf;
+
+template <>
+struct FieldTypeOf<double> {
+  static const FieldType value = FieldType::Float64;
+};
+
+template <>
+struct FieldTypeOf<float> {
+  static const FieldType value = FieldType::Float32;
+};
+
+template <>
+struct FieldTypeOf<int32_t> {
+  static const FieldType value = FieldType::Int32;
+};
+
+template <>
+struct FieldTypeOf<int16_t> {
+  static const FieldType value = FieldType::Int16;
+};
+
+template <>
+struct FieldTypeOf<uint8_t> {
+  static const FieldType value = FieldType::UInt8;
+};
+
+/**
+ * @brief FieldType from its stored representation.
+ */
+FieldType fieldTypeFromValue(uint32_t value);
+
+/**
+ * @brief Convert @p count values from one type to another.
+ *
+ * Float64 values are rounded to the nearest Float32 value, and
+ * floating point values are truncated towards zero when converted to
+ * an integer type, which must be able to represent them. Converted to
+ * Bit, a value sets its bit if it is not zero; Bit values convert to
+ * zero and one. The values are converted in parallel blocks when
+ * OpenMP is enabled.
+ */
+void convertValues(const void* source, FieldType from, void* target,
+                   FieldType to, size_t count);
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDTYPE_H_
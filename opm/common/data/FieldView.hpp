@@ -0,0 +1,71 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_FIELDVIEW_H_
+#define OPM_COMMON_DATA_FIELDVIEW_H_
+
+#include <cstddef>
+#include <type_traits>
+
+namespace Opm {
+/**
+ * @class FieldView
+ * @brief Non-owning view of the contiguous values of one field.
+ *
+ * The view offers the read and write part of the std::vector
+ * interface (size(), operator[], iterators, data()), independent of
+ * how the container stores the field. A view is invalidated by any
+ * operation which reallocates the field storage, e.g. registering a
+ * new field in arena storage.
+ */
+template <typename T>
+class FieldView {
+ public:
+  typedef T value_type;
+  typedef T* iterator;
+  typedef T& reference;
+
+  FieldView() : m_data(nullptr), m_size(0) {}
+
+  FieldView(T* data, size_t size) : m_data(data), m_size(size) {}
+
+  /**
+   * @brief Conversion from a mutable to a const view.
+   */
+  template <typename U,
+            typename = typename std::enable_if<
+              std::is_convertible<U*, T*>::value>::type>
+  FieldView(const FieldView<U>& other)
+      : m_data(other.data()), m_size(other.size()) {}
+
+  T* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  T& operator[](size_t index) const { return m_data[index]; }
+
+  T* begin() const { return m_data; }
+  T* end() const { return m_data + m_size; }
+
+ private:
+  T* m_data;  //!< first value
+  size_t m_size;  //!< number of values
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIELDVIEW_H_
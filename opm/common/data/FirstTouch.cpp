@@ -0,0 +1,152 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include "opm/common/data/FieldBits.hpp"
+#include "opm/common/data/FirstTouch.hpp"
+
+namespace Opm {
+namespace {
+// Call f(position) for every value of the entities of a field, not
+// the AoSoA padding. Each entity is visited by the thread which owns
+// it under schedule(static); the interleaved layout is one contiguous
+// run per entity.
+template <typename F>
+void forEachValue(const FieldLayout& layout, size_t num_entities,
+                  size_t components, F f) {
+  if (layout.kind() == FieldLayout::Kind::Interleaved) {
+#pragma omp parallel for schedule(static)
+    for (size_t entity = 0; entity < num_entities; ++entity) {
+      for (size_t k = 0; k < components; ++k) {
+        f(entity * components + k);
+      }
+    }
+    return;
+  }
+#pragma omp parallel for schedule(static)
+  for (size_t entity = 0; entity < num_entities; ++entity) {
+    for (size_t k = 0; k < components; ++k) {
+      f(layout.index(entity, k, num_entities, components));
+    }
+  }
+}
+
+// The padding entities of AoSoA are in the last block, next to the
+// entities of the last thread.
+template <typename F>
+void forEachPadding(const FieldLayout& layout, size_t num_entities,
+                    size_t components, F f) {
+  const size_t padded = layout.count(num_entities, 1);
+  for (size_t entity = num_entities; entity < padded; ++entity) {
+    for (size_t k = 0; k < components; ++k) {
+      f(layout.index(entity, k, num_entities, components));
+    }
+  }
+}
+
+template <typename T>
+void fillTyped(void* buffer, const FieldLayout& layout, size_t num_entities,
+               size_t components, T value) {
+  T* values = static_cast<T*>(buffer);
+  forEachValue(layout, num_entities, components, [=](size_t position) {
+    values[position] = value;
+  });
+  forEachPadding(layout, num_entities, components, [=](size_t position) {
+    values[position] = T(0);
+  });
+}
+
+template <typename T>
+void copyTyped(void* target, const void* source, const FieldLayout& layout,
+               size_t num_entities, size_t components) {
+  T* to = static_cast<T*>(target);
+  const T* from = static_cast<const T*>(source);
+  auto copy = [=](size_t position) { to[position] = from[position]; };
+  forEachValue(layout, num_entities, components, copy);
+  forEachPadding(layout, num_entities, components, copy);
+}
+
+// Bit fields are interleaved, so the words follow the entities; every
+// thread copies a contiguous range of whole words.
+void copyWords(void* target, const void* source, size_t bits) {
+  FieldBits::Word* to = static_cast<FieldBits::Word*>(target);
+  const FieldBits::Word* from = static_cast<const FieldBits::Word*>(source);
+  const size_t num_words = FieldBits::numWords(bits);
+#pragma omp parallel for schedule(static)
+  for (size_t word = 0; word < num_words; ++word) {
+    to[word] = from[word];
+  }
+}
+}  // namespace
+
+void parallelFill(void* values, FieldType type, const FieldLayout& layout,
+                  size_t num_entities, size_t components, double value) {
+  switch (type) {
+    case FieldType::Float64:
+      fillTyped(values, layout, num_entities, components, value);
+      break;
+    case FieldType::Float32:
+      fillTyped(values, layout, num_entities, components,
+                static_cast<float>(value));
+      break;
+    case FieldType::Int32:
+      fillTyped(values, layout, num_entities, components,
+                static_cast<int32_t>(value));
+      break;
+    case FieldType::Int16:
+      fillTyped(values, layout, num_entities, components,
+                static_cast<int16_t>(value));
+      break;
+    case FieldType::UInt8:
+      fillTyped(values, layout, num_entities, components,
+                static_cast<uint8_t>(value));
+      break;
+    case FieldType::Bit:
+      FieldBits::fill(static_cast<FieldBits::Word*>(values),
+                      num_entities * components, value != 0.0);
+      break;
+  }
+}
+
+void parallelCopy(void* target, const void* source, FieldType type,
+                  const FieldLayout& layout, size_t num_entities,
+                  size_t components) {
+  // Layout conversion moves values without looking at them, and so
+  // does this copy; the types are handled by their size.
+  if (type == FieldType::Bit) {
+    copyWords(target, source, num_entities * components);
+    return;
+  }
+  switch (valueSize(type)) {
+    case 1:
+      copyTyped<uint8_t>(target, source, layout, num_entities, components);
+      break;
+    case 2:
+      copyTyped<uint16_t>(target, source, layout, num_entities, components);
+      break;
+    case 4:
+      copyTyped<uint32_t>(target, source, layout, num_entities, components);
+      break;
+    default:
+      copyTyped<uint64_t>(target, source, layout, num_entities, components);
+      break;
+  }
+}
+}  // namespace Opm
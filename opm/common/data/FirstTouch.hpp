@@ -0,0 +1,61 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_FIRSTTOUCH_H_
+#define OPM_COMMON_DATA_FIRSTTOUCH_H_
+
+#include <cstddef>
+
+#include <opm/common/data/FieldLayout.hpp>
+#include <opm/common/data/FieldType.hpp>
+
+namespace Opm {
+/**
+ * @brief Which threads write the pages of a new field buffer first.
+ *
+ * The operating system places a page on the NUMA node of the thread
+ * which writes it first.
+ *
+ * - Serial: the calling thread writes the whole buffer, so all pages
+ *           land on its node.
+ * - Parallel: the buffer is allocated without writing to it, and the
+ *             OpenMP threads initialize it with the static partition
+ *             of a loop over the entities, i.e. the partition of the
+ *             kernels which use schedule(static). Every thread then
+ *             finds its entities on its own node.
+ */
+enum class FirstTouch { Serial, Parallel };
+
+/**
+ * @brief Set all values of a field to @p value, in parallel over the
+ *        entities; AoSoA padding is set to zero.
+ */
+void parallelFill(void* values, FieldType type, const FieldLayout& layout,
+                  size_t num_entities, size_t components, double value);
+
+/**
+ * @brief Copy all values of a field, padding included, in parallel
+ *        over the entities.
+ */
+void parallelCopy(void* target, const void* source, FieldType type,
+                  const FieldLayout& layout, size_t num_entities,
+                  size_t components);
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_FIRSTTOUCH_H_
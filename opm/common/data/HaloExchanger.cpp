@@ -0,0 +1,92 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/HaloExchanger.hpp"
+
+namespace Opm {
+LocalExchangeGroup::LocalExchangeGroup(int size)
+    : m_size(size),
+      m_mutex(),
+      m_posted(),
+      m_mailboxes(static_cast<size_t>(size) * size) {
+  if (size <= 0) {
+    OPM_THROW(std::invalid_argument,
+              "The number of ranks: " << size << " is invalid");
+  }
+}
+
+void LocalExchangeGroup::post(int from, int to, std::vector<char> message) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    mailbox(from, to).push_back(std::move(message));
+  }
+  m_posted.notify_all();
+}
+
+std::vector<char> LocalExchangeGroup::take(int from, int to) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  std::deque<std::vector<char>>& box = mailbox(from, to);
+  m_posted.wait(lock, [&] { return !box.empty(); });
+  std::vector<char> message = std::move(box.front());
+  box.pop_front();
+  return message;
+}
+
+LocalExchanger::LocalExchanger(
+    const std::shared_ptr<LocalExchangeGroup>& group, int rank)
+    : m_group(group), m_rank(rank) {
+  if (rank < 0 || rank >= group->size()) {
+    OPM_THROW(std::invalid_argument, "The rank: " << rank << " is invalid");
+  }
+}
+
+void LocalExchanger::exchange(const std::vector<HaloSend>& sends,
+                              const std::vector<HaloReceive>& receives) {
+  // Sends never block, so posting all of them first cannot deadlock.
+  for (const HaloSend& send : sends) {
+    if (send.rank < 0 || send.rank >= size()) {
+      OPM_THROW(std::invalid_argument,
+                "The rank: " << send.rank << " is invalid");
+    }
+    const char* data = static_cast<const char*>(send.data);
+    m_group->post(m_rank, send.rank,
+                  std::vector<char>(data, data + send.bytes));
+  }
+  for (const HaloReceive& receive : receives) {
+    if (receive.rank < 0 || receive.rank >= size()) {
+      OPM_THROW(std::invalid_argument,
+                "The rank: " << receive.rank << " is invalid");
+    }
+    const std::vector<char> message = m_group->take(receive.rank, m_rank);
+    if (message.size() != receive.bytes) {
+      OPM_THROW(std::runtime_error, "Rank " << m_rank << " expected "
+                << receive.bytes << " bytes from rank " << receive.rank
+                << " and got " << message.size());
+    }
+    if (!message.empty()) {
+      std::memcpy(receive.data, message.data(), message.size());
+    }
+  }
+}
+}  // namespace Opm
@@ -0,0 +1,137 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_HALOEXCHANGER_H_
+#define OPM_COMMON_DATA_HALOEXCHANGER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Opm {
+/**
+ * @brief A message to send to another rank.
+ */
+struct HaloSend {
+  int rank;  //!< the receiving rank
+  const void* data;  //!< first byte of the message
+  size_t bytes;  //!< size of the message
+};
+
+/**
+ * @brief Where to put a message from another rank.
+ */
+struct HaloReceive {
+  int rank;  //!< the sending rank
+  void* data;  //!< room for the message
+  size_t bytes;  //!< size of the message
+};
+
+/**
+ * @class HaloExchanger
+ * @brief Transport of the halo messages of a CellPartition between
+ *        ranks.
+ *
+ * The container packs the values of the cells its neighbours need into
+ * one message per neighbour, and unpacks the messages it receives into
+ * its ghost cells; an exchanger only moves the bytes. An MPI
+ * implementation posts one nonblocking receive and send per message
+ * and waits for all of them; LocalExchanger runs the ranks as threads
+ * of one process.
+ */
+class HaloExchanger {
+ public:
+  virtual ~HaloExchanger() {}
+
+  /**
+   * @brief The rank of this process (or thread) and the number of ranks.
+   */
+  virtual int rank() const = 0;
+  virtual int size() const = 0;
+
+  /**
+   * @brief Send all @p sends and receive all @p receives.
+   *
+   * Returns when every message is received and the send buffers may
+   * be reused. Messages between two ranks arrive in the order they
+   * were sent, and a received message must have the expected size.
+   */
+  virtual void exchange(const std::vector<HaloSend>& sends,
+                        const std::vector<HaloReceive>& receives) = 0;
+};
+
+/**
+ * @class LocalExchangeGroup
+ * @brief Mailboxes shared by the LocalExchanger of every rank.
+ */
+class LocalExchangeGroup {
+ public:
+  explicit LocalExchangeGroup(int size);
+
+  int size() const { return m_size; }
+
+  /**
+   * @brief Queue a message from rank @p from to rank @p to.
+   */
+  void post(int from, int to, std::vector<char> message);
+
+  /**
+   * @brief Wait for the next message from rank @p from to rank @p to.
+   */
+  std::vector<char> take(int from, int to);
+
+ private:
+  std::deque<std::vector<char>>& mailbox(int from, int to) {
+    return m_mailboxes[static_cast<size_t>(from) * m_size + to];
+  }
+
+  int m_size;  //!< number of ranks
+  std::mutex m_mutex;  //!< guards the mailboxes
+  std::condition_variable m_posted;  //!< signalled by post()
+  std::vector<std::deque<std::vector<char>>> m_mailboxes;  //!< by pair
+};
+
+/**
+ * @class LocalExchanger
+ * @brief HaloExchanger for ranks which are threads of one process.
+ *
+ * Every thread creates the exchanger of its rank on one shared
+ * LocalExchangeGroup. This is meant for tests of partitioned code
+ * without MPI; messages are copied through the mailboxes of the group.
+ */
+class LocalExchanger : public HaloExchanger {
+ public:
+  LocalExchanger(const std::shared_ptr<LocalExchangeGroup>& group, int rank);
+
+  int rank() const override { return m_rank; }
+  int size() const override { return m_group->size(); }
+
+  void exchange(const std::vector<HaloSend>& sends,
+                const std::vector<HaloReceive>& receives) override;
+
+ private:
+  std::shared_ptr<LocalExchangeGroup> m_group;  //!< the mailboxes
+  int m_rank;  //!< rank of this thread
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_HALOEXCHANGER_H_
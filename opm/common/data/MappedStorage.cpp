@@ -0,0 +1,471 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/MappedStorage.hpp"
+
+namespace Opm {
+namespace {
+const char magic[8] = { 'O', 'P', 'M', 'S', 'D', 'C', '\0', '\0' };
+const uint32_t endian_mark = 0x01020304;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian;
+  uint64_t num_cells;
+  uint64_t num_faces;
+  uint64_t data_end;
+  uint64_t directory_bytes;
+  uint64_t num_fields;
+  // Added in version 4.
+  uint64_t num_phases;
+};
+
+struct EntryHeader {
+  uint32_t entity;
+  uint32_t name_length;
+  uint64_t components;
+  uint64_t offset;
+  uint64_t count;
+  // Added in version 2.
+  uint32_t layout;
+  uint32_t width;
+  // Added in version 3.
+  uint32_t type;
+  uint32_t reserved;
+};
+
+// Size of an entry header in files of a given version.
+size_t entryHeaderBytes(uint32_t version) {
+  switch (version) {
+    case 1:
+      return offsetof(EntryHeader, layout);
+    case 2:
+      return offsetof(EntryHeader, type);
+    default:
+      return sizeof(EntryHeader);
+  }
+}
+
+size_t payloadBytes(const MappedStorage::Entry& entry) {
+  return storageBytes(entry.type, entry.count);
+}
+
+size_t roundUp(size_t bytes, size_t alignment) {
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+size_t entryBytes(const MappedStorage::Entry& entry) {
+  return sizeof(EntryHeader) + roundUp(entry.name.size(), 8);
+}
+}  // namespace
+
+const uint32_t MappedStorage::format_version;
+
+size_t MappedStorage::pageSize() {
+  static const long size = sysconf(_SC_PAGESIZE);
+  return size > 0 ? size_t(size) : 4096;
+}
+
+MappedStorage::MappedStorage(size_t num_cells, size_t num_faces)
+    : m_num_cells(num_cells),
+      m_num_faces(num_faces),
+      m_num_phases(0),
+      m_fd(-1),
+      m_base(nullptr),
+      m_capacity(0),
+      m_data_end(pageSize()),
+      m_entries() {
+}
+
+std::shared_ptr<MappedStorage> MappedStorage::create(const std::string& path,
+                                                     size_t num_cells,
+                                                     size_t num_faces) {
+  std::shared_ptr<MappedStorage> storage(
+    new MappedStorage(num_cells, num_faces));
+  storage->m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (storage->m_fd < 0) {
+    OPM_THROW(std::runtime_error, "Could not create " << path << ": "
+              << std::strerror(errno));
+  }
+  storage->mapFile(2 * pageSize(), true);
+  storage->writeDirectory();
+  return storage;
+}
+
+std::shared_ptr<MappedStorage> MappedStorage::createAnonymous(
+    size_t num_cells, size_t num_faces) {
+  std::shared_ptr<MappedStorage> storage(
+    new MappedStorage(num_cells, num_faces));
+  storage->mapAnonymous(2 * pageSize());
+  storage->writeDirectory();
+  return storage;
+}
+
+std::shared_ptr<MappedStorage> MappedStorage::open(const std::string& path,
+                                                   bool shared) {
+  std::shared_ptr<MappedStorage> storage(new MappedStorage(0, 0));
+  storage->m_fd = ::open(path.c_str(), shared ? O_RDWR : O_RDONLY);
+  if (storage->m_fd < 0) {
+    OPM_THROW(std::runtime_error, "Could not open " << path << ": "
+              << std::strerror(errno));
+  }
+  struct stat status;
+  if (fstat(storage->m_fd, &status) != 0 ||
+      size_t(status.st_size) < sizeof(Header)) {
+    OPM_THROW(std::runtime_error, path << " is not a field storage file");
+  }
+  storage->mapFile(status.st_size, shared);
+  if (!shared) {
+    // A private mapping stays valid after the file is closed.
+    ::close(storage->m_fd);
+    storage->m_fd = -1;
+  }
+  storage->readDirectory(status.st_size);
+  return storage;
+}
+
+std::shared_ptr<MappedStorage> MappedStorage::clone(FirstTouch touch) const {
+  std::shared_ptr<MappedStorage> storage(
+    new MappedStorage(m_num_cells, m_num_faces));
+  storage->m_num_phases = m_num_phases;
+  storage->mapAnonymous(m_data_end + directoryBytes());
+  if (touch == FirstTouch::Parallel) {
+    // The anonymous mapping is zero, like the page padding of every
+    // payload, so only the header and the values are copied.
+    std::memcpy(storage->m_base, m_base, pageSize());
+    for (const Entry& entry : m_entries) {
+      parallelCopy(storage->m_base + entry.offset, m_base + entry.offset,
+                   entry.type, entry.layout,
+                   entry.entity == Entity::Cell ? m_num_cells : m_num_faces,
+                   entry.components);
+    }
+  } else {
+    std::memcpy(storage->m_base, m_base, m_data_end);
+  }
+  storage->m_data_end = m_data_end;
+  storage->m_entries = m_entries;
+  storage->writeDirectory();
+  return storage;
+}
+
+MappedStorage::~MappedStorage() {
+  if (m_base) {
+    munmap(m_base, m_capacity);
+  }
+  if (m_fd >= 0) {
+    // Drop the unused capacity at the end of the file.
+    if (ftruncate(m_fd, m_data_end + directoryBytes()) != 0) {
+      OPM_MESSAGE("Could not truncate field storage file");
+    }
+    ::close(m_fd);
+  }
+}
+
+size_t MappedStorage::allocate(Entity entity, const std::string& name,
+                               size_t components, size_t count,
+                               const FieldLayout& layout, FieldType type) {
+  // The new payload goes where the directory is now; clear that part.
+  const size_t stale = directoryBytes();
+  const size_t payload = roundUp(storageBytes(type, count), pageSize());
+  Entry entry = { entity, name, components, m_data_end, count, layout,
+                  type };
+  m_entries.push_back(entry);
+  m_data_end += payload;
+  reserve(m_data_end + directoryBytes());
+  std::memset(m_base + entry.offset, 0, std::min(stale, payload));
+  writeDirectory();
+  return entry.offset;
+}
+
+void MappedStorage::setLayout(size_t offset, const FieldLayout& layout) {
+  for (auto& entry : m_entries) {
+    if (entry.offset == offset) {
+      entry.layout = layout;
+      writeDirectory();
+      return;
+    }
+  }
+  OPM_THROW(std::logic_error, "No field at offset " << offset);
+}
+
+void MappedStorage::advise(size_t offset, size_t bytes,
+                           FieldAdvice advice) const {
+  int flag = MADV_NORMAL;
+  switch (advice) {
+    case FieldAdvice::Normal: flag = MADV_NORMAL; break;
+    case FieldAdvice::Sequential: flag = MADV_SEQUENTIAL; break;
+    case FieldAdvice::Random: flag = MADV_RANDOM; break;
+    case FieldAdvice::WillNeed: flag = MADV_WILLNEED; break;
+    case FieldAdvice::Cold:
+#ifdef MADV_COLD
+      flag = MADV_COLD;
+      break;
+#else
+      return;
+#endif
+  }
+  // Hints are best effort; a kernel which does not know one is fine.
+  // madvise() takes whole pages, and payloads of files written with
+  // smaller pages may start inside one.
+  if (bytes > 0) {
+    const size_t page = pageSize();
+    const size_t begin = offset / page * page;
+    madvise(m_base + begin, roundUp(offset + bytes, page) - begin, flag);
+  }
+}
+
+void MappedStorage::mapFile(size_t capacity, bool shared) {
+  if (shared && ftruncate(m_fd, capacity) != 0) {
+    OPM_THROW(std::runtime_error, "Could not resize field storage file: "
+              << std::strerror(errno));
+  }
+  void* base = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                    shared ? MAP_SHARED : MAP_PRIVATE, m_fd, 0);
+  if (base == MAP_FAILED) {
+    OPM_THROW(std::runtime_error, "Could not map field storage file: "
+              << std::strerror(errno));
+  }
+  m_base = static_cast<char*>(base);
+  m_capacity = capacity;
+}
+
+void MappedStorage::mapAnonymous(size_t capacity) {
+  void* base = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    OPM_THROW(std::runtime_error, "Could not map anonymous field storage: "
+              << std::strerror(errno));
+  }
+  m_base = static_cast<char*>(base);
+  m_capacity = capacity;
+}
+
+void MappedStorage::reserve(size_t bytes) {
+  if (bytes <= m_capacity) {
+    return;
+  }
+  const size_t capacity = std::max(roundUp(bytes, pageSize()),
+                                   2 * m_capacity);
+  // The new mapping is made before the old one is dropped, so if it
+  // fails the storage still holds the old mapping and stays usable.
+  char* old_base = m_base;
+  const size_t old_capacity = m_capacity;
+  if (m_fd >= 0) {
+    // Both shared mappings of the file see the same pages.
+    mapFile(capacity, true);
+    munmap(old_base, old_capacity);
+  } else {
+    // Anonymous and private file mappings move to a larger anonymous
+    // mapping; the file, if any, is left untouched.
+    mapAnonymous(capacity);
+    std::memcpy(m_base, old_base, old_capacity);
+    munmap(old_base, old_capacity);
+  }
+}
+
+size_t MappedStorage::directoryBytes(const std::vector<Entry>& entries) {
+  size_t bytes = 0;
+  for (const auto& entry : entries) {
+    bytes += entryBytes(entry);
+  }
+  return bytes;
+}
+
+void MappedStorage::writeDirectory() {
+  reserve(m_data_end + directoryBytes());
+  writeHeader(m_base, m_base + m_data_end, m_num_cells, m_num_faces,
+              m_num_phases, m_data_end, m_entries);
+}
+
+void MappedStorage::writeHeader(char* header_destination,
+                                char* directory, size_t num_cells,
+                                size_t num_faces, size_t num_phases,
+                                size_t data_end,
+                                const std::vector<Entry>& entries) {
+  Header header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = format_version;
+  header.endian = endian_mark;
+  header.num_cells = num_cells;
+  header.num_faces = num_faces;
+  header.data_end = data_end;
+  header.directory_bytes = directoryBytes(entries);
+  header.num_fields = entries.size();
+  header.num_phases = num_phases;
+  std::memcpy(header_destination, &header, sizeof(header));
+
+  char* pos = directory;
+  for (const auto& entry : entries) {
+    EntryHeader entry_header;
+    entry_header.entity = static_cast<uint32_t>(entry.entity);
+    entry_header.name_length = entry.name.size();
+    entry_header.components = entry.components;
+    entry_header.offset = entry.offset;
+    entry_header.count = entry.count;
+    entry_header.layout = static_cast<uint32_t>(entry.layout.kind());
+    entry_header.width = entry.layout.width();
+    entry_header.type = static_cast<uint32_t>(entry.type);
+    entry_header.reserved = 0;
+    std::memcpy(pos, &entry_header, sizeof(entry_header));
+    std::memset(pos + sizeof(entry_header), 0,
+                entryBytes(entry) - sizeof(entry_header));
+    std::memcpy(pos + sizeof(entry_header), entry.name.data(),
+                entry.name.size());
+    pos += entryBytes(entry);
+  }
+}
+
+void MappedStorage::write(const std::string& path, size_t num_cells,
+                          size_t num_faces, size_t num_phases,
+                          std::vector<Entry> entries,
+                          const std::vector<const void*>& payloads) {
+  size_t data_end = pageSize();
+  for (auto& entry : entries) {
+    entry.offset = data_end;
+    data_end += roundUp(payloadBytes(entry), pageSize());
+  }
+
+  // Header and directory are assembled in one buffer, with the
+  // directory placed right after the header page.
+  const size_t directory_bytes = directoryBytes(entries);
+  std::vector<char> head(pageSize() + directory_bytes, 0);
+  writeHeader(head.data(), head.data() + pageSize(), num_cells, num_faces,
+              num_phases, data_end, entries);
+
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    OPM_THROW(std::runtime_error, "Could not create " << path << ": "
+              << std::strerror(errno));
+  }
+  auto writeAt = [&](const char* data, size_t bytes, size_t offset) {
+    while (bytes > 0) {
+      // Large writes are split since write() may stop at 2 GiB.
+      const ssize_t written = pwrite(fd, data,
+                                     std::min(bytes, size_t(1) << 30),
+                                     offset);
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+      if (written <= 0) {
+        const int error = errno;
+        ::close(fd);
+        OPM_THROW(std::runtime_error, "Could not write " << path << ": "
+                  << std::strerror(error));
+      }
+      data += written;
+      offset += written;
+      bytes -= written;
+    }
+  };
+  writeAt(head.data(), pageSize(), 0);
+  for (size_t field = 0; field < entries.size(); ++field) {
+    writeAt(static_cast<const char*>(payloads[field]),
+            payloadBytes(entries[field]), entries[field].offset);
+  }
+  writeAt(head.data() + pageSize(), directory_bytes, data_end);
+  // The padding between payloads is left as holes, which read as zero.
+  if (ftruncate(fd, data_end + directory_bytes) != 0 || ::close(fd) != 0) {
+    OPM_THROW(std::runtime_error, "Could not write " << path << ": "
+              << std::strerror(errno));
+  }
+}
+
+void MappedStorage::readDirectory(size_t file_size) {
+  Header header;
+  std::memcpy(&header, m_base, sizeof(header));
+  if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+    OPM_THROW(std::runtime_error, "Not a field storage file");
+  }
+  if (header.endian != endian_mark || header.version == 0 ||
+      header.version > format_version) {
+    OPM_THROW(std::runtime_error, "Unsupported field storage file version "
+              << header.version);
+  }
+  if (header.data_end > file_size ||
+      header.directory_bytes > file_size - header.data_end) {
+    OPM_THROW(std::runtime_error, "Truncated field storage file");
+  }
+  m_num_cells = header.num_cells;
+  m_num_faces = header.num_faces;
+  m_num_phases = header.version >= 4 ? header.num_phases : 0;
+  m_data_end = header.data_end;
+
+  // Sizes from the file are checked against what is left of it before
+  // they are added, so that corrupt ones cannot overflow.
+  const size_t header_bytes = entryHeaderBytes(header.version);
+  const size_t max_count = 8 * file_size;
+  const char* pos = m_base + m_data_end;
+  size_t left = header.directory_bytes;
+  for (uint64_t field = 0; field < header.num_fields; ++field) {
+    EntryHeader entry_header;
+    entry_header.layout = static_cast<uint32_t>(FieldLayout::Kind::Interleaved);
+    entry_header.width = 1;
+    entry_header.type = static_cast<uint32_t>(FieldType::Float64);
+    if (header_bytes > left) {
+      OPM_THROW(std::runtime_error, "Corrupt field storage directory");
+    }
+    std::memcpy(&entry_header, pos, header_bytes);
+    if (entry_header.name_length > left - header_bytes ||
+        entry_header.entity > static_cast<uint32_t>(Entity::Face)) {
+      OPM_THROW(std::runtime_error, "Corrupt field storage directory");
+    }
+    Entry entry = { static_cast<Entity>(entry_header.entity),
+                    std::string(pos + header_bytes,
+                                entry_header.name_length),
+                    entry_header.components,
+                    entry_header.offset,
+                    entry_header.count,
+                    FieldLayout::fromKind(entry_header.layout,
+                                          entry_header.width),
+                    fieldTypeFromValue(entry_header.type) };
+    // No field has more values than the file has bits.
+    const size_t num_entities = entry.entity == Entity::Cell
+                                ? m_num_cells : m_num_faces;
+    const bool sized = entry.components == 0 ||
+        (num_entities <= max_count &&
+         num_entities + entry.layout.width() <=
+           max_count / entry.components);
+    if (!sized || entry.count > max_count ||
+        entry.count != entry.layout.count(num_entities, entry.components) ||
+        entry.offset % sizeof(double) != 0 || entry.offset > m_data_end ||
+        payloadBytes(entry) > m_data_end - entry.offset) {
+      OPM_THROW(std::runtime_error, "Corrupt field storage directory");
+    }
+    const size_t bytes = std::min(header_bytes + roundUp(entry.name.size(), 8),
+                                  left);
+    pos += bytes;
+    left -= bytes;
+    m_entries.push_back(entry);
+  }
+}
+}  // namespace Opm
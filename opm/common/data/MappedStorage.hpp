@@ -0,0 +1,218 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_MAPPEDSTORAGE_H_
+#define OPM_COMMON_DATA_MAPPEDSTORAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "opm/common/data/FieldLayout.hpp"
+#include "opm/common/data/FieldType.hpp"
+#include "opm/common/data/FirstTouch.hpp"
+
+namespace Opm {
+/**
+ * @brief Access pattern hints for memory mapped field storage.
+ *
+ * - Normal:     no special treatment.
+ * - Sequential: the field will be read front to back.
+ * - Random:     the field will be accessed randomly; no read-ahead.
+ * - WillNeed:   the field will be accessed soon; start paging it in.
+ * - Cold:       the field will not be accessed for a while; the kernel
+ *               may page it out first.
+ */
+enum class FieldAdvice { Normal, Sequential, Random, WillNeed, Cold };
+
+/**
+ * @class MappedStorage
+ * @brief Memory mapping holding the cell and face fields of a
+ *        SimulationDataContainer.
+ *
+ * The mapping is either backed by a file or anonymous (backed by
+ * swap). The layout is the same in both cases:
+ *
+ * - page 0:   header with magic, format version, numCells(), numFaces(),
+ *             numPhases() and the position of the field directory;
+ * - payloads: the values of every field, each starting on a page
+ *             boundary, in registration order;
+ * - directory: entity kind, name, components, offset and number of
+ *             values of every field, following the last payload.
+ *
+ * A file written this way can be mapped again and used directly,
+ * without parsing or copying the payloads. Allocating a field appends
+ * a payload and rewrites the directory; when the mapping must grow it
+ * may move, which invalidates all pointers into it.
+ */
+class MappedStorage {
+ public:
+  /**
+   * @brief Entity kind of a field.
+   */
+  enum class Entity : uint32_t { Cell = 0, Face = 1 };
+
+  /**
+   * @brief Directory entry describing one field.
+   */
+  struct Entry {
+    Entity entity;  //!< cell or face field
+    std::string name;  //!< name of the field
+    size_t components;  //!< components per entity
+    size_t offset;  //!< first byte of the payload
+    size_t count;  //!< number of values
+    FieldLayout layout;  //!< order of the values
+    FieldType type;  //!< scalar type of the values
+  };
+
+  /**
+   * @brief Alignment of new payloads, in bytes: the page size of the
+   *        system.
+   *
+   * Files written on a system with other pages are still read; their
+   * payloads need only be aligned for their values.
+   */
+  static size_t pageSize();
+
+  /**
+   * @brief Version of the layout written by this class.
+   *
+   * Version 2 added the field layout to the directory entries,
+   * version 3 the scalar type and version 4 the number of phases to
+   * the header; older files are still read, with interleaved Float64
+   * fields and no phases.
+   */
+  static const uint32_t format_version = 4;
+
+  /**
+   * @brief Create a new file, truncating an existing one.
+   */
+  static std::shared_ptr<MappedStorage> create(const std::string& path,
+                                               size_t num_cells,
+                                               size_t num_faces);
+
+  /**
+   * @brief Create an anonymous mapping.
+   */
+  static std::shared_ptr<MappedStorage> createAnonymous(size_t num_cells,
+                                                        size_t num_faces);
+
+  /**
+   * @brief Map an existing file.
+   * @param path the file
+   * @param shared if true, changes are written back to the file;
+   *               otherwise they are private to this mapping
+   */
+  static std::shared_ptr<MappedStorage> open(const std::string& path,
+                                             bool shared);
+
+  /**
+   * @brief Write fields to a file in the layout of this class.
+   * 
+   * The file is written with large sequential writes straight from
+   * the payloads, and can afterwards be opened with open().
+   * @param path the file to write, truncated if it exists
+   * @param num_cells number of cells
+   * @param num_faces number of faces
+   * @param num_phases number of phases of the container
+   * @param entries the fields; the offsets are ignored
+   * @param payloads the values of every entry
+   */
+  static void write(const std::string& path, size_t num_cells,
+                    size_t num_faces, size_t num_phases,
+                    std::vector<Entry> entries,
+                    const std::vector<const void*>& payloads);
+
+  /**
+   * @brief Anonymous copy of the whole mapping.
+   * @param touch with Parallel the payloads are copied by the threads
+   *        which own their entities (see FirstTouch)
+   */
+  std::shared_ptr<MappedStorage> clone(
+    FirstTouch touch = FirstTouch::Serial) const;
+
+  MappedStorage(const MappedStorage&) = delete;
+  MappedStorage& operator=(const MappedStorage&) = delete;
+  ~MappedStorage();
+
+  size_t numCells() const { return m_num_cells; }
+  size_t numFaces() const { return m_num_faces; }
+  size_t numPhases() const { return m_num_phases; }
+
+  /**
+   * @brief Whether changes are written to a file.
+   */
+  bool fileBacked() const { return m_fd >= 0; }
+
+  /**
+   * @brief The directory, in registration order.
+   */
+  const std::vector<Entry>& entries() const { return m_entries; }
+
+  /**
+   * @brief Append a zero initialized payload for a new field.
+   * @return the offset of the payload
+   */
+  size_t allocate(Entity entity, const std::string& name,
+                  size_t components, size_t count,
+                  const FieldLayout& layout = FieldLayout(),
+                  FieldType type = FieldType::Float64);
+
+  /**
+   * @brief Record a new layout for the field with payload at @p offset.
+   *
+   * The payload is not touched and must keep its size.
+   */
+  void setLayout(size_t offset, const FieldLayout& layout);
+
+  char* base() { return m_base; }
+  const char* base() const { return m_base; }
+
+  /**
+   * @brief Pass an access pattern hint for a byte range to the kernel.
+   */
+  void advise(size_t offset, size_t bytes, FieldAdvice advice) const;
+
+ private:
+  MappedStorage(size_t num_cells, size_t num_faces);
+
+  void mapFile(size_t capacity, bool shared);
+  void mapAnonymous(size_t capacity);
+  void reserve(size_t bytes);
+  void readDirectory(size_t file_size);
+  void writeDirectory();
+  static void writeHeader(char* header, char* directory,
+                          size_t num_cells, size_t num_faces,
+                          size_t num_phases, size_t data_end,
+                          const std::vector<Entry>& entries);
+  static size_t directoryBytes(const std::vector<Entry>& entries);
+  size_t directoryBytes() const { return directoryBytes(m_entries); }
+
+  size_t m_num_cells;  //!< number of cells
+  size_t m_num_faces;  //!< number of faces
+  size_t m_num_phases;  //!< number of phases, zero unless read from a file
+  int m_fd;  //!< shared file, or -1
+  char* m_base;  //!< start of the mapping
+  size_t m_capacity;  //!< size of the mapping in bytes
+  size_t m_data_end;  //!< end of the last payload
+  std::vector<Entry> m_entries;  //!< the directory
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_MAPPEDSTORAGE_H_
@@ -0,0 +1,201 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/MemoryResource.hpp"
+
+namespace Opm {
+namespace {
+size_t roundUp(size_t bytes, size_t alignment) {
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+class DefaultResource : public MemoryResource {
+ public:
+  void* allocate(size_t bytes, size_t alignment) override {
+    void* block = nullptr;
+    if (posix_memalign(&block, std::max(alignment, sizeof(void*)),
+                       bytes) != 0) {
+      throw std::bad_alloc();
+    }
+    return block;
+  }
+
+  void deallocate(void* block, size_t, size_t) override {
+    free(block);
+  }
+};
+
+// An anonymous mapping of @p bytes, a multiple of the huge page size,
+// which starts on a huge page boundary.
+void* mapAligned(size_t bytes) {
+  const size_t page_size = HugePageResource::page_size;
+  void* base = mmap(nullptr, bytes + page_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  char* start = static_cast<char*>(base);
+  char* aligned = reinterpret_cast<char*>(
+    roundUp(reinterpret_cast<uintptr_t>(start), page_size));
+  if (aligned > start) {
+    munmap(start, aligned - start);
+  }
+  munmap(aligned + bytes, start + page_size - aligned);
+  return aligned;
+}
+}  // namespace
+
+MemoryResource::~MemoryResource() {
+}
+
+std::shared_ptr<MemoryResource> defaultMemoryResource() {
+  static const std::shared_ptr<MemoryResource> resource =
+    std::make_shared<DefaultResource>();
+  return resource;
+}
+
+const size_t HugePageResource::page_size;
+
+HugePageResource::HugePageResource(Pages pages, size_t min_bytes,
+                                   std::shared_ptr<MemoryResource> upstream)
+    : m_pages(pages),
+      m_min_bytes(min_bytes),
+      m_upstream(upstream) {
+  if (!m_upstream) {
+    OPM_THROW(std::invalid_argument,
+              "A huge page resource needs an upstream resource");
+  }
+}
+
+void* HugePageResource::allocate(size_t bytes, size_t alignment) {
+  if (bytes < m_min_bytes) {
+    return m_upstream->allocate(bytes, alignment);
+  }
+  if (alignment > page_size) {
+    OPM_THROW(std::invalid_argument, "The alignment: " << alignment
+              << " is larger than a huge page");
+  }
+  const size_t size = roundUp(bytes, page_size);
+  if (m_pages == Pages::Explicit) {
+#ifdef MAP_HUGETLB
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+    flags |= MAP_HUGE_2MB;
+#endif
+    void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (block != MAP_FAILED) {
+      return block;
+    }
+#endif
+    throw std::bad_alloc();
+  }
+  void* block = mapAligned(size);
+#ifdef MADV_HUGEPAGE
+  // A hint only; without transparent huge pages the block still works.
+  madvise(block, size, MADV_HUGEPAGE);
+#endif
+  return block;
+}
+
+void HugePageResource::deallocate(void* block, size_t bytes,
+                                  size_t alignment) {
+  if (bytes < m_min_bytes) {
+    m_upstream->deallocate(block, bytes, alignment);
+  } else {
+    munmap(block, roundUp(bytes, page_size));
+  }
+}
+
+const size_t MonotonicResource::chunk_alignment;
+
+MonotonicResource::MonotonicResource(size_t capacity,
+                                     std::shared_ptr<MemoryResource> upstream)
+    : m_upstream(upstream),
+      m_mutex(),
+      m_chunks(),
+      m_position(0),
+      m_used(0) {
+  if (!m_upstream) {
+    OPM_THROW(std::invalid_argument,
+              "A monotonic resource needs an upstream resource");
+  }
+  if (capacity > 0) {
+    addChunk(capacity);
+  }
+}
+
+MonotonicResource::~MonotonicResource() {
+  for (const Chunk& chunk : m_chunks) {
+    m_upstream->deallocate(chunk.data, chunk.size, chunk_alignment);
+  }
+}
+
+void MonotonicResource::addChunk(size_t bytes) {
+  Chunk chunk = { nullptr, bytes };
+  chunk.data = static_cast<char*>(
+    m_upstream->allocate(bytes, chunk_alignment));
+  m_chunks.push_back(chunk);
+  m_used += m_position;
+  m_position = 0;
+}
+
+void* MonotonicResource::allocate(size_t bytes, size_t alignment) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_chunks.empty()) {
+    const Chunk& chunk = m_chunks.back();
+    const uintptr_t start = reinterpret_cast<uintptr_t>(chunk.data);
+    const size_t offset = roundUp(start + m_position, alignment) - start;
+    if (offset <= chunk.size && bytes <= chunk.size - offset) {
+      m_position = offset + bytes;
+      return chunk.data + offset;
+    }
+  }
+  const size_t last = m_chunks.empty() ? 0 : m_chunks.back().size;
+  addChunk(std::max(2 * last,
+                    bytes + std::max(alignment, chunk_alignment)));
+  const uintptr_t start = reinterpret_cast<uintptr_t>(m_chunks.back().data);
+  const size_t offset = roundUp(start, alignment) - start;
+  m_position = offset + bytes;
+  return m_chunks.back().data + offset;
+}
+
+void MonotonicResource::deallocate(void*, size_t, size_t) {
+}
+
+size_t MonotonicResource::capacity() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t total = 0;
+  for (const Chunk& chunk : m_chunks) {
+    total += chunk.size;
+  }
+  return total;
+}
+
+size_t MonotonicResource::used() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_used + m_position;
+}
+}  // namespace Opm
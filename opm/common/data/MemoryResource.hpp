@@ -0,0 +1,150 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_MEMORYRESOURCE_H_
+#define OPM_COMMON_DATA_MEMORYRESOURCE_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Opm {
+/**
+ * @class MemoryResource
+ * @brief Where the field buffers of a container are allocated.
+ *
+ * A resource hands out raw, uninitialized blocks, like
+ * std::pmr::memory_resource. Buffers keep a reference to the resource
+ * which allocated them, so a resource lives as long as any of its
+ * blocks. Resources may be shared by several containers and must be
+ * safe to use from several threads.
+ */
+class MemoryResource {
+ public:
+  virtual ~MemoryResource();
+
+  /**
+   * @brief Allocate @p bytes bytes aligned to @p alignment, a power of
+   *        two; throws std::bad_alloc on failure.
+   */
+  virtual void* allocate(size_t bytes, size_t alignment) = 0;
+
+  /**
+   * @brief Return a block from allocate() with the same size and
+   *        alignment.
+   */
+  virtual void deallocate(void* block, size_t bytes, size_t alignment) = 0;
+};
+
+/**
+ * @brief The resource used when none is given: posix_memalign() and
+ *        free().
+ */
+std::shared_ptr<MemoryResource> defaultMemoryResource();
+
+/**
+ * @class HugePageResource
+ * @brief Places large blocks on 2 MiB huge pages.
+ *
+ * Blocks of at least minBytes() bytes get a mapping of their own,
+ * rounded up to whole huge pages:
+ *
+ * - Transparent: an anonymous mapping aligned to 2 MiB, marked with
+ *                madvise(MADV_HUGEPAGE) so that the kernel backs it
+ *                with transparent huge pages where it can.
+ * - Explicit: a MAP_HUGETLB mapping from the preallocated huge page
+ *             pool (vm.nr_hugepages); allocate() throws
+ *             std::bad_alloc when the pool is exhausted.
+ *
+ * Smaller blocks come from the upstream resource, since a huge page
+ * per small field would waste most of it.
+ */
+class HugePageResource : public MemoryResource {
+ public:
+  enum class Pages { Transparent, Explicit };
+
+  static const size_t page_size = size_t(2) << 20;
+
+  explicit HugePageResource(
+      Pages pages = Pages::Transparent, size_t min_bytes = page_size / 2,
+      std::shared_ptr<MemoryResource> upstream = defaultMemoryResource());
+
+  void* allocate(size_t bytes, size_t alignment) override;
+  void deallocate(void* block, size_t bytes, size_t alignment) override;
+
+  Pages pages() const { return m_pages; }
+  size_t minBytes() const { return m_min_bytes; }
+
+ private:
+  Pages m_pages;  //!< transparent or explicit huge pages
+  size_t m_min_bytes;  //!< smaller blocks come from m_upstream
+  std::shared_ptr<MemoryResource> m_upstream;  //!< for small blocks
+};
+
+/**
+ * @class MonotonicResource
+ * @brief A bump allocator over large chunks from an upstream resource.
+ *
+ * The first chunk of capacity() bytes is allocated up front; when it
+ * is used up the next chunk is twice as large (at least as large as
+ * the request). deallocate() does nothing: the memory returns to the
+ * upstream resource when the resource is destroyed, i.e. after the
+ * last buffer allocated from it. This suits fields which are
+ * registered once and live for the whole run; relayout(), retype()
+ * and copies of fields allocate again.
+ */
+class MonotonicResource : public MemoryResource {
+ public:
+  explicit MonotonicResource(
+      size_t capacity,
+      std::shared_ptr<MemoryResource> upstream = defaultMemoryResource());
+  ~MonotonicResource() override;
+
+  MonotonicResource(const MonotonicResource&) = delete;
+  MonotonicResource& operator=(const MonotonicResource&) = delete;
+
+  void* allocate(size_t bytes, size_t alignment) override;
+  void deallocate(void* block, size_t bytes, size_t alignment) override;
+
+  /**
+   * @brief Total size of the chunks, and the bytes handed out of them
+   *        (alignment gaps included).
+   */
+  size_t capacity() const;
+  size_t used() const;
+
+ private:
+  struct Chunk {
+    char* data;
+    size_t size;
+  };
+
+  static const size_t chunk_alignment = 64;
+
+  void addChunk(size_t bytes);
+
+  std::shared_ptr<MemoryResource> m_upstream;  //!< source of the chunks
+  mutable std::mutex m_mutex;  //!< guards the members below
+  std::vector<Chunk> m_chunks;  //!< all chunks, the current one last
+  size_t m_position;  //!< next free byte in the current chunk
+  size_t m_used;  //!< bytes handed out of the earlier chunks
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_MEMORYRESOURCE_H_
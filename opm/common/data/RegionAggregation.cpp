@@ -0,0 +1,174 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "opm/common/data/FieldBits.hpp"
+#include "opm/common/data/RegionAggregation.hpp"
+
+namespace Opm {
+namespace {
+const size_t block_values = 4096;
+
+// Entity e of the component is at (e / block) * stride + e % block.
+template <typename T>
+void readValues(const T* values, size_t stride, size_t block, size_t begin,
+                size_t end, double* out) {
+  if (block == 1) {
+    for (size_t entity = begin; entity < end; ++entity) {
+      *out++ = values[entity * stride];
+    }
+    return;
+  }
+  size_t entity = begin;
+  while (entity < end) {
+    const size_t offset = entity % block;
+    const size_t length = std::min(block - offset, end - entity);
+    const T* run = values + (entity / block) * stride + offset;
+    for (size_t i = 0; i < length; ++i) {
+      out[i] = run[i];
+    }
+    out += length;
+    entity += length;
+  }
+}
+
+// Values [begin, end) of @p field as double.
+void read(const FieldComponent& field, size_t entity_count, size_t begin,
+          size_t end, double* out) {
+  if (field.type == FieldType::Bit) {
+    const BitView<const FieldBits::Word> bits(
+      static_cast<const FieldBits::Word*>(field.values),
+      entity_count * field.components);
+    for (size_t entity = begin; entity < end; ++entity) {
+      *out++ = bits[entity * field.components + field.component];
+    }
+    return;
+  }
+  const size_t offset = field.layout.componentOffset(field.component,
+                                                     entity_count);
+  const size_t stride = field.layout.componentStride(entity_count,
+                                                     field.components);
+  const size_t block = field.layout.componentBlock(entity_count);
+  switch (field.type) {
+    case FieldType::Float64:
+      readValues(static_cast<const double*>(field.values) + offset, stride,
+                 block, begin, end, out);
+      break;
+    case FieldType::Float32:
+      readValues(static_cast<const float*>(field.values) + offset, stride,
+                 block, begin, end, out);
+      break;
+    case FieldType::Int32:
+      readValues(static_cast<const int32_t*>(field.values) + offset, stride,
+                 block, begin, end, out);
+      break;
+    case FieldType::Int16:
+      readValues(static_cast<const int16_t*>(field.values) + offset, stride,
+                 block, begin, end, out);
+      break;
+    case FieldType::UInt8:
+      readValues(static_cast<const uint8_t*>(field.values) + offset, stride,
+                 block, begin, end, out);
+      break;
+    case FieldType::Bit:
+      break;
+  }
+}
+
+void merge(RegionAggregate& target, const RegionAggregate& source) {
+  target.count += source.count;
+  target.weight += source.weight;
+  target.sum += source.sum;
+  target.min = std::min(target.min, source.min);
+  target.max = std::max(target.max, source.max);
+}
+}  // namespace
+
+RegionReport aggregateRegions(size_t num_entities, size_t entity_count,
+                              size_t num_regions,
+                              const FieldComponent& regions,
+                              const std::vector<FieldComponent>& columns,
+                              const FieldComponent* weights) {
+  const size_t num_columns = columns.size();
+  const size_t num_blocks = (num_entities + block_values - 1) / block_values;
+#ifdef _OPENMP
+  const size_t num_threads = omp_get_max_threads();
+#else
+  const size_t num_threads = 1;
+#endif
+  std::vector<RegionReport> partials(num_threads,
+                                     RegionReport(0, num_columns));
+#pragma omp parallel
+  {
+#ifdef _OPENMP
+    RegionReport& partial = partials[omp_get_thread_num()];
+#else
+    RegionReport& partial = partials[0];
+#endif
+    partial = RegionReport(num_regions, num_columns);
+    std::vector<double> region(block_values);
+    std::vector<double> weight(block_values, 1.0);
+    std::vector<double> value(block_values);
+#pragma omp for schedule(static)
+    for (size_t block = 0; block < num_blocks; ++block) {
+      const size_t begin = block * block_values;
+      const size_t end = std::min(begin + block_values, num_entities);
+      const size_t length = end - begin;
+      read(regions, entity_count, begin, end, region.data());
+      if (weights) {
+        read(*weights, entity_count, begin, end, weight.data());
+      }
+      for (size_t column = 0; column < num_columns; ++column) {
+        read(columns[column], entity_count, begin, end, value.data());
+        for (size_t i = 0; i < length; ++i) {
+          // Also false for NaN.
+          if (!(region[i] >= 0.0 && region[i] < num_regions)) {
+            continue;
+          }
+          RegionAggregate& aggregate =
+            partial(static_cast<size_t>(region[i]), column);
+          aggregate.count += 1;
+          aggregate.weight += weight[i];
+          aggregate.sum += weight[i] * value[i];
+          aggregate.min = std::min(aggregate.min, value[i]);
+          aggregate.max = std::max(aggregate.max, value[i]);
+        }
+      }
+    }
+  }
+
+  RegionReport report(num_regions, num_columns);
+  for (const RegionReport& partial : partials) {
+    if (partial.numRegions() != num_regions) {
+      continue;
+    }
+    for (size_t region = 0; region < num_regions; ++region) {
+      for (size_t column = 0; column < num_columns; ++column) {
+        merge(report(region, column), partial(region, column));
+      }
+    }
+  }
+  return report;
+}
+}  // namespace Opm
@@ -0,0 +1,133 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_REGIONAGGREGATION_H_
+#define OPM_COMMON_DATA_REGIONAGGREGATION_H_
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <opm/common/data/FieldLayout.hpp>
+#include <opm/common/data/FieldType.hpp>
+
+namespace Opm {
+/**
+ * @brief The values of one column of one region.
+ *
+ * Without weights every value has weight one, so weight is the
+ * number of values and sum the plain sum. min and max ignore the
+ * weights.
+ */
+struct RegionAggregate {
+  size_t count;  //!< number of values
+  double weight;  //!< sum of the weights
+  double sum;  //!< weighted sum of the values
+  double min;  //!< smallest value, +infinity without values
+  double max;  //!< largest value, -infinity without values
+
+  /**
+   * @brief The aggregate of no values.
+   */
+  static RegionAggregate empty() {
+    RegionAggregate aggregate = {
+      0, 0.0, 0.0, std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity() };
+    return aggregate;
+  }
+
+  /**
+   * @brief The weighted mean, NaN without weight.
+   */
+  double mean() const {
+    return weight != 0.0 ? sum / weight
+                         : std::numeric_limits<double>::quiet_NaN();
+  }
+};
+
+/**
+ * @class RegionReport
+ * @brief Aggregates of a number of columns over a number of regions.
+ *
+ * A column is one component of one field.
+ */
+class RegionReport {
+ public:
+  RegionReport(size_t num_regions, size_t num_columns)
+      : m_num_regions(num_regions),
+        m_num_columns(num_columns),
+        m_aggregates(num_regions * num_columns, RegionAggregate::empty()) {}
+
+  size_t numRegions() const { return m_num_regions; }
+  size_t numColumns() const { return m_num_columns; }
+
+  const RegionAggregate& operator()(size_t region, size_t column) const {
+    return m_aggregates[region * m_num_columns + column];
+  }
+  RegionAggregate& operator()(size_t region, size_t column) {
+    return m_aggregates[region * m_num_columns + column];
+  }
+
+ private:
+  size_t m_num_regions;  //!< number of regions
+  size_t m_num_columns;  //!< number of columns
+  std::vector<RegionAggregate> m_aggregates;  //!< by region, then column
+};
+
+/**
+ * @brief Number of regions SimulationDataContainer::aggregateCellData()
+ *        accepts; region numbers beyond it are taken as corrupt data
+ *        rather than allocating histograms for them.
+ */
+const size_t max_regions = size_t(1) << 20;
+
+/**
+ * @brief One component of a field, read as double.
+ */
+struct FieldComponent {
+  const void* values;  //!< the values of the field
+  FieldType type;  //!< their scalar type
+  FieldLayout layout;  //!< their layout
+  size_t components;  //!< components of the field
+  size_t component;  //!< the component to read
+};
+
+/**
+ * @brief Aggregate columns over regions in one pass over the entities.
+ *
+ * The entities are read in blocks which fit in cache: the region
+ * numbers, weights and every column of a block are converted to
+ * double and then added to histograms of the thread, which are merged
+ * in thread order at the end. Entities whose region number is
+ * negative, NaN or not below @p num_regions are skipped; region
+ * numbers are truncated to integers.
+ * @param num_entities the entities [0, num_entities) to aggregate
+ * @param entity_count number of cells or faces of the fields
+ * @param num_regions number of regions in the report
+ * @param regions the region numbers
+ * @param columns the columns of the report
+ * @param weights the weights, or null for weight one
+ */
+RegionReport aggregateRegions(size_t num_entities, size_t entity_count,
+                              size_t num_regions,
+                              const FieldComponent& regions,
+                              const std::vector<FieldComponent>& columns,
+                              const FieldComponent* weights);
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_REGIONAGGREGATION_H_
@@ -0,0 +1,188 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef OPM_COMMON_DATA_SEGMENTEDARRAY_H_
+#define OPM_COMMON_DATA_SEGMENTEDARRAY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace Opm {
+/**
+ * @class SegmentedArray
+ * @brief Append-only array whose elements never move.
+ *
+ * The elements live in segments of 8, 16, 32, ... elements, reached
+ * through a fixed table of segment pointers. Unlike std::deque,
+ * push_back() never reallocates anything an element is reached
+ * through, so one thread may append while others index the elements
+ * already there, without locks. Concurrent push_back() calls must be
+ * serialized by the caller; copying, swapping and destroying an array
+ * must not overlap with any other use of it.
+ */
+template <typename T>
+class SegmentedArray {
+ public:
+  /**
+   * @brief Forward iterator over the elements of an array.
+   */
+  template <typename Array, typename Value>
+  class Iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    Iterator(Array* array, size_t index) : m_array(array), m_index(index) {}
+
+    Value& operator*() const { return (*m_array)[m_index]; }
+    Value* operator->() const { return &(*m_array)[m_index]; }
+
+    Iterator& operator++() {
+      ++m_index;
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return m_index == other.m_index;
+    }
+    bool operator!=(const Iterator& other) const {
+      return m_index != other.m_index;
+    }
+
+   private:
+    Array* m_array;
+    size_t m_index;
+  };
+
+  typedef Iterator<SegmentedArray, T> iterator;
+  typedef Iterator<const SegmentedArray, const T> const_iterator;
+
+  SegmentedArray() : m_size(0) {
+    for (auto& segment : m_segments) {
+      segment.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  SegmentedArray(const SegmentedArray& other) : SegmentedArray() {
+    for (const T& element : other) {
+      push_back(element);
+    }
+  }
+
+  SegmentedArray(SegmentedArray&& other) : SegmentedArray() { swap(other); }
+
+  SegmentedArray& operator=(const SegmentedArray& other) = delete;
+
+  ~SegmentedArray() {
+    const size_t size = this->size();
+    for (size_t index = 0; index < size; ++index) {
+      (*this)[index].~T();
+    }
+    for (auto& segment : m_segments) {
+      ::operator delete(segment.load(std::memory_order_relaxed));
+    }
+  }
+
+  void swap(SegmentedArray& other) {
+    for (size_t s = 0; s < max_segments; ++s) {
+      T* segment = m_segments[s].load(std::memory_order_relaxed);
+      m_segments[s].store(other.m_segments[s].load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+      other.m_segments[s].store(segment, std::memory_order_relaxed);
+    }
+    const size_t size = m_size.load(std::memory_order_relaxed);
+    m_size.store(other.m_size.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+    other.m_size.store(size, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Number of elements; elements below it can be indexed.
+   */
+  size_t size() const { return m_size.load(std::memory_order_acquire); }
+
+  bool empty() const { return size() == 0; }
+
+  T& operator[](size_t index) { return *address(index); }
+  const T& operator[](size_t index) const { return *address(index); }
+
+  /**
+   * @brief Append a copy of @p value; the element is visible to other
+   *        threads once it is complete.
+   */
+  T& push_back(const T& value) {
+    const size_t index = m_size.load(std::memory_order_relaxed);
+    const size_t position = index + first_capacity;
+    const size_t s = segmentOf(position);
+    T* segment = m_segments[s].load(std::memory_order_relaxed);
+    if (!segment) {
+      segment = static_cast<T*>(
+        ::operator new((first_capacity << s) * sizeof(T)));
+      m_segments[s].store(segment, std::memory_order_release);
+    }
+    T* element = new (segment + (position - (first_capacity << s)))
+                   T(value);
+    m_size.store(index + 1, std::memory_order_release);
+    return *element;
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+ private:
+  static const size_t first_bits = 3;
+  static const size_t first_capacity = size_t(1) << first_bits;
+  static const size_t max_segments = 8 * sizeof(size_t) - first_bits;
+
+  // The segment of position index + first_capacity: one less than the
+  // number of bits above the first_bits lowest ones.
+  static size_t segmentOf(size_t position) {
+#ifdef __GNUC__
+    return 8 * sizeof(unsigned long long) - 1
+           - __builtin_clzll(position) - first_bits;
+#else
+    size_t s = 0;
+    while (position >> (first_bits + s + 1)) {
+      ++s;
+    }
+    return s;
+#endif
+  }
+
+  T* address(size_t index) const {
+    const size_t position = index + first_capacity;
+    const size_t s = segmentOf(position);
+    return m_segments[s].load(std::memory_order_acquire)
+           + (position - (first_capacity << s));
+  }
+
+  std::atomic<T*> m_segments[max_segments];  //!< null until needed
+  std::atomic<size_t> m_size;  //!< number of complete elements
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_SEGMENTEDARRAY_H_
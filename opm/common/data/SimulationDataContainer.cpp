@@ -18,44 +18,447 @@
  */
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "opm/common/ErrorMacros.hpp"
 #include "opm/common/util/numeric/cmp.hpp"
+#include "opm/common/data/DeltaCheckpoint.hpp"
+#include "opm/common/data/FieldCompressor.hpp"
 #include "opm/common/data/SimulationDataContainer.hpp"
 
 namespace Opm {
+namespace {
+// Whether two fields hold the same number of entities and components.
+bool sameShape(const FieldTable& fields, size_t index,
+               const FieldTable& other, size_t other_index) {
+  return fields.numEntities() == other.numEntities() &&
+         fields.components(index) == other.components(other_index);
+}
+
+// Number of doubles holding @p count values of type @p type.
+size_t scratchSize(size_t count, FieldType type) {
+  return (storageBytes(type, count) + sizeof(double) - 1) / sizeof(double);
+}
+
+// The values of a field of @p fields and of the field of @p other
+// with the same shape, in the layout of the former and in a common
+// type: their own when both have the same type, else Float64, which
+// holds every value of the other types exactly. Both sides are
+// converted alike, so comparing either way round gives the same
+// result; the values are converted into @p scratch where needed.
+struct CommonFormat {
+  FieldType type;
+  const void* values;
+  const void* other_values;
+};
+
+CommonFormat inCommonFormat(const FieldTable& fields, size_t index,
+                            const FieldTable& other, size_t other_index,
+                            std::vector<double> (&scratch)[3]) {
+  const FieldLayout& layout = fields.layout(index);
+  const FieldLayout& other_layout = other.layout(other_index);
+  const size_t components = fields.components(index);
+  const FieldType other_type = other.type(other_index);
+  CommonFormat format = { fields.type(index), fields.rawData(index),
+                          other.rawData(other_index) };
+  if (other_type != format.type) {
+    format.type = FieldType::Float64;
+    scratch[0].resize(fields.count(index));
+    convertValues(format.values, fields.type(index), scratch[0].data(),
+                  format.type, fields.count(index));
+    format.values = scratch[0].data();
+    scratch[1].resize(other.count(other_index));
+    convertValues(format.other_values, other_type, scratch[1].data(),
+                  format.type, other.count(other_index));
+    format.other_values = scratch[1].data();
+  }
+  if (other_layout != layout) {
+    scratch[2].assign(
+      scratchSize(layout.count(other.numEntities(), components),
+                  format.type),
+      0.0);
+    FieldLayout::convert(format.other_values, other_layout,
+                         scratch[2].data(), layout, format.type,
+                         other.numEntities(), components);
+    format.other_values = scratch[2].data();
+  }
+  return format;
+}
+
+bool equalValues(FieldType type, const void* values, const void* other,
+                 size_t count) {
+  switch (type) {
+    case FieldType::Float32:
+      return FieldComparison::equal(static_cast<const float*>(values),
+                                    static_cast<const float*>(other), count,
+                                    cmp::default_abs_epsilon,
+                                    cmp::default_rel_epsilon);
+    case FieldType::Int32:
+      return FieldComparison::equal(static_cast<const int32_t*>(values),
+                                    static_cast<const int32_t*>(other),
+                                    count);
+    case FieldType::Int16:
+      return FieldComparison::equal(static_cast<const int16_t*>(values),
+                                    static_cast<const int16_t*>(other),
+                                    count);
+    case FieldType::UInt8:
+      return FieldComparison::equal(static_cast<const uint8_t*>(values),
+                                    static_cast<const uint8_t*>(other),
+                                    count);
+    case FieldType::Bit:
+      return FieldComparison::equalBits(
+        static_cast<const uint64_t*>(values),
+        static_cast<const uint64_t*>(other), count);
+    default:
+      return FieldComparison::equal(static_cast<const double*>(values),
+                                    static_cast<const double*>(other), count,
+                                    cmp::default_abs_epsilon,
+                                    cmp::default_rel_epsilon);
+  }
+}
+
+void compareValues(FieldType type, const void* values, const void* other,
+                   size_t count, double abs_eps, double rel_eps,
+                   FieldDifference& difference) {
+  switch (type) {
+    case FieldType::Float32:
+      FieldComparison::compare(static_cast<const float*>(values),
+                               static_cast<const float*>(other), count,
+                               abs_eps, rel_eps, difference);
+      break;
+    case FieldType::Int32:
+      FieldComparison::compare(static_cast<const int32_t*>(values),
+                               static_cast<const int32_t*>(other), count,
+                               difference);
+      break;
+    case FieldType::Int16:
+      FieldComparison::compare(static_cast<const int16_t*>(values),
+                               static_cast<const int16_t*>(other), count,
+                               difference);
+      break;
+    case FieldType::UInt8:
+      FieldComparison::compare(static_cast<const uint8_t*>(values),
+                               static_cast<const uint8_t*>(other), count,
+                               difference);
+      break;
+    case FieldType::Bit:
+      FieldComparison::compareBits(static_cast<const uint64_t*>(values),
+                                   static_cast<const uint64_t*>(other), count,
+                                   difference);
+      break;
+    default:
+      FieldComparison::compare(static_cast<const double*>(values),
+                               static_cast<const double*>(other), count,
+                               abs_eps, rel_eps, difference);
+      break;
+  }
+}
+
+bool equalFields(const FieldTable& fields, const FieldTable& other) {
+  if (fields.size() != other.size()) {
+    return false;
+  }
+  std::vector<double> scratch[3];
+  for (size_t index = 0; index < fields.size(); ++index) {
+    const std::string& name = fields.name(index);
+    const size_t other_index = other.find(name.data(), name.size());
+    if (other_index == FieldTable::npos ||
+        !sameShape(fields, index, other, other_index)) {
+      return false;
+    }
+    const CommonFormat format = inCommonFormat(fields, index, other,
+                                               other_index, scratch);
+    if (!equalValues(format.type, format.values, format.other_values,
+                     fields.count(index))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The sparse field named @p name in @p fields, or null.
+const SparseField* findSparse(const std::vector<SparseField>& fields,
+                              const std::string& name) {
+  auto match = std::find_if(fields.begin(), fields.end(),
+                            [&](const SparseField& candidate) {
+                              return candidate.name() == name;
+                            });
+  return match == fields.end() ? nullptr : &*match;
+}
+
+// Whether two sparse fields hold values of the same entities.
+bool sameShape(const SparseField& field, const SparseField& other) {
+  return field.components() == other.components() &&
+         field.entities() == other.entities();
+}
+
+bool equalSparse(const std::vector<SparseField>& fields,
+                 const std::vector<SparseField>& other) {
+  if (fields.size() != other.size()) {
+    return false;
+  }
+  for (const SparseField& field : fields) {
+    const SparseField* match = findSparse(other, field.name());
+    if (!match || !sameShape(field, *match) ||
+        !FieldComparison::equal(field.values().data(),
+                                match->values().data(),
+                                field.values().size(),
+                                cmp::default_abs_epsilon,
+                                cmp::default_rel_epsilon)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A new entry of @p differences, with no values compared yet.
+FieldDifference& addDifference(std::vector<FieldDifference>& differences,
+                               const std::string& name,
+                               FieldDifference::Status status) {
+  FieldDifference difference = { name, status, 0, 0, FieldDifference::npos,
+                                 FieldDifference::npos, 0.0, 0.0 };
+  differences.push_back(difference);
+  return differences.back();
+}
+
+std::vector<FieldDifference> compareFields(const FieldTable& fields,
+                                           const FieldTable& other,
+                                           double abs_eps, double rel_eps) {
+  std::vector<FieldDifference> differences;
+  auto add = [&](const std::string& name, FieldDifference::Status status)
+      -> FieldDifference& {
+    return addDifference(differences, name, status);
+  };
+  std::vector<double> scratch[3];
+  for (size_t index = 0; index < fields.size(); ++index) {
+    const std::string& name = fields.name(index);
+    const size_t other_index = other.find(name.data(), name.size());
+    if (other_index == FieldTable::npos) {
+      add(name, FieldDifference::Status::Missing);
+    } else if (!sameShape(fields, index, other, other_index)) {
+      add(name, FieldDifference::Status::SizeMismatch);
+    } else {
+      const CommonFormat format = inCommonFormat(fields, index, other,
+                                                 other_index, scratch);
+      compareValues(format.type, format.values, format.other_values,
+                    fields.count(index), abs_eps, rel_eps,
+                    add(name, FieldDifference::Status::Compared));
+    }
+  }
+  for (size_t index = 0; index < other.size(); ++index) {
+    const std::string& name = other.name(index);
+    if (fields.find(name.data(), name.size()) == FieldTable::npos) {
+      add(name, FieldDifference::Status::Missing);
+    }
+  }
+  return differences;
+}
+
+std::vector<FieldDifference> compareSparse(
+    const std::vector<SparseField>& fields,
+    const std::vector<SparseField>& other, double abs_eps, double rel_eps) {
+  std::vector<FieldDifference> differences;
+  auto add = [&](const std::string& name, FieldDifference::Status status)
+      -> FieldDifference& {
+    return addDifference(differences, name, status);
+  };
+  for (const SparseField& field : fields) {
+    const SparseField* match = findSparse(other, field.name());
+    if (!match) {
+      add(field.name(), FieldDifference::Status::Missing);
+    } else if (!sameShape(field, *match)) {
+      add(field.name(), FieldDifference::Status::SizeMismatch);
+    } else {
+      FieldComparison::compare(field.values().data(),
+                               match->values().data(),
+                               field.values().size(), abs_eps, rel_eps,
+                               add(field.name(),
+                                   FieldDifference::Status::Compared));
+    }
+  }
+  for (const SparseField& field : other) {
+    if (!findSparse(fields, field.name())) {
+      add(field.name(), FieldDifference::Status::Missing);
+    }
+  }
+  return differences;
+}
+
+// Validate cell indices in one pass and return the smallest and the
+// largest; negative indices compare as too large.
+template <typename Index>
+std::pair<uint64_t, uint64_t> checkCells(const Index* cells, size_t count,
+                                         size_t num_cells) {
+  uint64_t first = UINT64_MAX;
+  uint64_t last = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const uint64_t cell = static_cast<uint64_t>(
+      static_cast<typename std::make_unsigned<Index>::type>(cells[i]));
+    first = std::min(first, cell);
+    last = std::max(last, cell);
+  }
+  if (count > 0 && last >= num_cells) {
+    for (size_t i = 0; i < count; ++i) {
+      if (cells[i] < 0 || static_cast<uint64_t>(cells[i]) >= num_cells) {
+        OPM_THROW(std::invalid_argument,
+                  "The cell number: " << cells[i] << " is invalid.");
+      }
+    }
+  }
+  return std::make_pair(first, last);
+}
+
+template <typename T, typename Index>
+void scatterValues(const StridedView<T>& target, const Index* cells,
+                   const double* values, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    target[static_cast<size_t>(cells[i])] = static_cast<T>(values[i]);
+  }
+}
+
+template <typename T, typename Index>
+void gatherValues(const StridedView<const T>& source, const Index* cells,
+                  double* values, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = source[static_cast<size_t>(cells[i])];
+  }
+}
+
+// Stride for FieldCompressor: the distance to the previous value of
+// the same component.
+size_t compressionStride(const FieldTable& fields, size_t index) {
+  return fields.layout(index).kind() == FieldLayout::Kind::Interleaved
+         ? fields.components(index) : 1;
+}
+
+// Fields of the other types are compressed as Float64, which is exact;
+// the low mantissa bytes are then all zero and cost next to nothing.
+std::vector<char> compressField(const FieldTable& fields, size_t index) {
+  const size_t count = fields.count(index);
+  if (fields.type(index) == FieldType::Float64) {
+    return FieldCompressor::compress(fields.data(index), count,
+                                     compressionStride(fields, index));
+  }
+  std::vector<double> values(count);
+  convertValues(fields.rawData(index), fields.type(index), values.data(),
+                FieldType::Float64, count);
+  return FieldCompressor::compress(values.data(), count,
+                                   compressionStride(fields, index));
+}
+
+void decompressField(FieldTable& fields, size_t index,
+                     const std::vector<char>& data) {
+  const size_t count = fields.count(index);
+  fields.touch(index);
+  if (fields.type(index) == FieldType::Float64) {
+    FieldCompressor::decompress(data.data(), data.size(), fields.data(index),
+                                count);
+    return;
+  }
+  std::vector<double> values(count);
+  FieldCompressor::decompress(data.data(), data.size(), values.data(), count);
+  convertValues(values.data(), FieldType::Float64, fields.rawData(index),
+                fields.type(index), count);
+}
+
+// The indices of all fields of a table, in registration order.
+std::vector<size_t> allCellFields(const FieldTable& fields) {
+  std::vector<size_t> indices(fields.size());
+  for (size_t index = 0; index < indices.size(); ++index) {
+    indices[index] = index;
+  }
+  return indices;
+}
+}  // namespace
+
 SimulationDataContainer::SimulationDataContainer(size_t num_cells,
                                                  size_t num_faces,
                                                  size_t num_phases)
     : m_num_cells(num_cells),
       m_num_faces(num_faces),
       m_num_phases(num_phases),
-      m_cell_data(),
-      m_face_data(),
-      pressure_ref_(),
-      temperature_ref_(),
-      saturation_ref_(),
-      facepressure_ref_(),
-      faceflux_ref_() {
+      m_mapping(),
+      m_cell_data(num_cells, FieldStorage::Vector),
+      m_face_data(num_faces, FieldStorage::Vector),
+      m_partition(std::make_shared<CellPartition>(num_cells)),
+      m_sparse_cell_data(),
+      m_sparse_face_data() {
   addDefaultFields();
 }
 
+SimulationDataContainer::SimulationDataContainer(
+    size_t num_cells, size_t num_faces, FieldStorage storage,
+    std::shared_ptr<MemoryResource> resource)
+    : m_num_cells(num_cells),
+      m_num_faces(num_faces),
+      m_num_phases(0),
+      m_mapping(storage == FieldStorage::Mapped
+                ? MappedStorage::createAnonymous(num_cells, num_faces)
+                : std::shared_ptr<MappedStorage>()),
+      m_cell_data(m_mapping
+                  ? FieldTable(m_mapping, MappedStorage::Entity::Cell)
+                  : FieldTable(num_cells, storage, resource)),
+      m_face_data(m_mapping
+                  ? FieldTable(m_mapping, MappedStorage::Entity::Face)
+                  : FieldTable(num_faces, storage, resource)),
+      m_partition(std::make_shared<CellPartition>(num_cells)),
+      m_sparse_cell_data(),
+      m_sparse_face_data() {
+  if (m_mapping && resource) {
+    OPM_THROW(std::invalid_argument,
+              "Mapped field storage does not take a memory resource");
+  }
+}
+
+SimulationDataContainer::SimulationDataContainer(size_t num_cells,
+                                                 size_t num_faces,
+                                                 const std::string& path)
+    : m_num_cells(num_cells),
+      m_num_faces(num_faces),
+      m_num_phases(0),
+      m_mapping(MappedStorage::create(path, num_cells, num_faces)),
+      m_cell_data(m_mapping, MappedStorage::Entity::Cell),
+      m_face_data(m_mapping, MappedStorage::Entity::Face),
+      m_partition(std::make_shared<CellPartition>(num_cells)),
+      m_sparse_cell_data(),
+      m_sparse_face_data() {
+}
+
+SimulationDataContainer::SimulationDataContainer(const std::string& path)
+    : m_num_cells(0),
+      m_num_faces(0),
+      m_num_phases(0),
+      m_mapping(MappedStorage::open(path, true)),
+      m_cell_data(m_mapping, MappedStorage::Entity::Cell),
+      m_face_data(m_mapping, MappedStorage::Entity::Face),
+      m_partition(),
+      m_sparse_cell_data(),
+      m_sparse_face_data() {
+  m_num_cells = m_mapping->numCells();
+  m_num_faces = m_mapping->numFaces();
+  m_num_phases = m_mapping->numPhases();
+  m_partition = std::make_shared<CellPartition>(m_num_cells);
+}
+
 SimulationDataContainer::SimulationDataContainer(
     const SimulationDataContainer& other)
     : m_num_cells(other.m_num_cells),
       m_num_faces(other.m_num_faces),
       m_num_phases(other.m_num_phases),
-      m_cell_data(other.m_cell_data),
-      m_face_data(other.m_face_data),
-      pressure_ref_(),
-      temperature_ref_(),
-      saturation_ref_(),
-      facepressure_ref_(),
-      faceflux_ref_() {
-  setReferencePointers();
+      m_mapping(other.m_mapping
+                ? other.m_mapping->clone(other.firstTouch())
+                : std::shared_ptr<MappedStorage>()),
+      m_cell_data(other.m_cell_data, m_mapping),
+      m_face_data(other.m_face_data, m_mapping),
+      m_partition(other.m_partition),
+      m_sparse_cell_data(other.m_sparse_cell_data),
+      m_sparse_face_data(other.m_sparse_face_data) {
 }
 
 SimulationDataContainer& SimulationDataContainer::operator=(
@@ -70,10 +473,21 @@ void SimulationDataContainer::swap(SimulationDataContainer& other) {
   swap(m_num_cells, other.m_num_cells);
   swap(m_num_faces, other.m_num_faces);
   swap(m_num_phases, other.m_num_phases);
-  swap(m_cell_data, other.m_cell_data);
-  swap(m_face_data, other.m_face_data);
-  setReferencePointers();
-  other.setReferencePointers();
+  swap(m_mapping, other.m_mapping);
+  m_cell_data.swap(other.m_cell_data);
+  m_face_data.swap(other.m_face_data);
+  swap(m_partition, other.m_partition);
+  swap(m_sparse_cell_data, other.m_sparse_cell_data);
+  swap(m_sparse_face_data, other.m_sparse_face_data);
+}
+
+FieldStorage SimulationDataContainer::storage() const {
+  return m_cell_data.storage();
+}
+
+void SimulationDataContainer::setFirstTouch(FirstTouch touch) {
+  m_cell_data.setFirstTouch(touch);
+  m_face_data.setFirstTouch(touch);
 }
 
 size_t SimulationDataContainer::numPhases() const {
@@ -90,48 +504,105 @@ size_t SimulationDataContainer::numCells() const {
 
 
 bool SimulationDataContainer::hasCellData(const std::string& name) const {
-  return (m_cell_data.find(name) == m_cell_data.end() ? false : true );
+  return m_cell_data.find(name.data(), name.size()) != FieldTable::npos;
+}
+
+bool SimulationDataContainer::hasCellData(const char* name) const {
+  return m_cell_data.find(name, std::strlen(name)) != FieldTable::npos;
+}
+
+CellFieldId SimulationDataContainer::cellFieldId(
+    const std::string& name) const {
+  return CellFieldId(findCellData(name.data(), name.size()));
+}
+
+CellFieldId SimulationDataContainer::cellFieldId(const char* name) const {
+  return CellFieldId(findCellData(name, std::strlen(name)));
 }
 
 std::vector<double>& SimulationDataContainer::getCellData(
     const std::string& name) {
-  auto iter = m_cell_data.find(name);
-  if (iter == m_cell_data.end()) {
-    throw std::invalid_argument(
-      "The cell data with name: " + name + " does not exist");
-  } else {
-    return iter->second;
-  }
+  return getCellData(CellFieldId(findCellData(name.data(), name.size())));
 }
 
 const std::vector<double>& SimulationDataContainer::getCellData(
     const std::string& name) const {
-  auto iter = m_cell_data.find(name);
-  if (iter == m_cell_data.end()) {
-    throw std::invalid_argument(
-      "The cell data with name: " + name + " does not exist");
-  } else {
-    return iter->second;
-  }
+  return m_cell_data.vector(findCellData(name.data(), name.size()));
 }
 
-void SimulationDataContainer::registerCellData(const std::string& name,
-                                               size_t components,
-                                               double initialValue) {
-  if (!hasCellData(name)) {
-      m_cell_data.insert(std::pair<std::string, std::vector<double>>(
-        name,
-        std::vector<double>(components * m_num_cells, initialValue)));
-  }
+std::vector<double>& SimulationDataContainer::getCellData(const char* name) {
+  return getCellData(CellFieldId(findCellData(name, std::strlen(name))));
+}
+
+const std::vector<double>& SimulationDataContainer::getCellData(
+    const char* name) const {
+  return m_cell_data.vector(findCellData(name, std::strlen(name)));
+}
+
+FieldView<double> SimulationDataContainer::cellView(const std::string& name) {
+  return cellView(CellFieldId(findCellData(name.data(), name.size())));
+}
+
+FieldView<const double> SimulationDataContainer::cellView(
+    const std::string& name) const {
+  return cellView(CellFieldId(findCellData(name.data(), name.size())));
+}
+
+StridedView<double> SimulationDataContainer::cellComponentView(
+    CellFieldId id, size_t component) {
+  return cellComponentView<double>(id, component);
+}
+
+StridedView<const double> SimulationDataContainer::cellComponentView(
+    CellFieldId id, size_t component) const {
+  return cellComponentView<double>(id, component);
+}
+
+StridedView<double> SimulationDataContainer::cellComponentView(
+    const std::string& name, size_t component) {
+  const CellFieldId id(findCellData(name.data(), name.size()));
+  return cellComponentView(id, component);
+}
+
+StridedView<const double> SimulationDataContainer::cellComponentView(
+    const std::string& name, size_t component) const {
+  const CellFieldId id(findCellData(name.data(), name.size()));
+  return cellComponentView(id, component);
+}
+
+CellFieldId SimulationDataContainer::registerCellData(
+    const std::string& name, size_t components, double initialValue,
+    const FieldLayout& layout, FieldType type) {
+  return CellFieldId(m_cell_data.findOrInsert(name, components, initialValue,
+                                           layout, type));
+}
+
+void SimulationDataContainer::relayoutCellData(CellFieldId id,
+                                               const FieldLayout& layout) {
+  m_cell_data.relayout(id.index(), layout);
 }
 
+void SimulationDataContainer::convertCellData(CellFieldId id, FieldType type) {
+  m_cell_data.retype(id.index(), type);
+}
+
+size_t SimulationDataContainer::findCellData(const char* name,
+                                             size_t length) const {
+  const size_t index = m_cell_data.find(name, length);
+  if (index == FieldTable::npos) {
+    throw std::invalid_argument(
+      "The cell data with name: " + std::string(name, length)
+      + " does not exist");
+  }
+  return index;
+}
 
 void SimulationDataContainer::setCellDataComponent(
     const std::string& key,
     size_t component,
     const std::vector<int>& cells,
     const std::vector<double>& values) {
-  auto& data = getCellData(key);
+  const size_t index = findCellData(key.data(), key.size());
   if (component >= m_num_phases) {
     OPM_THROW(std::invalid_argument,
               "The component number: " << component << " is invalid");
@@ -145,58 +616,758 @@ void SimulationDataContainer::setCellDataComponent(
   // we are currently focusing on has num_phases components in
   // total. This restriction should be lifted by allowing a per
   // field number of components.
-  if (data.size() != m_num_phases * m_num_cells) {
+  if (m_cell_data.components(index) != m_num_phases) {
     OPM_THROW(std::invalid_argument,
               "Can currently only be used on fields with num_components"
               " == num_phases (i.e. saturation...) ");
   }
-  for (size_t i = 0; i < cells.size(); i++) {
-    if (size_t(cells[i]) < m_num_cells) {
-        auto field_index = cells[i] * m_num_phases + component;
-        data[field_index] = values[i];
-    } else {
-        OPM_THROW(std::invalid_argument,
-                  "The cell number: " << cells[i] << " is invalid.");
+  scatter(m_cell_data, m_num_cells, index, component, cells.data(),
+          values.data(), cells.size(), IndexCheck::Checked);
+}
+
+void SimulationDataContainer::scatterCellData(
+    CellFieldId id, size_t component, const int32_t* cells,
+    const double* values, size_t count, IndexCheck check) {
+  scatter(m_cell_data, m_num_cells, id.index(), component, cells, values,
+          count, check);
+}
+
+void SimulationDataContainer::scatterCellData(
+    CellFieldId id, size_t component, const int64_t* cells,
+    const double* values, size_t count, IndexCheck check) {
+  scatter(m_cell_data, m_num_cells, id.index(), component, cells, values,
+          count, check);
+}
+
+void SimulationDataContainer::gatherCellData(
+    CellFieldId id, size_t component, const int32_t* cells,
+    double* values, size_t count, IndexCheck check) const {
+  gather(m_cell_data, m_num_cells, id.index(), component, cells, values,
+         count, check);
+}
+
+void SimulationDataContainer::gatherCellData(
+    CellFieldId id, size_t component, const int64_t* cells,
+    double* values, size_t count, IndexCheck check) const {
+  gather(m_cell_data, m_num_cells, id.index(), component, cells, values,
+         count, check);
+}
+
+template <typename Index>
+void SimulationDataContainer::scatter(FieldTable& fields,
+                                      size_t num_entities, size_t index,
+                                      size_t component, const Index* cells,
+                                      const double* values, size_t count,
+                                      IndexCheck check) {
+  checkComponent(fields, index, component);
+  const FieldLayout& layout = fields.layout(index);
+  const size_t components = fields.components(index);
+  auto position = [&](size_t cell) {
+    return layout.index(cell, component, num_entities, components);
+  };
+  if (check == IndexCheck::Checked) {
+    // Sparse lists mark the chunk of every cell, dense lists the
+    // whole range of cells; both cost at most one step per cell.
+    const auto range = checkCells(cells, count, num_entities);
+    const size_t begin = position(range.first);
+    const size_t end = position(range.second) + 1;
+    if (count > 0 && (end - begin) / fields.chunkSize() > count) {
+      for (size_t i = 0; i < count; ++i) {
+        const size_t value = position(static_cast<size_t>(cells[i]));
+        fields.markDirty(index, value, value + 1);
+      }
+    } else if (count > 0) {
+      fields.markDirty(index, begin, end);
+    }
+  } else {
+    fields.touch(index);
+  }
+  switch (fields.type(index)) {
+    case FieldType::Float64:
+      scatterValues(componentView(fields, index, fields.data(index),
+                                  component),
+                    cells, values, count);
+      break;
+    case FieldType::Float32:
+      scatterValues(componentView(fields, index,
+                                  fields.typedData<float>(index), component),
+                    cells, values, count);
+      break;
+    case FieldType::Int32:
+      scatterValues(componentView(fields, index,
+                                  fields.typedData<int32_t>(index),
+                                  component),
+                    cells, values, count);
+      break;
+    case FieldType::Int16:
+      scatterValues(componentView(fields, index,
+                                  fields.typedData<int16_t>(index),
+                                  component),
+                    cells, values, count);
+      break;
+    case FieldType::UInt8:
+      scatterValues(componentView(fields, index,
+                                  fields.typedData<uint8_t>(index),
+                                  component),
+                    cells, values, count);
+      break;
+    case FieldType::Bit: {
+      const BitView<FieldBits::Word> bits(fields.words(index),
+                                          fields.count(index));
+      for (size_t i = 0; i < count; ++i) {
+        bits.set(position(static_cast<size_t>(cells[i])), values[i] != 0.0);
+      }
+      break;
+    }
+  }
+}
+
+template <typename Index>
+void SimulationDataContainer::gather(const FieldTable& fields,
+                                     size_t num_entities, size_t index,
+                                     size_t component, const Index* cells,
+                                     double* values, size_t count,
+                                     IndexCheck check) {
+  checkComponent(fields, index, component);
+  if (check == IndexCheck::Checked) {
+    checkCells(cells, count, num_entities);
+  }
+  switch (fields.type(index)) {
+    case FieldType::Float64:
+      gatherValues(componentView(fields, index, fields.data(index),
+                                 component),
+                   cells, values, count);
+      break;
+    case FieldType::Float32:
+      gatherValues(componentView(fields, index,
+                                 fields.typedData<float>(index), component),
+                   cells, values, count);
+      break;
+    case FieldType::Int32:
+      gatherValues(componentView(fields, index,
+                                 fields.typedData<int32_t>(index), component),
+                   cells, values, count);
+      break;
+    case FieldType::Int16:
+      gatherValues(componentView(fields, index,
+                                 fields.typedData<int16_t>(index), component),
+                   cells, values, count);
+      break;
+    case FieldType::UInt8:
+      gatherValues(componentView(fields, index,
+                                 fields.typedData<uint8_t>(index), component),
+                   cells, values, count);
+      break;
+    case FieldType::Bit: {
+      const BitView<const FieldBits::Word> bits(fields.words(index),
+                                                fields.count(index));
+      const size_t components = fields.components(index);
+      for (size_t i = 0; i < count; ++i) {
+        values[i] = bits[static_cast<size_t>(cells[i]) * components
+                         + component];
+      }
+      break;
+    }
+  }
+}
+
+void SimulationDataContainer::setPartition(const CellPartition& partition) {
+  if (partition.numCells() != m_num_cells) {
+    OPM_THROW(std::invalid_argument, "The partition has "
+              << partition.numCells() << " cells, not " << m_num_cells);
+  }
+  m_partition = std::make_shared<CellPartition>(partition);
+}
+
+size_t SimulationDataContainer::haloSendBytes(
+    const std::vector<CellFieldId>& fields, size_t neighbor) const {
+  return HaloPacking::messageBytes(
+    m_cell_data, fieldIndices(fields),
+    m_partition->neighbors().at(neighbor).send.size());
+}
+
+size_t SimulationDataContainer::haloReceiveBytes(
+    const std::vector<CellFieldId>& fields, size_t neighbor) const {
+  return HaloPacking::messageBytes(
+    m_cell_data, fieldIndices(fields),
+    m_partition->neighbors().at(neighbor).receive.size());
+}
+
+void SimulationDataContainer::packHalo(const std::vector<CellFieldId>& fields,
+                                       size_t neighbor, void* buffer) const {
+  HaloPacking::pack(m_cell_data, fieldIndices(fields),
+                    m_partition->neighbors().at(neighbor).send, buffer);
+}
+
+void SimulationDataContainer::unpackHalo(
+    const std::vector<CellFieldId>& fields, size_t neighbor,
+    const void* buffer) {
+  HaloPacking::unpack(m_cell_data, fieldIndices(fields),
+                      m_partition->neighbors().at(neighbor).receive, buffer);
+}
+
+void SimulationDataContainer::exchangeHalo(
+    const std::vector<CellFieldId>& fields, HaloExchanger& exchanger) {
+  const std::vector<size_t> indices = fieldIndices(fields);
+  const auto& neighbors = m_partition->neighbors();
+  const size_t num_neighbors = neighbors.size();
+  // The buffers are vectors of double for the alignment of the values.
+  std::vector<std::vector<double>> send_buffers(num_neighbors);
+  std::vector<std::vector<double>> receive_buffers(num_neighbors);
+  std::vector<HaloSend> sends;
+  std::vector<HaloReceive> receives;
+  for (size_t i = 0; i < num_neighbors; ++i) {
+    const size_t send_bytes = HaloPacking::messageBytes(
+      m_cell_data, indices, neighbors[i].send.size());
+    const size_t receive_bytes = HaloPacking::messageBytes(
+      m_cell_data, indices, neighbors[i].receive.size());
+    send_buffers[i].resize(send_bytes / sizeof(double));
+    receive_buffers[i].resize(receive_bytes / sizeof(double));
+    sends.push_back(HaloSend { neighbors[i].rank, send_buffers[i].data(),
+                               send_bytes });
+    receives.push_back(HaloReceive { neighbors[i].rank,
+                                     receive_buffers[i].data(),
+                                     receive_bytes });
+  }
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < num_neighbors; ++i) {
+    HaloPacking::pack(m_cell_data, indices, neighbors[i].send,
+                      send_buffers[i].data());
+  }
+  exchanger.exchange(sends, receives);
+  // Ghost cells are received from one neighbour each, but the dirty
+  // flags of a field are shared, so the messages are unpacked in turn.
+  for (size_t i = 0; i < num_neighbors; ++i) {
+    HaloPacking::unpack(m_cell_data, indices, neighbors[i].receive,
+                        receive_buffers[i].data());
+  }
+}
+
+SimulationDataContainer SimulationDataContainer::extractCells(
+    const std::vector<int32_t>& cells) const {
+  for (int32_t cell : cells) {
+    if (cell < 0 || static_cast<size_t>(cell) >= m_num_cells) {
+      OPM_THROW(std::out_of_range, "The cell: " << cell
+                << " is not below the number of cells: " << m_num_cells);
     }
   }
+  SimulationDataContainer part(cells.size(), 0, storage(),
+                               m_cell_data.memoryResource());
+  part.m_num_phases = m_num_phases;
+  part.setFirstTouch(firstTouch());
+  for (size_t index = 0; index < m_cell_data.size(); ++index) {
+    const CellFieldId id = part.registerCellData(
+      m_cell_data.name(index), m_cell_data.components(index), 0.0,
+      m_cell_data.layout(index), m_cell_data.type(index));
+    HaloPacking::copy(m_cell_data, index, cells, part.m_cell_data,
+                      id.index(), std::vector<int32_t>(), cells.size());
+  }
+  return part;
 }
 
+SimulationDataContainer SimulationDataContainer::mergeCells(
+    const std::vector<const SimulationDataContainer*>& parts,
+    const std::vector<std::vector<int32_t>>& mappings) {
+  if (parts.empty() || parts.size() != mappings.size()) {
+    OPM_THROW(std::invalid_argument, "Cells are merged from "
+              << parts.size() << " parts with " << mappings.size()
+              << " mappings");
+  }
+  size_t num_cells = 0;
+  for (size_t p = 0; p < parts.size(); ++p) {
+    if (mappings[p].size() != parts[p]->m_num_cells) {
+      OPM_THROW(std::invalid_argument, "The mapping of part " << p
+                << " has " << mappings[p].size() << " cells, not "
+                << parts[p]->m_num_cells);
+    }
+    for (int32_t cell : mappings[p]) {
+      if (cell < 0) {
+        OPM_THROW(std::invalid_argument, "The mapping of part " << p
+                  << " has the negative cell: " << cell);
+      }
+      num_cells = std::max(num_cells, static_cast<size_t>(cell) + 1);
+    }
+  }
+  // The parts must partition the merged cells: every cell is mapped to
+  // exactly once. Fewer mapped cells than cells leave a gap, which is
+  // reported before the coverage of a stray large index is allocated.
+  size_t num_mapped = 0;
+  for (const auto& mapping : mappings) {
+    num_mapped += mapping.size();
+  }
+  if (num_mapped < num_cells) {
+    OPM_THROW(std::invalid_argument, "The parts map " << num_mapped
+              << " cells to " << num_cells << " cells");
+  }
+  std::vector<bool> covered(num_cells, false);
+  for (size_t p = 0; p < parts.size(); ++p) {
+    for (int32_t cell : mappings[p]) {
+      if (covered[cell]) {
+        OPM_THROW(std::invalid_argument, "The cell: " << cell
+                  << " is mapped to more than once");
+      }
+      covered[cell] = true;
+    }
+  }
+  const auto gap = std::find(covered.begin(), covered.end(), false);
+  if (gap != covered.end()) {
+    OPM_THROW(std::invalid_argument, "No part is mapped to the cell: "
+              << gap - covered.begin());
+  }
+  const SimulationDataContainer& first = *parts.front();
+  SimulationDataContainer merged(num_cells, 0, first.storage(),
+                                 first.m_cell_data.memoryResource());
+  merged.m_num_phases = first.m_num_phases;
+  merged.setFirstTouch(first.firstTouch());
+  for (size_t p = 0; p < parts.size(); ++p) {
+    const FieldTable& fields = parts[p]->m_cell_data;
+    for (size_t index = 0; index < fields.size(); ++index) {
+      const std::string& name = fields.name(index);
+      size_t target = merged.m_cell_data.find(name.data(), name.size());
+      if (target == FieldTable::npos) {
+        target = merged.registerCellData(name, fields.components(index), 0.0,
+                                         fields.layout(index),
+                                         fields.type(index)).index();
+      } else if (merged.m_cell_data.components(target) !=
+                   fields.components(index) ||
+                 merged.m_cell_data.type(target) != fields.type(index)) {
+        OPM_THROW(std::invalid_argument, "The cell field: " << name
+                  << " differs in components or type between the parts");
+      }
+      HaloPacking::copy(fields, index, std::vector<int32_t>(),
+                        merged.m_cell_data, target, mappings[p],
+                        mappings[p].size());
+    }
+  }
+  return merged;
+}
+
+size_t SimulationDataContainer::cellMessageBytes(size_t num_cells) const {
+  return HaloPacking::messageBytes(m_cell_data, allCellFields(m_cell_data),
+                                   num_cells);
+}
+
+void SimulationDataContainer::packCells(const std::vector<int32_t>& cells,
+                                        void* buffer) const {
+  HaloPacking::pack(m_cell_data, allCellFields(m_cell_data), cells, buffer);
+}
+
+void SimulationDataContainer::unpackCells(const std::vector<int32_t>& cells,
+                                          const void* buffer) {
+  HaloPacking::unpack(m_cell_data, allCellFields(m_cell_data), cells,
+                      buffer);
+}
+
+std::vector<size_t> SimulationDataContainer::fieldIndices(
+    const std::vector<CellFieldId>& fields) const {
+  std::vector<size_t> indices;
+  indices.reserve(fields.size());
+  for (CellFieldId id : fields) {
+    if (id.index() >= m_cell_data.size()) {
+      OPM_THROW(std::invalid_argument, "Invalid cell field handle");
+    }
+    indices.push_back(id.index());
+  }
+  return indices;
+}
 
 bool SimulationDataContainer::hasFaceData(const std::string& name) const {
-  return (m_face_data.find(name) == m_face_data.end() ? false : true );
+  return m_face_data.find(name.data(), name.size()) != FieldTable::npos;
+}
+
+bool SimulationDataContainer::hasFaceData(const char* name) const {
+  return m_face_data.find(name, std::strlen(name)) != FieldTable::npos;
+}
+
+FaceFieldId SimulationDataContainer::faceFieldId(
+    const std::string& name) const {
+  return FaceFieldId(findFaceData(name.data(), name.size()));
+}
+
+FaceFieldId SimulationDataContainer::faceFieldId(const char* name) const {
+  return FaceFieldId(findFaceData(name, std::strlen(name)));
 }
 
 std::vector<double>& SimulationDataContainer::getFaceData(
     const std::string& name) {
-  auto iter = m_face_data.find(name);
-  if (iter == m_face_data.end()) {
-      throw std::invalid_argument("The face data with name: "
-                                  + name + " does not exist");
-  } else {
-    return iter->second;
-  }
+  return getFaceData(FaceFieldId(findFaceData(name.data(), name.size())));
 }
 
 const std::vector<double>& SimulationDataContainer::getFaceData(
     const std::string& name) const {
-  auto iter = m_face_data.find(name);
-  if (iter == m_face_data.end()) {
-    throw std::invalid_argument("The Face data with name: "
-                                + name + " does not exist");
-  } else {
-    return iter->second;
+  return m_face_data.vector(findFaceData(name.data(), name.size()));
+}
+
+std::vector<double>& SimulationDataContainer::getFaceData(const char* name) {
+  return getFaceData(FaceFieldId(findFaceData(name, std::strlen(name))));
+}
+
+const std::vector<double>& SimulationDataContainer::getFaceData(
+    const char* name) const {
+  return m_face_data.vector(findFaceData(name, std::strlen(name)));
+}
+
+FieldView<double> SimulationDataContainer::faceView(const std::string& name) {
+  return faceView(FaceFieldId(findFaceData(name.data(), name.size())));
+}
+
+FieldView<const double> SimulationDataContainer::faceView(
+    const std::string& name) const {
+  return faceView(FaceFieldId(findFaceData(name.data(), name.size())));
+}
+
+StridedView<double> SimulationDataContainer::faceComponentView(
+    FaceFieldId id, size_t component) {
+  return faceComponentView<double>(id, component);
+}
+
+StridedView<const double> SimulationDataContainer::faceComponentView(
+    FaceFieldId id, size_t component) const {
+  return faceComponentView<double>(id, component);
+}
+
+StridedView<double> SimulationDataContainer::faceComponentView(
+    const std::string& name, size_t component) {
+  const FaceFieldId id(findFaceData(name.data(), name.size()));
+  return faceComponentView(id, component);
+}
+
+StridedView<const double> SimulationDataContainer::faceComponentView(
+    const std::string& name, size_t component) const {
+  const FaceFieldId id(findFaceData(name.data(), name.size()));
+  return faceComponentView(id, component);
+}
+
+FaceFieldId SimulationDataContainer::registerFaceData(
+    const std::string& name, size_t components, double initialValue,
+    const FieldLayout& layout, FieldType type) {
+  return FaceFieldId(m_face_data.findOrInsert(name, components, initialValue,
+                                           layout, type));
+}
+
+void SimulationDataContainer::relayoutFaceData(FaceFieldId id,
+                                               const FieldLayout& layout) {
+  m_face_data.relayout(id.index(), layout);
+}
+
+void SimulationDataContainer::convertFaceData(FaceFieldId id, FieldType type) {
+  m_face_data.retype(id.index(), type);
+}
+
+size_t SimulationDataContainer::findFaceData(const char* name,
+                                             size_t length) const {
+  const size_t index = m_face_data.find(name, length);
+  if (index == FieldTable::npos) {
+    throw std::invalid_argument("The face data with name: "
+                                + std::string(name, length)
+                                + " does not exist");
+  }
+  return index;
+}
+
+void SimulationDataContainer::adviseCellData(CellFieldId id,
+                                             FieldAdvice advice) const {
+  m_cell_data.advise(id.index(), advice);
+}
+
+void SimulationDataContainer::adviseFaceData(FaceFieldId id,
+                                             FieldAdvice advice) const {
+  m_face_data.advise(id.index(), advice);
+}
+
+RegionReport SimulationDataContainer::aggregateCellData(
+    CellFieldId regions, const std::vector<CellFieldId>& fields,
+    CellFieldId weights) const {
+  auto component = [&](CellFieldId id, size_t component) {
+    const size_t index = id.index();
+    FieldComponent values = {
+      m_cell_data.rawData(index), m_cell_data.type(index),
+      m_cell_data.layout(index), m_cell_data.components(index),
+      component };
+    return values;
+  };
+  if (!regions.valid() || regions.index() >= m_cell_data.size()) {
+    OPM_THROW(std::invalid_argument, "Invalid region field handle");
+  }
+  const FieldType region_type = m_cell_data.type(regions.index());
+  if (region_type == FieldType::Float64 ||
+      region_type == FieldType::Float32) {
+    OPM_THROW(std::invalid_argument, "The region numbers: "
+              << m_cell_data.name(regions.index())
+              << " must have an integer type");
+  }
+  if (weights.valid() && weights.index() >= m_cell_data.size()) {
+    OPM_THROW(std::invalid_argument, "Invalid weight field handle");
+  }
+  fieldIndices(fields);  // checks the handles
+  for (CellFieldId id : { regions, weights }) {
+    if (id.valid() && m_cell_data.components(id.index()) != 1) {
+      OPM_THROW(std::invalid_argument, "The cell data: "
+                << m_cell_data.name(id.index())
+                << " must have one component");
+    }
+  }
+  std::vector<FieldComponent> columns;
+  for (CellFieldId id : fields) {
+    for (size_t index = 0; index < m_cell_data.components(id.index());
+         ++index) {
+      columns.push_back(component(id, index));
+    }
+  }
+  // The largest region number is cached with the statistics.
+  const double max_region = cellStatistics(regions, 0).max;
+  if (max_region >= static_cast<double>(max_regions)) {
+    OPM_THROW(std::invalid_argument, "The region number: " << max_region
+              << " in " << m_cell_data.name(regions.index())
+              << " is not below " << max_regions);
+  }
+  const size_t num_regions = max_region >= 0.0
+                             ? static_cast<size_t>(max_region) + 1 : 0;
+  const FieldComponent weight_values = weights.valid()
+                                       ? component(weights, 0)
+                                       : FieldComponent();
+  return aggregateRegions(m_partition->numOwned(), m_num_cells, num_regions,
+                          component(regions, 0), columns,
+                          weights.valid() ? &weight_values : nullptr);
+}
+
+SparseCellFieldId SimulationDataContainer::registerSparseCellData(
+    const std::string& name, size_t components,
+    const std::vector<int32_t>& cells, double initialValue) {
+  size_t index = findSparse(m_sparse_cell_data, name);
+  if (index == SparseField::npos) {
+    index = m_sparse_cell_data.size();
+    m_sparse_cell_data.emplace_back(name, m_num_cells, cells, components,
+                                    initialValue);
+  }
+  return SparseCellFieldId(index);
+}
+
+SparseFaceFieldId SimulationDataContainer::registerSparseFaceData(
+    const std::string& name, size_t components,
+    const std::vector<int32_t>& faces, double initialValue) {
+  size_t index = findSparse(m_sparse_face_data, name);
+  if (index == SparseField::npos) {
+    index = m_sparse_face_data.size();
+    m_sparse_face_data.emplace_back(name, m_num_faces, faces, components,
+                                    initialValue);
+  }
+  return SparseFaceFieldId(index);
+}
+
+bool SimulationDataContainer::hasSparseCellData(
+    const std::string& name) const {
+  return findSparse(m_sparse_cell_data, name) != SparseField::npos;
+}
+
+bool SimulationDataContainer::hasSparseFaceData(
+    const std::string& name) const {
+  return findSparse(m_sparse_face_data, name) != SparseField::npos;
+}
+
+SparseCellFieldId SimulationDataContainer::sparseCellFieldId(
+    const std::string& name) const {
+  const size_t index = findSparse(m_sparse_cell_data, name);
+  if (index == SparseField::npos) {
+    throw std::invalid_argument(
+      "The sparse cell data with name: " + name + " does not exist");
   }
+  return SparseCellFieldId(index);
+}
+
+SparseFaceFieldId SimulationDataContainer::sparseFaceFieldId(
+    const std::string& name) const {
+  const size_t index = findSparse(m_sparse_face_data, name);
+  if (index == SparseField::npos) {
+    throw std::invalid_argument(
+      "The sparse face data with name: " + name + " does not exist");
+  }
+  return SparseFaceFieldId(index);
+}
+
+void SimulationDataContainer::scatterSparseCellData(SparseCellFieldId sparse,
+                                                    CellFieldId dense) {
+  const SparseField& field = m_sparse_cell_data[sparse.index()];
+  checkSparse(field, m_cell_data, dense.index());
+  for (size_t component = 0; component < field.components(); ++component) {
+    scatter(m_cell_data, m_num_cells, dense.index(), component,
+            field.entities().data(), field.component(component),
+            field.size(), IndexCheck::Checked);
+  }
+}
+
+void SimulationDataContainer::scatterSparseFaceData(SparseFaceFieldId sparse,
+                                                    FaceFieldId dense) {
+  const SparseField& field = m_sparse_face_data[sparse.index()];
+  checkSparse(field, m_face_data, dense.index());
+  for (size_t component = 0; component < field.components(); ++component) {
+    scatter(m_face_data, m_num_faces, dense.index(), component,
+            field.entities().data(), field.component(component),
+            field.size(), IndexCheck::Checked);
+  }
+}
+
+void SimulationDataContainer::gatherSparseCellData(SparseCellFieldId sparse,
+                                                   CellFieldId dense) {
+  SparseField& field = m_sparse_cell_data[sparse.index()];
+  checkSparse(field, m_cell_data, dense.index());
+  for (size_t component = 0; component < field.components(); ++component) {
+    gather(m_cell_data, m_num_cells, dense.index(), component,
+           field.entities().data(), field.component(component),
+           field.size(), IndexCheck::Unchecked);
+  }
+}
+
+void SimulationDataContainer::gatherSparseFaceData(SparseFaceFieldId sparse,
+                                                   FaceFieldId dense) {
+  SparseField& field = m_sparse_face_data[sparse.index()];
+  checkSparse(field, m_face_data, dense.index());
+  for (size_t component = 0; component < field.components(); ++component) {
+    gather(m_face_data, m_num_faces, dense.index(), component,
+           field.entities().data(), field.component(component),
+           field.size(), IndexCheck::Unchecked);
+  }
+}
+
+size_t SimulationDataContainer::findSparse(
+    const std::vector<SparseField>& fields, const std::string& name) {
+  for (size_t index = 0; index < fields.size(); ++index) {
+    if (fields[index].name() == name) {
+      return index;
+    }
+  }
+  return SparseField::npos;
+}
+
+void SimulationDataContainer::checkSparse(const SparseField& sparse,
+                                          const FieldTable& fields,
+                                          size_t index) {
+  if (sparse.components() != fields.components(index)) {
+    OPM_THROW(std::invalid_argument, "The sparse field: " << sparse.name()
+              << " has " << sparse.components() << " components, but "
+              << fields.name(index) << " has "
+              << fields.components(index));
+  }
+}
+
+void SimulationDataContainer::checkComponent(const FieldTable& fields,
+                                             size_t index,
+                                             size_t component) {
+  if (component >= fields.components(index)) {
+    OPM_THROW(std::invalid_argument,
+              "The component number: " << component << " is invalid");
+  }
+}
+
+void SimulationDataContainer::throwMissingField(const char* name) {
+  throw std::invalid_argument("The field with name: " + std::string(name)
+                              + " does not exist");
+}
+
+void SimulationDataContainer::save(const std::string& path) const {
+  std::vector<MappedStorage::Entry> entries;
+  std::vector<const void*> payloads;
+  auto add = [&](const FieldTable& fields, MappedStorage::Entity entity) {
+    for (size_t index = 0; index < fields.size(); ++index) {
+      MappedStorage::Entry entry = { entity, fields.name(index),
+                                     fields.components(index), 0,
+                                     fields.count(index),
+                                     fields.layout(index),
+                                     fields.type(index) };
+      entries.push_back(entry);
+      payloads.push_back(fields.rawData(index));
+    }
+  };
+  add(m_cell_data, MappedStorage::Entity::Cell);
+  add(m_face_data, MappedStorage::Entity::Face);
+  MappedStorage::write(path, m_num_cells, m_num_faces, m_num_phases, entries,
+                       payloads);
+  clearDirty();
+}
+
+void SimulationDataContainer::load(const std::string& path) {
+  std::shared_ptr<MappedStorage> mapping = MappedStorage::open(path, false);
+  FieldTable cell_data(mapping, MappedStorage::Entity::Cell);
+  FieldTable face_data(mapping, MappedStorage::Entity::Face);
+  cell_data.setChunkSize(m_cell_data.chunkSize());
+  face_data.setChunkSize(m_face_data.chunkSize());
+  cell_data.setFirstTouch(m_cell_data.firstTouch());
+  face_data.setFirstTouch(m_face_data.firstTouch());
+  m_num_cells = mapping->numCells();
+  m_num_faces = mapping->numFaces();
+  m_num_phases = mapping->numPhases();
+  m_partition = std::make_shared<CellPartition>(m_num_cells);
+  m_sparse_cell_data.clear();
+  m_sparse_face_data.clear();
+  m_mapping.swap(mapping);
+  m_cell_data.swap(cell_data);
+  m_face_data.swap(face_data);
 }
 
-void SimulationDataContainer::registerFaceData(const std::string& name,
-                                               size_t components,
-                                               double initialValue) {
-  if (!hasFaceData(name)) {
-    m_face_data.insert(
-      std::pair<std::string, std::vector<double>>(
-        name,
-        std::vector<double>(components * m_num_faces, initialValue)));
+void SimulationDataContainer::setDirtyChunkSize(size_t bytes) {
+  if (bytes == 0 || bytes % sizeof(double) != 0) {
+    OPM_THROW(std::invalid_argument,
+              "The chunk size: " << bytes << " is not a positive multiple"
+              " of the value size");
   }
+  m_cell_data.setChunkSize(bytes / sizeof(double));
+  m_face_data.setChunkSize(bytes / sizeof(double));
+}
+
+size_t SimulationDataContainer::dirtyChunkSize() const {
+  return m_cell_data.chunkSize() * sizeof(double);
+}
+
+void SimulationDataContainer::markCellDataDirty(CellFieldId id, size_t begin,
+                                                size_t end) {
+  m_cell_data.markDirty(id.index(), begin, end);
+}
+
+void SimulationDataContainer::markFaceDataDirty(FaceFieldId id, size_t begin,
+                                                size_t end) {
+  m_face_data.markDirty(id.index(), begin, end);
+}
+
+void SimulationDataContainer::clearDirty() const {
+  m_cell_data.clearDirty();
+  m_face_data.clearDirty();
+}
+
+void SimulationDataContainer::saveDelta(const std::string& path) const {
+  DeltaCheckpoint::write(path, m_cell_data, m_face_data);
+  clearDirty();
+}
+
+void SimulationDataContainer::applyDelta(const std::string& path) {
+  DeltaCheckpoint::apply(path, m_cell_data, m_face_data);
+}
+
+void SimulationDataContainer::snapshot(SnapshotSlot& slot) const {
+  slot.save(m_cell_data, m_face_data);
+}
+
+void SimulationDataContainer::restore(const SnapshotSlot& slot) {
+  slot.restore(m_cell_data, m_face_data);
+}
+
+std::vector<char> SimulationDataContainer::compressCellData(
+    CellFieldId id) const {
+  return compressField(m_cell_data, id.index());
+}
+
+std::vector<char> SimulationDataContainer::compressFaceData(
+    FaceFieldId id) const {
+  return compressField(m_face_data, id.index());
+}
+
+void SimulationDataContainer::decompressCellData(
+    CellFieldId id, const std::vector<char>& data) {
+  decompressField(m_cell_data, id.index(), data);
+}
+
+void SimulationDataContainer::decompressFaceData(
+    FaceFieldId id, const std::vector<char>& data) {
+  decompressField(m_face_data, id.index(), data);
 }
 
 bool SimulationDataContainer::equal(
@@ -210,68 +1381,53 @@ bool SimulationDataContainer::equal(
       (m_cell_data.size() != other.m_cell_data.size())) {
       return false;
   }
-  for (const auto& cell_data : m_cell_data) {
-    const auto key = cell_data.first;
-    const auto data = cell_data.second;
-    if (other.hasCellData(key)) {
-      const auto& other_data = other.getCellData(key);
-      if (!cmp::vector_equal<double>(data, other_data)) {
-          return false;
-      }
-    } else {
-      return false;
-    }
-  }
+  return equalFields(m_cell_data, other.m_cell_data) &&
+         equalFields(m_face_data, other.m_face_data) &&
+         equalSparse(m_sparse_cell_data, other.m_sparse_cell_data) &&
+         equalSparse(m_sparse_face_data, other.m_sparse_face_data);
+}
 
-  for (const auto& face_data : m_face_data) {
-      const auto key = face_data.first;
-      const auto data = face_data.second;
-    if (other.hasFaceData(key)) {
-        const auto& other_data = other.getFaceData(key);
-      if (!cmp::vector_equal<double>(data, other_data)) {
-        return false;
-      }
-    } else {
-      return false;
-    }
-  }
-  return true;
+ComparisonReport SimulationDataContainer::compare(
+    const SimulationDataContainer& other, double abs_eps,
+    double rel_eps) const {
+  ComparisonReport report;
+  report.sizes_equal = m_num_cells == other.m_num_cells &&
+                       m_num_faces == other.m_num_faces &&
+                       m_num_phases == other.m_num_phases;
+  report.cell_fields = compareFields(m_cell_data, other.m_cell_data,
+                                     abs_eps, rel_eps);
+  report.face_fields = compareFields(m_face_data, other.m_face_data,
+                                     abs_eps, rel_eps);
+  report.sparse_cell_fields = compareSparse(m_sparse_cell_data,
+                                            other.m_sparse_cell_data,
+                                            abs_eps, rel_eps);
+  report.sparse_face_fields = compareSparse(m_sparse_face_data,
+                                            other.m_sparse_face_data,
+                                            abs_eps, rel_eps);
+  return report;
 }
 
 size_t SimulationDataContainer::numCellDataComponents(
     const std::string& name) const {
-  const auto& data = getCellData(name);
-  return data.size() / m_num_cells;
+  return m_cell_data.components(findCellData(name.data(), name.size()));
 }
 
 const std::map<std::string, std::vector<double>>&
     SimulationDataContainer::cellData() const {
-  return m_cell_data;
+  return m_cell_data.vectorMap();
 }
 
 std::map<std::string, std::vector<double>>&
     SimulationDataContainer::cellData() {
-  return m_cell_data;
+  return m_cell_data.vectorMap();
 }
 
 // This is very deprecated.
 void SimulationDataContainer::addDefaultFields() {
-  registerCellData("PRESSURE" , 1, 0.0);
-  registerCellData("SATURATION" , m_num_phases, 0.0);
-  registerCellData("TEMPERATURE" , 1, 273.15 + 20);
-  registerFaceData("FACEPRESSURE" , 1, 0.0);
-  registerFaceData("FACEFLUX" , 1, 0.0);
-  setReferencePointers();
-}
-
-void SimulationDataContainer::setReferencePointers() {
-  // This sets the reference pointers for the fast
-  // accessors, the fields must be created first
-  // by copying or a call to addDefaultFields().
-  pressure_ref_ = &getCellData("PRESSURE");
-  temperature_ref_ = &getCellData("TEMPERATURE");
-  saturation_ref_ = &getCellData("SATURATION");
-  facepressure_ref_ = &getFaceData("FACEPRESSURE");
-  faceflux_ref_ = &getFaceData("FACEFLUX");
+  registerData<FieldKeys::Pressure>(1, 0.0);
+  registerData<FieldKeys::Saturation>(m_num_phases, 0.0);
+  registerData<FieldKeys::Temperature>(1, 273.15 + 20);
+  registerData<FieldKeys::FacePressure>(1, 0.0);
+  registerData<FieldKeys::FaceFlux>(1, 0.0);
 }
 }  // namespace Opm
@@ -21,12 +21,40 @@
 #define OPM_COMMON_DATA_SIMULATIONDATACONTAINER_H_
 
 #include <cstddef>
-#include <string>
+#include <cstdint>
 #include <map>
+#include <string>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include <opm/common/data/CellPartition.hpp>
+#include <opm/common/data/FieldBits.hpp>
+#include <opm/common/data/FieldComparison.hpp>
+#include <opm/common/data/FieldExpression.hpp>
+#include <opm/common/data/FieldId.hpp>
+#include <opm/common/data/FieldKey.hpp>
+#include <opm/common/data/FieldLayout.hpp>
+#include <opm/common/data/FieldStatistics.hpp>
+#include <opm/common/data/FieldTable.hpp>
+#include <opm/common/data/FieldType.hpp>
+#include <opm/common/data/FieldView.hpp>
+#include <opm/common/data/HaloExchanger.hpp>
+#include <opm/common/data/RegionAggregation.hpp>
+#include <opm/common/data/SnapshotSlot.hpp>
+#include <opm/common/data/SparseField.hpp>
+#include <opm/common/data/StridedView.hpp>
+#include <opm/common/util/numeric/cmp.hpp>
+
 namespace Opm {
+/**
+ * @brief Whether scatter and gather operations validate the cell indices.
+ *
+ * Unchecked operations skip the pass over the indices; an index out of
+ * range is then undefined behaviour.
+ */
+enum class IndexCheck { Checked, Unchecked };
+
 /**
  * @class SimulationDataContainer
  * @brief A simple container to manage simulation data.
@@ -42,6 +70,67 @@ namespace Opm {
  * mutable references are returned with the getCellData() and
  * getFaceData() methods, and the content will typically be
  * modified by external scope.
+ *
+ * The register functions return a handle (CellFieldId or FaceFieldId)
+ * which indexes the field table directly; code which accesses a field
+ * repeatedly should look the field up by handle instead of by name.
+ *
+ * By default every field is a separate std::vector<double>. A
+ * container constructed with FieldStorage::Arena instead packs all
+ * cell fields and all face fields into one aligned slab each (see
+ * FieldTable); the fields are then accessed through cellView() and
+ * faceView(), and the accessors returning std::vector throw
+ * std::logic_error. The same holds for FieldStorage::Mapped, where
+ * the fields live in a memory mapping which is either anonymous or
+ * backed by a file; copies of such a container use anonymous mappings.
+ *
+ * Copies share the field buffers with the container they were copied
+ * from (except with FieldStorage::Mapped), and a field is duplicated
+ * by the first mutable access to it, so copying a container costs
+ * O(number of fields). Fields to which mutable references or views
+ * were handed out are duplicated by the copy itself, so that those
+ * references keep writing to their own container only, as with a
+ * deep copy.
+ *
+ * The container records which parts of the fields changed since the
+ * last clearDirty(), for incremental checkpoints with saveDelta().
+ * Mutable access to a field (getCellData(), cellView(), ...) marks the
+ * whole field as changed, while setCellDataComponent() only marks the
+ * chunks it writes to. A field is marked when the reference or view is
+ * obtained, so ones obtained before save(), saveDelta() or clearDirty()
+ * must be obtained again for their writes to reach the next delta.
+ * Code which writes a few values can instead use untrackedCellView(),
+ * which unshares the field without marking it, and mark the values it
+ * wrote with markCellDataDirty().
+ *
+ * Quantities on a few cells or faces (wells, aquifers, faults) are
+ * better held in sparse fields (see SparseField), registered with
+ * registerSparseCellData() and registerSparseFaceData(). They are
+ * copied, swapped and compared with the container, and can be
+ * scattered into and gathered from dense fields, but they are not
+ * part of snapshots, checkpoints, saved files or halo exchanges.
+ *
+ * Threads may register fields while other threads look fields up:
+ * registerCellData(), registerFaceData(), hasCellData(),
+ * cellFieldId() and the const accessors and views of existing fields
+ * can be called concurrently. Lookups of existing fields take no lock,
+ * and registrations take a lock per entity kind (see FieldRegistry and
+ * FieldTable::findOrInsert()), so no global mutex is needed around the
+ * container. This holds for FieldStorage::Vector, whose fields stay in
+ * place when others are registered; with Arena and Mapped storage a
+ * registration moves the values of the existing fields. The mutable
+ * accessors unshare a field and update its dirty and statistics state
+ * without synchronization. They may only be called concurrently on a
+ * field which one thread accessed mutably before, with no copy,
+ * save(), saveDelta(), clearDirty() or statistics in between; they
+ * then only read that state. Writes to the same values, and all other
+ * operations on the container, still need synchronization by the
+ * caller.
+ *
+ * In a distributed run the cells of a container are the cells its rank
+ * owns followed by ghost cells owned by other ranks (see
+ * CellPartition); exchangeHalo() updates the ghost cells of a set of
+ * cell fields through a HaloExchanger.
  */
 class SimulationDataContainer {
  public:
@@ -58,19 +147,62 @@ class SimulationDataContainer {
   SimulationDataContainer(size_t num_cells, size_t num_faces,
                           size_t num_phases);
 
+  /**
+   * @brief Constructor selecting the field storage.
+   * 
+   * No default fields are registered, and numPhases() is zero. With a
+   * memory resource, the field buffers are allocated from it (see
+   * HugePageResource and MonotonicResource), except for the Float64
+   * fields with Vector storage, which stay std::vector<double> for
+   * getCellData(); use Arena storage to place all fields in the
+   * resource. Mapped storage lives in its mapping and takes no
+   * resource.
+   * @param num_cells number of elements in cell data vectors
+   * @param num_faces   number of elements in face data vectors
+   * @param storage how the field values are stored
+   * @param resource where Vector and Arena storage is allocated; null
+   *                 for std::vector and posix_memalign()
+   */
+  SimulationDataContainer(size_t num_cells, size_t num_faces,
+                          FieldStorage storage,
+                          std::shared_ptr<MemoryResource> resource =
+                            std::shared_ptr<MemoryResource>());
+
+  /**
+   * @brief Constructor placing the fields in a new memory mapped file.
+   * 
+   * An existing file is truncated. The file holds a small header with
+   * the number of cells and faces and the field registry (see
+   * MappedStorage), so the container can be reopened later. No
+   * default fields are registered, and numPhases() is zero.
+   * @param num_cells number of elements in cell data vectors
+   * @param num_faces   number of elements in face data vectors
+   * @param path the file to create
+   */
+  SimulationDataContainer(size_t num_cells, size_t num_faces,
+                          const std::string& path);
+
+  /**
+   * @brief Constructor reopening a memory mapped file.
+   * 
+   * The fields are used in place; changes are written to the file.
+   * @param path a file created by the constructor above
+   */
+  explicit SimulationDataContainer(const std::string& path);
+
   /**
    * @brief Copy constructor.
    * 
-   * Must be defined explicitly because class contains non-value objects (the 
-   * reference pointers pressure_ref_ etc.) that should not simply be copied.
+   * Must be defined explicitly because Mapped storage is cloned into
+   * one mapping shared by the cell and face fields of the copy.
+   * The fields are shared with @p other until either container writes
+   * to them, except for the fields @p other handed out mutable
+   * references or views to, which are copied.
    */
   SimulationDataContainer(const SimulationDataContainer&);
 
   /**
-   * @brief Copy assignment operator.
-   * 
-   * Must be defined explicitly because class contains non-value objects (the 
-   * reference pointers pressure_ref_ etc.) that should not simply be copied.
+   * @brief Copy assignment operator, copying as the copy constructor.
    */
   SimulationDataContainer& operator=(const SimulationDataContainer&);
 
@@ -79,6 +211,34 @@ class SimulationDataContainer {
    */
   void swap(SimulationDataContainer&);
 
+  /**
+   * @brief Get the field storage of the container.
+   */
+  FieldStorage storage() const;
+
+  /**
+   * @brief The memory resource of the fields, or null.
+   */
+  const std::shared_ptr<MemoryResource>& memoryResource() const {
+    return m_cell_data.memoryResource();
+  }
+
+  /**
+   * @brief Let the OpenMP threads initialize new field buffers.
+   *
+   * With FirstTouch::Parallel, fields registered afterwards, the
+   * duplicates made when a shared field is first written, and the
+   * mapping of a copy of a Mapped container are written first by the
+   * threads which own their cells (or faces) under schedule(static),
+   * so that their pages land on the NUMA nodes of those threads.
+   * Float64 fields with Vector storage are std::vector<double>, which
+   * the calling thread writes on construction, so they are only
+   * placed this way with Arena storage. The setting is copied with
+   * the container.
+   */
+  void setFirstTouch(FirstTouch touch);
+  FirstTouch firstTouch() const { return m_cell_data.firstTouch(); }
+
   /**
    * @brief Get the number of phases.
    * @todo Inline this getter, it looks relatively cheap.
@@ -104,14 +264,83 @@ class SimulationDataContainer {
    */
   bool hasCellData(const std::string& name) const;
 
+  /**
+   * @brief Check whether a cell is in the container.
+   * 
+   * Overload which does not construct a temporary std::string.
+   * @param name the name of the cell
+   * @return true if found
+   */
+  bool hasCellData(const char* name) const;
+
   /**
    * @brief Register a cell data vector of size numCells() * components.
+   * 
+   * Registering a name which already exists leaves the data untouched.
    * @param name the name of the data vector
    * @param components the number of components related to each cell
    * @param initialValue initialization value for the vector
+   * @param layout order of the values (see FieldLayout)
+   * @param type scalar type of the values (see FieldType); Bit vectors
+   *        must have the interleaved layout
+   * @return the handle of the (new or existing) data vector
+   */
+  CellFieldId registerCellData(const std::string& name, size_t components,
+                               double initialValue = 0.0,
+                               const FieldLayout& layout = FieldLayout(),
+                               FieldType type = FieldType::Float64);
+
+  /**
+   * @brief The layout of a cell data vector.
+   */
+  const FieldLayout& cellLayout(CellFieldId id) const {
+    return m_cell_data.layout(id.index());
+  }
+
+  /**
+   * @brief Reorder the values of a cell data vector to another layout.
+   *
+   * The vector is marked as dirty. Views and pointers into it are
+   * invalidated, and it may get a buffer of its own (see
+   * FieldTable::relayout()).
+   * @param id the handle of the vector
+   * @param layout the new layout
    */
-  void registerCellData(const std::string& name, size_t components,
-                        double initialValue = 0.0);
+  void relayoutCellData(CellFieldId id, const FieldLayout& layout);
+
+  /**
+   * @brief The scalar type of a cell data vector.
+   */
+  FieldType cellType(CellFieldId id) const {
+    return m_cell_data.type(id.index());
+  }
+
+  /**
+   * @brief Convert the values of a cell data vector to another type.
+   *
+   * The values are converted as by convertValues(). The vector is
+   * marked as dirty and gets a new buffer; only Float64 vectors with
+   * Vector storage are std::vector<double>. Mapped storage cannot
+   * convert, and only interleaved vectors can become Bit vectors;
+   * otherwise std::logic_error is thrown.
+   * @param id the handle of the vector
+   * @param type the new type
+   */
+  void convertCellData(CellFieldId id, FieldType type);
+
+  /**
+   * @brief Look up the handle of a stored cell data vector.
+   * @param name the name of the vector
+   * @return the handle, valid for this container and all its copies
+   */
+  CellFieldId cellFieldId(const std::string& name) const;
+
+  /**
+   * @brief Look up the handle of a stored cell data vector.
+   * @param name the name of the vector
+   * @return the handle, valid for this container and all its copies
+   */
+  CellFieldId cellFieldId(const char* name) const;
 
   /**
    * @brief Retrieve a stored cell data vector 
@@ -127,6 +356,199 @@ class SimulationDataContainer {
    */
   const std::vector<double>& getCellData(const std::string& name) const;
 
+  /**
+   * @brief Retrieve a stored cell data vector 
+   * @param name the name of the vector
+   * @return a reference to a vector of size numCells() * components
+   */
+  std::vector<double>& getCellData(const char* name);
+
+  /**
+   * @brief Retrieve a stored cell data vector 
+   * @param name the name of the vector
+   * @return a const reference to a vector of size numCells() * components
+   */
+  const std::vector<double>& getCellData(const char* name) const;
+
+  /**
+   * @brief Retrieve a stored cell data vector by handle.
+   * 
+   * The handle is not checked; it must come from this container or
+   * one of its copies. The field is unshared and marked as changed by
+   * the first call after a copy or a save; later calls only index the
+   * table and read the state of the field.
+   * @param id the handle returned by registerCellData()
+   * @return a reference to a vector of size numCells() * components
+   */
+  inline std::vector<double>& getCellData(CellFieldId id) {
+    std::vector<double>& values = m_cell_data.vector(id.index());
+    m_cell_data.expose(id.index());
+    m_cell_data.touch(id.index());
+    return values;
+  }
+
+  /**
+   * @brief Retrieve a stored cell data vector by handle.
+   * @param id the handle returned by registerCellData()
+   * @return a const reference to a vector of size numCells() * components
+   */
+  inline const std::vector<double>& getCellData(CellFieldId id) const {
+    return m_cell_data.vector(id.index());
+  }
+
+  /**
+   * @brief View of a stored cell data vector, for any storage mode.
+   * @param id the handle returned by registerCellData()
+   * @return a view of numCells() * components values
+   */
+  inline FieldView<double> cellView(CellFieldId id) {
+    double* values = m_cell_data.data(id.index());
+    m_cell_data.expose(id.index());
+    m_cell_data.touch(id.index());
+    return FieldView<double>(values, m_cell_data.count(id.index()));
+  }
+
+  /**
+   * @brief View of a stored cell data vector, for any storage mode.
+   * @param id the handle returned by registerCellData()
+   * @return a const view of numCells() * components values
+   */
+  inline FieldView<const double> cellView(CellFieldId id) const {
+    return FieldView<const double>(m_cell_data.data(id.index()),
+                                   m_cell_data.count(id.index()));
+  }
+
+  /**
+   * @brief Mutable view of a stored cell data vector which does not
+   *        mark it as changed.
+   *
+   * The vector is unshared as by cellView(), but writes through the
+   * view must be marked with markCellDataDirty() to reach the next
+   * delta and to drop cached statistics.
+   * @param id the handle returned by registerCellData()
+   * @return a view of numCells() * components values
+   */
+  inline FieldView<double> untrackedCellView(CellFieldId id) {
+    double* values = m_cell_data.data(id.index());
+    m_cell_data.expose(id.index());
+    return FieldView<double>(values, m_cell_data.count(id.index()));
+  }
+
+  /**
+   * @brief Typed view of a stored cell data vector.
+   *
+   * T is the C++ type of the scalar type of the vector (double, float,
+   * int32_t, int16_t or uint8_t); for a vector of another type
+   * std::logic_error is thrown. Bit vectors are accessed through
+   * BitView.
+   * @param id the handle returned by registerCellData()
+   * @return a view of numCells() * components values
+   */
+  template <typename T>
+  FieldView<T> cellView(CellFieldId id) {
+    T* values = m_cell_data.typedData<T>(id.index());
+    m_cell_data.expose(id.index());
+    m_cell_data.touch(id.index());
+    return FieldView<T>(values, m_cell_data.count(id.index()));
+  }
+
+  template <typename T>
+  FieldView<const T> cellView(CellFieldId id) const {
+    return FieldView<const T>(m_cell_data.typedData<T>(id.index()),
+                              m_cell_data.count(id.index()));
+  }
+
+  /**
+   * @brief View of the bits of a stored cell data vector of type Bit.
+   *
+   * For a vector of another type std::logic_error is thrown.
+   * @param id the handle returned by registerCellData()
+   * @return a view of numCells() * components bits
+   */
+  BitView<FieldBits::Word> cellBits(CellFieldId id) {
+    FieldBits::Word* words = m_cell_data.words(id.index());
+    m_cell_data.expose(id.index());
+    m_cell_data.touch(id.index());
+    return BitView<FieldBits::Word>(words, m_cell_data.count(id.index()));
+  }
+
+  BitView<const FieldBits::Word> cellBits(CellFieldId id) const {
+    return BitView<const FieldBits::Word>(m_cell_data.words(id.index()),
+                                          m_cell_data.count(id.index()));
+  }
+
+  /**
+   * @brief View of a stored cell data vector, for any storage mode.
+   * @param name the name of the vector
+   * @return a view of numCells() * components values
+   */
+  FieldView<double> cellView(const std::string& name);
+
+  /**
+   * @brief View of a stored cell data vector, for any storage mode.
+   * @param name the name of the vector
+   * @return a const view of numCells() * components values
+   */
+  FieldView<const double> cellView(const std::string& name) const;
+
+  /**
+   * @brief View of one component of a stored cell data vector.
+   * 
+   * The values of a component are numCells() values, components() apart
+   * with the interleaved layout and in blocks with the others.
+   * @param id the handle of the vector
+   * @param component the component, less than the number of components
+   * @return a strided view of numCells() values
+   */
+  StridedView<double> cellComponentView(CellFieldId id, size_t component);
+
+  /**
+   * @brief View of one component of a stored cell data vector.
+   * @param id the handle of the vector
+   * @param component the component, less than the number of components
+   * @return a const strided view of numCells() values
+   */
+  StridedView<const double> cellComponentView(CellFieldId id,
+                                              size_t component) const;
+
+  /**
+   * @brief Typed view of one component of a stored cell data vector.
+   *
+   * T is the scalar type of the vector, as for cellView<T>().
+   */
+  template <typename T>
+  StridedView<T> cellComponentView(CellFieldId id, size_t component) {
+    checkComponent(m_cell_data, id.index(), component);
+    return componentView(m_cell_data, id.index(), cellView<T>(id).data(),
+                         component);
+  }
+
+  template <typename T>
+  StridedView<const T> cellComponentView(CellFieldId id,
+                                        size_t component) const {
+    checkComponent(m_cell_data, id.index(), component);
+    return componentView(m_cell_data, id.index(), cellView<T>(id).data(),
+                         component);
+  }
+
+  /**
+   * @brief View of one component of a stored cell data vector.
+   * @param name the name of the vector
+   * @param component the component, less than the number of components
+   * @return a strided view of numCells() values
+   */
+  StridedView<double> cellComponentView(const std::string& name,
+                                        size_t component);
+
+  /**
+   * @brief View of one component of a stored cell data vector.
+   * @param name the name of the vector
+   * @param component the component, less than the number of components
+   * @return a const strided view of numCells() values
+   */
+  StridedView<const double> cellComponentView(const std::string& name,
+                                              size_t component) const;
+
   /**
    * @brief Check whether a face is in the container.
    * @param name the name of the face
@@ -134,14 +556,83 @@ class SimulationDataContainer {
    */
   bool hasFaceData(const std::string& name) const;
 
+  /**
+   * @brief Check whether a face is in the container.
+   * 
+   * Overload which does not construct a temporary std::string.
+   * @param name the name of the face
+   * @return true if found
+   */
+  bool hasFaceData(const char* name) const;
+
   /**
    * @brief Register a face data vector of size numCells() * components.
+   * 
+   * Registering a name which already exists leaves the data untouched.
    * @param name the name of the data vector
    * @param components the number of components related to each face
    * @param initialValue initialization value for the vector
+   * @param layout order of the values (see FieldLayout)
+   * @param type scalar type of the values (see FieldType); Bit vectors
+   *        must have the interleaved layout
+   * @return the handle of the (new or existing) data vector
+   */
+  FaceFieldId registerFaceData(const std::string& name, size_t components,
+                               double initialValue = 0.0,
+                               const FieldLayout& layout = FieldLayout(),
+                               FieldType type = FieldType::Float64);
+
+  /**
+   * @brief The layout of a face data vector.
+   */
+  const FieldLayout& faceLayout(FaceFieldId id) const {
+    return m_face_data.layout(id.index());
+  }
+
+  /**
+   * @brief Reorder the values of a face data vector to another layout.
+   *
+   * The vector is marked as dirty. Views and pointers into it are
+   * invalidated, and it may get a buffer of its own (see
+   * FieldTable::relayout()).
+   * @param id the handle of the vector
+   * @param layout the new layout
+   */
+  void relayoutFaceData(FaceFieldId id, const FieldLayout& layout);
+
+  /**
+   * @brief The scalar type of a face data vector.
+   */
+  FieldType faceType(FaceFieldId id) const {
+    return m_face_data.type(id.index());
+  }
+
+  /**
+   * @brief Convert the values of a face data vector to another type.
+   *
+   * The values are converted as by convertValues(). The vector is
+   * marked as dirty and gets a new buffer; only Float64 vectors with
+   * Vector storage are std::vector<double>. Mapped storage cannot
+   * convert, and only interleaved vectors can become Bit vectors;
+   * otherwise std::logic_error is thrown.
+   * @param id the handle of the vector
+   * @param type the new type
+   */
+  void convertFaceData(FaceFieldId id, FieldType type);
+
+  /**
+   * @brief Look up the handle of a stored face data vector.
+   * @param name the name of the vector
+   * @return the handle, valid for this container and all its copies
    */
-  void registerFaceData(const std::string& name, size_t components,
-                        double initialValue = 0.0);
+  FaceFieldId faceFieldId(const std::string& name) const;
+
+  /**
+   * @brief Look up the handle of a stored face data vector.
+   * @param name the name of the vector
+   * @return the handle, valid for this container and all its copies
+   */
+  FaceFieldId faceFieldId(const char* name) const;
 
   /**
    * @brief Retrieve a stored face data vector 
@@ -157,6 +648,195 @@ class SimulationDataContainer {
    */
   const std::vector<double>& getFaceData(const std::string& name) const;
 
+  /**
+   * @brief Retrieve a stored face data vector 
+   * @param name the name of the vector
+   * @return a reference to a vector of size numCells() * components
+   */
+  std::vector<double>& getFaceData(const char* name);
+
+  /**
+   * @brief Retrieve a stored face data vector 
+   * @param name the name of the vector
+   * @return a const reference to a vector of size numCells() * components
+   */
+  const std::vector<double>& getFaceData(const char* name) const;
+
+  /**
+   * @brief Retrieve a stored face data vector by handle.
+   * 
+   * The handle is not checked; it must come from this container or
+   * one of its copies. The field is unshared and marked as changed by
+   * the first call after a copy or a save; later calls only index the
+   * table and read the state of the field.
+   * @param id the handle returned by registerFaceData()
+   * @return a reference to a vector of size numFaces() * components
+   */
+  inline std::vector<double>& getFaceData(FaceFieldId id) {
+    std::vector<double>& values = m_face_data.vector(id.index());
+    m_face_data.expose(id.index());
+    m_face_data.touch(id.index());
+    return values;
+  }
+
+  /**
+   * @brief Retrieve a stored face data vector by handle.
+   * @param id the handle returned by registerFaceData()
+   * @return a const reference to a vector of size numFaces() * components
+   */
+  inline const std::vector<double>& getFaceData(FaceFieldId id) const {
+    return m_face_data.vector(id.index());
+  }
+
+  /**
+   * @brief View of a stored face data vector, for any storage mode.
+   * @param id the handle returned by registerFaceData()
+   * @return a view of numFaces() * components values
+   */
+  inline FieldView<double> faceView(FaceFieldId id) {
+    double* values = m_face_data.data(id.index());
+    m_face_data.expose(id.index());
+    m_face_data.touch(id.index());
+    return FieldView<double>(values, m_face_data.count(id.index()));
+  }
+
+  /**
+   * @brief View of a stored face data vector, for any storage mode.
+   * @param id the handle returned by registerFaceData()
+   * @return a const view of numFaces() * components values
+   */
+  inline FieldView<const double> faceView(FaceFieldId id) const {
+    return FieldView<const double>(m_face_data.data(id.index()),
+                                   m_face_data.count(id.index()));
+  }
+
+  /**
+   * @brief Mutable view of a stored face data vector which does not
+   *        mark it as changed; see untrackedCellView().
+   * @param id the handle returned by registerFaceData()
+   * @return a view of numFaces() * components values
+   */
+  inline FieldView<double> untrackedFaceView(FaceFieldId id) {
+    double* values = m_face_data.data(id.index());
+    m_face_data.expose(id.index());
+    return FieldView<double>(values, m_face_data.count(id.index()));
+  }
+
+  /**
+   * @brief Typed view of a stored face data vector.
+   *
+   * T is the C++ type of the scalar type of the vector (double, float,
+   * int32_t, int16_t or uint8_t); for a vector of another type
+   * std::logic_error is thrown. Bit vectors are accessed through
+   * BitView.
+   * @param id the handle returned by registerFaceData()
+   * @return a view of numFaces() * components values
+   */
+  template <typename T>
+  FieldView<T> faceView(FaceFieldId id) {
+    T* values = m_face_data.typedData<T>(id.index());
+    m_face_data.expose(id.index());
+    m_face_data.touch(id.index());
+    return FieldView<T>(values, m_face_data.count(id.index()));
+  }
+
+  template <typename T>
+  FieldView<const T> faceView(FaceFieldId id) const {
+    return FieldView<const T>(m_face_data.typedData<T>(id.index()),
+                              m_face_data.count(id.index()));
+  }
+
+  /**
+   * @brief View of the bits of a stored face data vector of type Bit.
+   *
+   * For a vector of another type std::logic_error is thrown.
+   * @param id the handle returned by registerFaceData()
+   * @return a view of numFaces() * components bits
+   */
+  BitView<FieldBits::Word> faceBits(FaceFieldId id) {
+    FieldBits::Word* words = m_face_data.words(id.index());
+    m_face_data.expose(id.index());
+    m_face_data.touch(id.index());
+    return BitView<FieldBits::Word>(words, m_face_data.count(id.index()));
+  }
+
+  BitView<const FieldBits::Word> faceBits(FaceFieldId id) const {
+    return BitView<const FieldBits::Word>(m_face_data.words(id.index()),
+                                          m_face_data.count(id.index()));
+  }
+
+  /**
+   * @brief View of a stored face data vector, for any storage mode.
+   * @param name the name of the vector
+   * @return a view of numFaces() * components values
+   */
+  FieldView<double> faceView(const std::string& name);
+
+  /**
+   * @brief View of a stored face data vector, for any storage mode.
+   * @param name the name of the vector
+   * @return a const view of numFaces() * components values
+   */
+  FieldView<const double> faceView(const std::string& name) const;
+
+  /**
+   * @brief View of one component of a stored face data vector.
+   * 
+   * The values of a component are numFaces() values, components() apart
+   * with the interleaved layout and in blocks with the others.
+   * @param id the handle of the vector
+   * @param component the component, less than the number of components
+   * @return a strided view of numFaces() values
+   */
+  StridedView<double> faceComponentView(FaceFieldId id, size_t component);
+
+  /**
+   * @brief View of one component of a stored face data vector.
+   * @param id the handle of the vector
+   * @param component the component, less than the number of components
+   * @return a const strided view of numFaces() values
+   */
+  StridedView<const double> faceComponentView(FaceFieldId id,
+                                              size_t component) const;
+
+  /**
+   * @brief Typed view of one component of a stored face data vector.
+   *
+   * T is the scalar type of the vector, as for faceView<T>().
+   */
+  template <typename T>
+  StridedView<T> faceComponentView(FaceFieldId id, size_t component) {
+    checkComponent(m_face_data, id.index(), component);
+    return componentView(m_face_data, id.index(), faceView<T>(id).data(),
+                         component);
+  }
+
+  template <typename T>
+  StridedView<const T> faceComponentView(FaceFieldId id,
+                                        size_t component) const {
+    checkComponent(m_face_data, id.index(), component);
+    return componentView(m_face_data, id.index(), faceView<T>(id).data(),
+                         component);
+  }
+
+  /**
+   * @brief View of one component of a stored face data vector.
+   * @param name the name of the vector
+   * @param component the component, less than the number of components
+   * @return a strided view of numFaces() values
+   */
+  StridedView<double> faceComponentView(const std::string& name,
+                                        size_t component);
+
+  /**
+   * @brief View of one component of a stored face data vector.
+   * @param name the name of the vector
+   * @param component the component, less than the number of components
+   * @return a const strided view of numFaces() values
+   */
+  StridedView<const double> faceComponentView(const std::string& name,
+                                              size_t component) const;
+
   /**
    * @brief Return the number of components of the cell data vector.
    * 
@@ -169,13 +849,188 @@ class SimulationDataContainer {
    */
   size_t numCellDataComponents(const std::string& name) const;
 
+  /**
+   * @brief Pass an access pattern hint for a cell data vector.
+   * 
+   * With FieldStorage::Mapped the hint is passed on to the kernel,
+   * e.g. to page out fields which are not needed for a while; with
+   * other storage it is ignored.
+   * @param id the handle of the vector
+   * @param advice the expected access pattern
+   */
+  void adviseCellData(CellFieldId id, FieldAdvice advice) const;
+
+  /**
+   * @brief Pass an access pattern hint for a face data vector.
+   * @param id the handle of the vector
+   * @param advice the expected access pattern
+   */
+  void adviseFaceData(FaceFieldId id, FieldAdvice advice) const;
+
+  /**
+   * @brief Write all cell and face fields to a checkpoint file.
+   * 
+   * The file uses the versioned layout of MappedStorage: a header with
+   * numCells(), numFaces() and numPhases(), the page aligned payloads
+   * and a field directory with names, component counts and offsets.
+   * The payloads are written straight from the field storage with
+   * large writes. The file is the base of later deltas, so all fields
+   * are marked as unchanged afterwards (see saveDelta()); the dirty
+   * state is bookkeeping rather than content, so this is const.
+   * @param path the file to write, truncated if it exists
+   */
+  void save(const std::string& path) const;
+
+  /**
+   * @brief Replace the content of the container by a checkpoint file.
+   * 
+   * The file is mapped privately and the fields are used in place, so
+   * nothing is read until it is accessed, and changes are not written
+   * back to the file. Afterwards storage() is FieldStorage::Mapped and
+   * numPhases() is that of the saved container (zero for files of
+   * format versions before 4).
+   * @param path a file written by save(), or by a file backed container
+   */
+  void load(const std::string& path);
+
+  /**
+   * @brief Set the size of the chunks in which changes are tracked.
+   * 
+   * If the size changes, all fields are marked as dirty.
+   * @param bytes the chunk size, a positive multiple of sizeof(double);
+   *              the default is 64 KiB
+   */
+  void setDirtyChunkSize(size_t bytes);
+
+  /**
+   * @brief Get the size of the chunks in which changes are tracked, in bytes.
+   */
+  size_t dirtyChunkSize() const;
+
+  /**
+   * @brief Mark values [begin, end) of a cell data vector as changed.
+   * @param id the handle of the vector
+   * @param begin first changed value
+   * @param end one past the last changed value
+   */
+  void markCellDataDirty(CellFieldId id, size_t begin, size_t end);
+
+  /**
+   * @brief Mark values [begin, end) of a face data vector as changed.
+   * @param id the handle of the vector
+   * @param begin first changed value
+   * @param end one past the last changed value
+   */
+  void markFaceDataDirty(FaceFieldId id, size_t begin, size_t end);
+
+  /**
+   * @brief Mark all fields as unchanged.
+   * 
+   * save() and saveDelta() do this themselves; call it when the full
+   * checkpoint which later deltas are based on is written otherwise.
+   * References and views obtained before must be obtained again, or
+   * their writes marked with markCellDataDirty(), for the writes to
+   * reach the next delta.
+   */
+  void clearDirty() const;
+
+  /**
+   * @brief Write the fields changed since the last checkpoint.
+   * 
+   * Only the dirty chunks are written (see DeltaCheckpoint), and all
+   * fields are marked as unchanged afterwards, so every delta holds
+   * the changes since the previous delta or the last save().
+   * @param path the file to write, truncated if it exists
+   */
+  void saveDelta(const std::string& path) const;
+
+  /**
+   * @brief Apply a delta written by saveDelta().
+   * 
+   * Loading the base checkpoint with load() and applying the deltas
+   * written since, in order, restores the state of any step.
+   * @param path the delta file
+   */
+  void applyDelta(const std::string& path);
+
+  /**
+   * @brief Save the values of all fields in a slot.
+   * 
+   * Unlike a copy of the container, this does not allocate once the
+   * slot is large enough, and restore() copies the values back in
+   * place. Fields are matched by handle.
+   * @param slot the slot; its previous content is replaced
+   */
+  void snapshot(SnapshotSlot& slot) const;
+
+  /**
+   * @brief Restore the values saved by snapshot().
+   * 
+   * Fields registered after the snapshot keep their values. Fields
+   * shared with a copy of the container are duplicated first.
+   * @param slot a slot filled by snapshot() on this container
+   */
+  void restore(const SnapshotSlot& slot);
+
+  /**
+   * @brief Compress a cell data vector losslessly (see FieldCompressor).
+   * @param id the handle of the vector
+   * @return the compressed values
+   */
+  std::vector<char> compressCellData(CellFieldId id) const;
+
+  /**
+   * @brief Compress a face data vector losslessly (see FieldCompressor).
+   * @param id the handle of the vector
+   * @return the compressed values
+   */
+  std::vector<char> compressFaceData(FaceFieldId id) const;
+
+  /**
+   * @brief Overwrite a cell data vector with compressed values.
+   * @param id the handle of the vector
+   * @param data values returned by compressCellData() for a vector of
+   *             the same size
+   */
+  void decompressCellData(CellFieldId id, const std::vector<char>& data);
+
+  /**
+   * @brief Overwrite a face data vector with compressed values.
+   * @param id the handle of the vector
+   * @param data values returned by compressFaceData() for a vector of
+   *             the same size
+   */
+  void decompressFaceData(FaceFieldId id, const std::vector<char>& data);
+
   /**
    * @brief Check for equality between two containers
+   * 
+   * The fields are compared in place, in parallel when OpenMP is
+   * enabled, and the comparison stops at the first difference. Fields
+   * with different layouts or types compare by value, the latter in
+   * Float64, so the result does not depend on which container is
+   * compared with which.
    * @param other the other container to be tested
    * @return true if equal
    */
   bool equal(const SimulationDataContainer& other) const;
 
+  /**
+   * @brief Compare all fields with those of another container.
+   * 
+   * Every field of either container gets an entry in the report, in
+   * registration order, followed by the fields only @p other has; the
+   * sparse fields are reported separately in the same way. Fields of
+   * different types are compared in Float64, as in equal().
+   * @param other the other container
+   * @param abs_eps absolute tolerance, as in cmp::scalar_equal()
+   * @param rel_eps relative tolerance, as in cmp::scalar_equal()
+   * @return the differences per field
+   */
+  ComparisonReport compare(const SimulationDataContainer& other,
+                           double abs_eps = cmp::default_abs_epsilon,
+                           double rel_eps = cmp::default_rel_epsilon) const;
+
   /**
    * @brief Set values in a cell data vector
    * @param key the name of the cell data vector
@@ -188,97 +1043,548 @@ class SimulationDataContainer {
                             const std::vector<double>& values);
 
   /**
-   * @brief Get pressure (mutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Write one component of a cell data vector for a list of cells.
+   * 
+   * Works for any number of components. With IndexCheck::Checked all
+   * indices are validated in one pass before anything is written, and
+   * only the changed range of cells is marked as dirty; unchecked
+   * calls mark the whole field. Sorted indices give the best locality.
+   * @param id the handle of the vector
+   * @param component the component to write
+   * @param cells @p count cell indices
+   * @param values @p count values, one per cell
+   * @param count number of cells
+   * @param check whether the indices are validated
    */
-  __attribute__((deprecated))
-  inline std::vector<double>& pressure() {
-    return *pressure_ref_;
+  void scatterCellData(CellFieldId id, size_t component, const int32_t* cells,
+                       const double* values, size_t count,
+                       IndexCheck check = IndexCheck::Checked);
+
+  /**
+   * @brief Write one component of a cell data vector, 64-bit indices.
+   */
+  void scatterCellData(CellFieldId id, size_t component, const int64_t* cells,
+                       const double* values, size_t count,
+                       IndexCheck check = IndexCheck::Checked);
+
+  /**
+   * @brief Read one component of a cell data vector for a list of cells.
+   * @param id the handle of the vector
+   * @param component the component to read
+   * @param cells @p count cell indices
+   * @param values receives @p count values, one per cell
+   * @param count number of cells
+   * @param check whether the indices are validated
+   */
+  void gatherCellData(CellFieldId id, size_t component, const int32_t* cells,
+                      double* values, size_t count,
+                      IndexCheck check = IndexCheck::Checked) const;
+
+  /**
+   * @brief Read one component of a cell data vector, 64-bit indices.
+   */
+  void gatherCellData(CellFieldId id, size_t component, const int64_t* cells,
+                      double* values, size_t count,
+                      IndexCheck check = IndexCheck::Checked) const;
+
+  /**
+   * @brief Set which cells this rank owns and how its ghost cells are
+   *        exchanged with the other ranks.
+   *
+   * The partition must have numCells() cells; std::invalid_argument is
+   * thrown otherwise. A container starts out owning all its cells, and
+   * copies share the partition.
+   */
+  void setPartition(const CellPartition& partition);
+
+  const CellPartition& partition() const { return *m_partition; }
+
+  /**
+   * @brief Size of the halo message to or from a neighbour.
+   * @param fields the cell vectors in the message
+   * @param neighbor position in partition().neighbors()
+   */
+  size_t haloSendBytes(const std::vector<CellFieldId>& fields,
+                       size_t neighbor) const;
+  size_t haloReceiveBytes(const std::vector<CellFieldId>& fields,
+                          size_t neighbor) const;
+
+  /**
+   * @brief Pack the values a neighbour needs into one message.
+   * @param fields the cell vectors in the message
+   * @param neighbor position in partition().neighbors()
+   * @param buffer haloSendBytes() bytes, 8 byte aligned
+   */
+  void packHalo(const std::vector<CellFieldId>& fields, size_t neighbor,
+                void* buffer) const;
+
+  /**
+   * @brief Unpack a message from a neighbour into the ghost cells; the
+   *        changed chunks are marked as dirty.
+   * @param fields the cell vectors in the message, as for packHalo()
+   * @param neighbor position in partition().neighbors()
+   * @param buffer haloReceiveBytes() bytes, 8 byte aligned
+   */
+  void unpackHalo(const std::vector<CellFieldId>& fields, size_t neighbor,
+                  const void* buffer);
+
+  /**
+   * @brief Update the ghost cells of @p fields from their owners.
+   *
+   * All ranks call exchangeHalo() with the same fields. The messages
+   * are packed in parallel over the neighbours when OpenMP is enabled.
+   */
+  void exchangeHalo(const std::vector<CellFieldId>& fields,
+                    HaloExchanger& exchanger);
+
+  /**
+   * @brief A container with the cell fields of a subset of the cells,
+   *        for moving cells to another rank when the load is
+   *        rebalanced.
+   *
+   * Cell i of the result is cell cells[i] of this container. Every cell
+   * field is copied with its name, components, layout and type, in one
+   * parallel pass over the cells per field. The result has the storage
+   * and first touch of this container, shares its memory resource, has
+   * no faces and owns all its cells; face fields and sparse fields are
+   * not copied. std::out_of_range is thrown for cells not below
+   * numCells().
+   * @param cells the cells to extract, in their new order
+   */
+  SimulationDataContainer extractCells(
+    const std::vector<int32_t>& cells) const;
+
+  /**
+   * @brief Merge the cells of several containers into one, as after
+   *        receiving cells from other ranks.
+   *
+   * Cell i of parts[p] becomes cell mappings[p][i] of the result, which
+   * has one cell more than the largest mapped cell. The mappings must
+   * cover the cells of the result exactly once. The result holds the
+   * cell fields of all parts, in the order they first appear, with the
+   * layout of the first part having them; a field must have the same
+   * components and type in every part. Cells of parts lacking a field
+   * are zero. std::invalid_argument is thrown for overlapping or
+   * missing cells and mismatching fields. The storage, first touch and
+   * memory resource are those of the first part.
+   * @param parts the containers to merge, at least one
+   * @param mappings for each part, the new indices of its cells
+   */
+  static SimulationDataContainer mergeCells(
+    const std::vector<const SimulationDataContainer*>& parts,
+    const std::vector<std::vector<int32_t>>& mappings);
+
+  /**
+   * @brief Size of a message with all cell fields of @p num_cells cells.
+   */
+  size_t cellMessageBytes(size_t num_cells) const;
+
+  /**
+   * @brief Pack all cell fields of a list of cells into one contiguous
+   *        message, in the format of packHalo().
+   * @param cells the cells to send
+   * @param buffer cellMessageBytes() bytes, 8 byte aligned
+   */
+  void packCells(const std::vector<int32_t>& cells, void* buffer) const;
+
+  /**
+   * @brief Unpack a message of packCells() into a list of cells.
+   *
+   * The cell fields of this container must be those of the sender,
+   * in the same order, as for a container made by extractCells() or
+   * registered in the same sequence.
+   * @param cells the cells receiving the values
+   * @param buffer cellMessageBytes() bytes, 8 byte aligned
+   */
+  void unpackCells(const std::vector<int32_t>& cells, const void* buffer);
+
+  /**
+   * @brief Minimum, maximum, sum, mean and the cells of the extremes
+   *        of one component of a cell vector.
+   *
+   * The reduction runs in parallel (see fieldStatistics()) and its
+   * result is cached until the vector is next accessed mutably, so
+   * repeated convergence checks on unchanged vectors cost nothing.
+   * Writes through views obtained earlier must be marked with
+   * markCellDataDirty() to drop the cached result.
+   * @param id the handle of the vector
+   * @param component the component to reduce
+   */
+  FieldStatistics cellStatistics(CellFieldId id, size_t component) const {
+    checkComponent(m_cell_data, id.index(), component);
+    return m_cell_data.statistics(id.index(), component);
   }
 
   /**
-   * @brief Get temperature (mutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Statistics over all components of a cell vector.
    */
-  __attribute__((deprecated))
-  inline std::vector<double>& temperature() {
-    return *temperature_ref_;
+  FieldStatistics cellStatistics(CellFieldId id) const {
+    return m_cell_data.statistics(id.index(),
+                                  m_cell_data.components(id.index()));
   }
 
   /**
-   * @brief Get saturation (mutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Statistics of one component of a face vector, as
+   *        cellStatistics().
    */
-  __attribute__((deprecated))
-  inline std::vector<double>& saturation() {
-    return *saturation_ref_;
+  FieldStatistics faceStatistics(FaceFieldId id, size_t component) const {
+    checkComponent(m_face_data, id.index(), component);
+    return m_face_data.statistics(id.index(), component);
+  }
+
+  FieldStatistics faceStatistics(FaceFieldId id) const {
+    return m_face_data.statistics(id.index(),
+                                  m_face_data.components(id.index()));
   }
 
   /**
-   * @brief Get facepressure (mutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Register the field of a compile-time key (see FieldKey.hpp),
+   *        as registerCellData() or registerFaceData().
    */
-  __attribute__((deprecated))
-  inline std::vector<double>& facepressure() {
-    return *facepressure_ref_;
+  template <typename Key>
+  typename Key::Id registerData(size_t components, double initialValue = 0.0,
+                                const FieldLayout& layout = FieldLayout(),
+                                FieldType type = FieldType::Float64) {
+    return registerField(typename Key::Id(), Key::name(), components,
+                         initialValue, layout, type);
   }
 
   /**
-   * @brief Get faceflux (mutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Check whether the field of a compile-time key exists.
    */
-  __attribute__((deprecated))
-  inline std::vector<double>& faceflux() {
-    return *faceflux_ref_;
+  template <typename Key>
+  bool has() const {
+    return fields(typename Key::Id()).findKey(fieldKeySlot<Key>(),
+                                              Key::name())
+           != FieldTable::npos;
   }
 
   /**
-   * @brief Get pressure (immutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Handle of the field of a compile-time key.
+   *
+   * The name of the key is looked up once per container, after which
+   * the handle comes from the slot of the key in the field table. A
+   * missing field throws std::invalid_argument.
    */
-  __attribute__((deprecated))
-  inline const std::vector<double>& pressure() const {
-      return *pressure_ref_;
+  template <typename Key>
+  typename Key::Id fieldId() const {
+    const size_t index = fields(typename Key::Id()).findKey(
+      fieldKeySlot<Key>(), Key::name());
+    if (index == FieldTable::npos) {
+      throwMissingField(Key::name());
+    }
+    return typename Key::Id(index);
   }
 
   /**
-   * @brief Get temperature (immutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief View of the field of a compile-time key, e.g.
+   *        get<FieldKeys::Pressure>(), with values of type T.
+   *
+   * Mutable access marks the field as dirty, as cellView() and
+   * faceView() do. The view works with every storage mode and stays
+   * valid across swap() as long as the field is not reallocated.
    */
-  __attribute__((deprecated))
-  inline const std::vector<double>& temperature() const {
-    return *temperature_ref_;
+  template <typename Key, typename T = double>
+  FieldView<T> get() {
+    return view<T>(fieldId<Key>());
+  }
+
+  template <typename Key, typename T = double>
+  FieldView<const T> get() const {
+    return view<T>(fieldId<Key>());
   }
 
   /**
-   * @brief Get saturation (immutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Write the values of an expression over views (see
+   *        FieldExpression.hpp) to one component of a cell vector.
+   *
+   * The expression is evaluated in one parallel pass without
+   * temporaries and converted to the type of the vector, which is
+   * marked as dirty. Bit vectors throw std::logic_error.
+   * @param id the handle of the vector
+   * @param component the component to write
+   * @param expression an expression of numCells() values
    */
-  __attribute__((deprecated))
-  inline const std::vector<double>& saturation() const {
-    return *saturation_ref_;
+  template <typename E>
+  void evaluateCellData(CellFieldId id, size_t component,
+                        const E& expression) {
+    switch (cellType(id)) {
+      case FieldType::Float32:
+        evaluate(cellComponentView<float>(id, component), expression);
+        break;
+      case FieldType::Int32:
+        evaluate(cellComponentView<int32_t>(id, component), expression);
+        break;
+      case FieldType::Int16:
+        evaluate(cellComponentView<int16_t>(id, component), expression);
+        break;
+      case FieldType::UInt8:
+        evaluate(cellComponentView<uint8_t>(id, component), expression);
+        break;
+      default:
+        evaluate(cellComponentView<double>(id, component), expression);
+        break;
+    }
   }
 
   /**
-   * @brief Get facepressure (immutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Register a cell vector of one Float64 component holding the
+   *        values of an expression of numCells() values.
+   *
+   * With Vector storage the expression is evaluated straight into the
+   * new vector. Registering moves the values of Arena and Mapped
+   * storage, and with them the views the expression holds, so there
+   * the expression is evaluated into one temporary first. An existing
+   * vector of the name gets the values in its first component.
    */
-  __attribute__((deprecated))
-  inline const std::vector<double>& facepressure() const {
-    return *facepressure_ref_;
+  template <typename E>
+  CellFieldId evaluateCellData(const std::string& name,
+                               const E& expression) {
+    if (storage() == FieldStorage::Vector) {
+      const CellFieldId id = registerCellData(name, 1);
+      evaluateCellData(id, 0, expression);
+      return id;
+    }
+    std::vector<double> values(m_num_cells);
+    evaluate(FieldView<double>(values.data(), values.size()), expression);
+    const CellFieldId id = registerCellData(name, 1);
+    evaluateCellData(id, 0, FieldView<const double>(values.data(),
+                                                    values.size()));
+    return id;
   }
 
   /**
-   * @brief Get faceflux (immutable)
-   * @deprecated will eventually be moved to concrete subclasses
+   * @brief Evaluate an expression into a face vector, as
+   *        evaluateCellData().
    */
-  __attribute__((deprecated))
-  inline const std::vector<double>& faceflux() const {
-    return *faceflux_ref_;
+  template <typename E>
+  void evaluateFaceData(FaceFieldId id, size_t component,
+                        const E& expression) {
+    switch (faceType(id)) {
+      case FieldType::Float32:
+        evaluate(faceComponentView<float>(id, component), expression);
+        break;
+      case FieldType::Int32:
+        evaluate(faceComponentView<int32_t>(id, component), expression);
+        break;
+      case FieldType::Int16:
+        evaluate(faceComponentView<int16_t>(id, component), expression);
+        break;
+      case FieldType::UInt8:
+        evaluate(faceComponentView<uint8_t>(id, component), expression);
+        break;
+      default:
+        evaluate(faceComponentView<double>(id, component), expression);
+        break;
+    }
+  }
+
+  template <typename E>
+  FaceFieldId evaluateFaceData(const std::string& name,
+                               const E& expression) {
+    if (storage() == FieldStorage::Vector) {
+      const FaceFieldId id = registerFaceData(name, 1);
+      evaluateFaceData(id, 0, expression);
+      return id;
+    }
+    std::vector<double> values(m_num_faces);
+    evaluate(FieldView<double>(values.data(), values.size()), expression);
+    const FaceFieldId id = registerFaceData(name, 1);
+    evaluateFaceData(id, 0, FieldView<const double>(values.data(),
+                                                    values.size()));
+    return id;
+  }
+
+  /**
+   * @brief Sum, mean, minimum and maximum of cell vectors per region,
+   *        in one parallel pass over the cells (see aggregateRegions()).
+   *
+   * Every component of every vector in @p fields is one column of the
+   * report, in order. The regions are 0 to the largest region number;
+   * cells with a negative number are skipped. Only the cells this rank
+   * owns are aggregated, so ghost cells are not counted twice. Vectors
+   * of any type and layout can be used, except that the region numbers
+   * must have an integer type and be below max_regions;
+   * std::invalid_argument is thrown otherwise, and for invalid handles.
+   * @param regions a cell vector of one component with region numbers
+   * @param fields the vectors to aggregate
+   * @param weights a cell vector of one component with the weights,
+   *                e.g. pore volumes; an invalid handle for weight one
+   */
+  RegionReport aggregateCellData(CellFieldId regions,
+                                 const std::vector<CellFieldId>& fields,
+                                 CellFieldId weights = CellFieldId()) const;
+
+  /**
+   * @brief Keep the values of a cell vector at the last @p depth
+   *        timesteps (see FieldTable::setHistory()).
+   *
+   * rotateHistory() at the end of a timestep moves the values to lag
+   * 1 by rotating buffers instead of copying them; new lags start as
+   * copies of the oldest one. Throws std::logic_error with Mapped
+   * storage.
+   */
+  void setCellDataHistory(CellFieldId id, size_t depth) {
+    m_cell_data.setHistory(id.index(), depth);
+  }
+  void setFaceDataHistory(FaceFieldId id, size_t depth) {
+    m_face_data.setHistory(id.index(), depth);
+  }
+
+  size_t cellDataHistory(CellFieldId id) const {
+    return m_cell_data.historyDepth(id.index());
+  }
+  size_t faceDataHistory(FaceFieldId id) const {
+    return m_face_data.historyDepth(id.index());
+  }
+
+  /**
+   * @brief View of a cell vector @p lag timesteps ago; lag 0 is the
+   *        vector itself, as cellView().
+   *
+   * A lag larger than the history depth throws std::out_of_range.
+   * Only writing lag 0 marks the vector as dirty; checkpoints,
+   * snapshots and saved files hold lag 0 only.
+   */
+  template <typename T = double>
+  FieldView<T> cellHistoryView(CellFieldId id, size_t lag) {
+    T* values = m_cell_data.historyData<T>(id.index(), lag);
+    m_cell_data.expose(id.index());
+    if (lag == 0) {
+      m_cell_data.touch(id.index());
+    }
+    return FieldView<T>(values, m_cell_data.count(id.index()));
+  }
+
+  template <typename T = double>
+  FieldView<const T> cellHistoryView(CellFieldId id, size_t lag) const {
+    return FieldView<const T>(m_cell_data.historyData<T>(id.index(), lag),
+                              m_cell_data.count(id.index()));
+  }
+
+  BitView<const FieldBits::Word> cellHistoryBits(CellFieldId id,
+                                                 size_t lag) const {
+    return BitView<const FieldBits::Word>(
+      m_cell_data.historyWords(id.index(), lag),
+      m_cell_data.count(id.index()));
+  }
+
+  /**
+   * @brief View of a face vector @p lag timesteps ago, as
+   *        cellHistoryView().
+   */
+  template <typename T = double>
+  FieldView<T> faceHistoryView(FaceFieldId id, size_t lag) {
+    T* values = m_face_data.historyData<T>(id.index(), lag);
+    m_face_data.expose(id.index());
+    if (lag == 0) {
+      m_face_data.touch(id.index());
+    }
+    return FieldView<T>(values, m_face_data.count(id.index()));
+  }
+
+  template <typename T = double>
+  FieldView<const T> faceHistoryView(FaceFieldId id, size_t lag) const {
+    return FieldView<const T>(m_face_data.historyData<T>(id.index(), lag),
+                              m_face_data.count(id.index()));
+  }
+
+  BitView<const FieldBits::Word> faceHistoryBits(FaceFieldId id,
+                                                 size_t lag) const {
+    return BitView<const FieldBits::Word>(
+      m_face_data.historyWords(id.index(), lag),
+      m_face_data.count(id.index()));
+  }
+
+  /**
+   * @brief End a timestep: every vector with a history becomes lag 1
+   *        of itself, in O(depth) pointer moves per vector.
+   *
+   * The vectors then hold stale values (see FieldTable::rotateHistory())
+   * and must be written before they are read; to start from the last
+   * timestep copy lag 1 into them. References and views obtained
+   * before the rotation refer to lag 1 afterwards.
+   */
+  void rotateHistory() {
+    m_cell_data.rotateHistory();
+    m_face_data.rotateHistory();
   }
 
+  /**
+   * @brief Register a cell field defined on @p cells only.
+   *
+   * If a sparse cell field called @p name exists already, its handle
+   * is returned and the field is left unchanged. Duplicate cells and
+   * cells out of range throw std::invalid_argument.
+   * @param name the name of the field
+   * @param components values per cell
+   * @param cells the cells the field is defined on, in any order
+   * @param initialValue the value of all components
+   */
+  SparseCellFieldId registerSparseCellData(const std::string& name,
+                                           size_t components,
+                                           const std::vector<int32_t>& cells,
+                                           double initialValue = 0.0);
+
+  /**
+   * @brief Register a face field defined on @p faces only, like
+   *        registerSparseCellData().
+   */
+  SparseFaceFieldId registerSparseFaceData(const std::string& name,
+                                           size_t components,
+                                           const std::vector<int32_t>& faces,
+                                           double initialValue = 0.0);
+
+  bool hasSparseCellData(const std::string& name) const;
+  bool hasSparseFaceData(const std::string& name) const;
+
+  /**
+   * @brief Look up the handle of a sparse field; throws
+   *        std::invalid_argument if there is no such field.
+   */
+  SparseCellFieldId sparseCellFieldId(const std::string& name) const;
+  SparseFaceFieldId sparseFaceFieldId(const std::string& name) const;
+
+  /**
+   * @brief Access a sparse field by handle.
+   */
+  SparseField& sparseCellData(SparseCellFieldId id) {
+    return m_sparse_cell_data[id.index()];
+  }
+  const SparseField& sparseCellData(SparseCellFieldId id) const {
+    return m_sparse_cell_data[id.index()];
+  }
+  SparseField& sparseFaceData(SparseFaceFieldId id) {
+    return m_sparse_face_data[id.index()];
+  }
+  const SparseField& sparseFaceData(SparseFaceFieldId id) const {
+    return m_sparse_face_data[id.index()];
+  }
+
+  /**
+   * @brief Write the values of a sparse field into its cells of a
+   *        dense field with the same number of components; the other
+   *        cells keep their values.
+   *
+   * The written chunks of @p dense are marked as dirty. Values are
+   * converted to the type of @p dense as by scatterCellData().
+   */
+  void scatterSparseCellData(SparseCellFieldId sparse, CellFieldId dense);
+  void scatterSparseFaceData(SparseFaceFieldId sparse, FaceFieldId dense);
+
+  /**
+   * @brief Read the values of a sparse field from its cells of a
+   *        dense field with the same number of components.
+   */
+  void gatherSparseCellData(SparseCellFieldId sparse, CellFieldId dense);
+  void gatherSparseFaceData(SparseFaceFieldId sparse, FaceFieldId dense);
+
   /**
    * @brief Get cell data set (immutable)
+   *
+   * This is the map of the mutable cellData() if that holds every cell
+   * field, and otherwise a copy made by the call. Only available if
+   * all cell fields are std::vector<double>.
    * @deprecated will eventually be moved to concrete subclasses
    */
   __attribute__((deprecated))
@@ -286,12 +1592,64 @@ class SimulationDataContainer {
 
   /**
    * @brief Get cell data set (mutable)
+   *
+   * The first call moves the cell fields into the map (see
+   * FieldTable::vectorMap()), so references and views obtained before
+   * must be obtained again. Fields added to the map are not
+   * registered. Only available if all cell fields are
+   * std::vector<double>.
    * @deprecated will eventually be moved to concrete subclasses
    */
   __attribute__((deprecated))
   std::map<std::string, std::vector<double>>& cellData();
 
  private:
+  size_t findCellData(const char* name, size_t length) const;
+  size_t findFaceData(const char* name, size_t length) const;
+  template <typename Index>
+  static void scatter(FieldTable& fields, size_t num_entities, size_t index,
+                      size_t component, const Index* cells,
+                      const double* values, size_t count, IndexCheck check);
+  template <typename Index>
+  static void gather(const FieldTable& fields, size_t num_entities,
+                     size_t index, size_t component, const Index* cells,
+                     double* values, size_t count, IndexCheck check);
+  static size_t findSparse(const std::vector<SparseField>& fields,
+                           const std::string& name);
+  static void checkSparse(const SparseField& sparse, const FieldTable& fields,
+                          size_t index);
+  std::vector<size_t> fieldIndices(
+    const std::vector<CellFieldId>& fields) const;
+  static void checkComponent(const FieldTable& fields, size_t index,
+                             size_t component);
+  [[noreturn]] static void throwMissingField(const char* name);
+
+  // Overloads by handle type for the compile-time key accessors.
+  const FieldTable& fields(CellFieldId) const { return m_cell_data; }
+  const FieldTable& fields(FaceFieldId) const { return m_face_data; }
+  template <typename T>
+  FieldView<T> view(CellFieldId id) { return cellView<T>(id); }
+  template <typename T>
+  FieldView<T> view(FaceFieldId id) { return faceView<T>(id); }
+  template <typename T>
+  FieldView<const T> view(CellFieldId id) const { return cellView<T>(id); }
+  template <typename T>
+  FieldView<const T> view(FaceFieldId id) const { return faceView<T>(id); }
+  CellFieldId registerField(CellFieldId, const char* name, size_t components,
+                            double initialValue, const FieldLayout& layout,
+                            FieldType type) {
+    return registerCellData(name, components, initialValue, layout, type);
+  }
+  FaceFieldId registerField(FaceFieldId, const char* name, size_t components,
+                            double initialValue, const FieldLayout& layout,
+                            FieldType type) {
+    return registerFaceData(name, components, initialValue, layout, type);
+  }
+  template <typename T>
+  static StridedView<T> componentView(const FieldTable& fields,
+                                      size_t index, T* values,
+                                      size_t component);
+
   /**
    * @brief Adds default fields 
    * @deprecated It should not be used any more.
@@ -299,24 +1657,26 @@ class SimulationDataContainer {
   __attribute__((deprecated))
   void addDefaultFields();
 
-  /**
-   * @brief Sets the reference pointers for the fast accessors,
-   *        
-   * The fields must be created first by copying or a call to
-   * addDefaultFields().
-   */
-  void setReferencePointers();
-
   size_t m_num_cells;  //!< number of cells
   size_t m_num_faces;  //!< number of faces
   size_t m_num_phases;  //!< number of phases
-  std::map< std::string, std::vector<double> > m_cell_data;  //!< cell data set
-  std::map< std::string, std::vector<double> > m_face_data;  //!< face data set
-  std::vector<double>* pressure_ref_;  //!< the pressure
-  std::vector<double>* temperature_ref_;  //!< the temperature
-  std::vector<double>* saturation_ref_;  //!< the saturation
-  std::vector<double>* facepressure_ref_;  //!< the face pressure
-  std::vector<double>* faceflux_ref_;  //!< the face flux
+  std::shared_ptr<MappedStorage> m_mapping;  //!< Mapped storage only
+  FieldTable m_cell_data;  //!< cell data set
+  FieldTable m_face_data;  //!< face data set
+  std::shared_ptr<const CellPartition> m_partition;  //!< owned and ghosts
+  std::vector<SparseField> m_sparse_cell_data;  //!< by handle
+  std::vector<SparseField> m_sparse_face_data;  //!< by handle
 };
+
+template <typename T>
+StridedView<T> SimulationDataContainer::componentView(
+    const FieldTable& fields, size_t index, T* values, size_t component) {
+  const FieldLayout& layout = fields.layout(index);
+  const size_t num_entities = fields.numEntities();
+  return StridedView<T>(
+    values + layout.componentOffset(component, num_entities), num_entities,
+    layout.componentStride(num_entities, fields.components(index)),
+    layout.componentBlock(num_entities));
+}
 }  // namespace Opm
 #endif  // OPM_COMMON_DATA_SIMULATIONDATACONTAINER_H_
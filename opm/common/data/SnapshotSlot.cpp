@@ -0,0 +1,132 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/SnapshotSlot.hpp"
+
+namespace Opm {
+namespace {
+// Fields up to this many bytes are copied by one thread.
+const size_t block_bytes = 1 << 20;
+}  // namespace
+
+SnapshotSlot::SnapshotSlot()
+    : m_buffer(),
+      m_entries(),
+      m_num_cell_fields(0),
+      m_num_cells(0),
+      m_num_faces(0),
+      m_valid(false) {
+}
+
+void SnapshotSlot::copy(void* target, const void* source, size_t bytes) {
+  if (bytes <= block_bytes) {
+    if (bytes > 0) {
+      std::memcpy(target, source, bytes);
+    }
+    return;
+  }
+  char* first = static_cast<char*>(target);
+  const char* source_first = static_cast<const char*>(source);
+  const size_t num_blocks = (bytes + block_bytes - 1) / block_bytes;
+#pragma omp parallel for schedule(static)
+  for (size_t block = 0; block < num_blocks; ++block) {
+    const size_t begin = block * block_bytes;
+    std::memcpy(first + begin, source_first + begin,
+                std::min(block_bytes, bytes - begin));
+  }
+}
+
+void SnapshotSlot::save(const FieldTable& cells, const FieldTable& faces) {
+  size_t needed = 0;
+  for (const FieldTable* fields : { &cells, &faces }) {
+    for (size_t index = 0; index < fields->size(); ++index) {
+      needed += AlignedBuffer::padded(bytes(*fields, index));
+    }
+  }
+  if (needed > m_buffer.size()) {
+    AlignedBuffer(needed).swap(m_buffer);
+  }
+
+  m_entries.clear();
+  size_t offset = 0;
+  char* values = static_cast<char*>(m_buffer.data());
+  for (const FieldTable* fields : { &cells, &faces }) {
+    for (size_t index = 0; index < fields->size(); ++index) {
+      Entry entry = { offset, fields->count(index), fields->layout(index),
+                      fields->type(index) };
+      m_entries.push_back(entry);
+      copy(values + offset, fields->rawData(index), bytes(*fields, index));
+      offset += AlignedBuffer::padded(bytes(*fields, index));
+    }
+  }
+  m_num_cell_fields = cells.size();
+  m_num_cells = cells.numEntities();
+  m_num_faces = faces.numEntities();
+  m_valid = true;
+}
+
+void SnapshotSlot::check(const FieldTable& fields, size_t begin,
+                         size_t end) const {
+  if (fields.size() < end - begin) {
+    OPM_THROW(std::invalid_argument,
+              "The snapshot holds fields which are not in the container");
+  }
+  for (size_t entry = begin; entry < end; ++entry) {
+    if (fields.count(entry - begin) != m_entries[entry].count ||
+        fields.layout(entry - begin) != m_entries[entry].layout ||
+        fields.type(entry - begin) != m_entries[entry].type) {
+      OPM_THROW(std::invalid_argument, "The field "
+                << fields.name(entry - begin)
+                << " does not match the snapshot");
+    }
+  }
+}
+
+void SnapshotSlot::restore(FieldTable& fields, size_t begin,
+                           size_t end) const {
+  const char* values = static_cast<const char*>(m_buffer.data());
+  for (size_t entry = begin; entry < end; ++entry) {
+    const size_t index = entry - begin;
+    fields.touch(index);
+    copy(fields.rawData(index), values + m_entries[entry].offset,
+         bytes(fields, index));
+  }
+}
+
+void SnapshotSlot::restore(FieldTable& cells, FieldTable& faces) const {
+  if (!m_valid) {
+    OPM_THROW(std::logic_error, "No snapshot has been saved");
+  }
+  if (cells.numEntities() != m_num_cells ||
+      faces.numEntities() != m_num_faces) {
+    OPM_THROW(std::invalid_argument, "The snapshot does not match the "
+              "number of cells and faces");
+  }
+  // Everything is checked before anything is overwritten.
+  check(cells, 0, m_num_cell_fields);
+  check(faces, m_num_cell_fields, m_entries.size());
+  restore(cells, 0, m_num_cell_fields);
+  restore(faces, m_num_cell_fields, m_entries.size());
+}
+}  // namespace Opm
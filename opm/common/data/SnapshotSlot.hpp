@@ -0,0 +1,93 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_SNAPSHOTSLOT_H_
+#define OPM_COMMON_DATA_SNAPSHOTSLOT_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <opm/common/data/AlignedBuffer.hpp>
+#include <opm/common/data/FieldTable.hpp>
+
+namespace Opm {
+/**
+ * @class SnapshotSlot
+ * @brief Preallocated copy of the fields of a SimulationDataContainer,
+ *        for rolling back a failed timestep.
+ *
+ * The values of all fields are kept in one aligned buffer, which only
+ * grows when a snapshot needs more room than any snapshot before it;
+ * repeated snapshots and restores of the same container therefore do
+ * not allocate. Large fields are copied in parallel blocks when OpenMP
+ * is enabled.
+ */
+class SnapshotSlot {
+ public:
+  SnapshotSlot();
+
+  /**
+   * @brief Whether the slot holds a snapshot.
+   */
+  bool valid() const { return m_valid; }
+
+  /**
+   * @brief Number of bytes reserved for field values.
+   */
+  size_t capacity() const { return m_buffer.size(); }
+
+  /**
+   * @brief Copy all fields of the tables into the slot.
+   */
+  void save(const FieldTable& cells, const FieldTable& faces);
+
+  /**
+   * @brief Copy the saved values back into the tables.
+   *
+   * The tables must hold the saved fields with the same sizes,
+   * layouts and types, and may hold fields registered after the
+   * snapshot; these are left as they are. Restored fields are marked as dirty.
+   */
+  void restore(FieldTable& cells, FieldTable& faces) const;
+
+ private:
+  struct Entry {
+    size_t offset;  //!< first byte in the buffer
+    size_t count;  //!< number of values
+    FieldLayout layout;  //!< order of the values
+    FieldType type;  //!< scalar type of the values
+  };
+
+  static size_t bytes(const FieldTable& fields, size_t index) {
+    return storageBytes(fields.type(index), fields.count(index));
+  }
+
+  static void copy(void* target, const void* source, size_t bytes);
+  void check(const FieldTable& fields, size_t begin, size_t end) const;
+  void restore(FieldTable& fields, size_t begin, size_t end) const;
+
+  AlignedBuffer m_buffer;  //!< the saved values
+  std::vector<Entry> m_entries;  //!< cell fields, then face fields
+  size_t m_num_cell_fields;  //!< number of cell fields in m_entries
+  size_t m_num_cells;  //!< number of cells when saved
+  size_t m_num_faces;  //!< number of faces when saved
+  bool m_valid;  //!< whether a snapshot was saved
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_SNAPSHOTSLOT_H_
@@ -0,0 +1,87 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "opm/common/ErrorMacros.hpp"
+#include "opm/common/data/SparseField.hpp"
+
+namespace Opm {
+const size_t SparseField::npos;
+
+SparseField::SparseField(const std::string& name, size_t num_entities,
+                         std::vector<int32_t> entities, size_t components,
+                         double initialValue)
+    : m_name(name),
+      m_num_entities(num_entities),
+      m_components(components),
+      m_entities(std::move(entities)),
+      m_values() {
+  std::sort(m_entities.begin(), m_entities.end());
+  auto duplicate = std::adjacent_find(m_entities.begin(), m_entities.end());
+  if (duplicate != m_entities.end()) {
+    OPM_THROW(std::invalid_argument, "The entity: " << *duplicate
+              << " occurs twice in the sparse field: " << name);
+  }
+  if (!m_entities.empty() &&
+      (m_entities.front() < 0 ||
+       static_cast<size_t>(m_entities.back()) >= num_entities)) {
+    OPM_THROW(std::invalid_argument, "The sparse field: " << name
+              << " has entities outside [0, " << num_entities << ")");
+  }
+  m_values.assign(m_entities.size() * components, initialValue);
+}
+
+size_t SparseField::find(size_t entity) const {
+  if (entity >= m_num_entities) {
+    return npos;
+  }
+  auto iter = std::lower_bound(m_entities.begin(), m_entities.end(),
+                               static_cast<int32_t>(entity));
+  if (iter != m_entities.end() && static_cast<size_t>(*iter) == entity) {
+    return iter - m_entities.begin();
+  }
+  return npos;
+}
+
+double SparseField::value(size_t entity, size_t component,
+                          double missing) const {
+  checkComponent(component);
+  const size_t position = find(entity);
+  return position == npos ? missing : this->component(component)[position];
+}
+
+void SparseField::set(size_t entity, size_t component, double value) {
+  checkComponent(component);
+  const size_t position = find(entity);
+  if (position == npos) {
+    OPM_THROW(std::out_of_range, "The entity: " << entity
+              << " is not in the sparse field: " << m_name);
+  }
+  this->component(component)[position] = value;
+}
+
+void SparseField::checkComponent(size_t component) const {
+  if (component >= m_components) {
+    OPM_THROW(std::invalid_argument, "The component: " << component
+              << " is invalid for the sparse field: " << m_name);
+  }
+}
+}  // namespace Opm
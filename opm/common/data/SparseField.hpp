@@ -0,0 +1,120 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_SPARSEFIELD_H_
+#define OPM_COMMON_DATA_SPARSEFIELD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Opm {
+/**
+ * @class SparseField
+ * @brief A field defined on a small subset of the cells or faces.
+ *
+ * The field holds the sorted entity numbers of the subset and a
+ * compact array of size() * components() values, so it costs memory
+ * in proportion to the subset instead of numEntities(). The values are
+ * stored component by component: component(c) points to the size()
+ * values of component c, in the order of entities(). A value is found
+ * by a binary search over the entities.
+ */
+class SparseField {
+ public:
+  /**
+   * @brief Returned by find() for entities outside the subset.
+   */
+  static const size_t npos = static_cast<size_t>(-1);
+
+  /**
+   * @brief Create a field on @p entities, all values set to
+   *        @p initialValue.
+   *
+   * The entities need not be sorted; duplicates and entities outside
+   * [0, num_entities) throw std::invalid_argument.
+   * @param name the name of the field
+   * @param num_entities number of cells or faces of the container
+   * @param entities the subset the field is defined on
+   * @param components values per entity
+   * @param initialValue the value of all components
+   */
+  SparseField(const std::string& name, size_t num_entities,
+              std::vector<int32_t> entities, size_t components,
+              double initialValue);
+
+  const std::string& name() const { return m_name; }
+  size_t numEntities() const { return m_num_entities; }
+  size_t components() const { return m_components; }
+
+  /**
+   * @brief Number of entities in the subset.
+   */
+  size_t size() const { return m_entities.size(); }
+
+  /**
+   * @brief The entities of the subset in increasing order.
+   */
+  const std::vector<int32_t>& entities() const { return m_entities; }
+
+  /**
+   * @brief Position of @p entity in entities(), or npos.
+   */
+  size_t find(size_t entity) const;
+
+  bool contains(size_t entity) const { return find(entity) != npos; }
+
+  /**
+   * @brief The size() values of one component.
+   */
+  double* component(size_t component) {
+    return m_values.data() + component * size();
+  }
+  const double* component(size_t component) const {
+    return m_values.data() + component * size();
+  }
+
+  /**
+   * @brief All values, component by component.
+   */
+  const std::vector<double>& values() const { return m_values; }
+
+  /**
+   * @brief The value of an entity, or @p missing outside the subset.
+   */
+  double value(size_t entity, size_t component, double missing = 0.0) const;
+
+  /**
+   * @brief Set the value of an entity of the subset; other entities
+   *        throw std::out_of_range.
+   */
+  void set(size_t entity, size_t component, double value);
+
+ private:
+  void checkComponent(size_t component) const;
+
+  std::string m_name;  //!< name of the field
+  size_t m_num_entities;  //!< number of cells or faces
+  size_t m_components;  //!< values per entity
+  std::vector<int32_t> m_entities;  //!< the subset, sorted
+  std::vector<double> m_values;  //!< component by component
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_SPARSEFIELD_H_
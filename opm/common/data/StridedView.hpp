@@ -0,0 +1,293 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_COMMON_DATA_STRIDEDVIEW_H_
+#define OPM_COMMON_DATA_STRIDEDVIEW_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Opm {
+/**
+ * @class StridedView
+ * @brief Non-owning view of one component of a field, e.g. every
+ *        stride()-th value of a field stored cell by cell.
+ *
+ * The values of the view come in blocks of block() contiguous values,
+ * with stride() between the starts of consecutive blocks: value i is
+ * at data()[(i / block()) * stride() + i % block()]. Block one is a
+ * plain strided view; the other field layouts (see FieldLayout) give
+ * longer blocks.
+ *
+ * Besides indexing and iteration the view offers bulk operations
+ * (fill(), assign(), copyTo(), axpy()); these run as contiguous loops
+ * over the blocks, which the compiler vectorizes. Like FieldView, a
+ * view is invalidated by any operation which reallocates the field
+ * storage.
+ */
+template <typename T>
+class StridedView {
+ public:
+  typedef T value_type;
+  typedef T& reference;
+
+  /**
+   * @brief Random access iterator over the values of a view.
+   */
+  class iterator {
+   public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<T>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* pointer;
+    typedef T& reference;
+
+    iterator() : m_data(nullptr), m_index(0), m_stride(1), m_block(1) {}
+    iterator(T* data, size_t index, size_t stride, size_t block)
+        : m_data(data), m_index(index), m_stride(stride), m_block(block) {}
+
+    T& operator*() const { return m_data[position(m_index)]; }
+    T* operator->() const { return m_data + position(m_index); }
+    T& operator[](difference_type n) const { return *(*this + n); }
+
+    iterator& operator++() { ++m_index; return *this; }
+    iterator operator++(int) { iterator old = *this; ++*this; return old; }
+    iterator& operator--() { --m_index; return *this; }
+    iterator operator--(int) { iterator old = *this; --*this; return old; }
+    iterator& operator+=(difference_type n) { m_index += n; return *this; }
+    iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+    iterator operator+(difference_type n) const {
+      iterator result = *this;
+      return result += n;
+    }
+    iterator operator-(difference_type n) const {
+      iterator result = *this;
+      return result -= n;
+    }
+    friend iterator operator+(difference_type n, const iterator& it) {
+      return it + n;
+    }
+    difference_type operator-(const iterator& other) const {
+      return static_cast<difference_type>(m_index)
+             - static_cast<difference_type>(other.m_index);
+    }
+
+    bool operator==(const iterator& other) const {
+      return m_data == other.m_data && m_index == other.m_index;
+    }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+    bool operator<(const iterator& other) const {
+      return m_index < other.m_index;
+    }
+    bool operator>(const iterator& other) const { return other < *this; }
+    bool operator<=(const iterator& other) const { return !(other < *this); }
+    bool operator>=(const iterator& other) const { return !(*this < other); }
+
+   private:
+    size_t position(size_t index) const {
+      return m_block == 1 ? index * m_stride
+                          : index / m_block * m_stride + index % m_block;
+    }
+
+    T* m_data;  //!< first value of the view
+    size_t m_index;  //!< current value
+    size_t m_stride;  //!< distance between blocks
+    size_t m_block;  //!< contiguous values per block
+  };
+
+  StridedView() : m_data(nullptr), m_size(0), m_stride(1), m_block(1) {}
+
+  /**
+   * @param data the first value
+   * @param size number of values in the view
+   * @param stride distance between the starts of consecutive blocks
+   * @param block number of contiguous values per block
+   */
+  StridedView(T* data, size_t size, size_t stride, size_t block = 1)
+      : m_data(data), m_size(size), m_stride(stride), m_block(block) {}
+
+  /**
+   * @brief Conversion from a mutable to a const view.
+   */
+  template <typename U,
+            typename = typename std::enable_if<
+              std::is_convertible<U*, T*>::value>::type>
+  StridedView(const StridedView<U>& other)
+      : m_data(other.data()), m_size(other.size()),
+        m_stride(other.stride()), m_block(other.block()) {}
+
+  T* data() const { return m_data; }
+  size_t size() const { return m_size; }
+  size_t stride() const { return m_stride; }
+  size_t block() const { return m_block; }
+  bool empty() const { return m_size == 0; }
+
+  /**
+   * @brief Whether all values are contiguous.
+   */
+  bool contiguous() const {
+    return m_block >= m_size || (m_block == 1 && m_stride == 1);
+  }
+
+  T& operator[](size_t index) const { return m_data[position(index)]; }
+
+  iterator begin() const { return iterator(m_data, 0, m_stride, m_block); }
+  iterator end() const {
+    return iterator(m_data, m_size, m_stride, m_block);
+  }
+
+  /**
+   * @brief Set every value to @p value.
+   */
+  void fill(T value) const {
+    if (contiguous()) {
+      std::fill(m_data, m_data + m_size, value);
+    } else if (m_block == 1) {
+      for (size_t i = 0; i < m_size; ++i) {
+        m_data[i * m_stride] = value;
+      }
+    } else {
+      for (size_t first = 0; first < m_size; first += m_block) {
+        T* run = m_data + first / m_block * m_stride;
+        std::fill(run, run + runLength(first), value);
+      }
+    }
+  }
+
+  /**
+   * @brief Copy size() contiguous values into the view.
+   */
+  void assign(const typename std::remove_const<T>::type* values) const {
+    if (contiguous()) {
+      std::copy(values, values + m_size, m_data);
+    } else if (m_block == 1) {
+      for (size_t i = 0; i < m_size; ++i) {
+        m_data[i * m_stride] = values[i];
+      }
+    } else {
+      for (size_t first = 0; first < m_size; first += m_block) {
+        std::copy(values + first, values + first + runLength(first),
+                  m_data + first / m_block * m_stride);
+      }
+    }
+  }
+
+  /**
+   * @brief Copy the values of another view of the same size.
+   */
+  template <typename U>
+  void assign(const StridedView<U>& other) const {
+    checkSize(other.size());
+    if (other.contiguous()) {
+      assign(other.data());
+    } else if (contiguous()) {
+      other.copyTo(m_data);
+    } else if (m_block == other.block()) {
+      const U* values = other.data();
+      for (size_t first = 0; first < m_size; first += m_block) {
+        T* run = m_data + first / m_block * m_stride;
+        const U* source = values + first / m_block * other.stride();
+        const size_t length = runLength(first);
+        for (size_t j = 0; j < length; ++j) {
+          run[j] = source[j];
+        }
+      }
+    } else {
+      for (size_t i = 0; i < m_size; ++i) {
+        (*this)[i] = other[i];
+      }
+    }
+  }
+
+  /**
+   * @brief Copy the values into size() contiguous values.
+   */
+  void copyTo(typename std::remove_const<T>::type* values) const {
+    if (contiguous()) {
+      std::copy(m_data, m_data + m_size, values);
+    } else if (m_block == 1) {
+      for (size_t i = 0; i < m_size; ++i) {
+        values[i] = m_data[i * m_stride];
+      }
+    } else {
+      for (size_t first = 0; first < m_size; first += m_block) {
+        const T* run = m_data + first / m_block * m_stride;
+        std::copy(run, run + runLength(first), values + first);
+      }
+    }
+  }
+
+  /**
+   * @brief Add @p alpha times the values of @p x to the values.
+   */
+  template <typename U>
+  void axpy(T alpha, const StridedView<U>& x) const {
+    checkSize(x.size());
+    const U* values = x.data();
+    if (contiguous() && x.contiguous()) {
+      for (size_t i = 0; i < m_size; ++i) {
+        m_data[i] += alpha * values[i];
+      }
+    } else if (m_block == 1 && x.block() == 1) {
+      const size_t x_stride = x.stride();
+      for (size_t i = 0; i < m_size; ++i) {
+        m_data[i * m_stride] += alpha * values[i * x_stride];
+      }
+    } else if (m_block == x.block()) {
+      for (size_t first = 0; first < m_size; first += m_block) {
+        T* run = m_data + first / m_block * m_stride;
+        const U* source = values + first / m_block * x.stride();
+        const size_t length = runLength(first);
+        for (size_t j = 0; j < length; ++j) {
+          run[j] += alpha * source[j];
+        }
+      }
+    } else {
+      for (size_t i = 0; i < m_size; ++i) {
+        (*this)[i] += alpha * x[i];
+      }
+    }
+  }
+
+ private:
+  size_t position(size_t index) const {
+    return m_block == 1 ? index * m_stride
+                        : index / m_block * m_stride + index % m_block;
+  }
+
+  size_t runLength(size_t first) const {
+    return std::min(m_block, m_size - first);
+  }
+
+  void checkSize(size_t size) const {
+    if (size != m_size) {
+      throw std::invalid_argument("The views have different sizes");
+    }
+  }
+
+  T* m_data;  //!< first value
+  size_t m_size;  //!< number of values
+  size_t m_stride;  //!< distance between the starts of blocks
+  size_t m_block;  //!< contiguous values per block
+};
+}  // namespace Opm
+#endif  // OPM_COMMON_DATA_STRIDEDVIEW_H_
@@ -0,0 +1,116 @@
+/*
+  Copyright 2016 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE FIELD_COMPRESSOR_TESTS
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <opm/common/data/FieldCompressor.hpp>
+#include <opm/common/data/SimulationDataContainer.hpp>
+
+using namespace Opm;
+
+namespace {
+// Bitwise comparison, so that NaN and -0.0 are checked as well.
+bool sameBits(const std::vector<double>& a, const std::vector<double>& b) {
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+}
+
+
+BOOST_AUTO_TEST_CASE(TestRoundTrip) {
+    const size_t count = 3 * FieldCompressor::chunk_values + 17;
+    std::vector<double> smooth(count);
+    for (size_t i = 0; i < count; i++)
+        smooth[i] = 200 + std::sin(i * 1e-4);
+    auto compressed = FieldCompressor::compress( smooth );
+    BOOST_CHECK_EQUAL( FieldCompressor::count( compressed.data() , compressed.size() ) , count );
+    BOOST_CHECK( sameBits( FieldCompressor::decompress( compressed ) , smooth ));
+
+    std::vector<double> special = { 0.0 , -0.0 , 1.0 ,
+                                    std::numeric_limits<double>::quiet_NaN() ,
+                                    std::numeric_limits<double>::infinity() ,
+                                    -std::numeric_limits<double>::denorm_min() ,
+                                    std::numeric_limits<double>::max() };
+    BOOST_CHECK( sameBits( FieldCompressor::decompress( FieldCompressor::compress( special , 3 )) , special ));
+
+    std::vector<double> empty;
+    BOOST_CHECK( FieldCompressor::decompress( FieldCompressor::compress( empty )).empty() );
+    BOOST_CHECK_THROW( FieldCompressor::compress( special , 0 ) , std::invalid_argument );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestRatio) {
+    const size_t num_cells = 100000;
+    std::vector<double> constant(num_cells , 0.25);
+    BOOST_CHECK( FieldCompressor::compress( constant ).size() < num_cells * sizeof(double) / 50 );
+
+    // Saturations with three components per cell, piecewise constant
+    // along the cells.
+    std::vector<double> saturation(3 * num_cells);
+    for (size_t i = 0; i < num_cells; i++) {
+        saturation[3 * i] = (i / 1000) % 2 ? 0.2 : 0.7;
+        saturation[3 * i + 1] = 0.1;
+        saturation[3 * i + 2] = 1 - saturation[3 * i] - 0.1;
+    }
+    auto compressed = FieldCompressor::compress( saturation , 3 );
+    BOOST_CHECK( compressed.size() < saturation.size() * sizeof(double) / 5 );
+    BOOST_CHECK( sameBits( FieldCompressor::decompress( compressed ) , saturation ));
+}
+
+
+BOOST_AUTO_TEST_CASE(TestCorrupt) {
+    std::vector<double> values(1000 , 1.5);
+    values[10] = 3;
+    auto compressed = FieldCompressor::compress( values );
+    std::vector<double> output(999);
+    BOOST_CHECK_THROW( FieldCompressor::decompress( compressed.data() , compressed.size() , output.data() , output.size()) , std::invalid_argument );
+
+    compressed.pop_back();
+    BOOST_CHECK_THROW( FieldCompressor::decompress( compressed ) , std::runtime_error );
+    compressed[0] = 'X';
+    BOOST_CHECK_THROW( FieldCompressor::decompress( compressed ) , std::runtime_error );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestContainer) {
+    SimulationDataContainer container(1000 , 10 , FieldStorage::Arena);
+    auto pressure = container.registerCellData("PRESSURE" , 1 , 200);
+    auto flux = container.registerFaceData("FLUX" , 2 , 1);
+    container.cellView( pressure )[7] = 7;
+    auto compressed_pressure = container.compressCellData( pressure );
+    auto compressed_flux = container.compressFaceData( flux );
+
+    SimulationDataContainer copy( container );
+    container.cellView( pressure )[7] = 8;
+    container.faceView( flux )[0] = 0;
+    container.decompressCellData( pressure , compressed_pressure );
+    container.decompressFaceData( flux , compressed_flux );
+    BOOST_CHECK( container.equal( copy ));
+    BOOST_CHECK_THROW( container.decompressFaceData( flux , compressed_pressure ) , std::invalid_argument );
+}
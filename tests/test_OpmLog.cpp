@@ -259,8 +259,8 @@ BOOST_AUTO_TEST_CASE(TestHelperFunctions)
 
     // colorCode Message
     BOOST_CHECK_EQUAL(colorCodeMessage(MessageType::Info, "message"), "message");
-    BOOST_CHECK_EQUAL(colorCodeMessage(MessageType::Warning, "message"), AnsiTerminalColors::blue_strong + "message" + AnsiTerminalColors::none);
-    BOOST_CHECK_EQUAL(colorCodeMessage(MessageType::Error, "message"), AnsiTerminalColors::red_strong + "message" + AnsiTerminalColors::none);
+    BOOST_CHECK_EQUAL(colorCodeMessage(MessageType::Warning, "message"), std::string(AnsiTerminalColors::blue_strong) + "message" + AnsiTerminalColors::none);
+    BOOST_CHECK_EQUAL(colorCodeMessage(MessageType::Error, "message"), std::string(AnsiTerminalColors::red_strong) + "message" + AnsiTerminalColors::none);
 }
 
 
@@ -22,12 +22,32 @@
 #define BOOST_TEST_MODULE SIMULATION_DATA_CONTAINER_TESTS
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <thread>
+#include <utility>
 #include <iostream>
 #include <opm/common/data/SimulationDataContainer.hpp>
 
 using namespace Opm;
 
+namespace {
+// The fields the deprecated constructor registers, for the tests which
+// use them.
+void registerDefaultFields( SimulationDataContainer& container , size_t num_phases ) {
+    container.registerData<FieldKeys::Pressure>( 1 , 0.0 );
+    container.registerData<FieldKeys::Saturation>( num_phases , 0.0 );
+    container.registerData<FieldKeys::Temperature>( 1 , 273.15 + 20 );
+    container.registerData<FieldKeys::FacePressure>( 1 , 0.0 );
+    container.registerData<FieldKeys::FaceFlux>( 1 , 0.0 );
+}
+}
+
 
 BOOST_AUTO_TEST_CASE(TestCreate) {
     SimulationDataContainer container(1000 , 10 , 2);
@@ -63,10 +83,10 @@ BOOST_AUTO_TEST_CASE(TestRegisterDefaults) {
     }
 
     {
-        auto pressure = container.pressure();
+        auto pressure = container.get<FieldKeys::Pressure>();
         BOOST_CHECK_EQUAL( pressure.size() , 1000U );
 
-        auto sat = container.saturation();
+        auto sat = container.get<FieldKeys::Saturation>();
         BOOST_CHECK_EQUAL( sat.size() , 1000U*2 );
     }
 
@@ -204,4 +224,1757 @@ BOOST_AUTO_TEST_CASE(TestSetComponent) {
     BOOST_CHECK_EQUAL( data[2*2] , 30 );
     BOOST_CHECK_EQUAL( data[3*2] , 40 );
 
+    // A restarted container keeps its phases.
+    const std::string path = "test_set_component.bin";
+    container.save( path );
+    SimulationDataContainer loaded( 1 , 1 , FieldStorage::Vector );
+    loaded.load( path );
+    std::remove( path.c_str() );
+    BOOST_CHECK_EQUAL( loaded.numPhases() , 2U );
+    BOOST_CHECK( loaded.equal( container ));
+    loaded.setCellDataComponent( "FIELDX" , 1 , cells , values0 );
+    BOOST_CHECK_EQUAL( loaded.cellView("FIELDX")[1*2 + 1] , 20 );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldHandles) {
+    SimulationDataContainer container(100 , 10 , FieldStorage::Vector);
+    registerDefaultFields( container , 2 );
+    CellFieldId fieldx = container.registerCellData("FIELDX" , 1 , 123 );
+    FaceFieldId facex = container.registerFaceData("FACEX" , 2 , 7 );
+
+    BOOST_CHECK( fieldx.valid() );
+    BOOST_CHECK( !CellFieldId().valid() );
+    BOOST_CHECK( fieldx == container.cellFieldId("FIELDX") );
+    BOOST_CHECK( fieldx == container.cellFieldId(std::string("FIELDX")) );
+    BOOST_CHECK( fieldx == container.registerCellData("FIELDX" , 1 , 0 ) );
+    BOOST_CHECK( facex == container.faceFieldId("FACEX") );
+    BOOST_CHECK_THROW( container.cellFieldId("FIELDY") , std::invalid_argument );
+    BOOST_CHECK_THROW( container.faceFieldId("FIELDX") , std::invalid_argument );
+
+    BOOST_CHECK_EQUAL( &container.getCellData( fieldx ) , &container.getCellData("FIELDX") );
+    BOOST_CHECK_EQUAL( &container.getFaceData( facex ) , &container.getFaceData("FACEX") );
+    BOOST_CHECK_EQUAL( container.getFaceData( facex ).size() , 20U );
+    container.getCellData( fieldx )[0] = 1;
+
+    // Handles are positions in the field table and survive copies.
+    SimulationDataContainer copy( container );
+    BOOST_CHECK_EQUAL( &copy.getCellData( fieldx ) , &copy.getCellData("FIELDX") );
+    BOOST_CHECK_EQUAL( copy.getCellData( fieldx )[0] , 1 );
+
+    SimulationDataContainer other(100 , 10 , FieldStorage::Vector);
+    registerDefaultFields( other , 2 );
+    other.registerCellData("FIELDX" , 1 , 5 );
+    other.registerFaceData("FACEX" , 2 , 5 );
+    other.swap( container );
+    BOOST_CHECK_EQUAL( container.getCellData( fieldx )[0] , 5 );
+    BOOST_CHECK_EQUAL( other.getCellData( fieldx )[0] , 1 );
+    BOOST_CHECK_EQUAL( other.get<FieldKeys::Pressure>().size() , 100U );
+    BOOST_CHECK_EQUAL( other.get<FieldKeys::Pressure>().data() , other.getCellData("PRESSURE").data() );
+
+    container = other;
+    BOOST_CHECK_EQUAL( container.getCellData( fieldx )[0] , 1 );
+    BOOST_CHECK_EQUAL( &container.getFaceData( facex ) , &container.getFaceData("FACEX") );
+    BOOST_CHECK( container.equal( other ));
+}
+
+
+BOOST_AUTO_TEST_CASE(TestArenaStorage) {
+    SimulationDataContainer container(100 , 10 , FieldStorage::Arena);
+    BOOST_CHECK( container.storage() == FieldStorage::Arena );
+    BOOST_CHECK_EQUAL( 0U , container.numPhases() );
+    BOOST_CHECK( !container.hasCellData("PRESSURE") );
+
+    CellFieldId p = container.registerCellData("P" , 1 , 1.0 );
+    CellFieldId s = container.registerCellData("S" , 3 , 2.0 );
+    FaceFieldId f = container.registerFaceData("F" , 1 , 3.0 );
+    BOOST_CHECK_THROW( container.getCellData( p ) , std::logic_error );
+    BOOST_CHECK_THROW( container.getFaceData("F") , std::logic_error );
+
+    auto sat = container.cellView( s );
+    BOOST_CHECK_EQUAL( sat.size() , 300U );
+    BOOST_CHECK_EQUAL( container.numCellDataComponents("S") , 3U );
+    for (auto v : sat)
+        BOOST_CHECK_EQUAL( v , 2.0 );
+
+    // Every field starts on a cache line boundary.
+    BOOST_CHECK_EQUAL( reinterpret_cast<std::uintptr_t>( container.cellView( p ).data() ) % 64 , 0U );
+    BOOST_CHECK_EQUAL( reinterpret_cast<std::uintptr_t>( sat.data() ) % 64 , 0U );
+    BOOST_CHECK_EQUAL( reinterpret_cast<std::uintptr_t>( container.faceView( f ).data() ) % 64 , 0U );
+
+    container.cellView( p )[5] = 42;
+    for (int i = 0; i < 20; i++)
+        container.registerCellData("X" + std::to_string(i) , 2 , i );
+    BOOST_CHECK_EQUAL( container.cellView("P")[5] , 42 );
+    BOOST_CHECK_EQUAL( container.cellView("S")[299] , 2.0 );
+    BOOST_CHECK_EQUAL( container.cellView("X19")[199] , 19 );
+
+    SimulationDataContainer copy( container );
+    BOOST_CHECK( copy.equal( container ));
+    BOOST_CHECK_EQUAL( copy.cellView( p )[5] , 42 );
+    copy.cellView( p )[5] = 0;
+    BOOST_CHECK( !copy.equal( container ));
+    BOOST_CHECK_EQUAL( container.cellView( p )[5] , 42 );
+
+    SimulationDataContainer vectors(100 , 10 , FieldStorage::Vector);
+    vectors.registerCellData("P" , 1 , 1.0 );
+    vectors.swap( copy );
+    BOOST_CHECK( vectors.storage() == FieldStorage::Arena );
+    BOOST_CHECK_EQUAL( copy.getCellData("P").size() , 100U );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestMappedStorage) {
+    {
+        SimulationDataContainer container(1000 , 10 , FieldStorage::Mapped);
+        CellFieldId p = container.registerCellData("P" , 1 , 1.0 );
+        CellFieldId s = container.registerCellData("S" , 3 , 0.0 );
+        BOOST_CHECK_THROW( container.getCellData( p ) , std::logic_error );
+        BOOST_CHECK_EQUAL( container.cellView( s ).size() , 3000U );
+        BOOST_CHECK_EQUAL( container.cellView( s )[2999] , 0.0 );
+        BOOST_CHECK_EQUAL( container.cellView( p )[999] , 1.0 );
+        BOOST_CHECK_EQUAL( reinterpret_cast<std::uintptr_t>( container.cellView( s ).data() ) % 4096 , 0U );
+        container.adviseCellData( s , FieldAdvice::Cold );
+        container.adviseCellData( p , FieldAdvice::WillNeed );
+
+        SimulationDataContainer copy( container );
+        copy.cellView( p )[0] = 5;
+        BOOST_CHECK_EQUAL( container.cellView( p )[0] , 1.0 );
+        BOOST_CHECK( !copy.equal( container ));
+    }
+
+    const std::string path = "test_mapped_storage.bin";
+    {
+        SimulationDataContainer container(100 , 20 , path );
+        CellFieldId p = container.registerCellData("PRESSURE" , 1 , 200.0 );
+        container.registerFaceData("FLUX" , 2 , 0.0 );
+        for (int i = 0; i < 10; i++)
+            container.registerCellData("X" + std::to_string(i) , 1 , i );
+        container.cellView( p )[7] = 7;
+        container.faceView("FLUX")[39] = 39;
+    }
+    {
+        SimulationDataContainer container( path );
+        BOOST_CHECK_EQUAL( container.numCells() , 100U );
+        BOOST_CHECK_EQUAL( container.numFaces() , 20U );
+        BOOST_CHECK( container.storage() == FieldStorage::Mapped );
+        BOOST_CHECK_EQUAL( container.cellFieldId("PRESSURE").index() , 0U );
+        BOOST_CHECK_EQUAL( container.numCellDataComponents("PRESSURE") , 1U );
+        BOOST_CHECK_EQUAL( container.cellView("PRESSURE")[7] , 7 );
+        BOOST_CHECK_EQUAL( container.cellView("PRESSURE")[8] , 200 );
+        BOOST_CHECK_EQUAL( container.cellView("X9")[99] , 9 );
+        BOOST_CHECK_EQUAL( container.faceView("FLUX").size() , 40U );
+        BOOST_CHECK_EQUAL( container.faceView("FLUX")[39] , 39 );
+    }
+
+    // Directory entries which do not fit the file are rejected. The
+    // first entry starts at data_end, which follows the magic, the
+    // version, the endian mark and the cell and face counts.
+    std::vector<char> bytes;
+    {
+        std::FILE* file = std::fopen( path.c_str() , "rb" );
+        int c;
+        while ((c = std::fgetc( file )) != EOF)
+            bytes.push_back( static_cast<char>( c ));
+        std::fclose( file );
+    }
+    uint64_t data_end;
+    std::memcpy( &data_end , bytes.data() + 32 , sizeof data_end );
+    const std::string corrupt = "test_mapped_storage_corrupt.bin";
+    auto check_corrupt = [&]( size_t position , uint64_t value , size_t size ) {
+        std::vector<char> patched( bytes );
+        std::memcpy( patched.data() + data_end + position , &value , size );
+        std::FILE* file = std::fopen( corrupt.c_str() , "wb" );
+        std::fwrite( patched.data() , 1 , patched.size() , file );
+        std::fclose( file );
+        BOOST_CHECK_THROW( SimulationDataContainer container( corrupt ) , std::runtime_error );
+    };
+    check_corrupt( 0 , 2 , 4 );                           // entity
+    check_corrupt( 8 , uint64_t(1) << 62 , 8 );           // components
+    check_corrupt( 16 , uint64_t(0) - 8 , 8 );            // offset
+    check_corrupt( 24 , 101 , 8 );                        // count
+    std::remove( corrupt.c_str() );
+
+    std::remove( path.c_str() );
+    BOOST_CHECK_THROW( SimulationDataContainer container( path ) , std::runtime_error );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestSaveLoad) {
+    const std::string path = "test_save_load.bin";
+    SimulationDataContainer container(1000 , 100 , FieldStorage::Vector);
+    registerDefaultFields( container , 3 );
+    container.registerCellData("FIELDX" , 2 , 1.5 );
+    auto& pressure = container.getCellData("PRESSURE");
+    for (size_t i = 0; i < pressure.size(); i++)
+        pressure[i] = i;
+    container.getFaceData("FACEFLUX")[99] = -1;
+    container.save( path );
+
+    SimulationDataContainer loaded(1 , 1 , FieldStorage::Arena);
+    loaded.load( path );
+    BOOST_CHECK( loaded.storage() == FieldStorage::Mapped );
+    BOOST_CHECK_EQUAL( loaded.numCells() , 1000U );
+    BOOST_CHECK_EQUAL( loaded.numFaces() , 100U );
+    BOOST_CHECK( loaded.equal( container ));
+    BOOST_CHECK_EQUAL( loaded.numCellDataComponents("SATURATION") , 3U );
+    BOOST_CHECK( loaded.cellFieldId("FIELDX") == container.cellFieldId("FIELDX") );
+    for (const char* name : { "PRESSURE" , "SATURATION" , "TEMPERATURE" , "FIELDX" }) {
+        const auto& expected = container.getCellData( name );
+        auto actual = loaded.cellView( name );
+        BOOST_CHECK_EQUAL_COLLECTIONS( actual.begin() , actual.end() , expected.begin() , expected.end() );
+    }
+    BOOST_CHECK_EQUAL( loaded.faceView("FACEFLUX")[99] , -1 );
+
+    // The mapping is private; changes do not reach the file.
+    loaded.cellView("PRESSURE")[0] = 100;
+    loaded.registerCellData("NEW" , 1 , 2 );
+    BOOST_CHECK_EQUAL( loaded.cellView("PRESSURE")[0] , 100 );
+    SimulationDataContainer reloaded(1 , 1 , FieldStorage::Vector);
+    reloaded.load( path );
+    BOOST_CHECK_EQUAL( reloaded.cellView("PRESSURE")[0] , 0 );
+    BOOST_CHECK( !reloaded.hasCellData("NEW") );
+
+    // Saving a loaded container round trips.
+    loaded.save( path );
+    reloaded.load( path );
+    BOOST_CHECK( reloaded.equal( loaded ));
+    std::remove( path.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestDeltaCheckpoints) {
+    const std::string base = "test_delta_base.bin";
+    const std::string delta1 = "test_delta_1.bin";
+    const std::string delta2 = "test_delta_2.bin";
+    const std::string delta3 = "test_delta_3.bin";
+    SimulationDataContainer container(1000 , 100 , FieldStorage::Vector);
+    registerDefaultFields( container , 3 );
+    container.setDirtyChunkSize( 64 );
+    BOOST_CHECK_EQUAL( container.dirtyChunkSize() , 64U );
+    BOOST_CHECK_THROW( container.setDirtyChunkSize( 12 ) , std::invalid_argument );
+    // The full checkpoint marks all fields as unchanged.
+    const auto& const_container = container;
+    const_container.save( base );
+
+    // Step 1: a few values through scatterCellData() and an explicitly
+    // marked range.
+    const int32_t cells[] = { 3 , 500 };
+    const double saturations[] = { 0.25 , 0.75 };
+    container.scatterCellData( container.cellFieldId("SATURATION") , 1 , cells , saturations , 2 );
+    const auto pressure = container.cellFieldId("PRESSURE");
+    SimulationDataContainer copy( container );
+    auto values = container.untrackedCellView( pressure );
+    values[20] = 20;
+    values[21] = 21;
+    container.markCellDataDirty( pressure , 20 , 22 );
+    BOOST_CHECK_EQUAL( copy.cellView( pressure )[20] , 0 );
+    container.saveDelta( delta1 );
+
+    // Step 2: a new field, and mutable access to a face field.
+    container.registerCellData("NEW" , 2 , 1.5);
+    container.getFaceData("FACEFLUX")[99] = -1;
+    const auto temperature = container.cellFieldId("TEMPERATURE");
+    auto old_view = container.cellView( temperature );
+    container.saveDelta( delta2 );
+
+    // Step 3: writes through a view obtained before the delta reach the
+    // next one once the view is obtained again.
+    old_view[6] = 6;
+    container.cellView( temperature )[7] = 7;
+    container.saveDelta( delta3 );
+
+    // Two chunks of SATURATION and one of PRESSURE, 8 values each.
+    {
+        std::FILE* file = std::fopen( delta1.c_str() , "rb" );
+        std::fseek( file , 0 , SEEK_END );
+        const long size = std::ftell( file );
+        std::fclose( file );
+        BOOST_CHECK( size < 600 );
+    }
+
+    SimulationDataContainer restored(1 , 1 , FieldStorage::Vector);
+    const auto& view = restored;
+    restored.load( base );
+    restored.applyDelta( delta1 );
+    BOOST_CHECK_EQUAL( view.cellView("SATURATION")[3 * 3 + 1] , 0.25 );
+    BOOST_CHECK_EQUAL( view.cellView("PRESSURE")[21] , 21 );
+    BOOST_CHECK( !view.hasCellData("NEW") );
+    restored.applyDelta( delta2 );
+    restored.applyDelta( delta3 );
+    BOOST_CHECK_EQUAL( view.cellView( temperature )[6] , 6 );
+    BOOST_CHECK_EQUAL( view.cellView( temperature )[7] , 7 );
+    for (const char* name : { "PRESSURE" , "SATURATION" , "TEMPERATURE" , "NEW" }) {
+        const auto& expected = container.getCellData( name );
+        auto actual = view.cellView( name );
+        BOOST_CHECK_EQUAL_COLLECTIONS( actual.begin() , actual.end() , expected.begin() , expected.end() );
+    }
+    BOOST_CHECK_EQUAL( view.faceView("FACEFLUX")[99] , -1 );
+
+    // Applying the deltas does not mark anything as dirty.
+    restored.saveDelta( delta1 );
+    SimulationDataContainer empty(1000 , 100 , FieldStorage::Arena);
+    empty.applyDelta( delta1 );
+    BOOST_CHECK( !empty.hasCellData("PRESSURE") );
+
+    SimulationDataContainer mismatch(10 , 100 , FieldStorage::Arena);
+    BOOST_CHECK_THROW( mismatch.applyDelta( delta2 ) , std::invalid_argument );
+    BOOST_CHECK_THROW( mismatch.applyDelta( base ) , std::runtime_error );
+    std::remove( base.c_str() );
+    std::remove( delta1.c_str() );
+    std::remove( delta2.c_str() );
+    std::remove( delta3.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestCopyOnWrite) {
+    SimulationDataContainer container(100 , 10 , FieldStorage::Vector);
+    registerDefaultFields( container , 2 );
+    const auto& const_container = container;
+    auto pressure = container.cellFieldId("PRESSURE");
+    const int32_t first = 0;
+    const double one = 1;
+    container.scatterCellData( pressure , 0 , &first , &one , 1 );
+
+    // The copy shares the values until one of them writes.
+    SimulationDataContainer copy( container );
+    const auto& const_copy = copy;
+    BOOST_CHECK_EQUAL( const_copy.cellView( pressure ).data() , const_container.cellView( pressure ).data() );
+    copy.getCellData( pressure )[0] = 2;
+    BOOST_CHECK( const_copy.cellView( pressure ).data() != const_container.cellView( pressure ).data() );
+    BOOST_CHECK_EQUAL( const_container.cellView( pressure )[0] , 1 );
+    BOOST_CHECK_EQUAL( const_copy.cellView( pressure )[0] , 2 );
+
+    // The key accessors follow the duplicated fields.
+    BOOST_CHECK_EQUAL( const_copy.get<FieldKeys::Pressure>()[0] , 2 );
+    copy.get<FieldKeys::Saturation>()[3] = 0.5;
+    const int32_t cell = 2;
+    const double saturation = 0.25;
+    copy.scatterCellData( copy.cellFieldId("SATURATION") , 1 , &cell , &saturation , 1 );
+    BOOST_CHECK_EQUAL( const_copy.get<FieldKeys::Saturation>()[3] , 0.5 );
+    BOOST_CHECK_EQUAL( const_copy.get<FieldKeys::Saturation>()[5] , 0.25 );
+    BOOST_CHECK_EQUAL( const_container.get<FieldKeys::Saturation>()[3] , 0 );
+    BOOST_CHECK_EQUAL( const_container.get<FieldKeys::Saturation>()[5] , 0 );
+    container.get<FieldKeys::FaceFlux>()[1] = 3;
+    BOOST_CHECK_EQUAL( const_copy.get<FieldKeys::FaceFlux>()[1] , 0 );
+
+    // Assignment shares as well; the source is unchanged by writes.
+    copy = container;
+    BOOST_CHECK( copy.equal( container ));
+    copy.get<FieldKeys::Pressure>()[0] = 4;
+    BOOST_CHECK_EQUAL( const_container.get<FieldKeys::Pressure>()[0] , 1 );
+
+    // Arena fields are duplicated into a buffer of their own.
+    SimulationDataContainer arena(100 , 10 , FieldStorage::Arena);
+    auto x = arena.registerCellData("X" , 1 , 1.0);
+    auto y = arena.registerCellData("Y" , 3 , 2.0);
+    SimulationDataContainer arena_copy( arena );
+    arena_copy.cellView( x )[0] = 5;
+    arena_copy.registerCellData("Z" , 1 , 3.0);
+    arena.cellView( y )[299] = 6;
+    BOOST_CHECK_EQUAL( arena.cellView( x )[0] , 1 );
+    BOOST_CHECK_EQUAL( arena_copy.cellView( x )[0] , 5 );
+    BOOST_CHECK_EQUAL( arena_copy.cellView( y )[299] , 2 );
+    BOOST_CHECK_EQUAL( arena.cellView( y )[299] , 6 );
+    BOOST_CHECK_EQUAL( arena_copy.cellView("Z")[99] , 3 );
+    BOOST_CHECK( !arena.hasCellData("Z") );
+
+    // References and views obtained before a copy keep writing to their
+    // own container only.
+    std::vector<double>& reference = container.getCellData( pressure );
+    SimulationDataContainer deep( container );
+    const auto& const_deep = deep;
+    BOOST_CHECK( const_deep.cellView( pressure ).data() != const_container.cellView( pressure ).data() );
+    reference[1] = 7;
+    BOOST_CHECK_EQUAL( const_container.cellView( pressure )[1] , 7 );
+    BOOST_CHECK_EQUAL( const_deep.cellView( pressure )[1] , 0 );
+    deep.getCellData( pressure )[2] = 8;
+    BOOST_CHECK_EQUAL( reference[2] , 0 );
+
+    auto x_view = arena.cellView( x );
+    SimulationDataContainer arena_deep( arena );
+    x_view[1] = 9;
+    BOOST_CHECK_EQUAL( arena.cellView( x )[1] , 9 );
+    BOOST_CHECK_EQUAL( arena_deep.cellView( x )[1] , 1 );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestCellDataMap) {
+    SimulationDataContainer container(10 , 5 , FieldStorage::Vector);
+    const auto& const_container = container;
+    auto p = container.registerCellData("P" , 1 , 1.0 );
+    container.registerCellData("S" , 2 , 0.5 );
+
+    // The const map is a copy until the mutable one holds the fields.
+    BOOST_CHECK_EQUAL( const_container.cellData().size() , 2U );
+    BOOST_CHECK_EQUAL( const_container.cellData().at("S")[19] , 0.5 );
+    auto& map = container.cellData();
+    BOOST_CHECK_EQUAL( &map , &const_container.cellData() );
+    map["P"][3] = 3;
+    BOOST_CHECK_EQUAL( const_container.cellView( p )[3] , 3 );
+    container.getCellData( p )[4] = 4;
+    BOOST_CHECK_EQUAL( map["P"][4] , 4 );
+
+    // Copies do not share the vectors of the map.
+    SimulationDataContainer copy( container );
+    map["P"][5] = 5;
+    BOOST_CHECK_EQUAL( copy.cellView( p )[5] , 1 );
+    copy.getCellData( p )[6] = 6;
+    BOOST_CHECK_EQUAL( map["P"][6] , 1 );
+
+    // New fields join the map on the next mutable call.
+    auto t = container.registerCellData("T" , 1 , 2.0 );
+    BOOST_CHECK( &map != &const_container.cellData() );
+    BOOST_CHECK_EQUAL( const_container.cellData().at("T")[9] , 2 );
+    container.cellData()["T"][9] = 9;
+    BOOST_CHECK_EQUAL( const_container.cellView( t )[9] , 9 );
+
+    SimulationDataContainer arena(10 , 5 , FieldStorage::Arena);
+    arena.registerCellData("P" , 1 , 1.0 );
+    BOOST_CHECK_THROW( arena.cellData() , std::logic_error );
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotRestore) {
+    SimulationDataContainer container(1000 , 100 , FieldStorage::Arena);
+    auto x = container.registerCellData("X" , 3 , 1.0);
+    auto flux = container.registerFaceData("FLUX" , 1 , 2.0);
+    SimulationDataContainer expected( container );
+
+    SnapshotSlot slot;
+    BOOST_CHECK( !slot.valid() );
+    BOOST_CHECK_THROW( container.restore( slot ) , std::logic_error );
+    container.snapshot( slot );
+    const size_t capacity = slot.capacity();
+    container.cellView( x )[10] = 5;
+    container.faceView( flux )[99] = -1;
+    auto y = container.registerCellData("Y" , 1 , 3.0);
+    container.restore( slot );
+    BOOST_CHECK_EQUAL( container.cellView( x )[10] , 1 );
+    BOOST_CHECK_EQUAL( container.faceView( flux )[99] , 2 );
+    BOOST_CHECK_EQUAL( container.cellView( y )[0] , 3 );
+
+    // The buffer grows for the new field, and is reused afterwards.
+    container.snapshot( slot );
+    const size_t grown = slot.capacity();
+    BOOST_CHECK_EQUAL( grown , capacity + AlignedBuffer::padded(1000 * sizeof(double)) );
+    container.cellView( x )[10] = 6;
+    container.snapshot( slot );
+    BOOST_CHECK_EQUAL( slot.capacity() , grown );
+    container.cellView( x )[10] = 7;
+    container.restore( slot );
+    BOOST_CHECK_EQUAL( container.cellView( x )[10] , 6 );
+
+    SimulationDataContainer other(1000 , 100 , FieldStorage::Vector);
+    BOOST_CHECK_THROW( other.restore( slot ) , std::invalid_argument );
+    other.registerCellData("X" , 3 , 0.0);
+    other.registerCellData("Y" , 1 , 0.0);
+    other.registerFaceData("FLUX" , 1 , 0.0);
+    other.restore( slot );
+    BOOST_CHECK_EQUAL( other.cellView( x )[10] , 6 );
+    BOOST_CHECK( other.equal( container ));
+    expected.cellView( x )[10] = 6;
+    BOOST_CHECK( !expected.equal( container ));
+}
+
+
+BOOST_AUTO_TEST_CASE(TestCompare) {
+    SimulationDataContainer container(100000 , 10 , FieldStorage::Vector);
+    auto x = container.registerCellData("X" , 1 , 1.0);
+    container.registerCellData("Y" , 2 , 0.0);
+    auto flux = container.registerFaceData("FLUX" , 1 , 2.0);
+    SimulationDataContainer other( container );
+    BOOST_CHECK( other.equal( container ));
+    BOOST_CHECK( other.compare( container ).equal() );
+
+    other.cellView( x )[70000] = 1.5;
+    other.cellView( x )[20000] = 1.1;
+    other.cellView( x )[90000] = 1 + 1e-4;
+    other.faceView( flux )[3] = 2 + 1e-9;
+    other.registerCellData("Z" , 1 , 0.0);
+    container.registerFaceData("W" , 2 , 0.0);
+    BOOST_CHECK( !other.equal( container ));
+
+    auto report = container.compare( other );
+    BOOST_CHECK( report.sizes_equal );
+    BOOST_CHECK( !report.equal() );
+    BOOST_CHECK_EQUAL( report.cell_fields.size() , 3U );
+    const auto& dx = report.cell_fields[0];
+    BOOST_CHECK_EQUAL( dx.name , "X" );
+    BOOST_CHECK( dx.status == FieldDifference::Status::Compared );
+    BOOST_CHECK_EQUAL( dx.count , 100000U );
+    BOOST_CHECK_EQUAL( dx.mismatches , 3U );
+    BOOST_CHECK_EQUAL( dx.first_mismatch , 20000U );
+    BOOST_CHECK_EQUAL( dx.worst_mismatch , 70000U );
+    BOOST_CHECK_CLOSE( dx.max_abs_error , 0.5 , 1e-10 );
+    BOOST_CHECK_CLOSE( dx.max_rel_error , 0.5 / 1.5 , 1e-10 );
+    BOOST_CHECK( report.cell_fields[1].equal() );
+    BOOST_CHECK_EQUAL( report.cell_fields[2].name , "Z" );
+    BOOST_CHECK( report.cell_fields[2].status == FieldDifference::Status::Missing );
+
+    // Differences within the tolerance are reported, but do not count
+    // as mismatches.
+    BOOST_CHECK_EQUAL( report.face_fields.size() , 2U );
+    BOOST_CHECK( report.face_fields[0].equal() );
+    BOOST_CHECK( report.face_fields[0].max_abs_error > 0 );
+    BOOST_CHECK( report.face_fields[1].status == FieldDifference::Status::Missing );
+
+    // With a looser tolerance only the larger differences mismatch.
+    const auto loose = container.compare( other , 1e-3 , 1e-3 );
+    BOOST_CHECK_EQUAL( loose.cell_fields[0].mismatches , 2U );
+
+    SimulationDataContainer smaller(10 , 10 , FieldStorage::Vector);
+    BOOST_CHECK( !container.compare( smaller ).sizes_equal );
+
+    // Fields of different types compare in the wider type, the same
+    // either way round.
+    SimulationDataContainer single( container );
+    SimulationDataContainer twice( container );
+    single.convertCellData( x , FieldType::Int16 );
+    BOOST_CHECK( single.equal( twice ));
+    BOOST_CHECK( twice.equal( single ));
+    twice.cellView( x )[5] = 1.5;
+    BOOST_CHECK( !single.equal( twice ));
+    BOOST_CHECK( !twice.equal( single ));
+    BOOST_CHECK_EQUAL( single.compare( twice ).cell_fields[0].first_mismatch , 5U );
+    BOOST_CHECK_EQUAL( twice.compare( single ).cell_fields[0].first_mismatch , 5U );
+
+    // Sparse fields are compared too.
+    auto wells = twice.registerSparseCellData("WELLS" , 1 , { 3 , 7 } , 1.0 );
+    single.registerSparseCellData("WELLS" , 1 , { 3 , 8 } , 1.0 );
+    SimulationDataContainer same( twice );
+    twice.sparseCellData( wells ).set( 7 , 0 , 2.0 );
+    const auto sparse = twice.compare( same );
+    BOOST_CHECK( !sparse.equal() );
+    BOOST_CHECK_EQUAL( sparse.sparse_cell_fields.size() , 1U );
+    BOOST_CHECK_EQUAL( sparse.sparse_cell_fields[0].mismatches , 1U );
+    BOOST_CHECK_EQUAL( sparse.sparse_cell_fields[0].first_mismatch , 1U );
+    BOOST_CHECK( twice.compare( single ).sparse_cell_fields[0].status == FieldDifference::Status::SizeMismatch );
+    BOOST_CHECK( container.compare( same ).sparse_cell_fields[0].status == FieldDifference::Status::Missing );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestScatterGather) {
+    SimulationDataContainer container(1000 , 10 , FieldStorage::Arena);
+    auto x = container.registerCellData("X" , 4 , 0.0);
+    const std::vector<int32_t> cells32 = { 1 , 5 , 999 };
+    const std::vector<int64_t> cells64 = { 999 , 0 };
+    const std::vector<double> values = { 1 , 5 , 999 };
+
+    container.scatterCellData( x , 3 , cells32.data() , values.data() , cells32.size() );
+    BOOST_CHECK_EQUAL( container.cellView( x )[4 * 5 + 3] , 5 );
+    BOOST_CHECK_EQUAL( container.cellView( x )[4 * 999 + 3] , 999 );
+    BOOST_CHECK_EQUAL( container.cellView( x )[4 * 5 + 2] , 0 );
+
+    std::vector<double> gathered(2);
+    container.gatherCellData( x , 3 , cells64.data() , gathered.data() , gathered.size() );
+    BOOST_CHECK_EQUAL( gathered[0] , 999 );
+    BOOST_CHECK_EQUAL( gathered[1] , 0 );
+    container.gatherCellData( x , 3 , cells32.data() , gathered.data() , 2 , IndexCheck::Unchecked );
+    BOOST_CHECK_EQUAL( gathered[1] , 5 );
+    container.scatterCellData( x , 0 , cells64.data() , values.data() , 2 , IndexCheck::Unchecked );
+    BOOST_CHECK_EQUAL( container.cellView( x )[0] , 5 );
+
+    // Invalid input is rejected before anything is written.
+    const std::vector<int32_t> invalid = { 2 , -1 };
+    const std::vector<int64_t> too_large = { 3 , 1000 };
+    BOOST_CHECK_THROW( container.scatterCellData( x , 0 , invalid.data() , values.data() , 2 ) , std::invalid_argument );
+    BOOST_CHECK_THROW( container.scatterCellData( x , 0 , too_large.data() , values.data() , 2 ) , std::invalid_argument );
+    BOOST_CHECK_THROW( container.gatherCellData( x , 4 , cells32.data() , gathered.data() , 2 ) , std::invalid_argument );
+    BOOST_CHECK_EQUAL( container.cellView( x )[8] , 0 );
+    BOOST_CHECK_EQUAL( container.cellView( x )[12] , 0 );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestComponentViews) {
+    SimulationDataContainer container(100 , 10 , FieldStorage::Vector);
+    registerDefaultFields( container , 3 );
+    auto saturation = container.cellComponentView("SATURATION" , 1);
+    BOOST_CHECK_EQUAL( saturation.size() , 100U );
+    BOOST_CHECK_EQUAL( saturation.stride() , 3U );
+    saturation.fill( 0.5 );
+    saturation[2] = 0.25;
+    BOOST_CHECK_EQUAL( container.getCellData("SATURATION")[3 * 2 + 1] , 0.25 );
+    BOOST_CHECK_EQUAL( container.getCellData("SATURATION")[3 * 2] , 0 );
+
+    // Iteration and standard algorithms.
+    size_t count = 0;
+    for (double value : saturation)
+        count += value == 0.5;
+    BOOST_CHECK_EQUAL( count , 99U );
+    BOOST_CHECK_EQUAL( std::distance( saturation.begin() , saturation.end() ) , 100 );
+    BOOST_CHECK( *std::min_element( saturation.begin() , saturation.end() ) == 0.25 );
+
+    // Bulk operations between strided and contiguous views.
+    auto water = container.cellComponentView( container.cellFieldId("SATURATION") , 0 );
+    auto pressure = container.cellComponentView("PRESSURE" , 0);
+    BOOST_CHECK_EQUAL( pressure.stride() , 1U );
+    pressure.fill( 2 );
+    water.assign( pressure );
+    water.axpy( 0.5 , saturation );
+    BOOST_CHECK_EQUAL( water[2] , 2.125 );
+    BOOST_CHECK_EQUAL( water[3] , 2.25 );
+    pressure.axpy( -1 , StridedView<const double>( pressure ));
+    BOOST_CHECK_EQUAL( pressure[99] , 0 );
+
+    std::vector<double> values(100);
+    const auto& const_container = container;
+    const_container.cellComponentView("SATURATION" , 1).copyTo( values.data() );
+    BOOST_CHECK_EQUAL( values[2] , 0.25 );
+    values[5] = 0.75;
+    saturation.assign( values.data() );
+    BOOST_CHECK_EQUAL( container.getCellData("SATURATION")[3 * 5 + 1] , 0.75 );
+
+    BOOST_CHECK_THROW( container.cellComponentView("SATURATION" , 3) , std::invalid_argument );
+    BOOST_CHECK_THROW( water.assign( container.faceComponentView("FACEFLUX" , 0) ) , std::invalid_argument );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldLayouts) {
+    BOOST_CHECK_THROW( FieldLayout::aosoa( 0 ) , std::invalid_argument );
+    const FieldLayout aosoa = FieldLayout::aosoa( 4 );
+    BOOST_CHECK_EQUAL( aosoa.count( 10 , 3 ) , 36U );
+    BOOST_CHECK_EQUAL( aosoa.index( 5 , 2 , 10 , 3 ) , 12U + 8U + 1U );
+    BOOST_CHECK_EQUAL( FieldLayout::planar().index( 5 , 2 , 10 , 3 ) , 25U );
+
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena , FieldStorage::Mapped }) {
+        SimulationDataContainer container(10 , 4 , storage);
+        CellFieldId s = container.registerCellData("S" , 3 , 1.0 , aosoa );
+        CellFieldId p = container.registerCellData("P" , 3 , 0.0 , FieldLayout::planar() );
+        BOOST_CHECK( container.cellLayout( s ) == aosoa );
+        BOOST_CHECK( container.cellLayout( p ) == FieldLayout::planar() );
+        BOOST_CHECK_EQUAL( container.cellView( s ).size() , 36U );
+        // The padding of the last block is zero.
+        BOOST_CHECK_EQUAL( container.cellView( s )[2 * 12 + 2] , 0 );
+        BOOST_CHECK_EQUAL( container.cellView( s )[2 * 12 + 1] , 1 );
+
+        // Component views hide the layout.
+        for (size_t component = 0; component < 3; component++) {
+            auto view = container.cellComponentView( s , component );
+            BOOST_CHECK_EQUAL( view.size() , 10U );
+            for (size_t cell = 0; cell < 10; cell++)
+                view[cell] = 10 * cell + component;
+        }
+        BOOST_CHECK_EQUAL( container.cellView( s )[aosoa.index( 9 , 1 , 10 , 3 )] , 91 );
+        container.cellComponentView( p , 1 ).assign( container.cellComponentView( s , 1 ));
+        container.cellComponentView( p , 1 ).axpy( 1 , container.cellComponentView( s , 2 ));
+        BOOST_CHECK_EQUAL( container.cellView( p )[10 + 7] , 71 + 72 );
+
+        const int32_t cells[] = { 9 , 0 , 4 };
+        const double values[] = { -9 , -1 , -4 };
+        double gathered[3];
+        container.scatterCellData( s , 2 , cells , values , 3 );
+        container.gatherCellData( s , 2 , cells , gathered , 3 );
+        BOOST_CHECK_EQUAL_COLLECTIONS( gathered , gathered + 3 , values , values + 3 );
+        BOOST_CHECK_EQUAL( container.cellComponentView( s , 2 )[4] , -4 );
+
+        // Changing the layout keeps the values, and containers with
+        // different layouts compare by value.
+        SimulationDataContainer copy( container );
+        container.relayoutCellData( p , FieldLayout::interleaved() );
+        BOOST_CHECK_EQUAL( container.cellView( p )[7 * 3 + 1] , 71 + 72 );
+        BOOST_CHECK( copy.cellLayout( p ) == FieldLayout::planar() );
+        BOOST_CHECK( container.equal( copy ));
+        BOOST_CHECK( container.compare( copy ).equal() );
+        if (storage == FieldStorage::Mapped) {
+            BOOST_CHECK_THROW( container.relayoutCellData( s , FieldLayout::planar() ) , std::logic_error );
+        } else {
+            container.relayoutCellData( s , FieldLayout::planar() );
+            BOOST_CHECK_EQUAL( container.cellView( s ).size() , 30U );
+            BOOST_CHECK_EQUAL( container.cellView( s )[2 * 10 + 4] , -4 );
+            BOOST_CHECK( container.equal( copy ));
+        }
+        container.cellComponentView( s , 0 )[3] = -30;
+        BOOST_CHECK( !container.equal( copy ));
+        BOOST_CHECK_EQUAL( container.compare( copy ).cell_fields[0].mismatches , 1U );
+    }
+
+    // The layout is saved with the fields.
+    const std::string path = "test_field_layouts.bin";
+    SimulationDataContainer container(10 , 4 , FieldStorage::Vector);
+    container.registerCellData("S" , 2 , 0.5 , FieldLayout::aosoa( 8 ) );
+    container.registerFaceData("F" , 2 , 0.0 , FieldLayout::planar() );
+    container.faceComponentView("F" , 1)[3] = 3;
+    container.save( path );
+    SimulationDataContainer loaded( path );
+    BOOST_CHECK( loaded.cellLayout( loaded.cellFieldId("S") ) == FieldLayout::aosoa( 8 ) );
+    BOOST_CHECK( loaded.faceLayout( loaded.faceFieldId("F") ) == FieldLayout::planar() );
+    BOOST_CHECK_EQUAL( loaded.faceView("F")[4 + 3] , 3 );
+    BOOST_CHECK( loaded.equal( container ));
+    std::remove( path.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldTypes) {
+    const std::string path = "test_field_types.bin";
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena , FieldStorage::Mapped }) {
+        SimulationDataContainer container(100 , 10 , storage);
+        CellFieldId p = container.registerCellData("P" , 1 , 1.0 );
+        CellFieldId x = container.registerCellData("X" , 2 , 0.5 , FieldLayout() , FieldType::Float32 );
+        FaceFieldId f = container.registerFaceData("F" , 1 , 0.0 , FieldLayout::planar() , FieldType::Float32 );
+        BOOST_CHECK( container.cellType( p ) == FieldType::Float64 );
+        BOOST_CHECK( container.cellType( x ) == FieldType::Float32 );
+        BOOST_CHECK_THROW( container.cellView( x ) , std::logic_error );
+        BOOST_CHECK_THROW( container.cellView<float>( p ) , std::logic_error );
+        BOOST_CHECK_THROW( container.getCellData("X") , std::logic_error );
+
+        auto values = container.cellView<float>( x );
+        BOOST_CHECK_EQUAL( values.size() , 200U );
+        BOOST_CHECK_EQUAL( values[199] , 0.5f );
+        container.cellComponentView<float>( x , 1 )[10] = 0.25f;
+        BOOST_CHECK_EQUAL( values[21] , 0.25f );
+        container.faceView<float>( f )[9] = 9;
+
+        // Scatter and gather convert from and to double.
+        const int32_t cells[] = { 3 , 7 };
+        const double input[] = { 0.1 , 1e40 };
+        double output[2];
+        container.scatterCellData( x , 0 , cells , input , 2 );
+        container.gatherCellData( x , 0 , cells , output , 2 );
+        BOOST_CHECK_EQUAL( output[0] , double(0.1f) );
+        BOOST_CHECK( std::isinf( output[1] ));
+        container.cellComponentView<float>( x , 0 )[7] = 7;
+
+        // Copies, snapshots, compression and comparison.
+        SimulationDataContainer copy( container );
+        BOOST_CHECK( copy.equal( container ));
+        SnapshotSlot slot;
+        container.snapshot( slot );
+        const std::vector<char> compressed = container.compressCellData( x );
+        container.cellView<float>( x )[0] = -1;
+        BOOST_CHECK( !copy.equal( container ));
+        BOOST_CHECK_EQUAL( container.compare( copy ).cell_fields[1].mismatches , 1U );
+        BOOST_CHECK_EQUAL( copy.cellView<float>( x )[0] , 0.5f );
+        container.decompressCellData( x , compressed );
+        BOOST_CHECK( copy.equal( container ));
+        container.cellView<float>( x )[1] = -1;
+        container.restore( slot );
+        BOOST_CHECK( copy.equal( container ));
+
+        // Changing the type keeps the values, up to rounding, and
+        // fields of different types compare by value.
+        if (storage == FieldStorage::Mapped) {
+            BOOST_CHECK_THROW( container.convertCellData( p , FieldType::Float32 ) , std::logic_error );
+        } else {
+            container.cellView( p )[5] = 1.0 / 3;
+            container.convertCellData( p , FieldType::Float32 );
+            BOOST_CHECK_EQUAL( container.cellView<float>( p )[5] , 1.0f / 3 );
+            BOOST_CHECK( !container.equal( copy ));
+            container.cellView<float>( p )[5] = 1;
+            BOOST_CHECK( container.equal( copy ));
+            container.convertCellData( x , FieldType::Float64 );
+            BOOST_CHECK_EQUAL( container.cellComponentView( x , 1 )[10] , 0.25 );
+            BOOST_CHECK( container.equal( copy ));
+            BOOST_CHECK_THROW( container.restore( slot ) , std::invalid_argument );
+        }
+
+        container.save( path );
+        SimulationDataContainer loaded( path );
+        BOOST_CHECK( loaded.cellType( loaded.cellFieldId("X") ) == container.cellType( x ));
+        BOOST_CHECK( loaded.faceType( f ) == FieldType::Float32 );
+        BOOST_CHECK_EQUAL( loaded.faceView<float>( f )[9] , 9 );
+        BOOST_CHECK( loaded.equal( container ));
+    }
+    std::remove( path.c_str() );
+
+    // Delta checkpoints carry the type.
+    const std::string delta = "test_field_types_delta.bin";
+    SimulationDataContainer base(10 , 2 , FieldStorage::Vector);
+    SimulationDataContainer next( base );
+    CellFieldId y = next.registerCellData("Y" , 1 , 2.0 , FieldLayout() , FieldType::Float32 );
+    next.cellView<float>( y )[3] = 3;
+    next.saveDelta( delta );
+    base.applyDelta( delta );
+    BOOST_CHECK( base.cellType( y ) == FieldType::Float32 );
+    BOOST_CHECK( base.equal( next ));
+
+    // A delta which cannot be applied as a whole changes nothing; here
+    // the type of Z cannot change while it keeps a history.
+    SimulationDataContainer target(10 , 2 , FieldStorage::Vector);
+    CellFieldId z = target.registerCellData("Z" , 1 , 1.0 );
+    target.setCellDataHistory( z , 1 );
+    next.cellView<float>( y )[4] = 4;
+    next.registerCellData("Z" , 1 , 0.0 , FieldLayout() , FieldType::Int32 );
+    next.saveDelta( delta );
+    BOOST_CHECK_THROW( target.applyDelta( delta ) , std::invalid_argument );
+    BOOST_CHECK( !target.hasCellData("Y") );
+    BOOST_CHECK( target.cellType( z ) == FieldType::Float64 );
+    BOOST_CHECK_EQUAL( target.cellView( z )[0] , 1.0 );
+    std::remove( delta.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestIntegerFields) {
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena , FieldStorage::Mapped }) {
+        SimulationDataContainer container(100 , 10 , storage);
+        CellFieldId region = container.registerCellData("FIPNUM" , 1 , 1.0 , FieldLayout() , FieldType::Int32 );
+        CellFieldId pvt = container.registerCellData("PVTNUM" , 2 , 2.0 , FieldLayout::planar() , FieldType::Int16 );
+        FaceFieldId kind = container.registerFaceData("KIND" , 1 , 3.0 , FieldLayout() , FieldType::UInt8 );
+        BOOST_CHECK( container.cellType( container.cellFieldId("FIPNUM") ) == FieldType::Int32 );
+        BOOST_CHECK_THROW( container.cellView<int16_t>( region ) , std::logic_error );
+        BOOST_CHECK_EQUAL( container.cellView<int32_t>( region )[99] , 1 );
+        BOOST_CHECK_EQUAL( container.cellView<int16_t>( pvt )[199] , 2 );
+        BOOST_CHECK_EQUAL( container.faceView<uint8_t>( kind )[9] , 3 );
+
+        container.cellView<int32_t>( region )[5] = 7;
+        container.cellComponentView<int16_t>( pvt , 1 )[4] = -4;
+        BOOST_CHECK_EQUAL( container.cellView<int16_t>( pvt )[104] , -4 );
+        const int32_t cells[] = { 8 , 9 };
+        const double input[] = { 12.0 , -3.0 };
+        double output[2];
+        container.scatterCellData( pvt , 0 , cells , input , 2 );
+        container.gatherCellData( pvt , 0 , cells , output , 2 );
+        BOOST_CHECK_EQUAL( output[0] , 12.0 );
+        BOOST_CHECK_EQUAL( output[1] , -3.0 );
+
+        // Integer values match only when they are equal.
+        SimulationDataContainer copy( container );
+        BOOST_CHECK( copy.equal( container ));
+        container.cellView<int32_t>( region )[6] = 2;
+        BOOST_CHECK( !copy.equal( container ));
+        const ComparisonReport report = container.compare( copy , 10.0 , 10.0 );
+        BOOST_CHECK_EQUAL( report.cell_fields[0].mismatches , 1U );
+        BOOST_CHECK_EQUAL( report.cell_fields[0].first_mismatch , 6U );
+        BOOST_CHECK_EQUAL( report.cell_fields[0].max_abs_error , 1.0 );
+        BOOST_CHECK_EQUAL( copy.cellView<int32_t>( region )[6] , 1 );
+        const std::vector<char> compressed = copy.compressCellData( region );
+        container.decompressCellData( region , compressed );
+        BOOST_CHECK( copy.equal( container ));
+
+        SimulationDataContainer other( 100 , 10 , FieldStorage::Vector );
+        other.swap( container );
+        BOOST_CHECK( other.equal( copy ));
+        BOOST_CHECK_EQUAL( container.numCells() , 100U );
+        BOOST_CHECK( !container.hasCellData("FIPNUM") );
+
+        if (storage != FieldStorage::Mapped) {
+            other.convertCellData( region , FieldType::Float64 );
+            BOOST_CHECK_EQUAL( other.cellView( region )[5] , 7.0 );
+            BOOST_CHECK( other.equal( copy ));
+            other.cellView( region )[5] = 7.75;
+            other.convertCellData( region , FieldType::UInt8 );
+            BOOST_CHECK_EQUAL( other.cellView<uint8_t>( region )[5] , 7 );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestBitFields) {
+    const std::string path = "test_bit_fields.bin";
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena , FieldStorage::Mapped }) {
+        SimulationDataContainer container(1000 , 10 , storage);
+        CellFieldId active = container.registerCellData("ACTIVE" , 1 , 1.0 , FieldLayout() , FieldType::Bit );
+        CellFieldId region = container.registerCellData("REGION" , 1 , 0.0 , FieldLayout() , FieldType::Bit );
+        CellFieldId p = container.registerCellData("P" , 1 , 0.0 );
+        BOOST_CHECK_THROW( container.registerCellData("BAD" , 1 , 0.0 , FieldLayout::planar() , FieldType::Bit ) , std::invalid_argument );
+        BOOST_CHECK_THROW( container.relayoutCellData( active , FieldLayout::planar() ) , std::logic_error );
+        BOOST_CHECK_THROW( container.cellBits( p ) , std::logic_error );
+        BOOST_CHECK_THROW( container.cellView<uint8_t>( active ) , std::logic_error );
+
+        auto bits = container.cellBits( active );
+        BOOST_CHECK_EQUAL( bits.size() , 1000U );
+        BOOST_CHECK_EQUAL( bits.numWords() , 16U );
+        BOOST_CHECK_EQUAL( bits.count() , 1000U );
+        for (size_t cell = 0; cell < 1000; cell += 3)
+            bits.reset( cell );
+        BOOST_CHECK_EQUAL( bits.count() , 666U );
+        BOOST_CHECK( !bits[999] );
+        BOOST_CHECK( bits[998] );
+
+        // The cells 0 - 499 which are active.
+        auto selected = container.cellBits( region );
+        for (size_t cell = 0; cell < 500; cell++)
+            selected.set( cell );
+        BOOST_CHECK_EQUAL( selected.countAnd( bits ) , 333U );
+        selected.assignAnd( bits );
+        BOOST_CHECK_EQUAL( selected.count() , 333U );
+        std::vector<int32_t> cells( selected.count() );
+        BOOST_CHECK_EQUAL( selected.indices( cells.data() ) , 333U );
+        BOOST_CHECK_EQUAL( cells[0] , 1 );
+        BOOST_CHECK_EQUAL( cells[332] , 499 );
+
+        auto pressure = container.cellView( p );
+        for (size_t cell = 0; cell < 1000; cell++)
+            pressure[cell] = cell;
+        std::vector<double> values( cells.size() );
+        BOOST_CHECK_EQUAL( selected.select( pressure.data() , values.data() ) , 333U );
+        BOOST_CHECK_EQUAL( values[1] , 2.0 );
+        container.gatherCellData( p , 0 , cells.data() , values.data() , cells.size() );
+        BOOST_CHECK_EQUAL( values[332] , 499.0 );
+
+        selected.flip();
+        BOOST_CHECK_EQUAL( selected.count() , 667U );
+        selected.assignAndNot( bits );
+        BOOST_CHECK_EQUAL( selected.count() , 334U );
+        selected.assignOr( bits );
+        BOOST_CHECK_EQUAL( selected.count() , 1000U );
+        selected.fill( false );
+        BOOST_CHECK_EQUAL( selected.count() , 0U );
+        BOOST_CHECK_THROW( selected.assignAnd( BitView<const FieldBits::Word>( bits.data() , 999 )) , std::invalid_argument );
+
+        // Scatter sets the bit of non-zero values.
+        const int32_t scatter_cells[] = { 0 , 1 };
+        const double input[] = { 2.0 , 0.0 };
+        double output[2];
+        container.scatterCellData( active , 0 , scatter_cells , input , 2 );
+        container.gatherCellData( active , 0 , scatter_cells , output , 2 );
+        BOOST_CHECK_EQUAL( output[0] , 1.0 );
+        BOOST_CHECK_EQUAL( output[1] , 0.0 );
+
+        SimulationDataContainer copy( container );
+        BOOST_CHECK( copy.equal( container ));
+        container.cellBits( active ).reset( 700 );
+        BOOST_CHECK( !copy.equal( container ));
+        const ComparisonReport report = container.compare( copy );
+        BOOST_CHECK_EQUAL( report.cell_fields[0].mismatches , 1U );
+        BOOST_CHECK_EQUAL( report.cell_fields[0].first_mismatch , 700U );
+        BOOST_CHECK( copy.cellBits( active )[700] );
+
+        container.save( path );
+        SimulationDataContainer loaded( path );
+        BOOST_CHECK( loaded.cellType( active ) == FieldType::Bit );
+        BOOST_CHECK_EQUAL( loaded.cellBits( active ).count() , 665U );
+        BOOST_CHECK( loaded.equal( container ));
+
+        if (storage != FieldStorage::Mapped) {
+            container.convertCellData( p , FieldType::Bit );
+            BOOST_CHECK_EQUAL( container.cellBits( p ).count() , 999U );
+            container.convertCellData( active , FieldType::Float64 );
+            BOOST_CHECK_EQUAL( container.cellView( active )[2] , 1.0 );
+            BOOST_CHECK_EQUAL( container.cellView( active )[3] , 0.0 );
+            BOOST_CHECK( !container.equal( copy ));
+            container.cellView( active )[700] = 1;
+
+            // Only the pressures lost by the conversion to Bit differ,
+            // compared either way round.
+            BOOST_CHECK( !container.equal( copy ));
+            BOOST_CHECK( !copy.equal( container ));
+            for (const auto& difference : { container.compare( copy ) , copy.compare( container ) }) {
+                BOOST_CHECK( difference.cell_fields[0].equal() );
+                BOOST_CHECK( difference.cell_fields[1].equal() );
+                BOOST_CHECK_EQUAL( difference.cell_fields[2].mismatches , 998U );
+            }
+        }
+    }
+    std::remove( path.c_str() );
+
+    // Delta checkpoints write the words of the dirty chunks; the
+    // adjacent chunks of cells 50 and 90 share the word of bits 64 to
+    // 127, and the field after them must still be read in place.
+    const std::string delta = "test_bit_fields_delta.bin";
+    SimulationDataContainer base(1000 , 2 , FieldStorage::Vector);
+    CellFieldId active = base.registerCellData("ACTIVE" , 1 , 1.0 , FieldLayout() , FieldType::Bit );
+    CellFieldId pressure = base.registerCellData("PRESSURE" , 1 , 0.0 );
+    base.setDirtyChunkSize( 8 * 40 );
+    base.clearDirty();
+    SimulationDataContainer next( base );
+    const int32_t cells[] = { 50 , 90 , 999 };
+    const double input[] = { 0.0 , 0.0 , 0.0 };
+    next.scatterCellData( active , 0 , cells , input , 3 );
+    const double pressures[] = { 5.0 };
+    next.scatterCellData( pressure , 0 , cells + 2 , pressures , 1 );
+    next.saveDelta( delta );
+    base.applyDelta( delta );
+    BOOST_CHECK_EQUAL( base.cellBits( active ).count() , 997U );
+    BOOST_CHECK_EQUAL( base.cellView( pressure )[999] , 5.0 );
+    BOOST_CHECK( base.equal( next ));
+    std::remove( delta.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestPartition) {
+    CellPartition all( 10 );
+    BOOST_CHECK_EQUAL( all.numOwned() , 10U );
+    BOOST_CHECK_EQUAL( all.numGhosts() , 0U );
+
+    std::vector<CellPartition::Neighbor> neighbors = { { 1 , { 0 , 1 } , { 8 , 9 } } };
+    CellPartition partition( 10 , 8 , neighbors );
+    BOOST_CHECK( partition.owned( 7 ));
+    BOOST_CHECK( !partition.owned( 8 ));
+    BOOST_CHECK_THROW( CellPartition( 10 , 7 , { { 1 , { 7 } , {} } } ) , std::invalid_argument );
+    BOOST_CHECK_THROW( CellPartition( 10 , 8 , { { 1 , {} , { 7 } } } ) , std::invalid_argument );
+    BOOST_CHECK_THROW( CellPartition( 10 , 8 , { { 2 , {} , {} } , { 1 , {} , {} } } ) , std::invalid_argument );
+
+    // Pack the owned cells 0 and 1 of one container into the ghost
+    // cells 8 and 9 of another.
+    SimulationDataContainer source(10 , 2 , FieldStorage::Vector);
+    SimulationDataContainer target(10 , 2 , FieldStorage::Arena);
+    BOOST_CHECK_THROW( source.setPartition( CellPartition( 9 )) , std::invalid_argument );
+    source.setPartition( partition );
+    target.setPartition( partition );
+    for (SimulationDataContainer* container : { &source , &target }) {
+        container->registerCellData("P" , 1 , 0.0 );
+        container->registerCellData("S" , 2 , 0.0 , FieldLayout::aosoa( 4 ) , FieldType::Float32 );
+        container->registerCellData("ACTIVE" , 1 , 0.0 , FieldLayout() , FieldType::Bit );
+    }
+    const std::vector<CellFieldId> fields = { source.cellFieldId("P") , source.cellFieldId("S") , source.cellFieldId("ACTIVE") };
+    source.cellView( fields[0] )[1] = 11;
+    source.cellComponentView<float>( fields[1] , 1 )[0] = 10.5f;
+    source.cellBits( fields[2] ).set( 1 );
+    BOOST_CHECK_EQUAL( source.haloSendBytes( fields , 0 ) , 16U + 16U + 8U );
+    BOOST_CHECK_EQUAL( target.haloReceiveBytes( fields , 0 ) , 40U );
+    std::vector<double> buffer( 5 );
+    source.packHalo( fields , 0 , buffer.data() );
+    target.clearDirty();
+    target.unpackHalo( fields , 0 , buffer.data() );
+    BOOST_CHECK_EQUAL( target.cellView( fields[0] )[9] , 11.0 );
+    BOOST_CHECK_EQUAL( target.cellComponentView<float>( fields[1] , 1 )[8] , 10.5f );
+    BOOST_CHECK( target.cellBits( fields[2] )[9] );
+    BOOST_CHECK( !target.cellBits( fields[2] )[8] );
+
+    SimulationDataContainer copy( target );
+    BOOST_CHECK_EQUAL( copy.partition().numOwned() , 8U );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestHaloExchange) {
+    // Three ranks own ten cells each of a chain of 30 cells, and hold
+    // the cells next to their own as ghosts, numbered in reverse.
+    const int num_ranks = 3;
+    auto group = std::make_shared<LocalExchangeGroup>( num_ranks );
+    std::vector<std::vector<double>> pressures( num_ranks );
+    std::vector<std::vector<int>> flags( num_ranks );
+    std::vector<size_t> num_neighbors( num_ranks );
+    std::vector<std::string> errors( num_ranks );
+    std::vector<std::thread> threads;
+    for (int rank = 0; rank < num_ranks; rank++) {
+        threads.emplace_back( [&, rank]() {
+            try {
+                std::vector<int> owners;
+                std::vector<int64_t> global_ids;
+                for (int cell = 0; cell < 10; cell++) {
+                    owners.push_back( rank );
+                    global_ids.push_back( 10 * rank + cell );
+                }
+                if (rank < num_ranks - 1) {
+                    owners.push_back( rank + 1 );
+                    global_ids.push_back( 10 * rank + 10 );
+                }
+                if (rank > 0) {
+                    owners.push_back( rank - 1 );
+                    global_ids.push_back( 10 * rank - 1 );
+                }
+                LocalExchanger exchanger( group , rank );
+                SimulationDataContainer container( owners.size() , 0 , FieldStorage::Vector );
+                container.setPartition( CellPartition::build( owners , global_ids , exchanger ));
+                CellFieldId p = container.registerCellData("P" , 1 , -1.0 );
+                CellFieldId flag = container.registerCellData("FLAG" , 1 , 0.0 , FieldLayout() , FieldType::Bit );
+                for (size_t cell = 0; cell < container.partition().numOwned(); cell++) {
+                    container.cellView( p )[cell] = global_ids[cell];
+                    container.cellBits( flag ).set( cell , global_ids[cell] % 2 == 1 );
+                }
+                container.exchangeHalo( { p , flag } , exchanger );
+                pressures[rank] = std::vector<double>( container.cellView( p ).begin() , container.cellView( p ).end() );
+                for (size_t cell = 0; cell < container.numCells(); cell++)
+                    flags[rank].push_back( container.cellBits( flag )[cell] );
+                num_neighbors[rank] = container.partition().neighbors().size();
+            } catch (const std::exception& e) {
+                errors[rank] = e.what();
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int rank = 0; rank < num_ranks; rank++) {
+        BOOST_CHECK_EQUAL( errors[rank] , "" );
+        BOOST_CHECK_EQUAL( num_neighbors[rank] , rank == 1 ? 2U : 1U );
+    }
+    BOOST_CHECK_EQUAL( pressures[0][10] , 10.0 );
+    BOOST_CHECK_EQUAL( pressures[1][10] , 20.0 );
+    BOOST_CHECK_EQUAL( pressures[1][11] , 9.0 );
+    BOOST_CHECK_EQUAL( pressures[2][10] , 19.0 );
+    BOOST_CHECK_EQUAL( pressures[1][3] , 13.0 );
+    BOOST_CHECK_EQUAL( flags[1][10] , 0 );
+    BOOST_CHECK_EQUAL( flags[1][11] , 1 );
+    BOOST_CHECK_EQUAL( flags[2][10] , 1 );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFirstTouch) {
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena , FieldStorage::Mapped }) {
+        SimulationDataContainer serial(1001 , 10 , storage);
+        SimulationDataContainer parallel(1001 , 10 , storage);
+        BOOST_CHECK( parallel.firstTouch() == FirstTouch::Serial );
+        parallel.setFirstTouch( FirstTouch::Parallel );
+        BOOST_CHECK( parallel.firstTouch() == FirstTouch::Parallel );
+        for (auto* container : { &serial , &parallel }) {
+            container->registerCellData("P" , 1 , 2.5 );
+            container->registerCellData("X" , 3 , -1.0 , FieldLayout::aosoa(8) );
+            container->registerCellData("Y" , 2 , 0.25 , FieldLayout::planar() , FieldType::Float32 );
+            container->registerCellData("N" , 1 , 7 , FieldLayout() , FieldType::Int16 );
+            container->registerCellData("FLAG" , 1 , 1 , FieldLayout() , FieldType::Bit );
+            container->registerFaceData("F" , 2 , 3.0 );
+        }
+        BOOST_CHECK( parallel.equal( serial ));
+
+        // The raw values include the AoSoA padding, which must be zero.
+        const CellFieldId x = parallel.cellFieldId("X");
+        const auto raw = parallel.cellView( x );
+        const auto expected = static_cast<const SimulationDataContainer&>( serial ).cellView( x );
+        BOOST_CHECK( std::equal( raw.begin() , raw.end() , expected.begin() ));
+        BOOST_CHECK_EQUAL( parallel.cellBits( parallel.cellFieldId("FLAG") ).count() , 1001U );
+        if (storage == FieldStorage::Vector) {
+            BOOST_CHECK_EQUAL( serial.getCellData("P").size() , 1001U );
+            BOOST_CHECK_EQUAL( parallel.getCellData("P")[1000] , 2.5 );
+        }
+
+        // Writing a copy duplicates the field in parallel and leaves the
+        // original alone.
+        SimulationDataContainer copy( parallel );
+        BOOST_CHECK( copy.firstTouch() == FirstTouch::Parallel );
+        BOOST_CHECK( copy.equal( serial ));
+        copy.cellView( x )[5] = 42;
+        copy.cellView<int16_t>( copy.cellFieldId("N") )[1000] = -7;
+        BOOST_CHECK_EQUAL( parallel.cellView( x )[5] , -1.0 );
+        BOOST_CHECK_EQUAL( parallel.cellView<int16_t>( parallel.cellFieldId("N") )[1000] , 7 );
+        BOOST_CHECK_EQUAL( copy.compare( serial ).cell_fields[1].mismatches , 1U );
+        BOOST_CHECK_EQUAL( copy.compare( serial ).cell_fields[3].mismatches , 1U );
+        BOOST_CHECK( parallel.equal( serial ));
+    }
+}
+
+
+namespace {
+// Counts the live blocks and bytes it handed out.
+class CountingResource : public MemoryResource {
+public:
+    void* allocate(size_t bytes , size_t alignment) override {
+        blocks++;
+        live += bytes;
+        return defaultMemoryResource()->allocate( bytes , alignment );
+    }
+
+    void deallocate(void* block , size_t bytes , size_t alignment) override {
+        live -= bytes;
+        defaultMemoryResource()->deallocate( block , bytes , alignment );
+    }
+
+    size_t blocks = 0;
+    size_t live = 0;
+};
+}
+
+
+BOOST_AUTO_TEST_CASE(TestMemoryResource) {
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena }) {
+        auto resource = std::make_shared<CountingResource>();
+        {
+            SimulationDataContainer container(100 , 10 , storage , resource);
+            SimulationDataContainer plain(100 , 10 , storage);
+            BOOST_CHECK( container.memoryResource() == resource );
+            BOOST_CHECK( !plain.memoryResource() );
+            for (auto* c : { &container , &plain }) {
+                c->registerCellData("P" , 1 , 2.0 );
+                c->registerCellData("X" , 2 , 0.5 , FieldLayout::aosoa(8) , FieldType::Float32 );
+                c->registerFaceData("F" , 1 , 1.0 );
+            }
+            BOOST_CHECK( resource->blocks > 0 );
+            BOOST_CHECK( resource->live > 0 );
+            BOOST_CHECK( container.equal( plain ));
+            if (storage == FieldStorage::Vector)
+                BOOST_CHECK_EQUAL( container.getCellData("P")[99] , 2.0 );
+
+            // Copies allocate from the same resource when they are written.
+            const size_t blocks = resource->blocks;
+            SimulationDataContainer copy( container );
+            BOOST_CHECK( copy.memoryResource() == resource );
+            copy.cellView<float>( copy.cellFieldId("X") )[3] = 7;
+            BOOST_CHECK( resource->blocks > blocks );
+            BOOST_CHECK_EQUAL( container.cellView<float>( container.cellFieldId("X") )[3] , 0.5f );
+            container.relayoutCellData( container.cellFieldId("P") , FieldLayout::planar() );
+            container.convertCellData( container.cellFieldId("X") , FieldType::Float64 );
+            BOOST_CHECK( container.equal( plain ));
+        }
+        BOOST_CHECK_EQUAL( resource->live , 0U );
+    }
+    BOOST_CHECK_THROW( SimulationDataContainer(10 , 10 , FieldStorage::Mapped , std::make_shared<CountingResource>()) , std::invalid_argument );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestMonotonicResource) {
+    auto upstream = std::make_shared<CountingResource>();
+    {
+        MonotonicResource pool( 1000 , upstream );
+        BOOST_CHECK_EQUAL( pool.capacity() , 1000U );
+        BOOST_CHECK_EQUAL( upstream->blocks , 1U );
+        void* first = pool.allocate( 100 , 64 );
+        void* second = pool.allocate( 100 , 64 );
+        BOOST_CHECK_EQUAL( reinterpret_cast<uintptr_t>( first ) % 64 , 0U );
+        BOOST_CHECK_EQUAL( reinterpret_cast<uintptr_t>( second ) % 64 , 0U );
+        BOOST_CHECK_EQUAL( static_cast<char*>( second ) - static_cast<char*>( first ) , 128 );
+        BOOST_CHECK_EQUAL( pool.used() , 228U );
+        pool.deallocate( first , 100 , 64 );
+        BOOST_CHECK_EQUAL( pool.used() , 228U );
+
+        // A request larger than the rest of the chunk starts a new one.
+        pool.allocate( 1500 , 64 );
+        BOOST_CHECK_EQUAL( upstream->blocks , 2U );
+        BOOST_CHECK_EQUAL( pool.capacity() , 3000U );
+
+        SimulationDataContainer container(1000 , 0 , FieldStorage::Vector , std::make_shared<MonotonicResource>( 1 << 20 , upstream ));
+        container.registerCellData("P" , 3 , 1.0 );
+        container.registerCellData("S" , 1 , 0.0 , FieldLayout() , FieldType::Bit );
+        BOOST_CHECK_EQUAL( upstream->blocks , 3U );
+        BOOST_CHECK_EQUAL( container.cellView( container.cellFieldId("P") )[2999] , 1.0 );
+    }
+    BOOST_CHECK_EQUAL( upstream->live , 0U );
+    BOOST_CHECK_THROW( MonotonicResource( 10 , nullptr ) , std::invalid_argument );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestHugePageResource) {
+    auto upstream = std::make_shared<CountingResource>();
+    HugePageResource resource( HugePageResource::Pages::Transparent , 4096 , upstream );
+    void* small = resource.allocate( 1000 , 64 );
+    BOOST_CHECK_EQUAL( upstream->blocks , 1U );
+    resource.deallocate( small , 1000 , 64 );
+
+    const size_t bytes = 3 * HugePageResource::page_size + 100;
+    char* block = static_cast<char*>( resource.allocate( bytes , 64 ));
+    BOOST_CHECK_EQUAL( upstream->blocks , 1U );
+    BOOST_CHECK_EQUAL( reinterpret_cast<uintptr_t>( block ) % HugePageResource::page_size , 0U );
+    std::fill( block , block + bytes , 1 );
+    BOOST_CHECK_EQUAL( block[bytes - 1] , 1 );
+    resource.deallocate( block , bytes , 64 );
+    BOOST_CHECK_EQUAL( upstream->live , 0U );
+
+    SimulationDataContainer container(300000 , 0 , FieldStorage::Arena , std::make_shared<HugePageResource>());
+    CellFieldId p = container.registerCellData("P" , 2 , 3.0 );
+    container.registerCellData("T" , 1 , 4.0 );
+    BOOST_CHECK_EQUAL( container.cellView( p )[599999] , 3.0 );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestSparseFields) {
+    SimulationDataContainer container(1000 , 500 , FieldStorage::Arena);
+    BOOST_CHECK_THROW( container.registerSparseCellData("WELLS" , 1 , { 3 , 3 }) , std::invalid_argument );
+    BOOST_CHECK_THROW( container.registerSparseCellData("WELLS" , 1 , { 1000 }) , std::invalid_argument );
+    BOOST_CHECK_THROW( container.registerSparseCellData("WELLS" , 1 , { -1 }) , std::invalid_argument );
+
+    SparseCellFieldId wells = container.registerSparseCellData("WELLS" , 2 , { 700 , 5 , 42 } , 1.0 );
+    SparseFaceFieldId faults = container.registerSparseFaceData("FAULTS" , 1 , { 10 , 499 } );
+    BOOST_CHECK( container.registerSparseCellData("WELLS" , 1 , {}) == wells );
+    BOOST_CHECK( container.hasSparseCellData("WELLS") );
+    BOOST_CHECK( !container.hasSparseCellData("FAULTS") );
+    BOOST_CHECK( container.sparseFaceFieldId("FAULTS") == faults );
+    BOOST_CHECK_THROW( container.sparseCellFieldId("FAULTS") , std::invalid_argument );
+
+    SparseField& field = container.sparseCellData( wells );
+    BOOST_CHECK_EQUAL( field.size() , 3U );
+    BOOST_CHECK_EQUAL( field.components() , 2U );
+    BOOST_CHECK_EQUAL( field.entities()[0] , 5 );
+    BOOST_CHECK_EQUAL( field.entities()[2] , 700 );
+    BOOST_CHECK_EQUAL( field.find( 42 ) , 1U );
+    BOOST_CHECK_EQUAL( field.find( 43 ) , SparseField::npos );
+    BOOST_CHECK_EQUAL( field.find( 5000 ) , SparseField::npos );
+    BOOST_CHECK( !field.contains( 0 ));
+    field.set( 700 , 1 , 7.0 );
+    field.component( 0 )[1] = 4.2;
+    BOOST_CHECK_EQUAL( field.value( 700 , 1 ) , 7.0 );
+    BOOST_CHECK_EQUAL( field.value( 42 , 0 ) , 4.2 );
+    BOOST_CHECK_EQUAL( field.value( 41 , 0 , -1.0 ) , -1.0 );
+    BOOST_CHECK_THROW( field.set( 41 , 0 , 1.0 ) , std::out_of_range );
+    BOOST_CHECK_THROW( field.value( 42 , 2 ) , std::invalid_argument );
+
+    // Scatter into dense fields and gather back.
+    CellFieldId rate = container.registerCellData("RATE" , 2 , 0.0 , FieldLayout::planar() );
+    CellFieldId open = container.registerCellData("OPEN" , 2 , 0.0 , FieldLayout() , FieldType::Bit );
+    CellFieldId p = container.registerCellData("P" , 1 , 0.0 );
+    BOOST_CHECK_THROW( container.scatterSparseCellData( wells , p ) , std::invalid_argument );
+    container.scatterSparseCellData( wells , rate );
+    container.scatterSparseCellData( wells , open );
+    BOOST_CHECK_EQUAL( container.cellComponentView( rate , 0 )[42] , 4.2 );
+    BOOST_CHECK_EQUAL( container.cellComponentView( rate , 1 )[700] , 7.0 );
+    BOOST_CHECK_EQUAL( container.cellComponentView( rate , 1 )[699] , 0.0 );
+    BOOST_CHECK_EQUAL( container.cellBits( open ).count() , 6U );
+    container.cellComponentView( rate , 0 )[5] = -3.0;
+    container.gatherSparseCellData( wells , rate );
+    BOOST_CHECK_EQUAL( field.value( 5 , 0 ) , -3.0 );
+
+    FaceFieldId flux = container.registerFaceData("FLUX" , 1 , 2.0 );
+    container.gatherSparseFaceData( faults , flux );
+    BOOST_CHECK_EQUAL( container.sparseFaceData( faults ).value( 499 , 0 ) , 2.0 );
+    container.sparseFaceData( faults ).set( 10 , 0 , 9.0 );
+    container.scatterSparseFaceData( faults , flux );
+    BOOST_CHECK_EQUAL( container.faceView( flux )[10] , 9.0 );
+
+    // Copies, swap and equal() include the sparse fields.
+    SimulationDataContainer copy( container );
+    BOOST_CHECK( copy.equal( container ));
+    copy.sparseCellData( wells ).set( 42 , 1 , 0.5 );
+    BOOST_CHECK( !copy.equal( container ));
+    BOOST_CHECK_EQUAL( container.sparseCellData( wells ).value( 42 , 1 ) , 1.0 );
+
+    SimulationDataContainer other(1000 , 500 , FieldStorage::Arena);
+    other.swap( copy );
+    BOOST_CHECK( !copy.hasSparseCellData("WELLS") );
+    BOOST_CHECK_EQUAL( other.sparseCellData( wells ).value( 42 , 1 ) , 0.5 );
+    other.sparseCellData( wells ).set( 42 , 1 , 1.0 );
+    BOOST_CHECK( other.equal( container ));
+    other.registerSparseCellData("AQUIFER" , 1 , { 1 });
+    BOOST_CHECK( !other.equal( container ));
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldHistory) {
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena }) {
+        SimulationDataContainer container(100 , 10 , storage);
+        CellFieldId p = container.registerCellData("P" , 1 , 1.0 );
+        CellFieldId s = container.registerCellData("S" , 2 , 0.0 , FieldLayout() , FieldType::Float32 );
+        CellFieldId flag = container.registerCellData("FLAG" , 1 , 0.0 , FieldLayout() , FieldType::Bit );
+        FaceFieldId flux = container.registerFaceData("FLUX" , 1 , 0.0 );
+        container.setCellDataHistory( p , 2 );
+        container.setCellDataHistory( s , 1 );
+        container.setCellDataHistory( flag , 1 );
+        container.setFaceDataHistory( flux , 1 );
+        BOOST_CHECK_EQUAL( container.cellDataHistory( p ) , 2U );
+        BOOST_CHECK_EQUAL( container.faceDataHistory( flux ) , 1U );
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 2 )[50] , 1.0 );
+        BOOST_CHECK_THROW( container.cellHistoryView( p , 3 ) , std::out_of_range );
+        BOOST_CHECK_THROW( container.cellHistoryView( s , 1 ) , std::logic_error );
+        BOOST_CHECK_THROW( container.relayoutCellData( p , FieldLayout::planar() ) , std::logic_error );
+        BOOST_CHECK_THROW( container.convertCellData( p , FieldType::Float32 ) , std::logic_error );
+
+        // Three timesteps; the vectors are written fully every step.
+        for (int step = 1; step <= 3; step++) {
+            for (double& value : container.cellView( p ))
+                value = step;
+            for (float& value : container.cellView<float>( s ))
+                value = 10 * step;
+            container.cellBits( flag ).set( step , true );
+            container.faceView( flux )[0] = -step;
+            if (step < 3)
+                container.rotateHistory();
+        }
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 0 )[7] , 3.0 );
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 1 )[7] , 2.0 );
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 2 )[7] , 1.0 );
+        BOOST_CHECK_EQUAL( container.cellHistoryView<float>( s , 1 )[199] , 20.0f );
+        BOOST_CHECK_EQUAL( container.faceHistoryView( flux , 1 )[0] , -2.0 );
+        // The bit field of depth one holds its own values and those of
+        // lag 1 alternately.
+        BOOST_CHECK_EQUAL( container.cellBits( flag ).count() , 2U );
+        BOOST_CHECK_EQUAL( container.cellHistoryBits( flag , 1 ).count() , 1U );
+
+        // Rotation moves buffers; the vector holds the oldest values.
+        const double* lag1 = container.cellHistoryView( p , 1 ).data();
+        container.rotateHistory();
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 2 ).data() , lag1 );
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 0 )[0] , 1.0 );
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 1 )[0] , 3.0 );
+
+        // Copies share the lags until they are written.
+        SimulationDataContainer copy( container );
+        copy.cellHistoryView( p , 2 )[0] = -1;
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 2 )[0] , 2.0 );
+        copy.rotateHistory();
+        BOOST_CHECK_EQUAL( copy.cellHistoryView( p , 1 )[0] , 1.0 );
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 1 )[0] , 3.0 );
+
+        // Deeper histories start from the oldest lag.
+        container.setCellDataHistory( p , 3 );
+        BOOST_CHECK_EQUAL( container.cellHistoryView( p , 3 )[0] , 2.0 );
+        container.setCellDataHistory( p , 0 );
+        BOOST_CHECK_EQUAL( container.cellDataHistory( p ) , 0U );
+        container.relayoutCellData( p , FieldLayout::planar() );
+    }
+    SimulationDataContainer mapped(10 , 10 , FieldStorage::Mapped);
+    CellFieldId p = mapped.registerCellData("P" , 1 , 1.0 );
+    BOOST_CHECK_THROW( mapped.setCellDataHistory( p , 1 ) , std::logic_error );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldStatistics) {
+    const size_t num_cells = 50000;
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena , FieldStorage::Mapped }) {
+        SimulationDataContainer container(num_cells , 10 , storage);
+        CellFieldId p = container.registerCellData("P" , 1 , 0.0 );
+        CellFieldId s = container.registerCellData("S" , 3 , 0.0 , FieldLayout::aosoa(8) , FieldType::Float32 );
+        CellFieldId n = container.registerCellData("N" , 2 , 3.0 , FieldLayout::planar() , FieldType::Int16 );
+        CellFieldId flag = container.registerCellData("FLAG" , 1 , 0.0 , FieldLayout() , FieldType::Bit );
+        FaceFieldId flux = container.registerFaceData("FLUX" , 1 , 2.0 );
+        for (size_t cell = 0; cell < num_cells; cell++) {
+            container.cellView( p )[cell] = double( cell % 1000 ) - 500;
+            container.cellComponentView<float>( s , 1 )[cell] = 0.5f;
+        }
+        container.cellComponentView<float>( s , 2 )[40000] = -2;
+        container.cellComponentView<int16_t>( n , 1 )[20000] = 7;
+        container.cellBits( flag ).set( 30000 , true );
+
+        const FieldStatistics pressure = container.cellStatistics( p , 0 );
+        BOOST_CHECK_EQUAL( pressure.count , num_cells );
+        BOOST_CHECK_EQUAL( pressure.min , -500.0 );
+        BOOST_CHECK_EQUAL( pressure.max , 499.0 );
+        BOOST_CHECK_EQUAL( pressure.argmin , 0U );
+        BOOST_CHECK_EQUAL( pressure.argmax , 999U );
+        BOOST_CHECK_EQUAL( pressure.sum , -25000.0 );
+        BOOST_CHECK_CLOSE( pressure.mean() , -0.5 , 1e-12 );
+
+        BOOST_CHECK_EQUAL( container.cellStatistics( s , 1 ).sum , 25000.0 );
+        BOOST_CHECK_EQUAL( container.cellStatistics( s , 2 ).argmin , 40000U );
+        const FieldStatistics saturation = container.cellStatistics( s );
+        BOOST_CHECK_EQUAL( saturation.count , 3 * num_cells );
+        BOOST_CHECK_EQUAL( saturation.min , -2.0 );
+        BOOST_CHECK_EQUAL( saturation.max , 0.5 );
+        BOOST_CHECK_EQUAL( saturation.argmin , 40000U );
+        BOOST_CHECK_EQUAL( saturation.argmax , 0U );
+        BOOST_CHECK_EQUAL( container.cellStatistics( n , 1 ).argmax , 20000U );
+        BOOST_CHECK_EQUAL( container.cellStatistics( n ).max , 7.0 );
+        BOOST_CHECK_EQUAL( container.cellStatistics( flag , 0 ).sum , 1.0 );
+        BOOST_CHECK_EQUAL( container.cellStatistics( flag , 0 ).argmax , 30000U );
+        BOOST_CHECK_EQUAL( container.cellStatistics( flag , 0 ).argmin , 0U );
+        BOOST_CHECK_EQUAL( container.faceStatistics( flux ).sum , 20.0 );
+        BOOST_CHECK_THROW( container.cellStatistics( p , 1 ) , std::invalid_argument );
+
+        // Cached until the field is written through the container.
+        auto view = container.cellView( p );
+        BOOST_CHECK_EQUAL( container.cellStatistics( p , 0 ).max , 499.0 );
+        view[123] = 1000;
+        BOOST_CHECK_EQUAL( container.cellStatistics( p , 0 ).max , 499.0 );
+        container.markCellDataDirty( p , 123 , 124 );
+        BOOST_CHECK_EQUAL( container.cellStatistics( p , 0 ).max , 1000.0 );
+        BOOST_CHECK_EQUAL( container.cellStatistics( p , 0 ).argmax , 123U );
+        container.cellView( p )[124] = 2000;
+        BOOST_CHECK_EQUAL( container.cellStatistics( p ).argmax , 124U );
+
+        // NaN is skipped by min and max.
+        container.cellView( p )[0] = std::nan("");
+        BOOST_CHECK_EQUAL( container.cellStatistics( p ).min , -500.0 );
+        BOOST_CHECK_EQUAL( container.cellStatistics( p ).argmin , 1000U );
+        BOOST_CHECK( std::isnan( container.cellStatistics( p ).sum ));
+    }
+    SimulationDataContainer empty(0 , 0 , FieldStorage::Vector);
+    CellFieldId p = empty.registerCellData("P" , 1 , 0.0 );
+    BOOST_CHECK_EQUAL( empty.cellStatistics( p ).argmin , FieldStatistics::npos );
+    BOOST_CHECK( std::isnan( empty.cellStatistics( p ).mean() ));
+}
+
+
+BOOST_AUTO_TEST_CASE(TestRegionAggregation) {
+    const size_t num_cells = 20000;
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena }) {
+        SimulationDataContainer container(num_cells , 0 , storage);
+        CellFieldId region = container.registerCellData("FIPNUM" , 1 , 0 , FieldLayout() , FieldType::Int32 );
+        CellFieldId pv = container.registerCellData("PORV" , 1 , 0.0 );
+        CellFieldId p = container.registerCellData("P" , 1 , 0.0 );
+        CellFieldId s = container.registerCellData("S" , 2 , 0.0 , FieldLayout::aosoa(8) , FieldType::Float32 );
+        std::vector<double> expected_sum(4 , 0.0);
+        std::vector<double> expected_weight(4 , 0.0);
+        for (size_t cell = 0; cell < num_cells; cell++) {
+            const int number = cell % 7 == 6 ? -1 : int(cell % 4);
+            container.cellView<int32_t>( region )[cell] = number;
+            container.cellView( pv )[cell] = 1 + cell % 3;
+            container.cellView( p )[cell] = double( cell );
+            container.cellComponentView<float>( s , 1 )[cell] = 0.25f * (cell % 5);
+            if (number >= 0) {
+                expected_sum[number] += (1 + cell % 3) * double( cell );
+                expected_weight[number] += 1 + cell % 3;
+            }
+        }
+
+        const RegionReport report = container.aggregateCellData( region , { p , s } , pv );
+        BOOST_CHECK_EQUAL( report.numRegions() , 4U );
+        BOOST_CHECK_EQUAL( report.numColumns() , 3U );
+        size_t count = 0;
+        for (size_t number = 0; number < 4; number++) {
+            BOOST_CHECK_CLOSE( report( number , 0 ).sum , expected_sum[number] , 1e-10 );
+            BOOST_CHECK_EQUAL( report( number , 0 ).weight , expected_weight[number] );
+            BOOST_CHECK_CLOSE( report( number , 0 ).mean() , expected_sum[number] / expected_weight[number] , 1e-10 );
+            BOOST_CHECK_EQUAL( report( number , 1 ).max , 0.0 );
+            BOOST_CHECK_EQUAL( report( number , 2 ).min , 0.0 );
+            BOOST_CHECK_EQUAL( report( number , 2 ).max , 1.0 );
+            count += report( number , 0 ).count;
+        }
+        BOOST_CHECK_EQUAL( count , num_cells - num_cells / 7 );
+        BOOST_CHECK_EQUAL( report( 0 , 0 ).min , 0.0 );
+        BOOST_CHECK_EQUAL( report( 3 , 0 ).max , double( num_cells - 1 ));
+
+        // Unweighted; the cached region count follows changes.
+        container.cellView<int32_t>( region )[5] = 9;
+        const RegionReport plain = container.aggregateCellData( region , { p } );
+        BOOST_CHECK_EQUAL( plain.numRegions() , 10U );
+        BOOST_CHECK_EQUAL( plain( 9 , 0 ).count , 1U );
+        BOOST_CHECK_EQUAL( plain( 9 , 0 ).sum , 5.0 );
+        BOOST_CHECK_EQUAL( plain( 9 , 0 ).mean() , 5.0 );
+        BOOST_CHECK( std::isnan( plain( 7 , 0 ).mean() ));
+        BOOST_CHECK_THROW( container.aggregateCellData( s , { p } ) , std::invalid_argument );
+        BOOST_CHECK_THROW( container.aggregateCellData( p , { p } ) , std::invalid_argument );
+        BOOST_CHECK_THROW( container.aggregateCellData( CellFieldId() , { p } ) , std::invalid_argument );
+        BOOST_CHECK_THROW( container.aggregateCellData( region , { CellFieldId( 99 ) } ) , std::invalid_argument );
+        container.cellView<int32_t>( region )[6] = 1000000000;
+        BOOST_CHECK_THROW( container.aggregateCellData( region , { p } ) , std::invalid_argument );
+        container.cellView<int32_t>( region )[6] = -1;
+
+        // Ghost cells are left out.
+        container.setPartition( CellPartition( num_cells , 10 , {} ));
+        const RegionReport owned = container.aggregateCellData( region , { p } );
+        BOOST_CHECK_EQUAL( owned( 1 , 0 ).count , 2U );
+        BOOST_CHECK_EQUAL( owned( 1 , 0 ).sum , 1.0 + 9.0 );
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldExpression) {
+    const size_t num_cells = 10000;
+    for (FieldStorage storage : { FieldStorage::Vector , FieldStorage::Arena }) {
+        SimulationDataContainer container(num_cells , 0 , storage);
+        CellFieldId p = container.registerCellData("P" , 1 , 0.0 );
+        CellFieldId s = container.registerCellData("S" , 2 , 0.0 );
+        CellFieldId t = container.registerCellData("T" , 2 , 0.0 , FieldLayout::aosoa( 8 ) );
+        CellFieldId c = container.registerCellData("C" , 1 , 0 , FieldLayout() , FieldType::Int32 );
+        CellFieldId a = container.registerCellData("A" , 2 , 0.0 , FieldLayout::planar() );
+        for (size_t cell = 0; cell < num_cells; ++cell) {
+            container.cellComponentView( p , 0 )[cell] = cell;
+            container.cellComponentView( s , 0 )[cell] = 0.25;
+            container.cellComponentView( s , 1 )[cell] = 0.75;
+            container.cellComponentView( t , 1 )[cell] = 2.0 * cell;
+            container.cellComponentView<int32_t>( c , 0 )[cell] = 2;
+        }
+
+        const SimulationDataContainer& data = container;
+        const auto pv = data.cellComponentView( p , 0 );
+        const auto s0 = data.cellComponentView( s , 0 );
+        const auto t1 = data.cellComponentView( t , 1 );
+        const auto cv = data.cellComponentView<int32_t>( c , 0 );
+        container.evaluateCellData( a , 1 , pv * s0 + t1 / cv - 1 );
+        const auto a1 = data.cellComponentView( a , 1 );
+        for (size_t cell = 0; cell < num_cells; ++cell)
+            BOOST_CHECK_EQUAL( a1[cell] , 1.25 * cell - 1 );
+        BOOST_CHECK_EQUAL( container.cellStatistics( a , 1 ).max , 1.25 * (num_cells - 1) - 1 );
+
+        // Reductions over expressions, and the target as an operand.
+        const FieldStatistics statistics = evaluateStatistics( -absolute( a1 - 4.0 ) );
+        BOOST_CHECK_EQUAL( statistics.count , num_cells );
+        BOOST_CHECK_EQUAL( statistics.max , 0.0 );
+        BOOST_CHECK_EQUAL( statistics.argmax , 4U );
+        BOOST_CHECK_EQUAL( evaluateStatistics( maximum( s0 , data.cellComponentView( s , 1 ) ) ).sum , 0.75 * num_cells );
+        container.evaluateCellData( a , 1 , minimum( 2.0 * a1 , 100.0 ) );
+        BOOST_CHECK_EQUAL( a1[2] , 3.0 );
+        BOOST_CHECK_EQUAL( a1[100] , 100.0 );
+        container.evaluateCellData( c , 0 , squareRoot( pv ) );
+        BOOST_CHECK_EQUAL( cv[10] , 3 );
+        BOOST_CHECK_EQUAL( cv[16] , 4 );
+
+        // A new vector; with arena storage the views above are invalid afterwards.
+        CellFieldId q = container.evaluateCellData( "Q" , pv + data.cellView( p ) );
+        BOOST_CHECK_EQUAL( container.numCellDataComponents( "Q" ) , 1U );
+        BOOST_CHECK_EQUAL( container.cellStatistics( q , 0 ).sum , 1.0 * num_cells * (num_cells - 1) );
+
+        BOOST_CHECK_THROW( evaluateStatistics( data.cellView( s ) + data.cellComponentView( s , 0 ) ) , std::invalid_argument );
+        BOOST_CHECK_THROW( container.evaluateCellData( q , 0 , data.cellView( s ) * 2 ) , std::invalid_argument );
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(TestConcurrentRegistration) {
+    // Every thread registers its own scratch fields and a shared one,
+    // while it looks up and reads fields the others registered.
+    const int num_threads = 8;
+    const int fields_per_thread = 100;
+    SimulationDataContainer container( 64 , 16 , FieldStorage::Vector );
+    CellFieldId p = container.registerCellData("P" , 1 , 1.0 );
+    CellFieldId q = container.registerCellData("Q" , 1 , 0.0 );
+    const SimulationDataContainer& data = container;
+    // Mutable access to Q from all threads is safe once it was unshared
+    // and marked by one of them.
+    container.getCellData( q );
+    std::vector<std::string> errors( num_threads );
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+        threads.emplace_back( [&, thread]() {
+            try {
+                for (int field = 0; field < fields_per_thread; field++) {
+                    const std::string name = "SCRATCH_" + std::to_string( thread ) + "_" + std::to_string( field );
+                    CellFieldId id = container.registerCellData( name , 1 , thread );
+                    CellFieldId shared = container.registerCellData("SHARED" , 2 , 5.0 );
+                    container.registerFaceData( name , 1 , field );
+                    if (data.cellFieldId( name ) != id || data.cellFieldId("SHARED") != shared)
+                        throw std::runtime_error("handle mismatch");
+                    if (data.getCellData( name )[63] != thread || data.getCellData("P")[0] != 1.0)
+                        throw std::runtime_error("value mismatch");
+                    const std::string other = "SCRATCH_" + std::to_string( (thread + 1) % num_threads ) + "_" + std::to_string( field );
+                    if (data.hasCellData( other ) && data.getCellData( other )[0] != (thread + 1) % num_threads)
+                        throw std::runtime_error("value mismatch in other thread's field");
+                    container.getCellData( q )[thread] = field;
+                }
+            } catch (const std::exception& e) {
+                errors[thread] = e.what();
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (const auto& error : errors)
+        BOOST_CHECK_EQUAL( error , "" );
+
+    BOOST_CHECK( container.cellFieldId("P") == p );
+    for (int thread = 0; thread < num_threads; thread++)
+        BOOST_CHECK_EQUAL( data.getCellData( q )[thread] , fields_per_thread - 1 );
+    for (int thread = 0; thread < num_threads; thread++) {
+        for (int field = 0; field < fields_per_thread; field++) {
+            const std::string name = "SCRATCH_" + std::to_string( thread ) + "_" + std::to_string( field );
+            BOOST_CHECK_EQUAL( container.getCellData( name )[0] , thread );
+            BOOST_CHECK_EQUAL( container.getFaceData( name )[15] , field );
+        }
+    }
+
+    // Copies and swaps keep the names.
+    SimulationDataContainer copy( container );
+    BOOST_CHECK( copy.hasCellData("SCRATCH_7_99") );
+    BOOST_CHECK( !copy.hasCellData("SCRATCH_8_0") );
+    SimulationDataContainer other( 64 , 16 , FieldStorage::Vector );
+    other.swap( copy );
+    BOOST_CHECK( other.hasCellData("SHARED") );
+    BOOST_CHECK( !copy.hasCellData("SHARED") );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldTableMove) {
+    // A moved-from table is empty and can take new fields.
+    FieldTable table( 10 , FieldStorage::Vector );
+    table.insert("P" , 1 , 2.0 );
+    FieldTable moved( std::move( table ) );
+    BOOST_CHECK_EQUAL( moved.size() , 1U );
+    BOOST_CHECK_EQUAL( moved.find("P" , 1) , 0U );
+    BOOST_CHECK_EQUAL( table.size() , 0U );
+    BOOST_CHECK_EQUAL( table.find("P" , 1) , FieldTable::npos );
+    BOOST_CHECK_EQUAL( table.findOrInsert("S" , 2 , 1.0 ) , 0U );
+    BOOST_CHECK_EQUAL( table.numEntities() , 10U );
+    BOOST_CHECK_EQUAL( table.findKey( 0 , "S" ) , 0U );
+}
+
+
+namespace {
+struct Porosity : CellFieldKey {
+    static constexpr const char* name() { return "PORO"; }
+};
+
+struct Transmissibility : FaceFieldKey {
+    static constexpr const char* name() { return "TRANX"; }
+};
+}
+
+
+BOOST_AUTO_TEST_CASE(TestFieldKeys) {
+    SimulationDataContainer container( 10 , 4 , FieldStorage::Vector );
+    BOOST_CHECK( !container.has<FieldKeys::Pressure>() );
+    BOOST_CHECK_THROW( container.get<FieldKeys::Pressure>() , std::invalid_argument );
+
+    // A field registered by name is found by its key, and the other way round.
+    container.registerCellData("X" , 1 , 0.0 );
+    CellFieldId p = container.registerCellData("PRESSURE" , 1 , 2.0 );
+    CellFieldId poro = container.registerData<Porosity>( 1 , 0.25 );
+    FaceFieldId tranx = container.registerData<Transmissibility>( 1 , 0.0 , FieldLayout() , FieldType::Float32 );
+    BOOST_CHECK( container.has<FieldKeys::Pressure>() );
+    BOOST_CHECK( container.fieldId<FieldKeys::Pressure>() == p );
+    BOOST_CHECK( container.fieldId<Porosity>() == poro );
+    BOOST_CHECK( container.cellFieldId("PORO") == poro );
+    BOOST_CHECK( container.fieldId<Transmissibility>() == tranx );
+    BOOST_CHECK( !container.has<FieldKeys::FaceFlux>() );
+
+    container.get<FieldKeys::Pressure>()[3] = 5.0;
+    BOOST_CHECK_EQUAL( container.cellView( p )[3] , 5.0 );
+    BOOST_CHECK_EQUAL( container.get<Porosity>().size() , 10U );
+    container.get<Transmissibility , float>()[1] = 1.5f;
+    BOOST_CHECK_EQUAL( container.faceView<float>( tranx )[1] , 1.5f );
+    BOOST_CHECK_THROW( container.get<Transmissibility>() , std::logic_error );
+
+    // The handles of the keys follow their containers.
+    SimulationDataContainer other( 10 , 4 , FieldStorage::Vector );
+    other.registerData<Porosity>( 1 , 0.5 );
+    BOOST_CHECK( other.fieldId<Porosity>() == CellFieldId( 0 ));
+    other.swap( container );
+    BOOST_CHECK( container.fieldId<Porosity>() == CellFieldId( 0 ));
+    BOOST_CHECK( other.fieldId<Porosity>() == poro );
+    BOOST_CHECK_EQUAL( container.get<Porosity>()[0] , 0.5 );
+    BOOST_CHECK( !container.has<FieldKeys::Pressure>() );
+    const SimulationDataContainer copy( other );
+    BOOST_CHECK_EQUAL( copy.get<Porosity>()[0] , 0.25 );
+    BOOST_CHECK_EQUAL( copy.get<FieldKeys::Pressure>()[3] , 5.0 );
+}
+
+
+BOOST_AUTO_TEST_CASE(TestCellRebalancing) {
+    SimulationDataContainer source( 10 , 3 , FieldStorage::Vector );
+    CellFieldId p = source.registerCellData("P" , 1 , 0.0 );
+    CellFieldId s = source.registerCellData("S" , 3 , 0.0 , FieldLayout::planar() );
+    CellFieldId x = source.registerCellData("X" , 2 , 0.0 , FieldLayout::aosoa( 4 ) , FieldType::Float32 );
+    CellFieldId rank = source.registerCellData("RANK" , 1 , 0.0 , FieldLayout() , FieldType::Int32 );
+    CellFieldId active = source.registerCellData("ACTIVE" , 2 , 0.0 , FieldLayout() , FieldType::Bit );
+    source.registerFaceData("FLUX" , 1 , 1.0 );
+    for (size_t cell = 0; cell < 10; ++cell) {
+        source.cellView( p )[cell] = cell;
+        for (size_t component = 0; component < 3; ++component)
+            source.cellComponentView( s , component )[cell] = 10 * cell + component;
+        source.cellComponentView<float>( x , 1 )[cell] = 0.5f * cell;
+        source.cellView<int32_t>( rank )[cell] = cell % 3;
+        if (cell % 2)
+            source.cellBits( active ).set( 2 * cell + 1 );
+    }
+
+    // Cell i of the part is cell cells[i] of the source.
+    const std::vector<int32_t> cells = { 7 , 2 , 9 , 3 };
+    const SimulationDataContainer part = source.extractCells( cells );
+    BOOST_CHECK_EQUAL( part.numCells() , 4U );
+    BOOST_CHECK_EQUAL( part.numFaces() , 0U );
+    BOOST_CHECK( !part.hasFaceData("FLUX") );
+    BOOST_CHECK( part.cellLayout( part.cellFieldId("S") ) == FieldLayout::planar() );
+    BOOST_CHECK( part.cellLayout( part.cellFieldId("X") ) == FieldLayout::aosoa( 4 ) );
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const size_t cell = cells[i];
+        BOOST_CHECK_EQUAL( part.cellView( part.cellFieldId("P") )[i] , cell );
+        BOOST_CHECK_EQUAL( part.cellComponentView( part.cellFieldId("S") , 2 )[i] , 10.0 * cell + 2 );
+        BOOST_CHECK_EQUAL( part.cellComponentView<float>( part.cellFieldId("X") , 1 )[i] , 0.5f * cell );
+        BOOST_CHECK_EQUAL( part.cellView<int32_t>( part.cellFieldId("RANK") )[i] , int32_t( cell % 3 ));
+        BOOST_CHECK_EQUAL( part.cellBits( part.cellFieldId("ACTIVE") )[2 * i + 1] , cell % 2 == 1 );
+        BOOST_CHECK( !part.cellBits( part.cellFieldId("ACTIVE") )[2 * i] );
+    }
+    BOOST_CHECK_THROW( source.extractCells( { 3 , 10 } ) , std::out_of_range );
+    BOOST_CHECK_THROW( source.extractCells( { -1 } ) , std::out_of_range );
+
+    // Splitting the cells over two parts and merging them back restores
+    // the source, whatever the layouts of the parts.
+    const std::vector<int32_t> even = { 0 , 2 , 4 , 6 , 8 };
+    const std::vector<int32_t> odd = { 1 , 3 , 5 , 7 , 9 };
+    SimulationDataContainer first = source.extractCells( even );
+    const SimulationDataContainer second = source.extractCells( odd );
+    first.relayoutCellData( first.cellFieldId("S") , FieldLayout() );
+    const SimulationDataContainer merged = SimulationDataContainer::mergeCells( { &first , &second } , { even , odd } );
+    BOOST_CHECK_EQUAL( merged.numCells() , 10U );
+    BOOST_CHECK( merged.cellLayout( merged.cellFieldId("S") ) == FieldLayout() );
+    BOOST_CHECK( merged.equal( source.extractCells( { 0 , 1 , 2 , 3 , 4 , 5 , 6 , 7 , 8 , 9 } )));
+
+    // Fields missing from a part are zero.
+    SimulationDataContainer extra( 2 , 0 , FieldStorage::Vector );
+    extra.registerCellData("P" , 1 , 4.0 );
+    extra.registerCellData("T" , 1 , 3.0 );
+    const SimulationDataContainer grown = SimulationDataContainer::mergeCells( { &part , &extra } , { { 0 , 1 , 2 , 3 } , { 5 , 4 } } );
+    BOOST_CHECK_EQUAL( grown.numCells() , 6U );
+    BOOST_CHECK_EQUAL( grown.cellView( grown.cellFieldId("P") )[0] , 7.0 );
+    BOOST_CHECK_EQUAL( grown.cellView( grown.cellFieldId("P") )[3] , 3.0 );
+    BOOST_CHECK_EQUAL( grown.cellView( grown.cellFieldId("P") )[4] , 4.0 );
+    BOOST_CHECK_EQUAL( grown.cellView( grown.cellFieldId("T") )[0] , 0.0 );
+    BOOST_CHECK_EQUAL( grown.cellView( grown.cellFieldId("T") )[5] , 3.0 );
+    BOOST_CHECK_EQUAL( grown.cellView<int32_t>( grown.cellFieldId("RANK") )[5] , 0 );
+
+    // The parts must cover every cell exactly once.
+    BOOST_CHECK_THROW( SimulationDataContainer::mergeCells( { &part , &extra } , { { 0 , 1 , 2 , 3 } , { 3 , 4 } } ) , std::invalid_argument );
+    BOOST_CHECK_THROW( SimulationDataContainer::mergeCells( { &part , &extra } , { { 0 , 1 , 2 , 3 } , { 4 , 6 } } ) , std::invalid_argument );
+    BOOST_CHECK_THROW( SimulationDataContainer::mergeCells( { &part } , { { 0 , 1 , 2 , 2 } } ) , std::invalid_argument );
+
+    SimulationDataContainer clash( 2 , 0 , FieldStorage::Vector );
+    clash.registerCellData("P" , 2 , 0.0 );
+    BOOST_CHECK_THROW( SimulationDataContainer::mergeCells( { &part , &clash } , { { 0 , 1 , 2 , 3 } , { 4 , 5 } } ) , std::invalid_argument );
+    BOOST_CHECK_THROW( SimulationDataContainer::mergeCells( { &part } , { { 0 , 1 } } ) , std::invalid_argument );
+    BOOST_CHECK_THROW( SimulationDataContainer::mergeCells( { &part } , { { 0 , 1 , -2 , 3 } } ) , std::invalid_argument );
+    BOOST_CHECK_THROW( SimulationDataContainer::mergeCells( {} , {} ) , std::invalid_argument );
+
+    // The cells can also travel as one contiguous message.
+    const size_t bytes = source.cellMessageBytes( cells.size() );
+    BOOST_CHECK_EQUAL( bytes , 32U + 96U + 32U + 16U + 8U );
+    std::vector<double> buffer( bytes / sizeof(double) );
+    source.packCells( cells , buffer.data() );
+    SimulationDataContainer received = source.extractCells( { 0 , 0 , 0 , 0 } );
+    received.unpackCells( { 0 , 1 , 2 , 3 } , buffer.data() );
+    BOOST_CHECK( received.equal( part ) );
 }